@@ -0,0 +1,145 @@
+#include "Bounds.h"
+#include <float.h>
+#include <math.h>
+
+using namespace DirectX;
+
+AABB::AABB()
+{
+	// Start inside out, so the first Encapsulate sets both corners
+	Min = XMFLOAT3(FLT_MAX, FLT_MAX, FLT_MAX);
+	Max = XMFLOAT3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+}
+
+AABB::AABB(DirectX::XMFLOAT3 min, DirectX::XMFLOAT3 max)
+{
+	Min = min;
+	Max = max;
+}
+
+void AABB::Encapsulate(DirectX::XMFLOAT3 point)
+{
+	Min = XMFLOAT3(fminf(Min.x, point.x), fminf(Min.y, point.y), fminf(Min.z, point.z));
+	Max = XMFLOAT3(fmaxf(Max.x, point.x), fmaxf(Max.y, point.y), fmaxf(Max.z, point.z));
+}
+
+void AABB::Encapsulate(const AABB & other)
+{
+	Encapsulate(other.Min);
+	Encapsulate(other.Max);
+}
+
+void AABB::Expand(float amount)
+{
+	Min = XMFLOAT3(Min.x - amount, Min.y - amount, Min.z - amount);
+	Max = XMFLOAT3(Max.x + amount, Max.y + amount, Max.z + amount);
+}
+
+DirectX::XMFLOAT3 AABB::GetCenter() const
+{
+	return XMFLOAT3((Min.x + Max.x) * 0.5f, (Min.y + Max.y) * 0.5f, (Min.z + Max.z) * 0.5f);
+}
+
+DirectX::XMFLOAT3 AABB::GetExtents() const
+{
+	return XMFLOAT3((Max.x - Min.x) * 0.5f, (Max.y - Min.y) * 0.5f, (Max.z - Min.z) * 0.5f);
+}
+
+float AABB::DistanceTo(DirectX::XMFLOAT3 point) const
+{
+	float dx = fmaxf(fmaxf(Min.x - point.x, 0.0f), point.x - Max.x);
+	float dy = fmaxf(fmaxf(Min.y - point.y, 0.0f), point.y - Max.y);
+	float dz = fmaxf(fmaxf(Min.z - point.z, 0.0f), point.z - Max.z);
+	return sqrtf(dx * dx + dy * dy + dz * dz);
+}
+
+AABB AABB::Transformed(DirectX::FXMMATRIX world) const
+{
+	// Move the center, then add up how far each axis of the
+	// matrix stretches the extents along each world axis
+	XMFLOAT3 center = GetCenter();
+	XMFLOAT3 extents = GetExtents();
+	XMVECTOR newCenter = XMVector3Transform(XMLoadFloat3(&center), world);
+
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, world);
+	XMFLOAT3 newExtents(
+		fabsf(m._11) * extents.x + fabsf(m._21) * extents.y + fabsf(m._31) * extents.z,
+		fabsf(m._12) * extents.x + fabsf(m._22) * extents.y + fabsf(m._32) * extents.z,
+		fabsf(m._13) * extents.x + fabsf(m._23) * extents.y + fabsf(m._33) * extents.z);
+
+	XMFLOAT3 c;
+	XMStoreFloat3(&c, newCenter);
+	return AABB(
+		XMFLOAT3(c.x - newExtents.x, c.y - newExtents.y, c.z - newExtents.z),
+		XMFLOAT3(c.x + newExtents.x, c.y + newExtents.y, c.z + newExtents.z));
+}
+
+BoundingSphere BoundingSphere::Transformed(DirectX::FXMMATRIX world) const
+{
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, world);
+	float scaleX = m._11 * m._11 + m._12 * m._12 + m._13 * m._13;
+	float scaleY = m._21 * m._21 + m._22 * m._22 + m._23 * m._23;
+	float scaleZ = m._31 * m._31 + m._32 * m._32 + m._33 * m._33;
+
+	BoundingSphere sphere;
+	XMStoreFloat3(&sphere.Center, XMVector3Transform(XMLoadFloat3(&Center), world));
+	sphere.Radius = Radius * sqrtf(fmaxf(scaleX, fmaxf(scaleY, scaleZ)));
+	return sphere;
+}
+
+Frustum::Frustum()
+{
+	// Planes that accept everything
+	for (int i = 0; i < 6; i++)
+		planes[i] = XMFLOAT4(0, 0, 0, 1);
+}
+
+Frustum::Frustum(DirectX::FXMMATRIX viewProjection)
+{
+	// With row vectors, clip = p * M, so each clip coordinate is the dot
+	// product of p with a column of M.  Work with the transpose to get
+	// those columns as rows.
+	XMFLOAT4X4 m;
+	XMStoreFloat4x4(&m, XMMatrixTranspose(viewProjection));
+	XMVECTOR x = XMVectorSet(m._11, m._12, m._13, m._14);
+	XMVECTOR y = XMVectorSet(m._21, m._22, m._23, m._24);
+	XMVECTOR z = XMVectorSet(m._31, m._32, m._33, m._34);
+	XMVECTOR w = XMVectorSet(m._41, m._42, m._43, m._44);
+
+	// -w <= x <= w, -w <= y <= w, 0 <= z <= w
+	XMVECTOR extracted[6] =
+	{
+		XMVectorAdd(w, x),
+		XMVectorSubtract(w, x),
+		XMVectorAdd(w, y),
+		XMVectorSubtract(w, y),
+		z,
+		XMVectorSubtract(w, z)
+	};
+
+	for (int i = 0; i < 6; i++)
+		XMStoreFloat4(&planes[i], XMPlaneNormalize(extracted[i]));
+}
+
+bool Frustum::Intersects(const AABB & box) const
+{
+	XMFLOAT3 center = box.GetCenter();
+	XMFLOAT3 extents = box.GetExtents();
+
+	for (int i = 0; i < 6; i++)
+	{
+		const XMFLOAT4& p = planes[i];
+
+		// Distance of the center from the plane, and how far the box reaches towards it
+		float distance = p.x * center.x + p.y * center.y + p.z * center.z + p.w;
+		float radius = fabsf(p.x) * extents.x + fabsf(p.y) * extents.y + fabsf(p.z) * extents.z;
+
+		// Entirely behind this plane
+		if (distance + radius < 0)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// Axis-aligned bounding box in world space
+// --------------------------------------------------------
+struct AABB
+{
+	DirectX::XMFLOAT3 Min;
+	DirectX::XMFLOAT3 Max;
+
+	AABB();
+	AABB(DirectX::XMFLOAT3 min, DirectX::XMFLOAT3 max);
+
+	///<summary>
+	///Grow the box to contain the given point.
+	///</summary>
+	void Encapsulate(DirectX::XMFLOAT3 point);
+
+	///<summary>
+	///Grow the box to contain another box.
+	///</summary>
+	void Encapsulate(const AABB& other);
+
+	///<summary>
+	///Grow the box by amount in every direction.
+	///</summary>
+	void Expand(float amount);
+
+	DirectX::XMFLOAT3 GetCenter() const;
+	DirectX::XMFLOAT3 GetExtents() const;
+
+	///<summary>
+	///Distance from point to the nearest point of the box (0 when inside).
+	///</summary>
+	float DistanceTo(DirectX::XMFLOAT3 point) const;
+
+	///<summary>
+	///The box around this box once moved by a (non-transposed) world matrix.
+	///</summary>
+	AABB Transformed(DirectX::FXMMATRIX world) const;
+};
+
+// --------------------------------------------------------
+// Sphere around a mesh - looser than its box for long thin
+// shapes, tighter once those shapes are rotated
+// --------------------------------------------------------
+struct BoundingSphere
+{
+	DirectX::XMFLOAT3 Center;
+	float Radius;
+
+	///<summary>
+	///The sphere once moved by a (non-transposed) world matrix, grown by its largest scale.
+	///</summary>
+	BoundingSphere Transformed(DirectX::FXMMATRIX world) const;
+};
+
+// --------------------------------------------------------
+// The six planes of a camera's view volume, each stored as
+// (normal, d) with the normal pointing inwards
+// --------------------------------------------------------
+class Frustum
+{
+public:
+	Frustum();
+
+	///<summary>
+	///Extract the planes from a (non-transposed) view * projection matrix.
+	///</summary>
+	Frustum(DirectX::FXMMATRIX viewProjection);
+
+	///<summary>
+	///True if any part of the box might be inside the frustum.
+	///Conservative: boxes near a corner can be reported visible when they are not.
+	///</summary>
+	bool Intersects(const AABB& box) const;
+
+	DirectX::XMFLOAT4 planes[6];	// Left, right, bottom, top, near, far
+};
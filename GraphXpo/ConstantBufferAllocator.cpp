@@ -0,0 +1,62 @@
+#include "ConstantBufferAllocator.h"
+
+ConstantBufferAllocator::ConstantBufferAllocator(unsigned int frameSize, unsigned int frameCount)
+{
+	// Whole aligned blocks only, so every region starts aligned too
+	this->frameSize = frameSize / Alignment * Alignment;
+	this->frameCount = frameCount > 0 ? frameCount : 1;
+	frameIndex = 0;
+	head = 0;
+	failedAllocations = 0;
+}
+
+void ConstantBufferAllocator::BeginFrame()
+{
+	frameIndex++;
+	head = 0;
+	failedAllocations = 0;
+}
+
+bool ConstantBufferAllocator::Allocate(unsigned int size, unsigned int * offset)
+{
+	unsigned int alignedSize = (size + Alignment - 1) / Alignment * Alignment;
+	if (alignedSize == 0 || alignedSize > frameSize - head)
+	{
+		failedAllocations++;
+		return false;
+	}
+
+	*offset = (frameIndex % frameCount) * frameSize + head;
+	head += alignedSize;
+	return true;
+}
+
+bool ConstantBufferAllocator::IsFirstRegion()
+{
+	return frameIndex % frameCount == 0;
+}
+
+unsigned int ConstantBufferAllocator::GetFrameIndex()
+{
+	return frameIndex;
+}
+
+unsigned int ConstantBufferAllocator::GetFrameSize()
+{
+	return frameSize;
+}
+
+unsigned int ConstantBufferAllocator::GetTotalSize()
+{
+	return frameSize * frameCount;
+}
+
+unsigned int ConstantBufferAllocator::GetBytesUsed()
+{
+	return head;
+}
+
+unsigned int ConstantBufferAllocator::GetFailedAllocations()
+{
+	return failedAllocations;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// --------------------------------------------------------
+// Hands out space in a buffer that is split into one
+// region per frame in flight.  Each frame allocates
+// linearly through its own region, and a region is only
+// reused frameCount frames later, by which time the GPU
+// has finished reading it.
+//
+// Pure bookkeeping with no Direct3D calls, so it can be
+// used (and checked) without a GPU.
+// --------------------------------------------------------
+class ConstantBufferAllocator
+{
+public:
+	// Constant buffers bound with offsets must start on 256 byte boundaries
+	static const unsigned int Alignment = 256;
+
+	ConstantBufferAllocator(unsigned int frameSize, unsigned int frameCount);
+
+	///<summary>
+	///Move on to the next frame's region and start filling it from the beginning.
+	///</summary>
+	void BeginFrame();
+
+	///<summary>
+	///Reserve size bytes (rounded up to the Alignment) in this frame's region.
+	///Returns false, leaving offset untouched, if the region is full.
+	///</summary>
+	bool Allocate(unsigned int size, unsigned int* offset);
+
+	///<summary>
+	///Whether the current frame's region is the first one, i.e. this is a new pass through the buffer.
+	///</summary>
+	bool IsFirstRegion();
+
+	///<summary>
+	///Count of BeginFrame calls, which tells allocations from different frames apart.
+	///</summary>
+	unsigned int GetFrameIndex();
+
+	unsigned int GetFrameSize();
+	unsigned int GetTotalSize();
+	unsigned int GetBytesUsed();			// This frame, including alignment
+	unsigned int GetFailedAllocations();	// This frame
+
+private:
+	unsigned int frameSize;
+	unsigned int frameCount;
+	unsigned int frameIndex;
+	unsigned int head;		// Next free byte of this frame's region
+	unsigned int failedAllocations;
+};
@@ -0,0 +1,95 @@
+#include "ConstantBufferRing.h"
+#include <string.h>
+
+ConstantBufferRing::ConstantBufferRing(ID3D11Device * device, ID3D11DeviceContext * context, unsigned int frameSize, unsigned int frameCount)
+	: allocator(frameSize, frameCount)
+{
+	this->context = 0;
+	buffer = 0;
+	discardNext = true;
+
+	// Binding with offsets and appending with NO_OVERWRITE are both Direct3D 11.1 features
+	ID3D11DeviceContext1* context1 = 0;
+	if (FAILED(context->QueryInterface(&context1)))
+		return;
+
+	D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+	device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options));
+	if (!options.ConstantBufferOffsetting || !options.MapNoOverwriteOnDynamicConstantBuffer)
+	{
+		context1->Release();
+		return;
+	}
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	desc.Usage = D3D11_USAGE_DYNAMIC;
+	desc.ByteWidth = allocator.GetTotalSize();
+	if (FAILED(device->CreateBuffer(&desc, 0, &buffer)))
+	{
+		buffer = 0;
+		context1->Release();
+		return;
+	}
+
+	this->context = context1;
+}
+
+ConstantBufferRing::~ConstantBufferRing()
+{
+	if (buffer) buffer->Release();
+	if (context) context->Release();
+}
+
+bool ConstantBufferRing::IsEnabled()
+{
+	return buffer != 0;
+}
+
+void ConstantBufferRing::BeginFrame()
+{
+	allocator.BeginFrame();
+	if (allocator.IsFirstRegion())
+		discardNext = true;
+}
+
+bool ConstantBufferRing::Upload(const void * data, unsigned int size, UINT * firstConstant, UINT * constantCount)
+{
+	unsigned int offset;
+	if (!buffer || !allocator.Allocate(size, &offset))
+		return false;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->Map(buffer, 0, discardNext ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped)))
+		return false;
+	memcpy((unsigned char*)mapped.pData + offset, data, size);
+	context->Unmap(buffer, 0);
+	discardNext = false;
+
+	// Offsets and sizes are counted in 16 byte constants, and the
+	// allocator's alignment keeps the size a multiple of 16 of them
+	*firstConstant = offset / 16;
+	*constantCount = (size + ConstantBufferAllocator::Alignment - 1) / ConstantBufferAllocator::Alignment * ConstantBufferAllocator::Alignment / 16;
+	return true;
+}
+
+ID3D11Buffer * ConstantBufferRing::GetBuffer()
+{
+	return buffer;
+}
+
+ID3D11DeviceContext1 * ConstantBufferRing::GetContext()
+{
+	return context;
+}
+
+unsigned int ConstantBufferRing::GetFrameIndex()
+{
+	return allocator.GetFrameIndex();
+}
+
+ConstantBufferAllocator * ConstantBufferRing::GetAllocator()
+{
+	return &allocator;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3d11_1.h>
+#include "ConstantBufferAllocator.h"
+
+// --------------------------------------------------------
+// One large dynamic constant buffer that every draw's
+// constants are appended to, instead of each shader
+// rewriting its own small buffer with UpdateSubresource.
+// Shaders then bind their slice with an offset.
+//
+// Maps use NO_OVERWRITE, since nothing already written
+// this frame is ever touched again.  The first map of each
+// pass through the buffer uses DISCARD instead, so the GPU
+// can keep reading older passes without any fences.
+//
+// Needs Direct3D 11.1 with constant buffer offsetting and
+// NO_OVERWRITE on dynamic constant buffers - without them
+// IsEnabled() is false and shaders keep their own buffers.
+// --------------------------------------------------------
+class ConstantBufferRing
+{
+public:
+	ConstantBufferRing(ID3D11Device* device, ID3D11DeviceContext* context, unsigned int frameSize, unsigned int frameCount = 3);
+	~ConstantBufferRing();
+
+	bool IsEnabled();
+
+	///<summary>
+	///Start allocating from the next frame's part of the buffer.  Call once per frame before any uploads.
+	///</summary>
+	void BeginFrame();
+
+	///<summary>
+	///Copy size bytes into the buffer, and give back where they went in 16 byte constants, ready for
+	///XXSetConstantBuffers1.  Returns false if the ring is disabled or this frame's space has run out.
+	///</summary>
+	bool Upload(const void* data, unsigned int size, UINT* firstConstant, UINT* constantCount);
+
+	ID3D11Buffer* GetBuffer();
+	ID3D11DeviceContext1* GetContext();
+
+	///<summary>
+	///Changes every frame, so uploads from earlier frames can be told apart.
+	///</summary>
+	unsigned int GetFrameIndex();
+
+	ConstantBufferAllocator* GetAllocator();
+
+private:
+	ConstantBufferAllocator allocator;
+
+	ID3D11DeviceContext1* context;
+	ID3D11Buffer* buffer;
+	bool discardNext;	// Start of a new pass through the buffer
+};
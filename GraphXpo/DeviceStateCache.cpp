@@ -0,0 +1,450 @@
+#include "DeviceStateCache.h"
+#include <string.h>
+
+static bool operator==(const ConstantBufferBinding& a, const ConstantBufferBinding& b)
+{
+	return a.Buffer == b.Buffer && a.FirstConstant == b.FirstConstant && a.ConstantCount == b.ConstantCount;
+}
+
+DeviceStateCache::DeviceStateCache(ID3D11DeviceContext * context)
+{
+	this->context = context;
+
+	// Slices of constant buffers need Direct3D 11.1
+	context1 = 0;
+	if (FAILED(context->QueryInterface(&context1)))
+		context1 = 0;
+
+	memset(constantBuffers, 0, sizeof(constantBuffers));
+	memset(shaderResources, 0, sizeof(shaderResources));
+	memset(samplers, 0, sizeof(samplers));
+	memset(shaders, 0, sizeof(shaders));
+	memset(vertexBuffers, 0, sizeof(vertexBuffers));
+	memset(vertexStrides, 0, sizeof(vertexStrides));
+	memset(vertexOffsets, 0, sizeof(vertexOffsets));
+	memset(renderTargets, 0, sizeof(renderTargets));
+	memset(blendFactor, 0, sizeof(blendFactor));
+	inputLayout = 0;
+	indexBuffer = 0;
+	indexFormat = DXGI_FORMAT_UNKNOWN;
+	indexOffset = 0;
+	topology = D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	renderTargetCount = 0;
+	depthStencilView = 0;
+	blendState = 0;
+	sampleMask = 0;
+	depthStencilState = 0;
+	stencilRef = 0;
+	rasterizerState = 0;
+
+	// Nothing is known about the context yet
+	Invalidate();
+	ResetStats();
+}
+
+DeviceStateCache::~DeviceStateCache()
+{
+	if (context1) context1->Release();
+}
+
+void DeviceStateCache::Invalidate()
+{
+	for (int s = 0; s < (int)ShaderStage::Count; s++)
+	{
+		memset(constantBuffers[s].Known, 0, sizeof(constantBuffers[s].Known));
+		memset(constantBuffers[s].Dirty, 0, sizeof(constantBuffers[s].Dirty));
+		memset(shaderResources[s].Known, 0, sizeof(shaderResources[s].Known));
+		memset(shaderResources[s].Dirty, 0, sizeof(shaderResources[s].Dirty));
+		memset(samplers[s].Known, 0, sizeof(samplers[s].Known));
+		memset(samplers[s].Dirty, 0, sizeof(samplers[s].Dirty));
+		shaderKnown[s] = false;
+	}
+	pendingBindings = false;
+
+	inputLayoutKnown = false;
+	for (unsigned int i = 0; i < MaxVertexBuffers; i++)
+		vertexBufferKnown[i] = false;
+	indexBufferKnown = false;
+	topologyKnown = false;
+	renderTargetsKnown = false;
+	blendStateKnown = false;
+	depthStencilStateKnown = false;
+	rasterizerStateKnown = false;
+}
+
+bool DeviceStateCache::Changed(bool & known, bool same)
+{
+	if (known && same)
+	{
+		stats.CallsElided++;
+		return false;
+	}
+
+	known = true;
+	stats.CallsIssued++;
+	return true;
+}
+
+void DeviceStateCache::SetInputLayout(ID3D11InputLayout * inputLayout)
+{
+	if (!Changed(inputLayoutKnown, this->inputLayout == inputLayout))
+		return;
+	this->inputLayout = inputLayout;
+	context->IASetInputLayout(inputLayout);
+}
+
+void DeviceStateCache::SetVertexShader(ID3D11VertexShader * shader)
+{
+	int s = (int)ShaderStage::Vertex;
+	if (!Changed(shaderKnown[s], shaders[s] == shader))
+		return;
+	shaders[s] = shader;
+	context->VSSetShader(shader, 0, 0);
+}
+
+void DeviceStateCache::SetHullShader(ID3D11HullShader * shader)
+{
+	int s = (int)ShaderStage::Hull;
+	if (!Changed(shaderKnown[s], shaders[s] == shader))
+		return;
+	shaders[s] = shader;
+	context->HSSetShader(shader, 0, 0);
+}
+
+void DeviceStateCache::SetDomainShader(ID3D11DomainShader * shader)
+{
+	int s = (int)ShaderStage::Domain;
+	if (!Changed(shaderKnown[s], shaders[s] == shader))
+		return;
+	shaders[s] = shader;
+	context->DSSetShader(shader, 0, 0);
+}
+
+void DeviceStateCache::SetGeometryShader(ID3D11GeometryShader * shader)
+{
+	int s = (int)ShaderStage::Geometry;
+	if (!Changed(shaderKnown[s], shaders[s] == shader))
+		return;
+	shaders[s] = shader;
+	context->GSSetShader(shader, 0, 0);
+}
+
+void DeviceStateCache::SetPixelShader(ID3D11PixelShader * shader)
+{
+	int s = (int)ShaderStage::Pixel;
+	if (!Changed(shaderKnown[s], shaders[s] == shader))
+		return;
+	shaders[s] = shader;
+	context->PSSetShader(shader, 0, 0);
+}
+
+void DeviceStateCache::SetComputeShader(ID3D11ComputeShader * shader)
+{
+	int s = (int)ShaderStage::Compute;
+	if (!Changed(shaderKnown[s], shaders[s] == shader))
+		return;
+	shaders[s] = shader;
+	context->CSSetShader(shader, 0, 0);
+}
+
+template<typename T, unsigned int N>
+void DeviceStateCache::SetSlot(SlotTable<T, N>& table, UINT slot, const T & value)
+{
+	// Already on the device - cancel anything else that was waiting
+	if (table.Known[slot] && table.Bound[slot] == value)
+	{
+		table.Pending[slot] = value;
+		table.Dirty[slot] = false;
+		stats.CallsElided++;
+		return;
+	}
+
+	// Already waiting to be sent
+	if (table.Dirty[slot] && table.Pending[slot] == value)
+	{
+		stats.CallsElided++;
+		return;
+	}
+
+	table.Pending[slot] = value;
+	table.Dirty[slot] = true;
+	pendingBindings = true;
+}
+
+void DeviceStateCache::SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer * buffer, UINT firstConstant, UINT constantCount)
+{
+	ConstantBufferBinding binding = { buffer, firstConstant, constantCount };
+	if (slot >= MaxConstantBuffers)
+	{
+		IssueConstantBuffers(stage, slot, 1, &binding);
+		stats.CallsIssued++;
+		return;
+	}
+
+	SetSlot(constantBuffers[(int)stage], slot, binding);
+}
+
+void DeviceStateCache::SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView * srv)
+{
+	if (slot >= MaxShaderResources)
+	{
+		IssueShaderResources(stage, slot, 1, &srv);
+		stats.CallsIssued++;
+		return;
+	}
+
+	SetSlot(shaderResources[(int)stage], slot, srv);
+}
+
+void DeviceStateCache::SetSampler(ShaderStage stage, UINT slot, ID3D11SamplerState * sampler)
+{
+	if (slot >= MaxSamplers)
+	{
+		IssueSamplers(stage, slot, 1, &sampler);
+		stats.CallsIssued++;
+		return;
+	}
+
+	SetSlot(samplers[(int)stage], slot, sampler);
+}
+
+void DeviceStateCache::SetVertexBuffer(UINT slot, ID3D11Buffer * buffer, UINT stride, UINT offset)
+{
+	if (slot >= MaxVertexBuffers)
+	{
+		context->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+		stats.CallsIssued++;
+		return;
+	}
+
+	bool same = vertexBuffers[slot] == buffer && vertexStrides[slot] == stride && vertexOffsets[slot] == offset;
+	if (!Changed(vertexBufferKnown[slot], same))
+		return;
+	vertexBuffers[slot] = buffer;
+	vertexStrides[slot] = stride;
+	vertexOffsets[slot] = offset;
+	context->IASetVertexBuffers(slot, 1, &buffer, &stride, &offset);
+}
+
+void DeviceStateCache::SetIndexBuffer(ID3D11Buffer * buffer, DXGI_FORMAT format, UINT offset)
+{
+	bool same = indexBuffer == buffer && indexFormat == format && indexOffset == offset;
+	if (!Changed(indexBufferKnown, same))
+		return;
+	indexBuffer = buffer;
+	indexFormat = format;
+	indexOffset = offset;
+	context->IASetIndexBuffer(buffer, format, offset);
+}
+
+void DeviceStateCache::SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology)
+{
+	if (!Changed(topologyKnown, this->topology == topology))
+		return;
+	this->topology = topology;
+	context->IASetPrimitiveTopology(topology);
+}
+
+void DeviceStateCache::SetRenderTargets(UINT count, ID3D11RenderTargetView * const * rtvs, ID3D11DepthStencilView * dsv)
+{
+	bool same = renderTargetCount == count && depthStencilView == dsv;
+	for (UINT i = 0; same && i < count; i++)
+		same = renderTargets[i] == rtvs[i];
+
+	if (!Changed(renderTargetsKnown, same))
+		return;
+	renderTargetCount = min(count, MaxRenderTargets);
+	for (UINT i = 0; i < renderTargetCount; i++)
+		renderTargets[i] = rtvs[i];
+	depthStencilView = dsv;
+	context->OMSetRenderTargets(count, rtvs, dsv);
+}
+
+void DeviceStateCache::SetBlendState(ID3D11BlendState * state, const FLOAT blendFactor[4], UINT sampleMask)
+{
+	bool same = blendState == state && this->sampleMask == sampleMask && memcmp(this->blendFactor, blendFactor, sizeof(this->blendFactor)) == 0;
+	if (!Changed(blendStateKnown, same))
+		return;
+	blendState = state;
+	memcpy(this->blendFactor, blendFactor, sizeof(this->blendFactor));
+	this->sampleMask = sampleMask;
+	context->OMSetBlendState(state, blendFactor, sampleMask);
+}
+
+void DeviceStateCache::SetDepthStencilState(ID3D11DepthStencilState * state, UINT stencilRef)
+{
+	bool same = depthStencilState == state && this->stencilRef == stencilRef;
+	if (!Changed(depthStencilStateKnown, same))
+		return;
+	depthStencilState = state;
+	this->stencilRef = stencilRef;
+	context->OMSetDepthStencilState(state, stencilRef);
+}
+
+void DeviceStateCache::SetRasterizerState(ID3D11RasterizerState * state)
+{
+	if (!Changed(rasterizerStateKnown, rasterizerState == state))
+		return;
+	rasterizerState = state;
+	context->RSSetState(state);
+}
+
+template<typename T, unsigned int N, typename Issue>
+void DeviceStateCache::FlushSlots(SlotTable<T, N>& table, Issue issue)
+{
+	UINT i = 0;
+	while (i < N)
+	{
+		if (!table.Dirty[i])
+		{
+			i++;
+			continue;
+		}
+
+		// Extend the run over slots that are waiting, or that are known and so safe to
+		// send again unchanged, as long as another waiting slot follows
+		UINT start = i;
+		UINT end = i + 1;
+		for (UINT j = i + 1; j < N && (table.Dirty[j] || table.Known[j]); j++)
+		{
+			if (table.Dirty[j])
+				end = j + 1;
+		}
+
+		unsigned int dirtyCount = 0;
+		for (UINT j = start; j < end; j++)
+		{
+			if (table.Dirty[j])
+				dirtyCount++;
+			table.Bound[j] = table.Pending[j];
+			table.Known[j] = true;
+			table.Dirty[j] = false;
+		}
+
+		issue(start, end - start, &table.Pending[start]);
+		stats.CallsIssued++;
+		stats.SlotsCoalesced += dirtyCount - 1;
+		i = end;
+	}
+}
+
+void DeviceStateCache::Flush()
+{
+	if (!pendingBindings)
+		return;
+
+	for (int s = 0; s < (int)ShaderStage::Count; s++)
+	{
+		ShaderStage stage = (ShaderStage)s;
+		FlushSlots(constantBuffers[s], [&](UINT start, UINT count, const ConstantBufferBinding* bindings)
+		{
+			IssueConstantBuffers(stage, start, count, bindings);
+		});
+		FlushSlots(shaderResources[s], [&](UINT start, UINT count, ID3D11ShaderResourceView* const* srvs)
+		{
+			IssueShaderResources(stage, start, count, srvs);
+		});
+		FlushSlots(samplers[s], [&](UINT start, UINT count, ID3D11SamplerState* const* states)
+		{
+			IssueSamplers(stage, start, count, states);
+		});
+	}
+
+	pendingBindings = false;
+}
+
+void DeviceStateCache::IssueConstantBuffers(ShaderStage stage, UINT start, UINT count, const ConstantBufferBinding * bindings)
+{
+	ID3D11Buffer* buffers[MaxConstantBuffers];
+	UINT firstConstants[MaxConstantBuffers];
+	UINT constantCounts[MaxConstantBuffers];
+
+	bool sliced = false;
+	for (UINT i = 0; i < count; i++)
+	{
+		buffers[i] = bindings[i].Buffer;
+
+		// A whole buffer is a slice of the most constants a binding can see
+		firstConstants[i] = bindings[i].FirstConstant;
+		constantCounts[i] = bindings[i].ConstantCount ? bindings[i].ConstantCount : D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT;
+		sliced |= bindings[i].ConstantCount != 0;
+	}
+
+	if (sliced && context1)
+	{
+		switch (stage)
+		{
+		case ShaderStage::Vertex: context1->VSSetConstantBuffers1(start, count, buffers, firstConstants, constantCounts); break;
+		case ShaderStage::Hull: context1->HSSetConstantBuffers1(start, count, buffers, firstConstants, constantCounts); break;
+		case ShaderStage::Domain: context1->DSSetConstantBuffers1(start, count, buffers, firstConstants, constantCounts); break;
+		case ShaderStage::Geometry: context1->GSSetConstantBuffers1(start, count, buffers, firstConstants, constantCounts); break;
+		case ShaderStage::Pixel: context1->PSSetConstantBuffers1(start, count, buffers, firstConstants, constantCounts); break;
+		case ShaderStage::Compute: context1->CSSetConstantBuffers1(start, count, buffers, firstConstants, constantCounts); break;
+		}
+		return;
+	}
+
+	switch (stage)
+	{
+	case ShaderStage::Vertex: context->VSSetConstantBuffers(start, count, buffers); break;
+	case ShaderStage::Hull: context->HSSetConstantBuffers(start, count, buffers); break;
+	case ShaderStage::Domain: context->DSSetConstantBuffers(start, count, buffers); break;
+	case ShaderStage::Geometry: context->GSSetConstantBuffers(start, count, buffers); break;
+	case ShaderStage::Pixel: context->PSSetConstantBuffers(start, count, buffers); break;
+	case ShaderStage::Compute: context->CSSetConstantBuffers(start, count, buffers); break;
+	}
+}
+
+void DeviceStateCache::IssueShaderResources(ShaderStage stage, UINT start, UINT count, ID3D11ShaderResourceView * const * srvs)
+{
+	switch (stage)
+	{
+	case ShaderStage::Vertex: context->VSSetShaderResources(start, count, srvs); break;
+	case ShaderStage::Hull: context->HSSetShaderResources(start, count, srvs); break;
+	case ShaderStage::Domain: context->DSSetShaderResources(start, count, srvs); break;
+	case ShaderStage::Geometry: context->GSSetShaderResources(start, count, srvs); break;
+	case ShaderStage::Pixel: context->PSSetShaderResources(start, count, srvs); break;
+	case ShaderStage::Compute: context->CSSetShaderResources(start, count, srvs); break;
+	}
+}
+
+void DeviceStateCache::IssueSamplers(ShaderStage stage, UINT start, UINT count, ID3D11SamplerState * const * samplers)
+{
+	switch (stage)
+	{
+	case ShaderStage::Vertex: context->VSSetSamplers(start, count, samplers); break;
+	case ShaderStage::Hull: context->HSSetSamplers(start, count, samplers); break;
+	case ShaderStage::Domain: context->DSSetSamplers(start, count, samplers); break;
+	case ShaderStage::Geometry: context->GSSetSamplers(start, count, samplers); break;
+	case ShaderStage::Pixel: context->PSSetSamplers(start, count, samplers); break;
+	case ShaderStage::Compute: context->CSSetSamplers(start, count, samplers); break;
+	}
+}
+
+void DeviceStateCache::Draw(UINT vertexCount, UINT startVertex)
+{
+	Flush();
+	context->Draw(vertexCount, startVertex);
+}
+
+void DeviceStateCache::DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex)
+{
+	Flush();
+	context->DrawIndexed(indexCount, startIndex, baseVertex);
+}
+
+void DeviceStateCache::Dispatch(UINT groupsX, UINT groupsY, UINT groupsZ)
+{
+	Flush();
+	context->Dispatch(groupsX, groupsY, groupsZ);
+}
+
+const DeviceStateStats & DeviceStateCache::GetStats()
+{
+	return stats;
+}
+
+void DeviceStateCache::ResetStats()
+{
+	stats = {};
+}
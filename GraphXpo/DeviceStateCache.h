@@ -0,0 +1,168 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3d11_1.h>
+
+// The programmable pipeline stages, for per-stage bindings
+enum class ShaderStage
+{
+	Vertex,
+	Hull,
+	Domain,
+	Geometry,
+	Pixel,
+	Compute,
+	Count
+};
+
+// Calls made to the context versus calls the cache dropped
+struct DeviceStateStats
+{
+	unsigned int CallsIssued;
+	unsigned int CallsElided;		// Bindings that were already in place
+	unsigned int SlotsCoalesced;	// Slots that rode along in another slot's range call
+};
+
+// A constant buffer binding, optionally a slice of the buffer (in 16 byte constants)
+struct ConstantBufferBinding
+{
+	ID3D11Buffer* Buffer;
+	UINT FirstConstant;
+	UINT ConstantCount;		// 0 for the whole buffer
+};
+
+// --------------------------------------------------------
+// Wraps the device context and remembers what is bound,
+// so setting something that is already bound costs nothing.
+//
+// Shaders, input assembler and output merger state are set
+// straight away.  Constant buffers, SRVs and samplers are
+// held until the next draw (or Flush()), and then sent with
+// one call per run of neighbouring slots.
+//
+// Anything bound directly on the context behind the cache's
+// back makes its copy wrong - call Invalidate() before using
+// the cache again after that.
+// --------------------------------------------------------
+class DeviceStateCache
+{
+public:
+	static const unsigned int MaxConstantBuffers = D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT;
+	static const unsigned int MaxShaderResources = 16;	// Higher slots go straight to the context
+	static const unsigned int MaxSamplers = D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT;
+	static const unsigned int MaxVertexBuffers = 4;
+	static const unsigned int MaxRenderTargets = D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT;
+
+	DeviceStateCache(ID3D11DeviceContext* context);
+	~DeviceStateCache();
+
+	///<summary>
+	///Forget everything the cache thinks is bound, and drop any bindings not yet sent.
+	///</summary>
+	void Invalidate();
+
+	// Shaders
+	void SetInputLayout(ID3D11InputLayout* inputLayout);
+	void SetVertexShader(ID3D11VertexShader* shader);
+	void SetHullShader(ID3D11HullShader* shader);
+	void SetDomainShader(ID3D11DomainShader* shader);
+	void SetGeometryShader(ID3D11GeometryShader* shader);
+	void SetPixelShader(ID3D11PixelShader* shader);
+	void SetComputeShader(ID3D11ComputeShader* shader);
+
+	// Per-stage resources, sent on the next Flush()
+	void SetConstantBuffer(ShaderStage stage, UINT slot, ID3D11Buffer* buffer, UINT firstConstant = 0, UINT constantCount = 0);
+	void SetShaderResource(ShaderStage stage, UINT slot, ID3D11ShaderResourceView* srv);
+	void SetSampler(ShaderStage stage, UINT slot, ID3D11SamplerState* sampler);
+
+	// Input assembler
+	void SetVertexBuffer(UINT slot, ID3D11Buffer* buffer, UINT stride, UINT offset);
+	void SetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT format, UINT offset);
+	void SetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY topology);
+
+	// Output merger and rasterizer
+	void SetRenderTargets(UINT count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView* dsv);
+	void SetBlendState(ID3D11BlendState* state, const FLOAT blendFactor[4], UINT sampleMask);
+	void SetDepthStencilState(ID3D11DepthStencilState* state, UINT stencilRef);
+	void SetRasterizerState(ID3D11RasterizerState* state);
+
+	///<summary>
+	///Send every held constant buffer, SRV and sampler binding.
+	///</summary>
+	void Flush();
+
+	// Flush, then draw or dispatch
+	void Draw(UINT vertexCount, UINT startVertex);
+	void DrawIndexed(UINT indexCount, UINT startIndex, INT baseVertex);
+	void Dispatch(UINT groupsX, UINT groupsY, UINT groupsZ);
+
+	const DeviceStateStats& GetStats();
+	void ResetStats();
+
+private:
+	// One stage's slots of one kind: what the device has, and what's waiting to be sent
+	template<typename T, unsigned int N>
+	struct SlotTable
+	{
+		T Bound[N];
+		T Pending[N];
+		bool Known[N];		// Bound matches the device
+		bool Dirty[N];		// Pending differs from Bound
+	};
+
+	template<typename T, unsigned int N>
+	void SetSlot(SlotTable<T, N>& table, UINT slot, const T& value);
+
+	template<typename T, unsigned int N, typename Issue>
+	void FlushSlots(SlotTable<T, N>& table, Issue issue);
+
+	// Send bindings straight to the context
+	void IssueConstantBuffers(ShaderStage stage, UINT start, UINT count, const ConstantBufferBinding* bindings);
+	void IssueShaderResources(ShaderStage stage, UINT start, UINT count, ID3D11ShaderResourceView* const* srvs);
+	void IssueSamplers(ShaderStage stage, UINT start, UINT count, ID3D11SamplerState* const* samplers);
+
+	///<summary>
+	///Elide or issue an immediate binding.  Returns true if the call should be made.
+	///</summary>
+	bool Changed(bool& known, bool same);
+
+	ID3D11DeviceContext* context;
+	ID3D11DeviceContext1* context1;	// For constant buffer slices, null before Direct3D 11.1
+
+	SlotTable<ConstantBufferBinding, MaxConstantBuffers> constantBuffers[(int)ShaderStage::Count];
+	SlotTable<ID3D11ShaderResourceView*, MaxShaderResources> shaderResources[(int)ShaderStage::Count];
+	SlotTable<ID3D11SamplerState*, MaxSamplers> samplers[(int)ShaderStage::Count];
+	bool pendingBindings;	// Anything Dirty in the tables above
+
+	ID3D11DeviceChild* shaders[(int)ShaderStage::Count];
+	bool shaderKnown[(int)ShaderStage::Count];
+	ID3D11InputLayout* inputLayout;
+	bool inputLayoutKnown;
+
+	ID3D11Buffer* vertexBuffers[MaxVertexBuffers];
+	UINT vertexStrides[MaxVertexBuffers];
+	UINT vertexOffsets[MaxVertexBuffers];
+	bool vertexBufferKnown[MaxVertexBuffers];
+	ID3D11Buffer* indexBuffer;
+	DXGI_FORMAT indexFormat;
+	UINT indexOffset;
+	bool indexBufferKnown;
+	D3D11_PRIMITIVE_TOPOLOGY topology;
+	bool topologyKnown;
+
+	UINT renderTargetCount;
+	ID3D11RenderTargetView* renderTargets[MaxRenderTargets];
+	ID3D11DepthStencilView* depthStencilView;
+	bool renderTargetsKnown;
+	ID3D11BlendState* blendState;
+	FLOAT blendFactor[4];
+	UINT sampleMask;
+	bool blendStateKnown;
+	ID3D11DepthStencilState* depthStencilState;
+	UINT stencilRef;
+	bool depthStencilStateKnown;
+	ID3D11RasterizerState* rasterizerState;
+	bool rasterizerStateKnown;
+
+	DeviceStateStats stats;
+};
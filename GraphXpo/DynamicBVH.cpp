@@ -0,0 +1,438 @@
+#include "DynamicBVH.h"
+#include <math.h>
+
+using namespace DirectX;
+
+// Left of a node that is on the free list
+static const int FreeNodeMarker = -2;
+
+static float Smaller(float a, float b) { return a < b ? a : b; }
+static float Larger(float a, float b) { return a > b ? a : b; }
+
+static AABB Union(const AABB& a, const AABB& b)
+{
+	return AABB(
+		XMFLOAT3(Smaller(a.Min.x, b.Min.x), Smaller(a.Min.y, b.Min.y), Smaller(a.Min.z, b.Min.z)),
+		XMFLOAT3(Larger(a.Max.x, b.Max.x), Larger(a.Max.y, b.Max.y), Larger(a.Max.z, b.Max.z)));
+}
+
+static float SurfaceArea(const AABB& box)
+{
+	float x = box.Max.x - box.Min.x;
+	float y = box.Max.y - box.Min.y;
+	float z = box.Max.z - box.Min.z;
+	return 2.0f * (x * y + y * z + z * x);
+}
+
+static bool Contains(const AABB& outer, const AABB& inner)
+{
+	return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y && outer.Min.z <= inner.Min.z &&
+		outer.Max.x >= inner.Max.x && outer.Max.y >= inner.Max.y && outer.Max.z >= inner.Max.z;
+}
+
+static bool BoxesTouch(const AABB& a, const AABB& b)
+{
+	return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x &&
+		a.Min.y <= b.Max.y && a.Max.y >= b.Min.y &&
+		a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+}
+
+DynamicBVH::DynamicBVH()
+{
+	root = NullNode;
+	freeList = NullNode;
+	proxyCount = 0;
+	margin = 0.1f;
+	optimizeCursor = 0;
+	stats = BVHQueryStats();
+	updateStats = DynamicBVHUpdateStats();
+}
+
+void DynamicBVH::SetMargin(float margin)
+{
+	this->margin = margin > 0.0f ? margin : 0.0f;
+}
+
+int DynamicBVH::AllocateNode()
+{
+	int node;
+	if (freeList != NullNode)
+	{
+		node = freeList;
+		freeList = nodes[node].Parent;
+	}
+	else
+	{
+		node = (int)nodes.size();
+		nodes.push_back(DynamicBVHNode());
+	}
+
+	nodes[node].Parent = NullNode;
+	nodes[node].Left = NullNode;
+	nodes[node].Right = NullNode;
+	nodes[node].Id = 0;
+	return node;
+}
+
+void DynamicBVH::FreeNode(int node)
+{
+	nodes[node].Parent = freeList;
+	nodes[node].Left = FreeNodeMarker;
+	freeList = node;
+}
+
+int DynamicBVH::CreateProxy(const AABB& bounds, unsigned int id)
+{
+	int leaf = AllocateNode();
+	nodes[leaf].Bounds = bounds;
+	nodes[leaf].Bounds.Expand(margin);
+	nodes[leaf].Id = id;
+
+	InsertLeaf(leaf);
+	proxyCount++;
+	return leaf;
+}
+
+void DynamicBVH::DestroyProxy(int proxy)
+{
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	proxyCount--;
+}
+
+bool DynamicBVH::MoveProxy(int proxy, const AABB& bounds)
+{
+	updateStats.Moves++;
+
+	// Still inside its fat bounds - nothing to do
+	if (Contains(nodes[proxy].Bounds, bounds))
+		return false;
+
+	RemoveLeaf(proxy);
+	nodes[proxy].Bounds = bounds;
+	nodes[proxy].Bounds.Expand(margin);
+	InsertLeaf(proxy);
+
+	updateStats.Reinserts++;
+	return true;
+}
+
+void DynamicBVH::InsertLeaf(int leaf)
+{
+	if (root == NullNode)
+	{
+		root = leaf;
+		nodes[leaf].Parent = NullNode;
+		return;
+	}
+
+	// Walk down towards the sibling that adds the least surface area.  Whatever is
+	// passed on the way grows to hold the leaf, which every choice pays for.
+	AABB leafBounds = nodes[leaf].Bounds;
+	int sibling = root;
+	while (nodes[sibling].Left != NullNode)
+	{
+		const DynamicBVHNode& node = nodes[sibling];
+		float area = SurfaceArea(node.Bounds);
+		float combinedArea = SurfaceArea(Union(node.Bounds, leafBounds));
+
+		// Pairing with this node makes a new parent here
+		float cost = 2.0f * combinedArea;
+		float inheritedCost = 2.0f * (combinedArea - area);
+
+		float childCosts[2];
+		int children[2] = { node.Left, node.Right };
+		for (int c = 0; c < 2; c++)
+		{
+			const DynamicBVHNode& child = nodes[children[c]];
+			float grownArea = SurfaceArea(Union(child.Bounds, leafBounds));
+			childCosts[c] = child.Left == NullNode ?
+				grownArea + inheritedCost :
+				grownArea - SurfaceArea(child.Bounds) + inheritedCost;
+		}
+
+		if (cost < childCosts[0] && cost < childCosts[1])
+			break;
+
+		sibling = childCosts[0] < childCosts[1] ? children[0] : children[1];
+	}
+
+	// May move the node array, so nothing above holds on to a node
+	int newParent = AllocateNode();
+	int oldParent = nodes[sibling].Parent;
+	nodes[newParent].Parent = oldParent;
+	nodes[newParent].Left = sibling;
+	nodes[newParent].Right = leaf;
+	nodes[newParent].Bounds = Union(nodes[sibling].Bounds, leafBounds);
+	nodes[sibling].Parent = newParent;
+	nodes[leaf].Parent = newParent;
+
+	if (oldParent == NullNode)
+		root = newParent;
+	else if (nodes[oldParent].Left == sibling)
+		nodes[oldParent].Left = newParent;
+	else
+		nodes[oldParent].Right = newParent;
+
+	Refit(newParent);
+}
+
+void DynamicBVH::RemoveLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = NullNode;
+		return;
+	}
+
+	// The leaf's sibling takes its parent's place
+	int parent = nodes[leaf].Parent;
+	int grandparent = nodes[parent].Parent;
+	int sibling = nodes[parent].Left == leaf ? nodes[parent].Right : nodes[parent].Left;
+
+	nodes[sibling].Parent = grandparent;
+	FreeNode(parent);
+
+	if (grandparent == NullNode)
+	{
+		root = sibling;
+		return;
+	}
+
+	if (nodes[grandparent].Left == parent)
+		nodes[grandparent].Left = sibling;
+	else
+		nodes[grandparent].Right = sibling;
+
+	Refit(grandparent);
+}
+
+void DynamicBVH::Refit(int node)
+{
+	while (node != NullNode)
+	{
+		DynamicBVHNode& n = nodes[node];
+		n.Bounds = Union(nodes[n.Left].Bounds, nodes[n.Right].Bounds);
+
+		// A rotation keeps this node's bounds, only a child's change
+		if (Rotate(node))
+			updateStats.Rotations++;
+
+		node = n.Parent;
+	}
+}
+
+bool DynamicBVH::Rotate(int node)
+{
+	int children[2] = { nodes[node].Left, nodes[node].Right };
+
+	// Each child may swap with a child of its sibling.  The sibling then holds the
+	// first child and the grandchild left behind - keep whichever swap shrinks it most.
+	float bestSaving = 0.0f;
+	int bestChild = NullNode;
+	int bestGrandchild = NullNode;
+	for (int c = 0; c < 2; c++)
+	{
+		int child = children[c];
+		int other = children[1 - c];
+		const DynamicBVHNode& otherNode = nodes[other];
+		if (otherNode.Left == NullNode)
+			continue;
+
+		float otherArea = SurfaceArea(otherNode.Bounds);
+		int grandchildren[2] = { otherNode.Left, otherNode.Right };
+		for (int g = 0; g < 2; g++)
+		{
+			int kept = grandchildren[1 - g];
+			float saving = otherArea - SurfaceArea(Union(nodes[child].Bounds, nodes[kept].Bounds));
+			if (saving > bestSaving)
+			{
+				bestSaving = saving;
+				bestChild = child;
+				bestGrandchild = grandchildren[g];
+			}
+		}
+	}
+
+	if (bestChild == NullNode)
+		return false;
+
+	int other = nodes[bestGrandchild].Parent;
+
+	if (nodes[node].Left == bestChild)
+		nodes[node].Left = bestGrandchild;
+	else
+		nodes[node].Right = bestGrandchild;
+	nodes[bestGrandchild].Parent = node;
+
+	if (nodes[other].Left == bestGrandchild)
+		nodes[other].Left = bestChild;
+	else
+		nodes[other].Right = bestChild;
+	nodes[bestChild].Parent = other;
+
+	nodes[other].Bounds = Union(nodes[nodes[other].Left].Bounds, nodes[nodes[other].Right].Bounds);
+	return true;
+}
+
+void DynamicBVH::Optimize(unsigned int rotations)
+{
+	if (nodes.empty())
+		return;
+
+	for (unsigned int i = 0; i < rotations; i++)
+	{
+		if (optimizeCursor >= nodes.size())
+			optimizeCursor = 0;
+
+		// Interior nodes only - leaves and free nodes have nothing to rotate
+		int node = (int)optimizeCursor++;
+		if (nodes[node].Left >= 0 && Rotate(node))
+			updateStats.Rotations++;
+	}
+}
+
+unsigned int DynamicBVH::Cull(const Frustum& frustum, unsigned int* visible)
+{
+	stats = BVHQueryStats();
+	if (root == NullNode)
+		return 0;
+
+	unsigned int visibleCount = 0;
+	stack.clear();
+	TraversalEntry first = { root, 0x3F };
+	stack.push_back(first);
+
+	while (!stack.empty())
+	{
+		TraversalEntry entry = stack.back();
+		stack.pop_back();
+		stats.NodesVisited++;
+
+		const DynamicBVHNode& node = nodes[entry.Node];
+		unsigned int mask = entry.PlaneMask;
+
+		bool outside = false;
+		for (unsigned int p = 0; p < 6 && mask; p++)
+		{
+			if (!(mask & (1u << p)))
+				continue;
+
+			const XMFLOAT4& plane = frustum.planes[p];
+			XMFLOAT3 center = node.Bounds.GetCenter();
+			XMFLOAT3 extents = node.Bounds.GetExtents();
+			float distance = plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w;
+			float reach = fabsf(plane.x) * extents.x + fabsf(plane.y) * extents.y + fabsf(plane.z) * extents.z;
+			if (distance + reach < 0)
+			{
+				outside = true;
+				break;
+			}
+
+			// Wholly on the inside - nothing below needs this plane
+			if (distance - reach >= 0)
+				mask &= ~(1u << p);
+		}
+		if (outside)
+			continue;
+
+		if (node.Left == NullNode)
+		{
+			stats.PrimitivesTested++;
+			visible[visibleCount++] = node.Id;
+			continue;
+		}
+
+		TraversalEntry left = { node.Left, mask };
+		TraversalEntry right = { node.Right, mask };
+		stack.push_back(right);
+		stack.push_back(left);
+	}
+
+	stats.Results = visibleCount;
+	return visibleCount;
+}
+
+unsigned int DynamicBVH::Overlap(const AABB& box, unsigned int* results)
+{
+	stats = BVHQueryStats();
+	if (root == NullNode)
+		return 0;
+
+	unsigned int resultCount = 0;
+	stack.clear();
+	TraversalEntry first = { root, 0 };
+	stack.push_back(first);
+
+	while (!stack.empty())
+	{
+		TraversalEntry entry = stack.back();
+		stack.pop_back();
+		stats.NodesVisited++;
+
+		const DynamicBVHNode& node = nodes[entry.Node];
+		if (!BoxesTouch(node.Bounds, box))
+			continue;
+
+		if (node.Left == NullNode)
+		{
+			stats.PrimitivesTested++;
+			results[resultCount++] = node.Id;
+			continue;
+		}
+
+		TraversalEntry left = { node.Left, 0 };
+		TraversalEntry right = { node.Right, 0 };
+		stack.push_back(right);
+		stack.push_back(left);
+	}
+
+	stats.Results = resultCount;
+	return resultCount;
+}
+
+const AABB& DynamicBVH::GetFatBounds(int proxy)
+{
+	return nodes[proxy].Bounds;
+}
+
+unsigned int DynamicBVH::GetProxyCount()
+{
+	return proxyCount;
+}
+
+int DynamicBVH::GetRoot()
+{
+	return root;
+}
+
+const DynamicBVHNode* DynamicBVH::GetNodes()
+{
+	return nodes.data();
+}
+
+float DynamicBVH::GetCost()
+{
+	float cost = 0.0f;
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		if (nodes[i].Left >= 0)
+			cost += SurfaceArea(nodes[i].Bounds);
+	}
+	return cost;
+}
+
+const BVHQueryStats& DynamicBVH::GetStats()
+{
+	return stats;
+}
+
+const DynamicBVHUpdateStats& DynamicBVH::GetUpdateStats()
+{
+	return updateStats;
+}
+
+void DynamicBVH::ResetUpdateStats()
+{
+	updateStats = DynamicBVHUpdateStats();
+}
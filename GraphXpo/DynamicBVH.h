@@ -0,0 +1,129 @@
+#pragma once
+
+#include <vector>
+#include "Bounds.h"
+#include "SceneBVH.h"
+
+// One node of a DynamicBVH.  Leaves have no children and hold a proxy's fat bounds.
+struct DynamicBVHNode
+{
+	AABB Bounds;
+	int Parent;		// Next free node while on the free list
+	int Left;		// NullNode for a leaf
+	int Right;
+	unsigned int Id;	// Leaves only
+};
+
+// What keeping the tree up to date has cost since the last ResetUpdateStats()
+struct DynamicBVHUpdateStats
+{
+	unsigned int Moves;			// MoveProxy() calls
+	unsigned int Reinserts;		// Moves that left their fat bounds
+	unsigned int Rotations;		// Rotations that made the tree cheaper
+};
+
+// --------------------------------------------------------
+// Bounding volume hierarchy over boxes that move.
+//
+// Each proxy's leaf holds its box grown by a margin - its
+// fat bounds - so small moves change nothing.  A proxy that
+// leaves them is taken out and put back in where it adds
+// the least surface area, and the nodes above it are
+// refitted.  That costs O(log n) per moved proxy, whatever
+// the size of the scene.
+//
+// Refitting lets the tree drift from a good shape as things
+// move.  On the way back up, and a few nodes at a time in
+// Optimize(), a node swaps a child with a grandchild when
+// that shrinks the tree (Kopta et al., "Fast, Effective BVH
+// Updates for Animated Scenes").
+// --------------------------------------------------------
+class DynamicBVH
+{
+public:
+	static const int NullNode = -1;
+
+	DynamicBVH();
+
+	///<summary>
+	///How far fat bounds reach past the box they were made for.  Affects proxies inserted afterwards.
+	///</summary>
+	void SetMargin(float margin);
+
+	///<summary>
+	///Add a box.  Queries return id for it.  Returns the proxy to move or destroy it with.
+	///</summary>
+	int CreateProxy(const AABB& bounds, unsigned int id);
+	void DestroyProxy(int proxy);
+
+	///<summary>
+	///Give a proxy its new box.  Returns true if it left its fat bounds and was reinserted.
+	///</summary>
+	bool MoveProxy(int proxy, const AABB& bounds);
+
+	///<summary>
+	///Try up to rotations more nodes for a rotation, carrying on from where the last call stopped.
+	///</summary>
+	void Optimize(unsigned int rotations);
+
+	///<summary>
+	///Write the ids of the proxies whose fat bounds may be inside the frustum and return how many.
+	///visible must hold GetProxyCount() entries.
+	///</summary>
+	unsigned int Cull(const Frustum& frustum, unsigned int* visible);
+
+	///<summary>
+	///Write the ids of the proxies whose fat bounds touch box and return how many - the
+	///broadphase for a moved proxy.  results must hold GetProxyCount() entries.
+	///</summary>
+	unsigned int Overlap(const AABB& box, unsigned int* results);
+
+	const AABB& GetFatBounds(int proxy);
+	unsigned int GetProxyCount();
+	int GetRoot();
+	const DynamicBVHNode* GetNodes();
+
+	///<summary>
+	///Total surface area of the interior nodes - what a query expects to pay, lower is better.
+	///</summary>
+	float GetCost();
+
+	const BVHQueryStats& GetStats();
+	const DynamicBVHUpdateStats& GetUpdateStats();
+	void ResetUpdateStats();
+
+private:
+	int AllocateNode();
+	void FreeNode(int node);
+
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+
+	///<summary>
+	///Refit every node from node up to the root, rotating each on the way.
+	///</summary>
+	void Refit(int node);
+
+	///<summary>
+	///Swap a child of node with a grandchild under its other child if that leaves the other child smaller.
+	///</summary>
+	bool Rotate(int node);
+
+	// A node still to visit in a query
+	struct TraversalEntry
+	{
+		int Node;
+		unsigned int PlaneMask;	// Frustum planes the node might still cross
+	};
+
+	std::vector<DynamicBVHNode> nodes;
+	int root;
+	int freeList;
+	unsigned int proxyCount;
+	float margin;
+	unsigned int optimizeCursor;
+
+	std::vector<TraversalEntry> stack;
+	BVHQueryStats stats;
+	DynamicBVHUpdateStats updateStats;
+};
@@ -1,7 +1,11 @@
 #include "Emitter.h"
+#include "RadixSort.h"
+#include <algorithm>
+#include <math.h>
 
+using namespace DirectX;
 
-Emitter::Emitter(int maxParticles, int particlesPerSecond, float lifetime, float startSize, float endSize, DirectX::XMFLOAT4 startColor, DirectX::XMFLOAT4 endColor, DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 acceleration, DirectX::XMFLOAT3 startVelocity, DirectX::XMFLOAT3 velocityRandomRange, DirectX::XMFLOAT3 positionRandomRange, DirectX::XMFLOAT4 rotationRandomRanges, ID3D11Device * device, ID3D11ShaderResourceView * texture, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader)
+Emitter::Emitter(int maxParticles, int particlesPerSecond, float lifetime, float startSize, float endSize, DirectX::XMFLOAT4 startColor, DirectX::XMFLOAT4 endColor, DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 acceleration, DirectX::XMFLOAT3 startVelocity, DirectX::XMFLOAT3 velocityRandomRange, DirectX::XMFLOAT3 positionRandomRange, DirectX::XMFLOAT4 rotationRandomRanges, unsigned int seed)
 {
 	// Store variables
 	this->maxParticles = maxParticles;
@@ -18,198 +22,538 @@ Emitter::Emitter(int maxParticles, int particlesPerSecond, float lifetime, float
 	this->velocityRandomRange = velocityRandomRange;
 	this->positionRandomRange = positionRandomRange;
 	this->rotationRandomRanges = rotationRandomRanges;
-	this->texture = texture;
-	this->vertexShader = vertexShader;
-	this->pixelShader = pixelShader;
+	random.Seed(seed);
 
 	timeSinceLastEmit = 0;
+	lastUpdateTime = 0;
+	spawnRateScale = 1.0f;
+	sizeScale = 1.0f;
+	maxSizeScale = 1.0f;
+	maxSize = max(startSize, endSize);
+	curveRow = -1;
+	liveQuota = maxParticles;
+	priority = 1.0f;
+	spawnsRequested = 0;
+	spawnsGranted = 0;
 	liveParticleCount = 0;
 	firstLiveIndex = 0;
 	firstDeadIndex = 0;
+	emitterIndex = 0;
+	pendingUploadCount = 0;
+	bytesUploaded = 0;
+	collider = 0;
 
 	particles = new Particle[maxParticles];
 	ZeroMemory(particles, sizeof(Particle) * maxParticles);
 
-	// Create buffers
-	// Index buffer data
-	unsigned int* indices = new unsigned int[maxParticles * 6];
-	int indexCount = 0;
-	for (int i = 0; i < maxParticles * 4; i += 4)
-	{
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 1;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i;
-		indices[indexCount++] = i + 2;
-		indices[indexCount++] = i + 3;
-	}
-	D3D11_SUBRESOURCE_DATA indexData = {};
-	indexData.pSysMem = indices;
-
-	// Index buffer
-	D3D11_BUFFER_DESC ibDesc = {};
-	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	ibDesc.CPUAccessFlags = 0;
-	ibDesc.Usage = D3D11_USAGE_DEFAULT;
-	ibDesc.ByteWidth = sizeof(unsigned int) * maxParticles * 6;
-	device->CreateBuffer(&ibDesc, &indexData, &indexBuffer);
-
-	D3D11_BUFFER_DESC allParticleBufferDesc = {};
-	allParticleBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-	allParticleBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-	allParticleBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-	allParticleBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-	allParticleBufferDesc.StructureByteStride = sizeof(Particle);
-	allParticleBufferDesc.ByteWidth = sizeof(Particle) * maxParticles;
-	device->CreateBuffer(&allParticleBufferDesc, 0, &particleDataBuffer);
-
-	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
-	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-	srvDesc.Buffer.FirstElement = 0;
-	srvDesc.Buffer.NumElements = maxParticles;
-	device->CreateShaderResourceView(particleDataBuffer, &srvDesc, &particleDataSRV);
-
-	delete[] indices;
+	CalculateBounds();
 }
 
 Emitter::~Emitter()
 {
 	// Clean up Emitter
 	delete[] particles;
-	indexBuffer->Release();
-	particleDataBuffer->Release();
-	particleDataSRV->Release();
 }
 
 void Emitter::Update(float deltaTime, float currentTime)
 {
-	// Update living particles if there are any
-	if (liveParticleCount > 0)
+	lastUpdateTime = currentTime;
+	RetireExpiredParticles(currentTime);
+
+	if (collider)
 	{
-		if (firstLiveIndex < firstDeadIndex)
-		{
-			// Update from firstLiveIndex to firstDeadIndex
-			for (int i = firstLiveIndex; i < firstDeadIndex; i++)
-				UpdateParticle(currentTime, i);
-		}
-		else if (firstDeadIndex < firstLiveIndex)
-		{
-			// Living particles wrap around because the first live particle is after the first dead particle
-			// Updates are done in two halves: firstLiveIndex to maxParticles and 0 to firstDeadIndex
-			for (int i = firstLiveIndex; i < maxParticles; i++)
-				UpdateParticle(currentTime, i);
-			for (int i = 0; i < firstDeadIndex; i++)
-				UpdateParticle(currentTime, i);
-		}
-		else
-		{
-			// Update all particles, since all particles are alive
-			for (int i = 0; i < maxParticles; i++)
-				UpdateParticle(currentTime, i);
-		}
+		// The live Particles may wrap around the end of the array
+		int firstRun = min(liveParticleCount, maxParticles - firstLiveIndex);
+		collider->Collide(particles, firstLiveIndex, firstRun, acceleration, currentTime, dirtyIndices);
+		collider->Collide(particles, 0, liveParticleCount - firstRun, acceleration, currentTime, dirtyIndices);
+	}
+
+	// Nothing to spawn, and nothing should build up to burst out later
+	if (spawnRateScale <= 0.0f)
+	{
+		timeSinceLastEmit = 0;
+		return;
 	}
 
 	timeSinceLastEmit += deltaTime;
+	float spawnInterval = secondsPerParticle / spawnRateScale;
 
 	// Spawn new Particles if enough time has passed
-	while (timeSinceLastEmit > secondsPerParticle)
+	if (timeSinceLastEmit > spawnInterval)
 	{
-		SpawnParticle(currentTime);
-		timeSinceLastEmit -= secondsPerParticle;
+		int spawnCount = (int)(timeSinceLastEmit / spawnInterval);
+
+		// Spread the spawn times back over the frame, so a long frame
+		// produces an even stream of Particles rather than one clump
+		float firstSpawnTime = currentTime - timeSinceLastEmit + spawnInterval;
+		SpawnBatch(spawnCount, firstSpawnTime, spawnInterval);
+
+		timeSinceLastEmit -= spawnCount * spawnInterval;
 	}
 }
 
-void Emitter::UpdateParticle(float currentTime, int index)
+void Emitter::FastForward(float currentTime)
 {
-	// Kill the particle if it has outlived the lifetime
-	if (currentTime - particles[index].SpawnTime >= lifetime) {
-		firstLiveIndex = (firstLiveIndex + 1) % maxParticles;
-		liveParticleCount--;
+	float elapsed = currentTime - lastUpdateTime;
+	lastUpdateTime = currentTime;
+	RetireExpiredParticles(currentTime);
+
+	if (elapsed <= 0)
+		return;
+	if (spawnRateScale <= 0.0f)
+	{
+		timeSinceLastEmit = 0;
 		return;
 	}
+
+	// Every spawn Update would have made over the whole gap
+	float spawnInterval = secondsPerParticle / spawnRateScale;
+	timeSinceLastEmit += elapsed;
+	int spawnCount = (int)(timeSinceLastEmit / spawnInterval);
+	if (spawnCount <= 0)
+		return;
+
+	float firstSpawnTime = currentTime - timeSinceLastEmit + spawnInterval;
+	timeSinceLastEmit -= spawnCount * spawnInterval;
+
+	// Skip the ones that would already have died, and any that wouldn't fit
+	int capacity = min(maxParticles, liveQuota);
+	int expired = (int)floorf((currentTime - lifetime - firstSpawnTime) / spawnInterval) + 1;
+	expired = max(expired, spawnCount - capacity);
+	expired = max(0, min(expired, spawnCount));
+	int aliveCount = spawnCount - expired;
+
+	// The new Particles are younger than anything already alive, so make room by
+	// retiring the oldest ones, as they would have died first anyway
+	int overflow = min(aliveCount - (capacity - liveParticleCount), liveParticleCount);
+	if (overflow > 0)
+	{
+		firstLiveIndex = (firstLiveIndex + overflow) % maxParticles;
+		liveParticleCount -= overflow;
+	}
+
+	SpawnBatch(aliveCount, firstSpawnTime + expired * spawnInterval, spawnInterval);
+}
+
+void Emitter::Prewarm(float duration, float currentTime)
+{
+	// Start over from an empty Emitter
+	firstLiveIndex = firstDeadIndex;
+	liveParticleCount = 0;
+	timeSinceLastEmit = 0;
+
+	lastUpdateTime = currentTime - duration;
+	FastForward(currentTime);
+}
+
+void Emitter::RetireExpiredParticles(float currentTime)
+{
+	// Particles are spawned in order, so the live window is sorted by SpawnTime
+	// and the expired ones are always a run at its start.  Binary search for
+	// the first Particle that is still alive.
+	int low = 0;
+	int high = liveParticleCount;
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (currentTime - particles[(firstLiveIndex + mid) % maxParticles].SpawnTime >= lifetime)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	// Kill every particle before it
+	firstLiveIndex = (firstLiveIndex + low) % maxParticles;
+	liveParticleCount -= low;
 }
 
 void Emitter::SpawnParticle(float currentTime)
 {
-	// Only spawn if we have space for more Particles
-	if (liveParticleCount == maxParticles)
+	SpawnBatch(1, currentTime, 0.0f);
+}
+
+void Emitter::SpawnBatch(int count, float spawnTime, float spawnInterval)
+{
+	spawnsRequested += max(count, 0);
+
+	// Only spawn as many as we have space and budget for
+	count = min(count, min(maxParticles, liveQuota) - liveParticleCount);
+	if (count <= 0)
 		return;
+	spawnsGranted += count;
 
-	// Reset the first dead particle
-	particles[firstDeadIndex].SpawnTime = currentTime;
+	// The dead Particles are contiguous in the ring, but may wrap around the end of the array
+	int firstRun = min(count, maxParticles - firstDeadIndex);
+	FillParticles(firstDeadIndex, firstRun, spawnTime, spawnInterval);
+	if (count > firstRun)
+		FillParticles(0, count - firstRun, spawnTime + firstRun * spawnInterval, spawnInterval);
 
-	particles[firstDeadIndex].StartPosition = position;
-	particles[firstDeadIndex].StartPosition.x += (((float)rand() / RAND_MAX) * 2 - 1) * positionRandomRange.x;
-	particles[firstDeadIndex].StartPosition.y += (((float)rand() / RAND_MAX) * 2 - 1) * positionRandomRange.y;
-	particles[firstDeadIndex].StartPosition.z += (((float)rand() / RAND_MAX) * 2 - 1) * positionRandomRange.z;
+	// Increment firstDeadIndex and liveParticleCount
+	firstDeadIndex = (firstDeadIndex + count) % maxParticles;
+	liveParticleCount += count;
 
-	particles[firstDeadIndex].StartVelocity = startVelocity;
-	particles[firstDeadIndex].StartVelocity.x += (((float)rand() / RAND_MAX) * 2 - 1) * velocityRandomRange.x;
-	particles[firstDeadIndex].StartVelocity.y += (((float)rand() / RAND_MAX) * 2 - 1) * velocityRandomRange.y;
-	particles[firstDeadIndex].StartVelocity.z += (((float)rand() / RAND_MAX) * 2 - 1) * velocityRandomRange.z;
+	// Remember how many new Particles the GPU has yet to see
+	pendingUploadCount = min(pendingUploadCount + count, maxParticles);
+}
 
-	float rotStartMin = rotationRandomRanges.x;
-	float rotStartMax = rotationRandomRanges.y;
-	particles[firstDeadIndex].RotationStart = ((float)rand() / RAND_MAX) * (rotStartMax - rotStartMin) + rotStartMin;
+void Emitter::FillParticles(int start, int count, float spawnTime, float spawnInterval)
+{
+	XMVECTOR laneOffsets = XMVectorSet(0, 1, 2, 3);
+	XMVECTOR interval = XMVectorReplicate(spawnInterval);
+	XMVECTOR firstTime = XMVectorReplicate(spawnTime);
 
-	float rotEndMin = rotationRandomRanges.z;
-	float rotEndMax = rotationRandomRanges.w;
-	particles[firstDeadIndex].RotationEnd = ((float)rand() / RAND_MAX) * (rotEndMax - rotEndMin) + rotEndMin;
+	XMVECTOR positionX = XMVectorReplicate(position.x);
+	XMVECTOR positionY = XMVectorReplicate(position.y);
+	XMVECTOR positionZ = XMVectorReplicate(position.z);
+	XMVECTOR positionRangeX = XMVectorReplicate(positionRandomRange.x);
+	XMVECTOR positionRangeY = XMVectorReplicate(positionRandomRange.y);
+	XMVECTOR positionRangeZ = XMVectorReplicate(positionRandomRange.z);
 
-	// Increment firstDeadIndex and liveParticleCount
-	firstDeadIndex = (firstDeadIndex + 1) % maxParticles;
-	liveParticleCount++;
-}
-
-void Emitter::Draw(ID3D11DeviceContext * context, Camera * camera, float currentTime)
-{
-	// Set up buffers
-	D3D11_MAPPED_SUBRESOURCE mapped = {};
-	context->Map(particleDataBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
-	memcpy(mapped.pData, particles, sizeof(Particle) * maxParticles);
-	context->Unmap(particleDataBuffer, 0);
-
-	UINT stride = 0;
-	UINT offset = 0;
-	ID3D11Buffer* nullBuffer = 0;
-	context->IASetVertexBuffers(0, 1, &nullBuffer, &stride, &offset);
-	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-	// Set shaders
-	vertexShader->SetMatrix4x4("view", camera->GetViewMatrix());
-	vertexShader->SetMatrix4x4("projection", camera->GetProjectionMatrix());
-	vertexShader->SetFloat3("acceleration", acceleration);
-	vertexShader->SetFloat4("startColor", startColor);
-	vertexShader->SetFloat4("endColor", endColor);
-	vertexShader->SetFloat("startSize", startSize);
-	vertexShader->SetFloat("endSize", endSize);
-	vertexShader->SetFloat("lifetime", lifetime);
-	vertexShader->SetFloat("currentTime", currentTime);
-	vertexShader->SetShader();
-
-	context->VSSetShaderResources(0, 1, &particleDataSRV);
-	pixelShader->SetShaderResourceView("particle", texture);
-	pixelShader->SetShader();
-
-	// Draw Particles
-	if (firstLiveIndex < firstDeadIndex)
+	XMVECTOR velocityX = XMVectorReplicate(startVelocity.x);
+	XMVECTOR velocityY = XMVectorReplicate(startVelocity.y);
+	XMVECTOR velocityZ = XMVectorReplicate(startVelocity.z);
+	XMVECTOR velocityRangeX = XMVectorReplicate(velocityRandomRange.x);
+	XMVECTOR velocityRangeY = XMVectorReplicate(velocityRandomRange.y);
+	XMVECTOR velocityRangeZ = XMVectorReplicate(velocityRandomRange.z);
+
+	// Rotation ranges are (startMin, startMax, endMin, endMax)
+	XMVECTOR rotStartMin = XMVectorReplicate(rotationRandomRanges.x);
+	XMVECTOR rotStartRange = XMVectorReplicate(rotationRandomRanges.y - rotationRandomRanges.x);
+	XMVECTOR rotEndMin = XMVectorReplicate(rotationRandomRanges.z);
+	XMVECTOR rotEndRange = XMVectorReplicate(rotationRandomRanges.w - rotationRandomRanges.z);
+
+	// Generate four Particles per pass, one per SIMD lane
+	for (int i = 0; i < count; i += 4)
+	{
+		XMVECTORF32 spawnTimes;
+		XMVECTORF32 posX, posY, posZ;
+		XMVECTORF32 velX, velY, velZ;
+		XMVECTORF32 rotStart, rotEnd;
+
+		XMVECTOR laneIndex = XMVectorAdd(XMVectorReplicate((float)i), laneOffsets);
+		spawnTimes.v = XMVectorMultiplyAdd(laneIndex, interval, firstTime);
+
+		posX.v = XMVectorMultiplyAdd(random.NextSignedFloat4(), positionRangeX, positionX);
+		posY.v = XMVectorMultiplyAdd(random.NextSignedFloat4(), positionRangeY, positionY);
+		posZ.v = XMVectorMultiplyAdd(random.NextSignedFloat4(), positionRangeZ, positionZ);
+
+		velX.v = XMVectorMultiplyAdd(random.NextSignedFloat4(), velocityRangeX, velocityX);
+		velY.v = XMVectorMultiplyAdd(random.NextSignedFloat4(), velocityRangeY, velocityY);
+		velZ.v = XMVectorMultiplyAdd(random.NextSignedFloat4(), velocityRangeZ, velocityZ);
+
+		rotStart.v = XMVectorMultiplyAdd(random.NextFloat4(), rotStartRange, rotStartMin);
+		rotEnd.v = XMVectorMultiplyAdd(random.NextFloat4(), rotEndRange, rotEndMin);
+
+		// Scatter the lanes into the Particle structs
+		int lanes = min(4, count - i);
+		for (int l = 0; l < lanes; l++)
+		{
+			Particle* p = &particles[start + i + l];
+			p->SpawnTime = spawnTimes.f[l];
+			p->StartPosition = XMFLOAT3(posX.f[l], posY.f[l], posZ.f[l]);
+			p->StartVelocity = XMFLOAT3(velX.f[l], velY.f[l], velZ.f[l]);
+			p->RotationStart = rotStart.f[l];
+			p->RotationEnd = rotEnd.f[l];
+			p->EmitterIndex = emitterIndex;
+			p->Flags = 0;
+		}
+	}
+}
+
+void Emitter::Seed(unsigned int seed)
+{
+	random.Seed(seed);
+}
+
+void Emitter::UploadPending(ID3D11DeviceContext * context, ID3D11Buffer * buffer, int baseIndex)
+{
+	bytesUploaded = 0;
+
+	// So many Particles were hit that sending all of them is simpler
+	if ((int)dirtyIndices.size() >= liveParticleCount)
+		pendingUploadCount = maxParticles;
+
+	// Anything spawned and already dead since the last upload will never be drawn
+	int count = min(pendingUploadCount, liveParticleCount);
+	pendingUploadCount = 0;
+	if (count >= liveParticleCount)
+		dirtyIndices.clear();
+	UploadDirty(context, buffer, baseIndex);
+	if (count <= 0)
+		return;
+
+	// The new Particles are the last count entries before firstDeadIndex,
+	// which may wrap around the end of the array
+	int start = (firstDeadIndex - count + maxParticles) % maxParticles;
+	int firstRun = min(count, maxParticles - start);
+	UploadRange(context, buffer, baseIndex, start, firstRun);
+	if (count > firstRun)
+		UploadRange(context, buffer, baseIndex, 0, count - firstRun);
+}
+
+void Emitter::UploadDirty(ID3D11DeviceContext * context, ID3D11Buffer * buffer, int baseIndex)
+{
+	if (dirtyIndices.empty())
+		return;
+
+	// A Particle can be hit on several frames between uploads
+	std::sort(dirtyIndices.begin(), dirtyIndices.end());
+	dirtyIndices.erase(std::unique(dirtyIndices.begin(), dirtyIndices.end()), dirtyIndices.end());
+
+	// Send each run of neighbouring Particles in one go
+	size_t runStart = 0;
+	for (size_t i = 1; i <= dirtyIndices.size(); i++)
+	{
+		if (i < dirtyIndices.size() && dirtyIndices[i] == dirtyIndices[i - 1] + 1)
+			continue;
+
+		UploadRange(context, buffer, baseIndex, dirtyIndices[runStart], (int)(i - runStart));
+		runStart = i;
+	}
+
+	dirtyIndices.clear();
+}
+
+void Emitter::UploadRange(ID3D11DeviceContext * context, ID3D11Buffer * buffer, int baseIndex, int start, int count)
+{
+	D3D11_BOX box = {};
+	box.left = sizeof(Particle) * (baseIndex + start);
+	box.right = sizeof(Particle) * (baseIndex + start + count);
+	box.top = 0;
+	box.bottom = 1;
+	box.front = 0;
+	box.back = 1;
+	context->UpdateSubresource(buffer, 0, &box, &particles[start], 0, 0);
+
+	bytesUploaded += sizeof(Particle) * count;
+}
+
+void Emitter::InvalidateUploads()
+{
+	pendingUploadCount = maxParticles;
+	dirtyIndices.clear();
+}
+
+int Emitter::WriteDrawList(unsigned int * drawList, unsigned int baseIndex)
+{
+	// Live Particles run from firstLiveIndex, possibly wrapping around the end of the array
+	int firstRun = min(liveParticleCount, maxParticles - firstLiveIndex);
+	for (int i = 0; i < firstRun; i++)
+		drawList[i] = baseIndex + firstLiveIndex + i;
+	for (int i = firstRun; i < liveParticleCount; i++)
+		drawList[i] = baseIndex + i - firstRun;
+
+	return liveParticleCount;
+}
+
+void Emitter::WriteSortKeys(unsigned int * sortKeys, unsigned int * drawList, unsigned int baseIndex, int first, int count, DirectX::XMFLOAT4 depthAxis, float currentTime)
+{
+	for (int i = 0; i < count; i++)
 	{
-		// Draw from firstLiveIndex to firstDeadIndex
-		vertexShader->SetInt("startIndex", firstLiveIndex);
-		vertexShader->CopyAllBufferData();
-		context->DrawIndexed(liveParticleCount * 6, 0, 0);
+		int index = (firstLiveIndex + first + i) % maxParticles;
+		Particle* p = &particles[index];
+
+		// Same closed-form position as ParticleVertexShader.hlsl
+		float t = currentTime - p->SpawnTime;
+		float halfTSquared = t * t / 2.0f;
+		float x = acceleration.x * halfTSquared + p->StartVelocity.x * t + p->StartPosition.x;
+		float y = acceleration.y * halfTSquared + p->StartVelocity.y * t + p->StartPosition.y;
+		float z = acceleration.z * halfTSquared + p->StartVelocity.z * t + p->StartPosition.z;
+		float depth = x * depthAxis.x + y * depthAxis.y + z * depthAxis.z + depthAxis.w;
+
+		// Invert so the farthest Particles come first in ascending order
+		sortKeys[i] = ~FloatToSortKey(depth);
+		drawList[i] = baseIndex + index;
 	}
-	else
+}
+
+void Emitter::SetEmitterIndex(unsigned int index)
+{
+	emitterIndex = index;
+
+	// Restamp the Particles that are already alive
+	for (int i = 0; i < maxParticles; i++)
+		particles[i].EmitterIndex = index;
+	InvalidateUploads();
+}
+
+EmitterParams Emitter::GetParams()
+{
+	EmitterParams params = {};
+	params.Acceleration = acceleration;
+	params.Lifetime = lifetime;
+	params.SizeScale = sizeScale;
+	params.CurveRow = (unsigned int)max(curveRow, 0);
+	return params;
+}
+
+int Emitter::GetMaxParticles()
+{
+	return maxParticles;
+}
+
+int Emitter::GetLiveParticleCount()
+{
+	return liveParticleCount;
+}
+
+AABB Emitter::GetBounds()
+{
+	return bounds;
+}
+
+void Emitter::SetSpawnRateScale(float scale)
+{
+	spawnRateScale = scale;
+}
+
+void Emitter::SetSizeScale(float scale)
+{
+	sizeScale = scale;
+
+	if (scale > maxSizeScale)
+		SetMaxSizeScale(scale);
+}
+
+void Emitter::SetMaxSizeScale(float scale)
+{
+	maxSizeScale = scale;
+	CalculateBounds();
+}
+
+void Emitter::UseCurve(ParticleCurveAtlas * atlas, int row)
+{
+	curveRow = row;
+
+	// The curve decides how big Particles get
+	maxSize = atlas->GetMaxSize(row);
+	CalculateBounds();
+}
+
+void Emitter::UseLinearCurve(ParticleCurveAtlas * atlas)
+{
+	UseCurve(atlas, atlas->AddLinearRow(startColor, endColor, startSize, endSize));
+}
+
+int Emitter::GetCurveRow()
+{
+	return curveRow;
+}
+
+void Emitter::SetLiveQuota(int quota)
+{
+	liveQuota = max(quota, 0);
+
+	// A cap, not just a limit on spawning - retire the oldest Particles
+	// over it now, as they would have died first anyway
+	int overflow = liveParticleCount - min(maxParticles, liveQuota);
+	if (overflow > 0)
+	{
+		firstLiveIndex = (firstLiveIndex + overflow) % maxParticles;
+		liveParticleCount -= overflow;
+	}
+}
+
+void Emitter::SetPriority(float priority)
+{
+	this->priority = priority;
+}
+
+float Emitter::GetPriority()
+{
+	return priority;
+}
+
+int Emitter::GetSteadyStateCount()
+{
+	return min(maxParticles, (int)ceilf(particlesPerSecond * lifetime));
+}
+
+int Emitter::GetSpawnsRequested()
+{
+	return spawnsRequested;
+}
+
+int Emitter::GetSpawnsGranted()
+{
+	return spawnsGranted;
+}
+
+void Emitter::ResetSpawnCounters()
+{
+	spawnsRequested = 0;
+	spawnsGranted = 0;
+}
+
+// Smallest and largest value of p + v*t + a*t*t/2 over t in [0, lifetime],
+// for any p in [pMin, pMax] and v in [vMin, vMax]
+static void DisplacementRange(float pMin, float pMax, float vMin, float vMax, float a, float lifetime, float* outMin, float* outMax)
+{
+	float low = 0;
+	float high = 0;
+
+	// The displacement is linear in v, so only the extreme velocities matter.
+	// For each, the quadratic in t peaks at the ends or where v + a*t = 0.
+	float velocities[2] = { vMin, vMax };
+	for (int i = 0; i < 2; i++)
+	{
+		float v = velocities[i];
+		float times[3] = { 0, lifetime, lifetime };
+		if (a != 0 && -v / a > 0 && -v / a < lifetime)
+			times[2] = -v / a;
+
+		for (int j = 0; j < 3; j++)
+		{
+			float t = times[j];
+			float d = v * t + a * t * t / 2.0f;
+			low = min(low, d);
+			high = max(high, d);
+		}
+	}
+
+	*outMin = pMin + low;
+	*outMax = pMax + high;
+}
+
+void Emitter::CalculateBounds()
+{
+	XMFLOAT3 minimum, maximum;
+	DisplacementRange(
+		position.x - positionRandomRange.x, position.x + positionRandomRange.x,
+		startVelocity.x - velocityRandomRange.x, startVelocity.x + velocityRandomRange.x,
+		acceleration.x, lifetime, &minimum.x, &maximum.x);
+	DisplacementRange(
+		position.y - positionRandomRange.y, position.y + positionRandomRange.y,
+		startVelocity.y - velocityRandomRange.y, startVelocity.y + velocityRandomRange.y,
+		acceleration.y, lifetime, &minimum.y, &maximum.y);
+	DisplacementRange(
+		position.z - positionRandomRange.z, position.z + positionRandomRange.z,
+		startVelocity.z - velocityRandomRange.z, startVelocity.z + velocityRandomRange.z,
+		acceleration.z, lifetime, &minimum.z, &maximum.z);
+
+	bounds = AABB(minimum, maximum);
+
+	// A bounce can turn a Particle around, so also cover the flight mirrored
+	// through the Emitter.  Bounces lose speed, so this is enough in practice.
+	if (collider && collider->GetResponse() == ParticleCollisionResponse::Bounce)
 	{
-		// Living particles wrap around because the first live particle is after the first dead particle
-		// Draws are done in two halves: firstLiveIndex to maxParticles and 0 to firstDeadIndex
-		vertexShader->SetInt("startIndex", firstLiveIndex);
-		vertexShader->CopyAllBufferData();
-		context->DrawIndexed((maxParticles - firstLiveIndex) * 6, 0, 0);
-
-		vertexShader->SetInt("startIndex", 0);
-		vertexShader->CopyAllBufferData();
-		context->DrawIndexed(firstDeadIndex * 6, 0, 0);
+		bounds.Encapsulate(XMFLOAT3(2 * position.x - maximum.x, 2 * position.y - maximum.y, 2 * position.z - maximum.z));
+		bounds.Encapsulate(XMFLOAT3(2 * position.x - minimum.x, 2 * position.y - minimum.y, 2 * position.z - minimum.z));
 	}
+
+	// Quads reach size * sqrt(2) from their center when rotated 45 degrees
+	bounds.Expand(maxSize * maxSizeScale * sqrtf(2.0f));
+}
+
+void Emitter::SetCollider(ParticleCollider * collider)
+{
+	this->collider = collider;
+
+	// Bounces can send Particles back the way they came
+	CalculateBounds();
+}
+
+unsigned int Emitter::GetBytesUploaded()
+{
+	return bytesUploaded;
 }
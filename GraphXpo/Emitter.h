@@ -2,9 +2,11 @@
 
 #include <d3d11.h>
 #include <DirectXMath.h>
-#include <memory>
-#include "Camera.h"
-#include "SimpleShader.h"
+#include "Bounds.h"
+#include "ParticleCurveAtlas.h"
+#include "ParticleRandom.h"
+#include "ParticleCollider.h"
+#include <vector>
 
 struct Particle
 {
@@ -15,7 +17,26 @@ struct Particle
 	float RotationStart;
 
 	float RotationEnd;
-	DirectX::XMFLOAT3 padding;
+	unsigned int EmitterIndex;	// Row of the ParticleSystem's EmitterParams table
+	unsigned int Flags;			// ParticleFlags
+	float padding;
+};
+
+enum ParticleFlags : unsigned int
+{
+	ParticleFlagKilled = 1		// Hidden until it expires, e.g. after hitting a Kill collider
+};
+
+// Per-Emitter values shared by all of its Particles, as laid out in the
+// ParticleSystem's structured buffer
+struct EmitterParams
+{
+	DirectX::XMFLOAT3 Acceleration;
+	float Lifetime;
+
+	float SizeScale;
+	unsigned int CurveRow;		// Row of the ParticleCurveAtlas with color, size and rotation over life
+	DirectX::XMFLOAT2 padding;
 };
 
 class Emitter
@@ -35,10 +56,7 @@ public:
 		DirectX::XMFLOAT3 velocityRandomRange,
 		DirectX::XMFLOAT3 positionRandomRange,
 		DirectX::XMFLOAT4 rotationRandomRanges,
-		ID3D11Device* device,
-		ID3D11ShaderResourceView* texture,
-		std::shared_ptr<SimpleVertexShader> vertexShader,
-		std::shared_ptr<SimplePixelShader> pixelShader
+		unsigned int seed = 0
 	);
 	~Emitter();
 
@@ -48,9 +66,16 @@ public:
 	void Update(float deltaTime, float currentTime);
 
 	///<summary>
-	///Update the Particle at the given index.
+	///Bring the Emitter from its last Update to currentTime in one step, directly creating
+	///the Particles that would be alive now.  Costs O(live Particles) however long it slept.
+	///</summary>
+	void FastForward(float currentTime);
+
+	///<summary>
+	///Replace all Particles with those of an Emitter that has been running for duration seconds
+	///by currentTime, so it starts in its steady state rather than empty.
 	///</summary>
-	void UpdateParticle(float currentTime, int index);
+	void Prewarm(float duration, float currentTime);
 
 	///<summary>
 	///Spawn a Particle.
@@ -58,14 +83,150 @@ public:
 	void SpawnParticle(float currentTime);
 
 	///<summary>
-	///Draw the Emitter.
+	///Spawn up to count Particles, the first at spawnTime and each following one spawnInterval later.
+	///</summary>
+	void SpawnBatch(int count, float spawnTime, float spawnInterval);
+
+	///<summary>
+	///Restart the Emitter's random sequence, making future spawns reproducible.
+	///</summary>
+	void Seed(unsigned int seed);
+
+	///<summary>
+	///Copy the Particles spawned since the last upload into buffer, starting at element baseIndex.
+	///</summary>
+	void UploadPending(ID3D11DeviceContext* context, ID3D11Buffer* buffer, int baseIndex);
+
+	///<summary>
+	///Mark every live Particle as needing upload, e.g. after the GPU buffer was recreated.
+	///</summary>
+	void InvalidateUploads();
+
+	///<summary>
+	///Write the buffer index (baseIndex + ring index) of every live Particle, oldest first.
+	///Returns the number of indices written.
+	///</summary>
+	int WriteDrawList(unsigned int* drawList, unsigned int baseIndex);
+
+	///<summary>
+	///For count live Particles starting first from the oldest, write their buffer index to drawList
+	///and a key that sorts them back to front along depthAxis (a view matrix row) to sortKeys.
+	///</summary>
+	void WriteSortKeys(unsigned int* sortKeys, unsigned int* drawList, unsigned int baseIndex, int first, int count, DirectX::XMFLOAT4 depthAxis, float currentTime);
+
+	///<summary>
+	///Set which row of the EmitterParams table this Emitter's Particles read.
+	///</summary>
+	void SetEmitterIndex(unsigned int index);
+
+	///<summary>
+	///Get the values shared by all of this Emitter's Particles.
+	///</summary>
+	EmitterParams GetParams();
+
+	int GetMaxParticles();
+	int GetLiveParticleCount();
+
+	///<summary>
+	///A box every Particle this Emitter can spawn stays inside for its whole life, including its size.
+	///</summary>
+	AABB GetBounds();
+
+	///<summary>
+	///Scale how fast Particles spawn (1 = as constructed, 0 = not at all), e.g. for distance LOD.
+	///</summary>
+	void SetSpawnRateScale(float scale);
+
+	///<summary>
+	///Scale the size of every Particle, e.g. for distance LOD.  The bounds grow to fit a scale above the maximum.
+	///</summary>
+	void SetSizeScale(float scale);
+
+	///<summary>
+	///The largest size scale this Emitter will be given, so its bounds still cover its Particles when it is.
+	///</summary>
+	void SetMaxSizeScale(float scale);
+
+	///<summary>
+	///Take color, size and rotation over life from a row of the atlas.
+	///</summary>
+	void UseCurve(ParticleCurveAtlas* atlas, int row);
+
+	///<summary>
+	///Bake the constructor's start and end color and size into a new row of the atlas, and use it.
+	///</summary>
+	void UseLinearCurve(ParticleCurveAtlas* atlas);
+
+	///<summary>
+	///The atlas row in use, or -1 before one is chosen.
+	///</summary>
+	int GetCurveRow();
+
+	///<summary>
+	///Hard cap on live Particles (below maxParticles), set by the ParticleSystem's budget.
+	///Lowering it retires the oldest Particles over the new cap straight away; negative means 0.
+	///</summary>
+	void SetLiveQuota(int quota);
+
+	///<summary>
+	///How important this Emitter is when the particle budget runs short (default 1).
+	///</summary>
+	void SetPriority(float priority);
+	float GetPriority();
+
+	///<summary>
+	///Live Particles this Emitter settles at when spawning at full rate.
+	///</summary>
+	int GetSteadyStateCount();
+
+	///<summary>
+	///Spawns asked for and actually made since the last ResetSpawnCounters.
+	///</summary>
+	int GetSpawnsRequested();
+	int GetSpawnsGranted();
+	void ResetSpawnCounters();
+
+	///<summary>
+	///Collide Particles with collider every Update, or stop colliding if it's null.  Not owned by the Emitter.
 	///</summary>
-	void Draw(ID3D11DeviceContext* context, Camera* camera, float currentTime);
+	void SetCollider(ParticleCollider* collider);
+
+	///<summary>
+	///Number of bytes of Particle data sent to the GPU by the most recent upload.
+	///</summary>
+	unsigned int GetBytesUploaded();
 
 private:
+	///<summary>
+	///Copy the Particles changed by collisions into buffer, a run of neighbours at a time.
+	///</summary>
+	void UploadDirty(ID3D11DeviceContext* context, ID3D11Buffer* buffer, int baseIndex);
+
+	///<summary>
+	///Copy a contiguous run of the Particle array into buffer.
+	///</summary>
+	void UploadRange(ID3D11DeviceContext* context, ID3D11Buffer* buffer, int baseIndex, int start, int count);
+
+	///<summary>
+	///Retire every Particle that has outlived its lifetime.
+	///</summary>
+	void RetireExpiredParticles(float currentTime);
+
+	///<summary>
+	///Work out the Emitter's bounds from its spawn ranges, acceleration and lifetime.
+	///</summary>
+	void CalculateBounds();
+
+	///<summary>
+	///Fill a contiguous run of the Particle array with freshly spawned Particles.
+	///</summary>
+	void FillParticles(int start, int count, float spawnTime, float spawnInterval);
+
 	int particlesPerSecond;
 	float secondsPerParticle;
 	float timeSinceLastEmit;
+	float lastUpdateTime;
+	float spawnRateScale;
 
 	int liveParticleCount;
 	float lifetime;
@@ -79,6 +240,8 @@ private:
 	DirectX::XMFLOAT3 velocityRandomRange;
 	DirectX::XMFLOAT4 rotationRandomRanges;
 
+	ParticleRandom random;	// Per-Emitter random stream
+
 	// Particle Color
 	DirectX::XMFLOAT4 startColor;
 	DirectX::XMFLOAT4 endColor;
@@ -86,18 +249,31 @@ private:
 	// Particle Size
 	float startSize;
 	float endSize;
+	float sizeScale;
+	float maxSizeScale;	// Largest sizeScale expected, for the bounds
+	float maxSize;		// Largest size over life, for the bounds
+
+	int curveRow;
+
+	AABB bounds;
+
+	// Budget
+	int liveQuota;
+	float priority;
+	int spawnsRequested;
+	int spawnsGranted;
 
 	Particle* particles;	// Array of Particles
 	int maxParticles;		// Maximum number of Particles from this Emitter
 	int firstDeadIndex;		// Index of first dead Particle
 	int firstLiveIndex;		// Index of first alive Particle
+	unsigned int emitterIndex;	// Stamped into every spawned Particle
 
-	ID3D11Buffer* indexBuffer;
-	ID3D11Buffer* particleDataBuffer;
-	ID3D11ShaderResourceView* particleDataSRV;
+	ParticleCollider* collider;
 
-	ID3D11ShaderResourceView* texture;
-	std::shared_ptr<SimpleVertexShader> vertexShader;
-	std::shared_ptr<SimplePixelShader> pixelShader;
+	// Particles only change when spawned or hit, so only those need uploading
+	int pendingUploadCount;		// Particles spawned since the last upload
+	std::vector<int> dirtyIndices;	// Older Particles changed by collisions since the last upload
+	unsigned int bytesUploaded;	// Bytes sent to the GPU by the last upload
 };
 
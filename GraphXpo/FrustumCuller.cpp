@@ -0,0 +1,205 @@
+#include "FrustumCuller.h"
+#include <math.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define FRUSTUM_CULLER_AVX
+#elif defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#include <emmintrin.h>
+#define FRUSTUM_CULLER_SSE
+#endif
+
+FrustumCuller::FrustumCuller()
+{
+	count = 0;
+	blockCount = 0;
+	stats = CullingStats();
+}
+
+void FrustumCuller::Resize(unsigned int count)
+{
+	this->count = count;
+	blockCount = (count + Width - 1) / Width;
+
+	unsigned int padded = blockCount * Width;
+	centerX.resize(padded, 0.0f);
+	centerY.resize(padded, 0.0f);
+	centerZ.resize(padded, 0.0f);
+	extentX.resize(padded, 0.0f);
+	extentY.resize(padded, 0.0f);
+	extentZ.resize(padded, 0.0f);
+	radius.resize(padded, 0.0f);
+	masks.resize(blockCount);
+}
+
+unsigned int FrustumCuller::GetCount()
+{
+	return count;
+}
+
+void FrustumCuller::SetBounds(unsigned int index, const AABB& box, const BoundingSphere& sphere)
+{
+	if (index >= count)
+		return;
+
+	DirectX::XMFLOAT3 center = box.GetCenter();
+	DirectX::XMFLOAT3 extents = box.GetExtents();
+	centerX[index] = center.x;
+	centerY[index] = center.y;
+	centerZ[index] = center.z;
+	extentX[index] = extents.x;
+	extentY[index] = extents.y;
+	extentZ[index] = extents.z;
+	radius[index] = sphere.Radius;
+}
+
+unsigned int FrustumCuller::Cull(const Frustum& frustum, unsigned int* visible)
+{
+	CullBlocks(frustum,
+		centerX.data(), centerY.data(), centerZ.data(),
+		extentX.data(), extentY.data(), extentZ.data(),
+		radius.data(), blockCount, masks.data());
+
+	// Turn the masks into a list, ignoring the padding past the end
+	unsigned int visibleCount = 0;
+	for (unsigned int block = 0; block < blockCount; block++)
+	{
+		unsigned int mask = masks[block];
+		while (mask)
+		{
+			unsigned int lane = 0;
+			while (!(mask & (1u << lane)))
+				lane++;
+			mask &= mask - 1;
+
+			unsigned int index = block * Width + lane;
+			if (index < count)
+				visible[visibleCount++] = index;
+		}
+	}
+
+	stats.Tested = count;
+	stats.Visible = visibleCount;
+	stats.Culled = count - visibleCount;
+	return visibleCount;
+}
+
+const CullingStats& FrustumCuller::GetStats()
+{
+	return stats;
+}
+
+void FrustumCuller::CullBlocks(const Frustum& frustum,
+	const float* centerX, const float* centerY, const float* centerZ,
+	const float* extentX, const float* extentY, const float* extentZ,
+	const float* radius, unsigned int blockCount, unsigned char* masks)
+{
+#if defined(FRUSTUM_CULLER_AVX)
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	for (unsigned int block = 0; block < blockCount; block++)
+	{
+		unsigned int first = block * Width;
+		__m256 cx = _mm256_loadu_ps(centerX + first);
+		__m256 cy = _mm256_loadu_ps(centerY + first);
+		__m256 cz = _mm256_loadu_ps(centerZ + first);
+		__m256 ex = _mm256_loadu_ps(extentX + first);
+		__m256 ey = _mm256_loadu_ps(extentY + first);
+		__m256 ez = _mm256_loadu_ps(extentZ + first);
+		__m256 r = _mm256_loadu_ps(radius + first);
+
+		__m256 outside = _mm256_setzero_ps();
+		for (int p = 0; p < 6; p++)
+		{
+			const DirectX::XMFLOAT4& plane = frustum.planes[p];
+			__m256 px = _mm256_set1_ps(plane.x);
+			__m256 py = _mm256_set1_ps(plane.y);
+			__m256 pz = _mm256_set1_ps(plane.z);
+
+			// Signed distance of the centers, and how far each shape reaches towards the plane
+			__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(px, cx), _mm256_mul_ps(py, cy)), _mm256_mul_ps(pz, cz)), _mm256_set1_ps(plane.w));
+			__m256 reach = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(_mm256_andnot_ps(signMask, px), ex),
+				_mm256_mul_ps(_mm256_andnot_ps(signMask, py), ey)),
+				_mm256_mul_ps(_mm256_andnot_ps(signMask, pz), ez));
+			reach = _mm256_min_ps(reach, r);
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		masks[block] = (unsigned char)(~_mm256_movemask_ps(outside) & 0xFF);
+	}
+#elif defined(FRUSTUM_CULLER_SSE)
+	// Two 4-wide halves per block
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	for (unsigned int block = 0; block < blockCount; block++)
+	{
+		unsigned int mask = 0;
+		for (unsigned int half = 0; half < 2; half++)
+		{
+			unsigned int first = block * Width + half * 4;
+			__m128 cx = _mm_loadu_ps(centerX + first);
+			__m128 cy = _mm_loadu_ps(centerY + first);
+			__m128 cz = _mm_loadu_ps(centerZ + first);
+			__m128 ex = _mm_loadu_ps(extentX + first);
+			__m128 ey = _mm_loadu_ps(extentY + first);
+			__m128 ez = _mm_loadu_ps(extentZ + first);
+			__m128 r = _mm_loadu_ps(radius + first);
+
+			__m128 outside = _mm_setzero_ps();
+			for (int p = 0; p < 6; p++)
+			{
+				const DirectX::XMFLOAT4& plane = frustum.planes[p];
+				__m128 px = _mm_set1_ps(plane.x);
+				__m128 py = _mm_set1_ps(plane.y);
+				__m128 pz = _mm_set1_ps(plane.z);
+
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)), _mm_mul_ps(pz, cz)), _mm_set1_ps(plane.w));
+				__m128 reach = _mm_add_ps(_mm_add_ps(
+					_mm_mul_ps(_mm_andnot_ps(signMask, px), ex),
+					_mm_mul_ps(_mm_andnot_ps(signMask, py), ey)),
+					_mm_mul_ps(_mm_andnot_ps(signMask, pz), ez));
+				reach = _mm_min_ps(reach, r);
+
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+			}
+
+			mask |= (unsigned int)(~_mm_movemask_ps(outside) & 0xF) << (half * 4);
+		}
+		masks[block] = (unsigned char)mask;
+	}
+#else
+	CullBlocksScalar(frustum, centerX, centerY, centerZ, extentX, extentY, extentZ, radius, blockCount, masks);
+#endif
+}
+
+void FrustumCuller::CullBlocksScalar(const Frustum& frustum,
+	const float* centerX, const float* centerY, const float* centerZ,
+	const float* extentX, const float* extentY, const float* extentZ,
+	const float* radius, unsigned int blockCount, unsigned char* masks)
+{
+	for (unsigned int block = 0; block < blockCount; block++)
+	{
+		unsigned int mask = 0;
+		for (unsigned int lane = 0; lane < Width; lane++)
+		{
+			unsigned int i = block * Width + lane;
+			bool outside = false;
+			for (int p = 0; p < 6; p++)
+			{
+				const DirectX::XMFLOAT4& plane = frustum.planes[p];
+				float distance = ((plane.x * centerX[i] + plane.y * centerY[i]) + plane.z * centerZ[i]) + plane.w;
+				float reach = (fabsf(plane.x) * extentX[i] + fabsf(plane.y) * extentY[i]) + fabsf(plane.z) * extentZ[i];
+				reach = fminf(reach, radius[i]);
+
+				if (distance + reach < 0)
+					outside = true;
+			}
+
+			if (!outside)
+				mask |= 1u << lane;
+		}
+		masks[block] = (unsigned char)mask;
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <vector>
+#include "Bounds.h"
+
+// Boxes a Cull() looked at, and what became of them
+struct CullingStats
+{
+	unsigned int Tested;
+	unsigned int Visible;
+	unsigned int Culled;
+};
+
+// --------------------------------------------------------
+// Culls many bounding volumes against a Frustum at once.
+//
+// Volumes are kept structure-of-arrays - every center x
+// together, every center y together and so on - so one
+// kernel step tests Width of them against a plane.  Each
+// volume is its box's center and extents plus a sphere
+// radius around the same center; it is culled when either
+// shape is entirely behind any plane.
+// --------------------------------------------------------
+class FrustumCuller
+{
+public:
+	static const unsigned int Width = 8;	// Volumes per kernel step
+
+	FrustumCuller();
+
+	///<summary>
+	///Hold count volumes.  New ones are empty boxes at the origin until set.
+	///</summary>
+	void Resize(unsigned int count);
+	unsigned int GetCount();
+
+	///<summary>
+	///Set a volume from world space bounds that share a center, as GameEntity's do.
+	///</summary>
+	void SetBounds(unsigned int index, const AABB& box, const BoundingSphere& sphere);
+
+	///<summary>
+	///Write the indices of the volumes that may be visible, in ascending order, and return how many.
+	///visible must hold GetCount() entries.
+	///</summary>
+	unsigned int Cull(const Frustum& frustum, unsigned int* visible);
+
+	///<summary>
+	///Counts from the last Cull().
+	///</summary>
+	const CullingStats& GetStats();
+
+	///<summary>
+	///The kernel, on raw arrays of blockCount * Width volumes.  Sets bit i of masks[block]
+	///when volume block * Width + i may be visible.  Uses AVX when built for it, SSE otherwise.
+	///</summary>
+	static void CullBlocks(const Frustum& frustum,
+		const float* centerX, const float* centerY, const float* centerZ,
+		const float* extentX, const float* extentY, const float* extentZ,
+		const float* radius, unsigned int blockCount, unsigned char* masks);
+
+	///<summary>
+	///The same test one volume at a time, as a reference for the kernel.
+	///</summary>
+	static void CullBlocksScalar(const Frustum& frustum,
+		const float* centerX, const float* centerY, const float* centerZ,
+		const float* extentX, const float* extentY, const float* extentZ,
+		const float* radius, unsigned int blockCount, unsigned char* masks);
+
+private:
+	unsigned int count;
+	unsigned int blockCount;
+
+	// Padded out to whole blocks
+	std::vector<float> centerX, centerY, centerZ;
+	std::vector<float> extentX, extentY, extentZ;
+	std::vector<float> radius;
+	std::vector<unsigned char> masks;
+
+	CullingStats stats;
+};
@@ -44,7 +44,7 @@ Game::~Game()
 	//I've opted to wrap meshes, shaders, and materials in shared_ptrs, so they don't require manual deallocation
 
 	//delete all of the game objects
-	for (size_t i = 0; i < 44; i++)
+	for (size_t i = 0; i < EntityCount; i++)
 	{
 		delete gameEntities[i];
 	}
@@ -73,10 +73,14 @@ Game::~Game()
 	particleTexture->Release();
 	particleBlendState->Release();
 	particleDepthStencilState->Release();
-	delete thrusterEmitter;
-	delete thrusterEmitter2;
-	delete thrusterEmitter3;
-	delete campfireEmitter;
+	delete particleSystem;
+	delete thrusterCollider;
+	delete campfireCollider;
+	delete workerPool;
+	delete constantBufferRing;
+	delete stateCache;
+	delete pixelVariants;
+	delete shaderLibrary;
 
 	// Release sky resources
 	skyDepthStencilState->Release();
@@ -114,10 +118,50 @@ void Game::Init()
 	rotating = false;
 	printf("WASD to move. Space/X for vertical movement. Click and drag to rotate.");
 
+	// Threads shared by any system that splits its work across cores
+	workerPool = new WorkerPool();
+
+	// Shaders and the state objects made from descriptions, shared across the game
+	shaderLibrary = new ShaderLibrary(device, context, workerPool);
+
+	// Sort opaque draws by state within a few coarse bands, nearest first, up to the far plane
+	renderQueue.SetDepthBuckets(RenderPassOpaque, 4, 100.0f);
+
 	LoadAssets();
+
+	startupTimer.Begin("Geometry");
 	CreateMatrices();
 	CreateBasicGeometry();
 
+	// One culling volume per entity, filled in as their transforms change
+	entityCuller.Resize(EntityCount);
+	visibleEntities.resize(EntityCount);
+	viewCulling = CullingStats();
+	shadowCulling = CullingStats();
+
+	// The static entities won't move again, so build their hierarchy once
+	std::vector<AABB> staticBounds;
+	std::vector<unsigned int> staticIds;
+	for (unsigned int i = MovingEntityCount; i < EntityCount; i++)
+	{
+		gameEntities[i]->UpdateBounds();
+		entityCuller.SetBounds(i, gameEntities[i]->GetWorldBounds(), gameEntities[i]->GetWorldSphere());
+		staticBounds.push_back(gameEntities[i]->GetWorldBounds());
+		staticIds.push_back(i);
+	}
+	staticScene.Build(staticBounds.data(), staticIds.data(), (unsigned int)staticBounds.size(), workerPool);
+
+	// The moving ones are only reinserted once they leave a margin around where they were
+	movingScene.SetMargin(0.25f);
+	for (unsigned int i = 0; i < MovingEntityCount; i++)
+	{
+		gameEntities[i]->UpdateBounds();
+		entityCuller.SetBounds(i, gameEntities[i]->GetWorldBounds(), gameEntities[i]->GetWorldSphere());
+		movingProxies[i] = movingScene.CreateProxy(gameEntities[i]->GetWorldBounds(), i);
+	}
+
+	startupTimer.Begin("Scene");
+
 	context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
 	//set up the directional lights
@@ -169,8 +213,32 @@ void Game::Init()
 	lights.emplace_back(dl6);
 	lights.emplace_back(dl7);
 
-	// Set up the Emitters
-	thrusterEmitter = new Emitter(
+	// Give each lit material the pixel shader permutation that skips what it
+	// doesn't have (a missing normal map) and unrolls its loop for these lights
+	std::shared_ptr<Material> litMaterials[] = { barkMaterial, carpetMaterial, ceilingMaterial, marbleMaterial, marbleWallMaterial,
+		spaceshipMaterial, rockMaterial, logMaterial, dirtMaterial, caveMaterial };
+	for (auto& material : litMaterials)
+	{
+		pixelVariants->Apply(material.get(), (unsigned int)lights.size());
+	}
+
+	// Set up the Emitters - all of them share one texture, so one ParticleSystem draws them together
+	particleSystem = new ParticleSystem(device, particleTexture, particleVertexShader, particlePixelShader, workerPool);
+
+	// Thin out and shrink effects as they get farther from the camera
+	std::vector<ParticleLODPoint> particleLOD =
+	{
+		// Distance, spawn rate scale, size scale
+		{ 15.0f, 1.0f, 1.0f },
+		{ 30.0f, 0.25f, 0.75f },
+		{ 45.0f, 0.0f, 0.5f }
+	};
+	particleSystem->SetLODCurve(particleLOD);
+
+	// Hard cap on live particles across every effect in view
+	particleSystem->SetParticleBudget(2048);
+
+	thrusterEmitter = particleSystem->AddEmitter(new Emitter(
 		80,									// Max particles
 		50,										// Particles per second
 		1.6f,									// Particle lifetime
@@ -184,13 +252,10 @@ void Game::Init()
 		XMFLOAT3(0.1f, 0.05f, 0.0f),			// Velocity randomness range
 		XMFLOAT3(0, 0, 0),						// Position randomness range
 		XMFLOAT4(0, 0, -2, 2),					// Random rotation ranges (startMin, startMax, endMin, endMax)
-		device,
-		particleTexture,
-		particleVertexShader,
-		particlePixelShader
-	);
+		1										// Random seed
+	));
 
-	thrusterEmitter2 = new Emitter(
+	thrusterEmitter2 = particleSystem->AddEmitter(new Emitter(
 		40,										// Max particles
 		23,										// Particles per second
 		1.3f,									// Particle lifetime
@@ -204,13 +269,10 @@ void Game::Init()
 		XMFLOAT3(0.1f, 0.05f, 0.0f),			// Velocity randomness range
 		XMFLOAT3(0, 0, 0),						// Position randomness range
 		XMFLOAT4(0, 0, -2, 2),					// Random rotation ranges (startMin, startMax, endMin, endMax)
-		device,
-		particleTexture,
-		particleVertexShader,
-		particlePixelShader
-	);
+		2										// Random seed
+	));
 
-	thrusterEmitter3 = new Emitter(
+	thrusterEmitter3 = particleSystem->AddEmitter(new Emitter(
 		40,										// Max particles
 		23,										// Particles per second
 		1.3f,									// Particle lifetime
@@ -224,13 +286,10 @@ void Game::Init()
 		XMFLOAT3(0.1f, 0.05f, 0.0f),			// Velocity randomness range
 		XMFLOAT3(0, 0, 0),						// Position randomness range
 		XMFLOAT4(0, 0, -2, 2),					// Random rotation ranges (startMin, startMax, endMin, endMax)
-		device,
-		particleTexture,
-		particleVertexShader,
-		particlePixelShader
-	);
+		3										// Random seed
+	));
 
-	campfireEmitter = new Emitter(
+	campfireEmitter = particleSystem->AddEmitter(new Emitter(
 		120,									// Max particles
 		40,										// Particles per second
 		2.8f,									// Particle lifetime
@@ -244,15 +303,42 @@ void Game::Init()
 		XMFLOAT3(0.0f, 0.15f, 0.0f),			// Velocity randomness range
 		XMFLOAT3(0.12f, 0.1f, 0.12f),			// Position randomness range
 		XMFLOAT4(0, 0, -1, 1),					// Random rotation ranges (startMin, startMax, endMin, endMax)
-		device,
-		particleTexture,
-		particleVertexShader,
-		particlePixelShader
-	);
+		4										// Random seed
+	));
+
+	// The campfire holds its heat for a while before cooling off into smoke
+	ParticleCurveAtlas* curves = particleSystem->GetCurveAtlas();
+	campfireEmitter->UseCurve(curves, curves->AddRow(
+		{ { 0.0f, XMFLOAT4(0.972f, 0.823f, 0.686f, 1.0f) }, { 0.35f, XMFLOAT4(0.972f, 0.6f, 0.35f, 0.8f) }, { 1.0f, XMFLOAT4(0.877f, 0.877f, 0.877f, 0.0f) } },
+		{ { 0.0f, 0.20f }, { 0.25f, 0.22f }, { 1.0f, 0.02f } },
+		{ { 0.0f, 0.0f }, { 1.0f, 1.0f } }));
+
+	// Collide with the nearby boxes of the level
+	AABB thrusterRegion = thrusterEmitter->GetBounds();
+	thrusterRegion.Encapsulate(thrusterEmitter2->GetBounds());
+	thrusterRegion.Encapsulate(thrusterEmitter3->GetBounds());
+	thrusterCollider = new ParticleCollider(ParticleCollisionResponse::Bounce, 0.4f, 0.2f);
+	thrusterCollider->AddEntityBoxes(gameEntities, EntityCount, meshes[0].get(), XMFLOAT3(0.5f, 0.5f, 0.5f), thrusterRegion);
+	thrusterEmitter->SetCollider(thrusterCollider);
+	thrusterEmitter2->SetCollider(thrusterCollider);
+	thrusterEmitter3->SetCollider(thrusterCollider);
+
+	campfireCollider = new ParticleCollider(ParticleCollisionResponse::Kill);
+	campfireCollider->AddEntityBoxes(gameEntities, EntityCount, meshes[0].get(), XMFLOAT3(0.5f, 0.5f, 0.5f), campfireEmitter->GetBounds());
+	campfireEmitter->SetCollider(campfireCollider);
+
+	// Start every effect already burning rather than ramping up
+	particleSystem->Prewarm(5.0f, 0.0f);
+
+	startupTimer.End();
+	startupTimer.Report();
+	shaderLibrary->Report();
 }
 
 void Game::LoadAssets()
 {
+	startupTimer.Begin("Samplers");
+
 	//Sampler Creation
 	D3D11_SAMPLER_DESC samplerDesc = {};
 
@@ -263,7 +349,7 @@ void Game::LoadAssets()
 	samplerDesc.MaxAnisotropy = 16;
 	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
 
-	device->CreateSamplerState(&samplerDesc, &sampler);
+	sampler = shaderLibrary->GetSamplerState(samplerDesc);
 
 	D3D11_SAMPLER_DESC clampedDesc = {};
 
@@ -278,64 +364,73 @@ void Game::LoadAssets()
 	samplerDesc.MaxAnisotropy = 16;
 	samplerDesc.MaxLOD = D3D11_FLOAT32_MAX;
 
-	device->CreateSamplerState(&samplerDesc, &clampedSampler);
+	clampedSampler = shaderLibrary->GetSamplerState(samplerDesc);
 
 #pragma region shader loading
-	vertexShader = std::make_shared<SimpleVertexShader>(device, context);
-	vertexShader->LoadShaderFile(L"VertexShader.cso");
-
-	pixelShader = std::make_shared<SimplePixelShader>(device, context);
-	pixelShader->LoadShaderFile(L"PixelShader.cso");
-
-	pbrPixelShader = std::make_shared<SimplePixelShader>(device, context);
-	pbrPixelShader->LoadShaderFile(L"PBRPixelShader.cso");
-
-	// Load Skybox shaders
-	skyVertexShader = std::make_shared<SimpleVertexShader>(device, context);
-	skyVertexShader->LoadShaderFile(L"SkyVertexShader.cso");
-
-	skyPixelShader = std::make_shared<SimplePixelShader>(device, context);
-	skyPixelShader->LoadShaderFile(L"SkyPixelShader.cso");
-
-	//Load Post-Processing shaders
-	postProcessVS = std::make_shared<SimpleVertexShader>(device, context);
-	postProcessVS->LoadShaderFile(L"PostProcessVS.cso");
-
-	brightExtractPS = std::make_shared<SimplePixelShader>(device, context);
-	brightExtractPS->LoadShaderFile(L"BrightnessExtractPS.cso");
-
-	bloomBlurHPS = std::make_shared<SimplePixelShader>(device, context);
-	bloomBlurHPS->LoadShaderFile(L"BloomBlurHorizontalPS.cso");
-
-	bloomBlurVPS = std::make_shared<SimplePixelShader>(device, context);
-	bloomBlurVPS->LoadShaderFile(L"BloomBlurVerticalPS.cso");
-
-	motionBlurPS = std::make_shared<SimplePixelShader>(device, context);
-	motionBlurPS->LoadShaderFile(L"MotionBlurPS.cso");
-
-	// Load Particle shaders
-	particleVertexShader = std::make_shared<SimpleVertexShader>(device, context);
-	particleVertexShader->LoadShaderFile(L"ParticleVertexShader.cso");
-
-	particlePixelShader = std::make_shared<SimplePixelShader>(device, context);
-	particlePixelShader->LoadShaderFile(L"ParticlePixelShader.cso");
-
-	//Load Water Shaders
-	waterPixelShader = std::make_shared<SimplePixelShader>(device, context);
-	waterPixelShader->LoadShaderFile(L"WaterPixelShader.cso");
-
-	refractiveMaskPS = std::make_shared<SimplePixelShader>(device, context);
-	refractiveMaskPS->LoadShaderFile(L"RefractiveMaskPS.cso");
-
-	combineRefractionPS = std::make_shared<SimplePixelShader>(device, context);
-	combineRefractionPS->LoadShaderFile(L"CombineRefractionPS.cso");
-
-	//Load Shadow Shader
-	shadowVS = std::make_shared<SimpleVertexShader>(device, context);
-	shadowVS->LoadShaderFile(L"ShadowVS.cso");
+	startupTimer.Begin("Shaders");
+
+	// Shaders seen on an earlier run skip reflection
+	ShaderReflectionCache reflectionCache("ShaderReflection.cache");
+	reflectionCache.Load();
+	ISimpleShader::SetReflectionCache(&reflectionCache);
+
+	// Queue every shader up front, then load them all at once across the worker threads
+	vertexShader = shaderLibrary->AddVertexShader(L"VertexShader.cso");
+	pixelShader = shaderLibrary->AddPixelShader(L"PixelShader.cso");
+	pbrPixelShader = shaderLibrary->AddPixelShader(L"PBRPixelShader.cso");
+
+	// Lit materials switch to these once the lights are known
+	pixelVariants = new ShaderVariantSet(device, context, PixelShaderVariants, PixelShaderVariantCount);
+	pixelVariants->Request(shaderLibrary);
+
+	// Skybox shaders
+	skyVertexShader = shaderLibrary->AddVertexShader(L"SkyVertexShader.cso");
+	skyPixelShader = shaderLibrary->AddPixelShader(L"SkyPixelShader.cso");
+
+	// Post-Processing shaders
+	postProcessVS = shaderLibrary->AddVertexShader(L"PostProcessVS.cso");
+	brightExtractPS = shaderLibrary->AddPixelShader(L"BrightnessExtractPS.cso");
+	bloomBlurHPS = shaderLibrary->AddPixelShader(L"BloomBlurHorizontalPS.cso");
+	bloomBlurVPS = shaderLibrary->AddPixelShader(L"BloomBlurVerticalPS.cso");
+	motionBlurPS = shaderLibrary->AddPixelShader(L"MotionBlurPS.cso");
+
+	// Particle shaders
+	particleVertexShader = shaderLibrary->AddVertexShader(L"ParticleVertexShader.cso");
+	particlePixelShader = shaderLibrary->AddPixelShader(L"ParticlePixelShader.cso");
+
+	// Water Shaders
+	waterPixelShader = shaderLibrary->AddPixelShader(L"WaterPixelShader.cso");
+	refractiveMaskPS = shaderLibrary->AddPixelShader(L"RefractiveMaskPS.cso");
+	combineRefractionPS = shaderLibrary->AddPixelShader(L"CombineRefractionPS.cso");
+
+	// Shadow Shader
+	shadowVS = shaderLibrary->AddVertexShader(L"ShadowVS.cso");
+
+	shaderLibrary->LoadAll();
+
+	reflectionCache.Save();
+	ISimpleShader::SetReflectionCache(0);
+
+	// Entity shaders get new constants every draw, so append them all to one
+	// buffer instead of rewriting each shader's own buffers over and over
+	constantBufferRing = new ConstantBufferRing(device, context, 256 * 1024);
+	vertexShader->SetConstantBufferRing(constantBufferRing);
+	pixelShader->SetConstantBufferRing(constantBufferRing);
+	pbrPixelShader->SetConstantBufferRing(constantBufferRing);
+	pixelVariants->SetConstantBufferRing(constantBufferRing);
+	waterPixelShader->SetConstantBufferRing(constantBufferRing);
+
+	// Entities mostly share shaders and textures, so most of their bindings are already in place
+	stateCache = new DeviceStateCache(context);
+	vertexShader->SetStateCache(stateCache);
+	pixelShader->SetStateCache(stateCache);
+	pbrPixelShader->SetStateCache(stateCache);
+	pixelVariants->SetStateCache(stateCache);
 #pragma endregion
 
 #pragma region general texture loading
+	startupTimer.Begin("Textures and materials");
+
 	ID3D11ShaderResourceView* barkSRV;
 	CreateWICTextureFromFile(device, context, L"..\\..\\Assets\\Textures\\rock.jpg", 0, &barkSRV);
 	ID3D11ShaderResourceView* bark_s_SRV;
@@ -426,6 +521,8 @@ void Game::LoadAssets()
 #pragma endregion
 
 #pragma region skybox loading
+	startupTimer.Begin("Render targets and states");
+
 	ID3D11ShaderResourceView* skySRV;
 	CreateDDSTextureFromFile(device, L"..\\..\\Assets\\Textures\\NightSkyCubemap.dds", 0, &skySRV);
 
@@ -448,13 +545,13 @@ void Game::LoadAssets()
 	skyRD.CullMode = D3D11_CULL_FRONT;
 	skyRD.FillMode = D3D11_FILL_SOLID;
 	skyRD.DepthClipEnable = true;
-	device->CreateRasterizerState(&skyRD, &skyRasterizerState);
+	skyRasterizerState = shaderLibrary->GetRasterizerState(skyRD);
 
 	D3D11_DEPTH_STENCIL_DESC skyDS = {};
 	skyDS.DepthEnable = true;
 	skyDS.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ALL;
 	skyDS.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
-	device->CreateDepthStencilState(&skyDS, &skyDepthStencilState);
+	skyDepthStencilState = shaderLibrary->GetDepthStencilState(skyDS);
 
 #pragma endregion
 
@@ -521,7 +618,7 @@ void Game::LoadAssets()
 	dsDesc.DepthEnable = true;
 	dsDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO; // Turns off depth writing
 	dsDesc.DepthFunc = D3D11_COMPARISON_LESS;
-	device->CreateDepthStencilState(&dsDesc, &particleDepthStencilState);
+	particleDepthStencilState = shaderLibrary->GetDepthStencilState(dsDesc);
 
 
 	// Blend for particles (additive)
@@ -536,7 +633,7 @@ void Game::LoadAssets()
 	blend.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
 	blend.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ONE;
 	blend.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-	device->CreateBlendState(&blend, &particleBlendState);
+	particleBlendState = shaderLibrary->GetBlendState(blend);
 
 
 #pragma endregion
@@ -616,7 +713,7 @@ void Game::LoadAssets()
 	shadowSampDesc.BorderColor[1] = 1.0f;
 	shadowSampDesc.BorderColor[2] = 1.0f;
 	shadowSampDesc.BorderColor[3] = 1.0f;
-	device->CreateSamplerState(&shadowSampDesc, &shadowSampler);
+	shadowSampler = shaderLibrary->GetSamplerState(shadowSampDesc);
 
 	// Create a rasterizer state
 	D3D11_RASTERIZER_DESC shadowRastDesc = {};
@@ -626,7 +723,7 @@ void Game::LoadAssets()
 	shadowRastDesc.DepthBias = 1000; // Multiplied by (smallest possible value > 0 in depth buffer)
 	shadowRastDesc.DepthBiasClamp = 0.0f;
 	shadowRastDesc.SlopeScaledDepthBias = 1.0f;
-	device->CreateRasterizerState(&shadowRastDesc, &shadowRasterizer);
+	shadowRasterizer = shaderLibrary->GetRasterizerState(shadowRastDesc);
 #pragma endregion
 }
 
@@ -883,16 +980,13 @@ void Game::Update(float deltaTime, float totalTime)
 		Quit();
 
 
-	thrusterEmitter->Update(deltaTime, totalTime);
-	thrusterEmitter2->Update(deltaTime, totalTime);
-	thrusterEmitter3->Update(deltaTime, totalTime);
-	campfireEmitter->Update(deltaTime, totalTime);
+	particleSystem->Update(deltaTime, totalTime);
 
 	//camera->Update(deltaTime);
 	player->Update(deltaTime);
 
 	// Update each of the game objects
-	for (size_t i = 0; i < 10; i++)
+	for (size_t i = 0; i < MovingEntityCount; i++)
 	{
 		XMFLOAT3 zAxis(0, 0, 1);
 		XMFLOAT3 yAxis(0, 1, 0);
@@ -911,6 +1005,12 @@ void Game::Update(float deltaTime, float totalTime)
 
 void Game::Draw(float deltaTime, float totalTime)
 {
+	// Count constant buffer uploads per frame, and move on to
+	// the next frame's part of the constant buffer ring
+	ISimpleShader::ResetFrameStats();
+	constantBufferRing->BeginFrame();
+	stateCache->ResetStats();
+
 	// Background color
 	const float color[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
 
@@ -922,6 +1022,18 @@ void Game::Draw(float deltaTime, float totalTime)
 		1.0f,
 		0);
 
+	// Bring every entity's world matrix and bounds up to date before either pass culls them
+	for (unsigned int i = 0; i < EntityCount; i++)
+	{
+		if (gameEntities[i]->UpdateBounds())
+		{
+			entityCuller.SetBounds(i, gameEntities[i]->GetWorldBounds(), gameEntities[i]->GetWorldSphere());
+			if (i < MovingEntityCount)
+				movingScene.MoveProxy(movingProxies[i], gameEntities[i]->GetWorldBounds());
+		}
+	}
+	movingScene.Optimize(MovingEntityCount);
+
 	DrawShadowMaps();
 
 	//render all non-refractive elements to a texture
@@ -930,52 +1042,79 @@ void Game::Draw(float deltaTime, float totalTime)
 
 #pragma region main draw
 
-	// Game Entity Meshes
-	for (size_t i = 0; i < 44; i++)
+	// Everything before this bound straight on the context
+	stateCache->Invalidate();
+
+	// Only the entities the camera can see.  It stores its matrices transposed for HLSL.
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+	Frustum viewFrustum(XMMatrixMultiply(
+		XMMatrixTranspose(XMLoadFloat4x4(&view)),
+		XMMatrixTranspose(XMLoadFloat4x4(&projection))));
+	unsigned int visibleCount = staticScene.Cull(viewFrustum, visibleEntities.data());
+	visibleCount += movingScene.Cull(viewFrustum, visibleEntities.data() + visibleCount);
+	viewCulling.Tested = EntityCount;
+	viewCulling.Visible = visibleCount;
+	viewCulling.Culled = EntityCount - visibleCount;
+
+	// Queue the Game Entity Meshes, keyed so that draws sharing a shader,
+	// material or mesh end up next to each other
+	XMFLOAT3 cameraPosition = camera->transform.GetPosition();
+	XMVECTOR cameraPos = XMLoadFloat3(&cameraPosition);
+	renderQueue.Clear();
+	for (unsigned int v = 0; v < visibleCount; v++)
 	{
-		// If the world matrix is outdated, recalculate it
-		if (gameEntities[i]->transform->matrixOutdated)
-			gameEntities[i]->transform->CalculateWorldMatrix();
+		unsigned int i = visibleEntities[v];
+		Material* material = gameEntities[i]->material.get();
+		XMFLOAT3 position = gameEntities[i]->transform->GetPosition();
+		float depth = XMVectorGetX(XMVector3Length(XMVectorSubtract(XMLoadFloat3(&position), cameraPos)));
+
+		renderQueue.Add(RenderQueue::MakeKey(
+			RenderPassOpaque,
+			renderQueue.GetDepthBucket(RenderPassOpaque, depth),
+			renderQueue.GetShaderID(material->GetVertexShader().get(), material->GetPixelShader().get()),
+			renderQueue.GetMaterialID(material),
+			renderQueue.GetMeshID(gameEntities[i]->mesh.get())),
+			i);
+	}
+	renderQueue.Sort(workerPool);
 
-		int lightCount = lights.size();
+	int lightCount = lights.size();
+	renderQueue.Submit([&](unsigned int i, unsigned int changes)
+	{
+		GameEntity* entity = gameEntities[i];
+		Material* material = entity->material.get();
 
-		// Pass the appropriate lights to the material's pixel shader
-		gameEntities[i]->material->GetPixelShader()->SetData("lights", lights.data(), sizeof(PointLight) * 6);
-		gameEntities[i]->material->GetPixelShader()->SetData("lightCount", &lightCount, sizeof(int));
-		gameEntities[i]->material->GetPixelShader()->SetData("dirLight", directionalLight, sizeof(DirectionalLight));
-		gameEntities[i]->material->GetPixelShader()->SetData("cameraPos", &camera->transform.GetPosition(), sizeof(DirectX::XMFLOAT3));
+		// Pass the lights and camera to a pixel shader as it comes up - they're the same for the whole frame
+		if (changes & RenderChangeShader)
+		{
+			const MaterialParams& params = material->GetParams();
+			SimplePixelShader* entityPixelShader = material->GetPixelShader().get();
+			entityPixelShader->SetData(params.Lights, lights.data(), sizeof(PointLight) * 6);
+			entityPixelShader->SetData(params.LightCount, &lightCount, sizeof(int));
+			entityPixelShader->SetData(params.DirLight, directionalLight, sizeof(DirectionalLight));
+			entityPixelShader->SetData(params.CameraPos, &cameraPosition, sizeof(DirectX::XMFLOAT3));
+			entityPixelShader->SetMatrix4x4(params.PixelView, camera->GetViewMatrix());
+		}
 
+		// Textures and samplers come from the material's parameter blocks
+		if (changes & RenderChangeMaterial)
+			material->Bind();
 
 		// Set buffers in the input assembler
-		//  - Do this ONCE PER OBJECT you're drawing, since each object might
-		//    have different geometry.
-		UINT stride = sizeof(Vertex);
-		UINT offset = 0;
-
-		ID3D11Buffer* vertexBuffer = gameEntities[i]->mesh->GetVertexBuffer();
-		context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-		context->IASetIndexBuffer(gameEntities[i]->mesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
-
-		gameEntities[i]->material->GetPixelShader()->SetSamplerState("basicSampler", gameEntities[i]->material->GetSamplerState());
-		gameEntities[i]->material->GetPixelShader()->SetShaderResourceView("diffuseTexture", gameEntities[i]->material->GetDiffuse());
-		gameEntities[i]->material->GetPixelShader()->SetShaderResourceView("normalTexture", gameEntities[i]->material->GetNormal());
-
-		gameEntities[i]->material->GetPixelShader()->SetMatrix4x4("view", camera->GetViewMatrix());
-
-		if (gameEntities[i]->material->GetSpecular() != nullptr) //non-pbr
+		//  - Only when the mesh differs from the last draw's
+		if (changes & RenderChangeMesh)
 		{
-			gameEntities[i]->material->GetPixelShader()->SetShaderResourceView("specularTexture", gameEntities[i]->material->GetSpecular());
-		}
-		else // pbr
-		{
-			gameEntities[i]->material->GetPixelShader()->SetShaderResourceView("metallicTexture", gameEntities[i]->material->GetMetalness());
-			gameEntities[i]->material->GetPixelShader()->SetShaderResourceView("roughnessTexture", gameEntities[i]->material->GetRoughness());
+			UINT stride = sizeof(Vertex);
+			UINT offset = 0;
+			stateCache->SetVertexBuffer(0, entity->mesh->GetVertexBuffer(), stride, offset);
+			stateCache->SetIndexBuffer(entity->mesh->GetIndexBuffer(), DXGI_FORMAT_R32_UINT, 0);
 		}
 
-		gameEntities[i]->PrepareMaterial(camera->GetViewMatrix(), camera->GetProjectionMatrix());
+		entity->PrepareObject(camera->GetViewMatrix(), camera->GetProjectionMatrix());
 
-		context->DrawIndexed(gameEntities[i]->mesh->GetIndexCount(), 0, 0);
-	}
+		stateCache->DrawIndexed(entity->mesh->GetIndexCount(), 0, 0);
+	});
 #pragma endregion
 
 	DrawWater(totalTime);
@@ -983,14 +1122,11 @@ void Game::Draw(float deltaTime, float totalTime)
 	// Draw the sky after all other entities have been drawn
 	DrawSky();
 
-	// Draw the emitter
+	// Draw the emitters
 	float blend[4] = { 1,1,1,1 };
 	context->OMSetBlendState(particleBlendState, blend, 0xffffffff);	// Additive blending
 	context->OMSetDepthStencilState(particleDepthStencilState, 0);
-	thrusterEmitter->Draw(context, camera, totalTime);
-	thrusterEmitter2->Draw(context, camera, totalTime);
-	thrusterEmitter3->Draw(context, camera, totalTime);
-	campfireEmitter->Draw(context, camera, totalTime);
+	particleSystem->Draw(context, camera, totalTime);
 
 	// Reset states for drawing the sky
 	context->OMSetBlendState(0, blend, 0xffffffff);
@@ -1119,7 +1255,13 @@ void Game::DrawShadowMaps() {
 		)));
 #pragma endregion
 
-		for each (GameEntity * g in gameEntities) {
+		// Only what the face being drawn can see.  The matrix is stored transposed for HLSL.
+		Frustum shadowFrustum(XMMatrixTranspose(XMLoadFloat4x4(&l.viewProjection[3])));
+		unsigned int shadowCasterCount = entityCuller.Cull(shadowFrustum, visibleEntities.data());
+		shadowCulling = entityCuller.GetStats();
+
+		for (unsigned int v = 0; v < shadowCasterCount; v++) {
+			GameEntity* g = gameEntities[visibleEntities[v]];
 			vertexBuffer = g->mesh->GetVertexBuffer();
 			indexBuffer = g->mesh->GetIndexBuffer();
 
@@ -1204,7 +1346,7 @@ void Game::DrawWater(float totalTime)
 	refractiveMaskPS->CopyAllBufferData();
 	refractiveMaskPS->SetShader();
 
-	context->DrawIndexed(flatWater->mesh->GetIndexCount(), 0, 0);
+	stateCache->DrawIndexed(flatWater->mesh->GetIndexCount(), 0, 0);
 
 	//next, draw water into a refractive texture
 
@@ -1232,7 +1374,7 @@ void Game::DrawWater(float totalTime)
 
 	flatWater->PrepareMaterial(camera->GetViewMatrix(), camera->GetProjectionMatrix());
 
-	context->DrawIndexed(flatWater->mesh->GetIndexCount(), 0, 0);
+	stateCache->DrawIndexed(flatWater->mesh->GetIndexCount(), 0, 0);
 
 	//combine the refractive and non-refractive textures
 
@@ -13,6 +13,17 @@
 #include "Lights.h"
 #include "FPSController.h"
 #include "Emitter.h"
+#include "ParticleSystem.h"
+#include "WorkerPool.h"
+#include "ConstantBufferRing.h"
+#include "DeviceStateCache.h"
+#include "ShaderVariants.h"
+#include "ShaderLibrary.h"
+#include "StartupTimer.h"
+#include "RenderQueue.h"
+#include "FrustumCuller.h"
+#include "SceneBVH.h"
+#include "DynamicBVH.h"
 
 class Game
 	: public DXCore
@@ -47,6 +58,13 @@ private:
 
 	Camera* camera;
 	FPSController* player;
+	WorkerPool* workerPool;
+	ConstantBufferRing* constantBufferRing;	// Per-draw constants for the entity shaders
+	DeviceStateCache* stateCache;			// Drops redundant bindings between entity draws
+	ShaderVariantSet* pixelVariants;		// Precompiled permutations of the lit pixel shaders
+	ShaderLibrary* shaderLibrary;			// Loads every shader in parallel; owns the state objects
+	StartupTimer startupTimer;
+	RenderQueue renderQueue;				// Orders the entity draws by state each frame
 	bool rotating;
 
 	//Lights
@@ -58,7 +76,18 @@ private:
 
 
 	// GameEntity objects
-	GameEntity* gameEntities[44];
+	static const unsigned int EntityCount = 45;
+	static const unsigned int MovingEntityCount = 10;	// The first few move every frame, the rest never do
+	GameEntity* gameEntities[EntityCount];
+
+	// Culling of the entities against the camera and the shadow-casting light
+	FrustumCuller entityCuller;
+	std::vector<unsigned int> visibleEntities;
+	CullingStats viewCulling;	// This frame's counts for the camera
+	CullingStats shadowCulling;	// and for the shadow map
+	SceneBVH staticScene;		// The entities that never move, for the camera
+	DynamicBVH movingScene;		// and the ones that do
+	int movingProxies[MovingEntityCount];
 
 	GameEntity* flatWater;
 
@@ -106,10 +135,13 @@ private:
 	std::shared_ptr<SimplePixelShader> particlePixelShader;
 	ID3D11DepthStencilState* particleDepthStencilState;
 	ID3D11BlendState* particleBlendState;
+	ParticleSystem* particleSystem;	// Owns and draws the Emitters below
 	Emitter* thrusterEmitter;
 	Emitter* thrusterEmitter2;
 	Emitter* thrusterEmitter3;
 	Emitter* campfireEmitter;
+	ParticleCollider* thrusterCollider;		// Exhaust bounces off the ship and floor
+	ParticleCollider* campfireCollider;		// Smoke stops at the ceiling
 
 	// Shadows
 	int shadowMapSize = 1024;
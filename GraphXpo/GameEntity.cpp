@@ -1,4 +1,5 @@
 #include "GameEntity.h"
+#include "ShaderConstants.h"
 
 
 ///<summary>
@@ -17,6 +18,7 @@ GameEntity::GameEntity(std::shared_ptr<Mesh> const& meshObj, std::shared_ptr<Mat
 	material = materialObj;
 	transform = new Transform(); //create the entity's transform object
 	uvScale = 1;
+	boundsVersion = transform->GetVersion() - 1; // Stale, so the first UpdateBounds() fills them in
 }
 
 GameEntity::~GameEntity()
@@ -28,34 +30,67 @@ GameEntity::~GameEntity()
 ///Set shader data and activate the shaders.
 ///</summary>
 void GameEntity::PrepareMaterial(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection)
+{
+	// The material's own textures and values, which other materials sharing its shaders may have replaced
+	material->Bind();
+
+	PrepareObject(view, projection);
+}
+
+void GameEntity::PrepareObject(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection)
 {
 	// Send data to shader variables
 	//  - Do this ONCE PER OBJECT you're drawing
 	//  - This is actually a complex process of copying data to a local buffer
 	//    and then copying that entire buffer to the GPU.  
 	//  - The "SimpleShader" class handles all of that for you.
-	material->GetVertexShader()->SetMatrix4x4("world", transform->GetWorldMatrix());
-	material->GetVertexShader()->SetMatrix4x4("invTransWorld", transform->GetInverseTranspose());
-	material->GetVertexShader()->SetMatrix4x4("view", view);
-	material->GetVertexShader()->SetMatrix4x4("projection", projection);
-	material->GetVertexShader()->SetFloat("uvScale", uvScale);
+	//  - The whole buffer is filled in here and copied at once, laid out by ShaderConstants.h
+	ShaderConstants::VertexShader::ExternalData constants = {};
+	constants.world = transform->GetWorldMatrix();
+	constants.invTransWorld = transform->GetInverseTranspose();
+	constants.view = view;
+	constants.projection = projection;
+	constants.uvScale = uvScale;
+	material->GetVertexShader()->SetBufferData(constants);
 
 	// Once you've set all of the data you care to change for
 	// the next draw call, you need to actually send it to the GPU
 	//  - If you skip this, the "SetMatrix" calls above won't make it to the GPU!
 	material->GetVertexShader()->CopyAllBufferData();
 
-	material->GetPixelShader()->CopyAllBufferData();
-
-	// Set the vertex and pixel shaders to use for the next Draw() command
-	//  - These don't technically need to be set every frame...YET
-	//  - Once you start applying different shaders to different objects,
-	//    you'll need to swap the current shaders before each draw
+	// Set the vertex shader to use for the next Draw() command - its
+	// buffer moves every draw, so it is bound again every draw
 	material->GetVertexShader()->SetShader();
-	material->GetPixelShader()->SetShader();
 }
 
 void GameEntity::SetUVScale(float scale)
 {
 	uvScale = scale;
 }
+
+bool GameEntity::UpdateBounds()
+{
+	if (transform->matrixOutdated)
+		transform->CalculateWorldMatrix();
+
+	if (boundsVersion == transform->GetVersion())
+		return false;
+
+	// The transform keeps its matrix transposed for HLSL
+	DirectX::XMFLOAT4X4 world = transform->GetWorldMatrix();
+	DirectX::XMMATRIX worldMatrix = DirectX::XMMatrixTranspose(DirectX::XMLoadFloat4x4(&world));
+	worldBounds = mesh->GetBounds().Transformed(worldMatrix);
+	worldSphere = mesh->GetBoundingSphere().Transformed(worldMatrix);
+	boundsVersion = transform->GetVersion();
+	return true;
+}
+
+const AABB& GameEntity::GetWorldBounds()
+{
+	return worldBounds;
+}
+
+const BoundingSphere& GameEntity::GetWorldSphere()
+{
+	return worldSphere;
+}
@@ -24,6 +24,12 @@ public:
 	///</summary>
 	void PrepareMaterial(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection);
 
+	///<summary>
+	///Set this entity's own vertex shader data and activate the vertex shader, leaving the material's
+	///pixel shader and parameters as they are - for draws that share the previous draw's material.
+	///</summary>
+	void PrepareObject(DirectX::XMFLOAT4X4 view, DirectX::XMFLOAT4X4 projection);
+
 	Transform* transform; //holds all data for moving, rotating, and scaling the game entity. Also contains the entity's world matrix
 
 	std::shared_ptr<Mesh> mesh; //this object's mesh representation. Pointer is used so that mesh data can be shared
@@ -31,5 +37,19 @@ public:
 
 	float uvScale; // Float value to scale the game entities UVs by (default of 1)
 	void SetUVScale(float scale);
+
+	///<summary>
+	///Move the mesh's bounds into world space if the transform has changed since last time.
+	///Returns true if they moved.  Recalculates an outdated world matrix first.
+	///</summary>
+	bool UpdateBounds();
+
+	const AABB& GetWorldBounds();
+	const BoundingSphere& GetWorldSphere();
+
+private:
+	AABB worldBounds;
+	BoundingSphere worldSphere;
+	unsigned int boundsVersion; // The transform version the world bounds were made from
 };
 
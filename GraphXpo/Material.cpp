@@ -1,4 +1,5 @@
 #include "Material.h"
+#include "ShaderVariants.h"
 
 Material::Material(std::shared_ptr<SimpleVertexShader> const& vertex, std::shared_ptr<SimplePixelShader> const& pixel, ID3D11ShaderResourceView* diff, ID3D11SamplerState* sampler)
 {
@@ -7,6 +8,9 @@ Material::Material(std::shared_ptr<SimpleVertexShader> const& vertex, std::share
 
 	diffuse = diff;
 	textureSampler = sampler;
+
+	FindParams();
+	BuildParameterBlocks();
 }
 
 Material::Material(std::shared_ptr<SimpleVertexShader> const & vertex, std::shared_ptr<SimplePixelShader> const & pixel, ID3D11ShaderResourceView * diff, ID3D11ShaderResourceView * spec, ID3D11SamplerState * sampler)
@@ -17,6 +21,9 @@ Material::Material(std::shared_ptr<SimpleVertexShader> const & vertex, std::shar
 	diffuse = diff;
 	specular = spec;
 	textureSampler = sampler;
+
+	FindParams();
+	BuildParameterBlocks();
 }
 
 Material::Material(std::shared_ptr<SimpleVertexShader> const & vertex, std::shared_ptr<SimplePixelShader> const & pixel, ID3D11ShaderResourceView * diff, ID3D11ShaderResourceView * spec, ID3D11ShaderResourceView * norm, ID3D11SamplerState * sampler)
@@ -28,6 +35,9 @@ Material::Material(std::shared_ptr<SimpleVertexShader> const & vertex, std::shar
 	specular = spec;
 	normal = norm;
 	textureSampler = sampler;
+
+	FindParams();
+	BuildParameterBlocks();
 }
 
 //pbr material (metalness-roughness workflow)
@@ -42,10 +52,16 @@ Material::Material(std::shared_ptr<SimpleVertexShader> const & vertex, std::shar
 	specular = nullptr;
 	normal = norm;
 	textureSampler = sampler;
+
+	FindParams();
+	BuildParameterBlocks();
 }
 
 Material::~Material()
 {
+	delete vertexParameters;
+	delete pixelParameters;
+
 	//release textures + samplers
 	if (diffuse) { diffuse->Release(); }
 	if (specular) { specular->Release(); }
@@ -90,3 +106,76 @@ ID3D11SamplerState* Material::GetSamplerState()
 	return textureSampler;
 }
 
+const MaterialParams& Material::GetParams()
+{
+	return params;
+}
+
+void Material::FindParams()
+{
+	params.Lights = ps->GetParam("lights");
+	params.LightCount = ps->GetParam("lightCount");
+	params.DirLight = ps->GetParam("dirLight");
+	params.CameraPos = ps->GetParam("cameraPos");
+	params.PixelView = ps->GetParam("view");
+	params.DiffuseTexture = ps->GetShaderResourceViewInfo("diffuseTexture");
+	params.NormalTexture = ps->GetShaderResourceViewInfo("normalTexture");
+	params.SpecularTexture = ps->GetShaderResourceViewInfo("specularTexture");
+	params.MetallicTexture = ps->GetShaderResourceViewInfo("metallicTexture");
+	params.RoughnessTexture = ps->GetShaderResourceViewInfo("roughnessTexture");
+	params.BasicSampler = ps->GetSamplerInfo("basicSampler");
+}
+
+void Material::BuildParameterBlocks()
+{
+	vertexParameters = new MaterialParameterBlock(vs.get());
+	pixelParameters = new MaterialParameterBlock(ps.get());
+
+	// Textures never change after load
+	pixelParameters->SetSamplerState(params.BasicSampler, textureSampler);
+	pixelParameters->SetShaderResourceView(params.DiffuseTexture, diffuse);
+	pixelParameters->SetShaderResourceView(params.NormalTexture, normal);
+	if (specular != nullptr) //non-pbr
+	{
+		pixelParameters->SetShaderResourceView(params.SpecularTexture, specular);
+	}
+	else // pbr
+	{
+		pixelParameters->SetShaderResourceView(params.MetallicTexture, metalness);
+		pixelParameters->SetShaderResourceView(params.RoughnessTexture, roughness);
+	}
+}
+
+void Material::ApplyParameters()
+{
+	vertexParameters->Apply();
+	pixelParameters->Apply();
+}
+
+void Material::Bind()
+{
+	ApplyParameters();
+
+	ps->CopyAllBufferData();
+	ps->SetShader();
+}
+
+MaterialParameterBlock* Material::GetVertexParameters()
+{
+	return vertexParameters;
+}
+
+MaterialParameterBlock* Material::GetPixelParameters()
+{
+	return pixelParameters;
+}
+
+void Material::UseVariant(std::shared_ptr<SimplePixelShader> const& pixel, const ShaderVariantEntry* variant)
+{
+	ps = pixel;
+	FindParams();
+
+	delete pixelParameters;
+	pixelParameters = new MaterialParameterBlock(ps.get());
+	variant->BindResources(this, pixelParameters);
+}
@@ -1,7 +1,28 @@
 #pragma once
 #include "SimpleShader.h"
+#include "MaterialParameterBlock.h"
 #include <memory>
 
+struct ShaderVariantEntry;
+
+// Shader variables and resources set for every entity drawn with a
+// Material, looked up once when the Material is made
+struct MaterialParams
+{
+	// Pixel shader - the vertex shader's buffer is set whole, through ShaderConstants.h
+	ParamHandle Lights;
+	ParamHandle LightCount;
+	ParamHandle DirLight;
+	ParamHandle CameraPos;
+	ParamHandle PixelView;
+	const SimpleSRV* DiffuseTexture;
+	const SimpleSRV* NormalTexture;
+	const SimpleSRV* SpecularTexture;
+	const SimpleSRV* MetallicTexture;
+	const SimpleSRV* RoughnessTexture;
+	const SimpleSampler* BasicSampler;
+};
+
 class Material
 {
 public:
@@ -34,7 +55,43 @@ public:
 	ID3D11ShaderResourceView* GetRoughness();
 	ID3D11ShaderResourceView* GetNormal();
 	ID3D11SamplerState* GetSamplerState();
+
+	///<summary>
+	///Handles for the per-entity shader variables, so drawing needs no name lookups.
+	///</summary>
+	const MaterialParams& GetParams();
+
+	///<summary>
+	///Copy this material's own variables and resources into its shaders, which other materials share.
+	///</summary>
+	void ApplyParameters();
+
+	///<summary>
+	///Apply this material's parameters, upload its pixel shader's data and activate the pixel shader.
+	///</summary>
+	void Bind();
+
+	MaterialParameterBlock* GetVertexParameters();
+	MaterialParameterBlock* GetPixelParameters();
+
+	///<summary>
+	///Switch to a precompiled permutation of the pixel shader, binding only the resources it samples.
+	///</summary>
+	void UseVariant(std::shared_ptr<SimplePixelShader> const& pixel, const ShaderVariantEntry* variant);
 private:
+	///<summary>
+	///Look up the per-entity shader variables and resources in both shaders.
+	///</summary>
+	void FindParams();
+
+	///<summary>
+	///Write the material's textures and sampler into its parameter blocks, once.
+	///</summary>
+	void BuildParameterBlocks();
+
+	MaterialParams params;
+	MaterialParameterBlock* vertexParameters;
+	MaterialParameterBlock* pixelParameters;
 
 	//shaders use shared_ptrs so that materials can share shaders and so that
 	//the shaders will be cleaned up only when they are no longer referenced
@@ -0,0 +1,127 @@
+#include "MaterialParameterBlock.h"
+#include <string.h>
+
+MaterialParameterBlock::MaterialParameterBlock(ISimpleShader * shader)
+{
+	this->shader = shader;
+	layoutID = shader->GetLayoutID();
+
+	// Same layout as the shader's reflected buffers and resources
+	bufferData.resize(shader->GetBufferCount());
+	for (unsigned int i = 0; i < shader->GetBufferCount(); i++)
+		bufferData[i].resize(shader->GetBufferSize(i), 0);
+
+	shaderResourceViews.resize(shader->GetShaderResourceViewCount(), 0);
+	shaderResourceViewSet.resize(shader->GetShaderResourceViewCount(), 0);
+	samplerStates.resize(shader->GetSamplerCount(), 0);
+	samplerStateSet.resize(shader->GetSamplerCount(), 0);
+}
+
+bool MaterialParameterBlock::SetData(ParamHandle param, const void * data, unsigned int size)
+{
+	// Verify the handle against this block's layout
+	if (!param.IsValid() || param.Size != size || param.LayoutID != layoutID || param.ConstantBufferIndex >= bufferData.size())
+		return false;
+
+	std::vector<unsigned char>& buffer = bufferData[param.ConstantBufferIndex];
+	if (param.ByteOffset > buffer.size() || size > buffer.size() - param.ByteOffset)
+		return false;
+
+	memcpy(&buffer[param.ByteOffset], data, size);
+
+	// Remember the variable, once
+	for (size_t i = 0; i < setVariables.size(); i++)
+	{
+		if (setVariables[i].ConstantBufferIndex == param.ConstantBufferIndex && setVariables[i].ByteOffset == param.ByteOffset)
+			return true;
+	}
+	setVariables.push_back(param);
+	return true;
+}
+
+bool MaterialParameterBlock::SetData(const std::string & name, const void * data, unsigned int size)
+{
+	return SetData(shader->GetParam(name), data, size);
+}
+
+bool MaterialParameterBlock::SetInt(ParamHandle param, int data)
+{
+	return SetData(param, &data, sizeof(int));
+}
+
+bool MaterialParameterBlock::SetFloat(ParamHandle param, float data)
+{
+	return SetData(param, &data, sizeof(float));
+}
+
+bool MaterialParameterBlock::SetFloat3(ParamHandle param, const DirectX::XMFLOAT3 & data)
+{
+	return SetData(param, &data, sizeof(float) * 3);
+}
+
+bool MaterialParameterBlock::SetFloat4(ParamHandle param, const DirectX::XMFLOAT4 & data)
+{
+	return SetData(param, &data, sizeof(float) * 4);
+}
+
+bool MaterialParameterBlock::SetMatrix4x4(ParamHandle param, const DirectX::XMFLOAT4X4 & data)
+{
+	return SetData(param, &data, sizeof(float) * 16);
+}
+
+bool MaterialParameterBlock::SetShaderResourceView(const SimpleSRV * srvInfo, ID3D11ShaderResourceView * srv)
+{
+	if (srvInfo == 0 || srvInfo->Index >= shaderResourceViews.size())
+		return false;
+
+	shaderResourceViews[srvInfo->Index] = srv;
+	shaderResourceViewSet[srvInfo->Index] = 1;
+	return true;
+}
+
+bool MaterialParameterBlock::SetShaderResourceView(const std::string & name, ID3D11ShaderResourceView * srv)
+{
+	return SetShaderResourceView(shader->GetShaderResourceViewInfo(name), srv);
+}
+
+bool MaterialParameterBlock::SetSamplerState(const SimpleSampler * sampInfo, ID3D11SamplerState * samplerState)
+{
+	if (sampInfo == 0 || sampInfo->Index >= samplerStates.size())
+		return false;
+
+	samplerStates[sampInfo->Index] = samplerState;
+	samplerStateSet[sampInfo->Index] = 1;
+	return true;
+}
+
+bool MaterialParameterBlock::SetSamplerState(const std::string & name, ID3D11SamplerState * samplerState)
+{
+	return SetSamplerState(shader->GetSamplerInfo(name), samplerState);
+}
+
+void MaterialParameterBlock::Apply()
+{
+	// The shader skips any bytes that are already in place
+	for (size_t i = 0; i < setVariables.size(); i++)
+	{
+		const ParamHandle& param = setVariables[i];
+		shader->SetData(param, &bufferData[param.ConstantBufferIndex][param.ByteOffset], param.Size);
+	}
+
+	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
+	{
+		if (shaderResourceViewSet[i])
+			shader->SetShaderResourceView(shader->GetShaderResourceViewInfo(i), shaderResourceViews[i]);
+	}
+
+	for (unsigned int i = 0; i < samplerStates.size(); i++)
+	{
+		if (samplerStateSet[i])
+			shader->SetSamplerState(shader->GetSamplerInfo(i), samplerStates[i]);
+	}
+}
+
+ISimpleShader * MaterialParameterBlock::GetShader()
+{
+	return shader;
+}
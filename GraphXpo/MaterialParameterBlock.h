@@ -0,0 +1,65 @@
+#pragma once
+
+#include "SimpleShader.h"
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// A material's own copy of the shader variables and
+// resources it sets, laid out like the shader's reflected
+// constant buffers and resource tables.
+//
+// Many materials share one shader, and with it one local
+// data buffer, so anything a material sets there has to be
+// set again before each of its draws.  A block is written
+// once (at load, for static material data) and then copied
+// into the shader with Apply() when drawing.  Apply() only
+// touches what the block has set, so per-object and
+// per-frame values set directly on the shader are kept.
+//
+// Outside of Set calls a block is never modified, so it can
+// be read from any thread.  It does not hold references to
+// the views and states it is given.
+// --------------------------------------------------------
+class MaterialParameterBlock
+{
+public:
+	MaterialParameterBlock(ISimpleShader* shader);
+
+	// Shader variables, by handle (from the shader's GetParam()) or by name.
+	// Handles from a shader with a different layout are refused.
+	bool SetData(ParamHandle param, const void* data, unsigned int size);
+	bool SetData(const std::string& name, const void* data, unsigned int size);
+	bool SetInt(ParamHandle param, int data);
+	bool SetFloat(ParamHandle param, float data);
+	bool SetFloat3(ParamHandle param, const DirectX::XMFLOAT3& data);
+	bool SetFloat4(ParamHandle param, const DirectX::XMFLOAT4& data);
+	bool SetMatrix4x4(ParamHandle param, const DirectX::XMFLOAT4X4& data);
+
+	// Resources, by info (from the shader) or by name
+	bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv);
+	bool SetShaderResourceView(const std::string& name, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState);
+	bool SetSamplerState(const std::string& name, ID3D11SamplerState* samplerState);
+
+	///<summary>
+	///Copy everything this block has set into its shader's local data and bind its resources.
+	///</summary>
+	void Apply();
+
+	ISimpleShader* GetShader();
+
+private:
+	ISimpleShader* shader;
+	unsigned int layoutID;	// The shader's, which handles must match
+
+	// One block of bytes per constant buffer, and which variables in them have been set
+	std::vector<std::vector<unsigned char>> bufferData;
+	std::vector<ParamHandle> setVariables;
+
+	// Indexed like the shader's SRVs and samplers, with whether each has been set
+	std::vector<ID3D11ShaderResourceView*> shaderResourceViews;
+	std::vector<char> shaderResourceViewSet;
+	std::vector<ID3D11SamplerState*> samplerStates;
+	std::vector<char> samplerStateSet;
+};
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <stdexcept>
 #include <iostream>
+#include <math.h>
 
 
 using namespace DirectX;
@@ -335,6 +336,8 @@ void Mesh::CalculateTangents(Vertex* vertices, int vertexCount, UINT* indices, i
 ///</summary>
 void Mesh::CreateBuffers(Vertex* vertices, int vertexCount, UINT * indices, int indexCount, ID3D11Device * device)
 {
+	CalculateBounds(vertices, vertexCount);
+
 	// Create the VERTEX BUFFER description -----------------------------------
 	// - The description is created on the stack because we only need
 	//    it to create the buffer.  The description is then useless.
@@ -382,3 +385,35 @@ void Mesh::CreateBuffers(Vertex* vertices, int vertexCount, UINT * indices, int
 	//Finally, store the index count for later retrieval in Draw calls
 	numIndices = indexCount;
 }
+
+void Mesh::CalculateBounds(Vertex* vertices, int vertexCount)
+{
+	bounds = AABB();
+	for (int i = 0; i < vertexCount; i++)
+		bounds.Encapsulate(vertices[i].Position);
+
+	if (vertexCount == 0)
+		bounds = AABB(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0));
+
+	// Centered on the box, reaching the farthest vertex
+	boundingSphere.Center = bounds.GetCenter();
+	XMVECTOR center = XMLoadFloat3(&boundingSphere.Center);
+	float radiusSquared = 0.0f;
+	for (int i = 0; i < vertexCount; i++)
+	{
+		float distanceSquared = XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(XMLoadFloat3(&vertices[i].Position), center)));
+		if (distanceSquared > radiusSquared)
+			radiusSquared = distanceSquared;
+	}
+	boundingSphere.Radius = sqrtf(radiusSquared);
+}
+
+const AABB& Mesh::GetBounds()
+{
+	return bounds;
+}
+
+const BoundingSphere& Mesh::GetBoundingSphere()
+{
+	return boundingSphere;
+}
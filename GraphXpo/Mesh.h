@@ -2,6 +2,7 @@
 
 #include <d3d11.h>
 #include "Vertex.h"
+#include "Bounds.h"
 
 #pragma once
 class Mesh
@@ -21,6 +22,10 @@ public:
 	ID3D11Buffer* GetIndexBuffer();
 	int GetIndexCount();
 
+	//bounds of the vertices in model space, found at load
+	const AABB& GetBounds();
+	const BoundingSphere& GetBoundingSphere();
+
 private:
 
 	///<summary>
@@ -34,6 +39,11 @@ private:
 	///</summary>
 	void CalculateTangents(Vertex* vertices, int vertexCount, UINT* indices, int indexCount);
 
+	///<summary>
+	///Finds the box and sphere around the vertices.
+	///</summary>
+	void CalculateBounds(Vertex* vertices, int vertexCount);
+
 	///<summary>
 	///Helper function. Processes lists of vertices and indices into vertex and index buffers.
 	///</summary>
@@ -44,5 +54,8 @@ private:
 
 	int numIndices; //DrawIndexed() needs to know how many indices to use from the given index buffer, 
 					//so we need to keep track of the max possible indices to use
+
+	AABB bounds;
+	BoundingSphere boundingSphere;
 };
 
@@ -19,6 +19,16 @@ struct DirectionalLight
 
 
 #define MAX_LIGHTS 6
+
+// Permutation switches, set by the variant wrappers (see ShaderVariants.cpp).
+// The defaults make this file the general version: normal mapped, with the
+// light count only known at runtime.
+#ifndef NORMAL_MAP
+#define NORMAL_MAP 1
+#endif
+#ifndef LIGHT_LIMIT
+#define LIGHT_LIMIT 0
+#endif
 cbuffer externalData : register(b0)
 {
 	PointLight lights[MAX_LIGHTS];
@@ -148,9 +158,11 @@ float4 main(VertexToPixel input) : SV_TARGET
 
 	//Ensure normal and tangent are normalized and orthogonal after being interpolated
 	input.normal = normalize(input.normal);
+#if NORMAL_MAP
 	input.tangent = normalize(input.tangent - dot(input.tangent, input.normal) * input.normal);
 	
 	input.normal = ApplyNormalMap(input);
+#endif
 
 	//calc. surface details before lighting
 	float4 surfaceColor = diffuseTexture.Sample(basicSampler, input.UV);
@@ -162,10 +174,19 @@ float4 main(VertexToPixel input) : SV_TARGET
 
 	//process all lights this frame
 	float3 lightColor = float3(0, 0, 0);
+#if LIGHT_LIMIT > 0
+	// A fixed count unrolls, and lights past lightCount are masked off without branching
+	[unroll]
+	for (int i = 0; i < LIGHT_LIMIT; i++)
+	{
+		lightColor += (i < lightCount) ? PointLights(lights[i], input, surfaceColor, specColor, metalness, roughness) : float3(0, 0, 0);
+	}
+#else
 	for (int i = 0; i < lightCount; i++)
 	{
 		lightColor += PointLights(lights[i], input, surfaceColor, specColor, metalness, roughness);
 	}
+#endif
 	lightColor += DirLight(dirLight, input, surfaceColor, specColor, metalness, roughness);
 
 	float4 finalColor = float4(lightColor,1); //apply lighting to the sampled surface color
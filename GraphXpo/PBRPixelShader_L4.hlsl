@@ -0,0 +1,5 @@
+// PBRPixelShader without normal mapping, and an unrolled loop over up to 4 lights
+// One of the permutations listed in ShaderVariants.cpp
+#define NORMAL_MAP 0
+#define LIGHT_LIMIT 4
+#include "PBRPixelShader.hlsl"
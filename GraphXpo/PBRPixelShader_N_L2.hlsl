@@ -0,0 +1,5 @@
+// PBRPixelShader with normal mapping, and an unrolled loop over up to 2 lights
+// One of the permutations listed in ShaderVariants.cpp
+#define NORMAL_MAP 1
+#define LIGHT_LIMIT 2
+#include "PBRPixelShader.hlsl"
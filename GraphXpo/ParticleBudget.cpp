@@ -0,0 +1,100 @@
+#include "ParticleBudget.h"
+#include <stddef.h>
+
+ParticleBudget::ParticleBudget(int maxLiveParticles)
+{
+	this->maxLiveParticles = maxLiveParticles;
+	smoothingRate = 2.0f;
+}
+
+void ParticleBudget::SetMaxLiveParticles(int maxLiveParticles)
+{
+	this->maxLiveParticles = maxLiveParticles;
+}
+
+int ParticleBudget::GetMaxLiveParticles()
+{
+	return maxLiveParticles;
+}
+
+void ParticleBudget::SetSmoothingRate(float rate)
+{
+	smoothingRate = rate;
+}
+
+void ParticleBudget::Allocate(const std::vector<ParticleBudgetRequest>& requests, float deltaTime, std::vector<int>& quotas, std::vector<float>& spawnRateScales)
+{
+	size_t count = requests.size();
+	quotas.resize(count);
+	spawnRateScales.resize(count);
+	smoothedScales.resize(count, 1.0f);
+	satisfied.assign(count, 0);
+
+	int totalDemand = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		quotas[i] = requests[i].Demand;
+		totalDemand += requests[i].Demand;
+	}
+
+	// Over budget - hand out shares by weight.  Requests that need less
+	// than their share are granted in full and drop out, which frees up
+	// budget for the others, so repeat until nobody else drops out.
+	if (maxLiveParticles > 0 && totalDemand > maxLiveParticles)
+	{
+		int remaining = maxLiveParticles;
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+
+			float totalWeight = 0;
+			for (size_t i = 0; i < count; i++)
+			{
+				if (!satisfied[i])
+					totalWeight += requests[i].Weight;
+			}
+			if (totalWeight <= 0)
+				break;
+
+			for (size_t i = 0; i < count; i++)
+			{
+				if (satisfied[i])
+					continue;
+
+				float share = remaining * requests[i].Weight / totalWeight;
+				if (requests[i].Demand <= share)
+				{
+					quotas[i] = requests[i].Demand;
+					remaining -= requests[i].Demand;
+					satisfied[i] = 1;
+					changed = true;
+				}
+			}
+		}
+
+		// Everyone left gets their share, rounded down so the total never exceeds the budget
+		float totalWeight = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!satisfied[i])
+				totalWeight += requests[i].Weight;
+		}
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!satisfied[i])
+				quotas[i] = totalWeight > 0 ? (int)(remaining * requests[i].Weight / totalWeight) : 0;
+		}
+	}
+
+	// Ease spawn rates towards the fraction of demand that was granted
+	float blend = deltaTime * smoothingRate;
+	if (blend > 1.0f)
+		blend = 1.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		float target = requests[i].Demand > 0 ? (float)quotas[i] / requests[i].Demand : 1.0f;
+		smoothedScales[i] += (target - smoothedScales[i]) * blend;
+		spawnRateScales[i] = smoothedScales[i];
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+
+// What one Emitter would like from the budget this frame
+struct ParticleBudgetRequest
+{
+	int Demand;		// Live Particles it would have at its current spawn rate
+	float Weight;	// Priority combined with screen coverage and distance
+};
+
+// --------------------------------------------------------
+// Shares a fixed number of live Particles between Emitters.
+//
+// When the total demand fits, everyone gets what they ask
+// for.  Otherwise the budget is split in proportion to
+// weight, with any share an Emitter doesn't need passed on
+// to the rest.  Granted counts are hard caps; the matching
+// spawn rate scales ease towards their targets so effects
+// thin out gradually instead of popping.
+// --------------------------------------------------------
+class ParticleBudget
+{
+public:
+	///<summary>
+	///Create a budget of maxLiveParticles; 0 means unlimited.
+	///</summary>
+	ParticleBudget(int maxLiveParticles = 0);
+
+	void SetMaxLiveParticles(int maxLiveParticles);
+	int GetMaxLiveParticles();
+
+	///<summary>
+	///How quickly spawn rate scales move towards their targets, as a fraction per second.
+	///</summary>
+	void SetSmoothingRate(float rate);
+
+	///<summary>
+	///Share the budget between requests.  Fills quotas with each request's hard cap on live
+	///Particles and spawnRateScales with its smoothed spawn rate multiplier.
+	///</summary>
+	void Allocate(const std::vector<ParticleBudgetRequest>& requests, float deltaTime, std::vector<int>& quotas, std::vector<float>& spawnRateScales);
+
+private:
+	int maxLiveParticles;
+	float smoothingRate;
+	std::vector<float> smoothedScales;	// Last scale given to each request slot
+	std::vector<char> satisfied;		// Scratch space for Allocate
+};
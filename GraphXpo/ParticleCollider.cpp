@@ -0,0 +1,272 @@
+#include "ParticleCollider.h"
+#include "Emitter.h"
+#include <math.h>
+
+using namespace DirectX;
+
+ParticleCollider::ParticleCollider(ParticleCollisionResponse response, float restitution, float friction)
+{
+	this->response = response;
+	this->restitution = restitution;
+	this->friction = friction;
+}
+
+void ParticleCollider::AddPlane(DirectX::XMFLOAT3 normal, float distance)
+{
+	ParticleColliderPlane plane;
+	XMStoreFloat3(&plane.Normal, XMVector3Normalize(XMLoadFloat3(&normal)));
+	plane.Distance = distance;
+	planes.push_back(plane);
+}
+
+void ParticleCollider::AddBox(const ParticleColliderBox & box)
+{
+	boxes.push_back(box);
+}
+
+void ParticleCollider::AddBox(DirectX::XMFLOAT4X4 world, DirectX::XMFLOAT3 localHalfExtents)
+{
+	// The matrix is transposed, so its columns hold the scaled local axes and the translation
+	XMFLOAT3 axes[3] =
+	{
+		XMFLOAT3(world._11, world._21, world._31),
+		XMFLOAT3(world._12, world._22, world._32),
+		XMFLOAT3(world._13, world._23, world._33)
+	};
+	float localExtents[3] = { localHalfExtents.x, localHalfExtents.y, localHalfExtents.z };
+	float extents[3];
+
+	ParticleColliderBox box;
+	box.Center = XMFLOAT3(world._14, world._24, world._34);
+	for (int i = 0; i < 3; i++)
+	{
+		// Fold each axis' scale into the extent along it
+		XMVECTOR axis = XMLoadFloat3(&axes[i]);
+		extents[i] = localExtents[i] * XMVectorGetX(XMVector3Length(axis));
+		XMStoreFloat3(&box.Axes[i], XMVector3Normalize(axis));
+	}
+	box.HalfExtents = XMFLOAT3(extents[0], extents[1], extents[2]);
+
+	boxes.push_back(box);
+}
+
+int ParticleCollider::AddEntityBoxes(GameEntity * const * entities, int count, Mesh * boxMesh, DirectX::XMFLOAT3 localHalfExtents, const AABB & region)
+{
+	int added = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (entities[i]->mesh.get() != boxMesh)
+			continue;
+
+		// Entities may not have been drawn yet
+		Transform* transform = entities[i]->transform;
+		if (transform->matrixOutdated)
+			transform->CalculateWorldMatrix();
+
+		size_t before = boxes.size();
+		AddBox(transform->GetWorldMatrix(), localHalfExtents);
+		const ParticleColliderBox& box = boxes.back();
+
+		// World space AABB of the oriented box
+		XMFLOAT3 reach;
+		reach.x = fabsf(box.Axes[0].x) * box.HalfExtents.x + fabsf(box.Axes[1].x) * box.HalfExtents.y + fabsf(box.Axes[2].x) * box.HalfExtents.z;
+		reach.y = fabsf(box.Axes[0].y) * box.HalfExtents.x + fabsf(box.Axes[1].y) * box.HalfExtents.y + fabsf(box.Axes[2].y) * box.HalfExtents.z;
+		reach.z = fabsf(box.Axes[0].z) * box.HalfExtents.x + fabsf(box.Axes[1].z) * box.HalfExtents.y + fabsf(box.Axes[2].z) * box.HalfExtents.z;
+
+		// Only keep it if it's close enough to matter
+		bool overlaps =
+			box.Center.x - reach.x <= region.Max.x && box.Center.x + reach.x >= region.Min.x &&
+			box.Center.y - reach.y <= region.Max.y && box.Center.y + reach.y >= region.Min.y &&
+			box.Center.z - reach.z <= region.Max.z && box.Center.z + reach.z >= region.Min.z;
+		if (overlaps)
+			added++;
+		else
+			boxes.resize(before);
+	}
+
+	return added;
+}
+
+void ParticleCollider::Clear()
+{
+	planes.clear();
+	boxes.clear();
+}
+
+ParticleCollisionResponse ParticleCollider::GetResponse()
+{
+	return response;
+}
+
+void ParticleCollider::Collide(Particle * particles, int start, int count, DirectX::XMFLOAT3 acceleration, float currentTime, std::vector<int>& hitIndices)
+{
+	if (planes.empty() && boxes.empty())
+		return;
+
+	// Eight Particles per pass, as two sets of four lanes
+	for (int i = 0; i < count; i += 8)
+	{
+		CollideLanes(particles, start + i, min(4, count - i), acceleration, currentTime, hitIndices);
+		if (count - i > 4)
+			CollideLanes(particles, start + i + 4, min(4, count - i - 4), acceleration, currentTime, hitIndices);
+	}
+}
+
+void ParticleCollider::CollideLanes(Particle * particles, int start, int lanes, DirectX::XMFLOAT3 acceleration, float currentTime, std::vector<int>& hitIndices)
+{
+	// Gather the Particles into one register per field
+	XMVECTORF32 spawnTime, startX, startY, startZ, velX, velY, velZ;
+	XMVECTORU32 live;
+	for (int l = 0; l < 4; l++)
+	{
+		// Unused lanes repeat the first Particle, but are never live
+		Particle* p = &particles[start + (l < lanes ? l : 0)];
+		spawnTime.f[l] = p->SpawnTime;
+		startX.f[l] = p->StartPosition.x;
+		startY.f[l] = p->StartPosition.y;
+		startZ.f[l] = p->StartPosition.z;
+		velX.f[l] = p->StartVelocity.x;
+		velY.f[l] = p->StartVelocity.y;
+		velZ.f[l] = p->StartVelocity.z;
+		live.u[l] = (l < lanes && !(p->Flags & ParticleFlagKilled)) ? 0xFFFFFFFF : 0;
+	}
+
+	// Where each Particle is now, and how fast it's going
+	XMVECTOR accelX = XMVectorReplicate(acceleration.x);
+	XMVECTOR accelY = XMVectorReplicate(acceleration.y);
+	XMVECTOR accelZ = XMVectorReplicate(acceleration.z);
+	XMVECTOR t = XMVectorSubtract(XMVectorReplicate(currentTime), spawnTime);
+	XMVECTOR halfTSquared = XMVectorMultiply(XMVectorMultiply(t, t), XMVectorReplicate(0.5f));
+
+	XMVECTOR posX = XMVectorMultiplyAdd(accelX, halfTSquared, XMVectorMultiplyAdd(velX, t, startX));
+	XMVECTOR posY = XMVectorMultiplyAdd(accelY, halfTSquared, XMVectorMultiplyAdd(velY, t, startY));
+	XMVECTOR posZ = XMVectorMultiplyAdd(accelZ, halfTSquared, XMVectorMultiplyAdd(velZ, t, startZ));
+	XMVECTOR curVelX = XMVectorMultiplyAdd(accelX, t, velX);
+	XMVECTOR curVelY = XMVectorMultiplyAdd(accelY, t, velY);
+	XMVECTOR curVelZ = XMVectorMultiplyAdd(accelZ, t, velZ);
+
+	XMVECTOR alive = live;
+	XMVECTOR hit = XMVectorFalseInt();
+	XMVECTOR killed = XMVectorFalseInt();
+	XMVECTOR zero = XMVectorZero();
+
+	XMVECTOR keep = XMVectorReplicate(1.0f - friction);
+	XMVECTOR bounce = XMVectorReplicate(restitution);
+
+	// Push the masked lanes depth along n and reflect their velocity off the surface
+	auto respond = [&](XMVECTOR mask, XMVECTOR nx, XMVECTOR ny, XMVECTOR nz, XMVECTOR depth)
+	{
+		if (response == ParticleCollisionResponse::Kill)
+		{
+			killed = XMVectorOrInt(killed, mask);
+			alive = XMVectorAndCInt(alive, mask);
+			return;
+		}
+
+		posX = XMVectorSelect(posX, XMVectorMultiplyAdd(nx, depth, posX), mask);
+		posY = XMVectorSelect(posY, XMVectorMultiplyAdd(ny, depth, posY), mask);
+		posZ = XMVectorSelect(posZ, XMVectorMultiplyAdd(nz, depth, posZ), mask);
+
+		// Only reflect Particles still heading into the surface
+		XMVECTOR normalSpeed = XMVectorMultiplyAdd(curVelX, nx, XMVectorMultiplyAdd(curVelY, ny, XMVectorMultiply(curVelZ, nz)));
+		XMVECTOR reflect = XMVectorAndInt(mask, XMVectorLess(normalSpeed, zero));
+
+		// Split into normal and tangential parts, then damp each
+		XMVECTOR tangentX = XMVectorNegativeMultiplySubtract(nx, normalSpeed, curVelX);
+		XMVECTOR tangentY = XMVectorNegativeMultiplySubtract(ny, normalSpeed, curVelY);
+		XMVECTOR tangentZ = XMVectorNegativeMultiplySubtract(nz, normalSpeed, curVelZ);
+		XMVECTOR outSpeed = XMVectorNegate(XMVectorMultiply(normalSpeed, bounce));
+
+		curVelX = XMVectorSelect(curVelX, XMVectorMultiplyAdd(nx, outSpeed, XMVectorMultiply(tangentX, keep)), reflect);
+		curVelY = XMVectorSelect(curVelY, XMVectorMultiplyAdd(ny, outSpeed, XMVectorMultiply(tangentY, keep)), reflect);
+		curVelZ = XMVectorSelect(curVelZ, XMVectorMultiplyAdd(nz, outSpeed, XMVectorMultiply(tangentZ, keep)), reflect);
+
+		hit = XMVectorOrInt(hit, mask);
+	};
+
+	// Planes - anything behind one is pushed back onto it
+	for (size_t i = 0; i < planes.size(); i++)
+	{
+		XMVECTOR nx = XMVectorReplicate(planes[i].Normal.x);
+		XMVECTOR ny = XMVectorReplicate(planes[i].Normal.y);
+		XMVECTOR nz = XMVectorReplicate(planes[i].Normal.z);
+		XMVECTOR distance = XMVectorMultiplyAdd(nx, posX, XMVectorMultiplyAdd(ny, posY, XMVectorMultiplyAdd(nz, posZ, XMVectorReplicate(planes[i].Distance))));
+
+		XMVECTOR inside = XMVectorAndInt(alive, XMVectorLess(distance, zero));
+		if (XMVector4EqualInt(inside, XMVectorFalseInt()))
+			continue;
+
+		respond(inside, nx, ny, nz, XMVectorNegate(distance));
+	}
+
+	// Boxes - anything inside one leaves through the nearest face
+	for (size_t i = 0; i < boxes.size(); i++)
+	{
+		const ParticleColliderBox& box = boxes[i];
+		XMVECTOR dx = XMVectorSubtract(posX, XMVectorReplicate(box.Center.x));
+		XMVECTOR dy = XMVectorSubtract(posY, XMVectorReplicate(box.Center.y));
+		XMVECTOR dz = XMVectorSubtract(posZ, XMVectorReplicate(box.Center.z));
+
+		// Position in the box's own space, and how far inside each pair of faces it is
+		XMVECTOR local[3];
+		XMVECTOR penetration[3];
+		float extents[3] = { box.HalfExtents.x, box.HalfExtents.y, box.HalfExtents.z };
+		XMVECTOR inside = alive;
+		for (int a = 0; a < 3; a++)
+		{
+			local[a] = XMVectorMultiplyAdd(dx, XMVectorReplicate(box.Axes[a].x),
+				XMVectorMultiplyAdd(dy, XMVectorReplicate(box.Axes[a].y),
+				XMVectorMultiply(dz, XMVectorReplicate(box.Axes[a].z))));
+			penetration[a] = XMVectorSubtract(XMVectorReplicate(extents[a]), XMVectorAbs(local[a]));
+			inside = XMVectorAndInt(inside, XMVectorGreater(penetration[a], zero));
+		}
+		if (XMVector4EqualInt(inside, XMVectorFalseInt()))
+			continue;
+
+		// Pick the axis with the shallowest penetration
+		XMVECTOR useX = XMVectorAndInt(XMVectorLessOrEqual(penetration[0], penetration[1]), XMVectorLessOrEqual(penetration[0], penetration[2]));
+		XMVECTOR useY = XMVectorAndCInt(XMVectorLessOrEqual(penetration[1], penetration[2]), useX);
+		XMVECTOR depth = XMVectorSelect(XMVectorSelect(penetration[2], penetration[1], useY), penetration[0], useX);
+		XMVECTOR side = XMVectorSelect(XMVectorSelect(local[2], local[1], useY), local[0], useX);
+		XMVECTOR sign = XMVectorSelect(XMVectorReplicate(-1.0f), XMVectorReplicate(1.0f), XMVectorGreaterOrEqual(side, zero));
+
+		// The face's outward normal
+		XMVECTOR nx = XMVectorMultiply(sign, XMVectorSelect(XMVectorSelect(XMVectorReplicate(box.Axes[2].x), XMVectorReplicate(box.Axes[1].x), useY), XMVectorReplicate(box.Axes[0].x), useX));
+		XMVECTOR ny = XMVectorMultiply(sign, XMVectorSelect(XMVectorSelect(XMVectorReplicate(box.Axes[2].y), XMVectorReplicate(box.Axes[1].y), useY), XMVectorReplicate(box.Axes[0].y), useX));
+		XMVECTOR nz = XMVectorMultiply(sign, XMVectorSelect(XMVectorSelect(XMVectorReplicate(box.Axes[2].z), XMVectorReplicate(box.Axes[1].z), useY), XMVectorReplicate(box.Axes[0].z), useX));
+
+		respond(inside, nx, ny, nz, depth);
+	}
+
+	if (XMVector4EqualInt(XMVectorOrInt(hit, killed), XMVectorFalseInt()))
+		return;
+
+	// Rebase bounced Particles so the closed-form path continues from where they are now:
+	// v0 = v - a*t and p0 = p - v0*t - a*t*t/2
+	XMVECTORF32 outStartX, outStartY, outStartZ, outVelX, outVelY, outVelZ;
+	outVelX.v = XMVectorNegativeMultiplySubtract(accelX, t, curVelX);
+	outVelY.v = XMVectorNegativeMultiplySubtract(accelY, t, curVelY);
+	outVelZ.v = XMVectorNegativeMultiplySubtract(accelZ, t, curVelZ);
+	outStartX.v = XMVectorNegativeMultiplySubtract(accelX, halfTSquared, XMVectorNegativeMultiplySubtract(outVelX.v, t, posX));
+	outStartY.v = XMVectorNegativeMultiplySubtract(accelY, halfTSquared, XMVectorNegativeMultiplySubtract(outVelY.v, t, posY));
+	outStartZ.v = XMVectorNegativeMultiplySubtract(accelZ, halfTSquared, XMVectorNegativeMultiplySubtract(outVelZ.v, t, posZ));
+
+	XMVECTORU32 hitLanes, killedLanes;
+	hitLanes.v = hit;
+	killedLanes.v = killed;
+	for (int l = 0; l < lanes; l++)
+	{
+		Particle* p = &particles[start + l];
+		if (killedLanes.u[l])
+			p->Flags |= ParticleFlagKilled;
+		else if (hitLanes.u[l])
+		{
+			p->StartPosition = XMFLOAT3(outStartX.f[l], outStartY.f[l], outStartZ.f[l]);
+			p->StartVelocity = XMFLOAT3(outVelX.f[l], outVelY.f[l], outVelZ.f[l]);
+		}
+		else
+			continue;
+
+		hitIndices.push_back(start + l);
+	}
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+#include "Bounds.h"
+#include "GameEntity.h"
+
+struct Particle;
+
+// What happens to a Particle that hits something
+enum class ParticleCollisionResponse
+{
+	Bounce,		// Reflect off the surface, losing some speed
+	Kill		// Disappear on contact
+};
+
+// Half-space n.x + d >= 0 that Particles must stay inside
+struct ParticleColliderPlane
+{
+	DirectX::XMFLOAT3 Normal;
+	float Distance;
+};
+
+// Oriented box that Particles must stay out of
+struct ParticleColliderBox
+{
+	DirectX::XMFLOAT3 Center;
+	DirectX::XMFLOAT3 Axes[3];		// Unit length
+	DirectX::XMFLOAT3 HalfExtents;	// Along each axis
+};
+
+// --------------------------------------------------------
+// A set of planes and boxes that an Emitter's Particles
+// collide with, and how they respond.
+//
+// Particles move along closed-form paths, so a collision
+// rebases the Particle's start position and velocity so
+// that the same formula carries on from the contact point,
+// leaving its SpawnTime (and so its age) untouched.
+//
+// Particles are tested eight at a time, as two halves of
+// four SIMD lanes, with their fields gathered into
+// structure-of-arrays registers for the math.
+// --------------------------------------------------------
+class ParticleCollider
+{
+public:
+	ParticleCollider(ParticleCollisionResponse response = ParticleCollisionResponse::Bounce, float restitution = 0.5f, float friction = 0.1f);
+
+	void AddPlane(DirectX::XMFLOAT3 normal, float distance);
+	void AddBox(const ParticleColliderBox& box);
+
+	///<summary>
+	///Add a box from a (transposed, as stored by Transform) world matrix and the half extents of the mesh it is applied to.
+	///</summary>
+	void AddBox(DirectX::XMFLOAT4X4 world, DirectX::XMFLOAT3 localHalfExtents);
+
+	///<summary>
+	///Add a box for every entity drawn with boxMesh whose bounds reach into region.
+	///Returns the number of boxes added.
+	///</summary>
+	int AddEntityBoxes(GameEntity* const* entities, int count, Mesh* boxMesh, DirectX::XMFLOAT3 localHalfExtents, const AABB& region);
+
+	void Clear();
+
+	ParticleCollisionResponse GetResponse();
+
+	///<summary>
+	///Collide count Particles starting at particles[start] at currentTime.  Hit Particles are rebased or
+	///flagged as killed, and their indices appended to hitIndices.
+	///</summary>
+	void Collide(Particle* particles, int start, int count, DirectX::XMFLOAT3 acceleration, float currentTime, std::vector<int>& hitIndices);
+
+private:
+	///<summary>
+	///Collide up to four Particles held in SIMD lanes.
+	///</summary>
+	void CollideLanes(Particle* particles, int start, int lanes, DirectX::XMFLOAT3 acceleration, float currentTime, std::vector<int>& hitIndices);
+
+	std::vector<ParticleColliderPlane> planes;
+	std::vector<ParticleColliderBox> boxes;
+
+	ParticleCollisionResponse response;
+	float restitution;	// Fraction of speed kept into the surface after a bounce
+	float friction;		// Fraction of speed lost along the surface after a bounce
+};
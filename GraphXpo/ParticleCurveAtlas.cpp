@@ -0,0 +1,164 @@
+#include "ParticleCurveAtlas.h"
+#include <math.h>
+
+using namespace DirectX;
+
+ParticleCurveAtlas::ParticleCurveAtlas()
+{
+	bufferOutdated = true;
+	buffer = 0;
+	srv = 0;
+}
+
+ParticleCurveAtlas::~ParticleCurveAtlas()
+{
+	if (buffer) buffer->Release();
+	if (srv) srv->Release();
+}
+
+int ParticleCurveAtlas::AddRow(const std::vector<ParticleColorKey>& colorKeys, const std::vector<ParticleCurveKey>& sizeKeys, const std::vector<ParticleCurveKey>& rotationKeys)
+{
+	int row = GetRowCount();
+
+	for (int i = 0; i < SamplesPerRow; i++)
+	{
+		float t = (float)i / (SamplesPerRow - 1);
+
+		ParticleCurveSample sample = {};
+		sample.Color = Evaluate(colorKeys, t);
+		sample.Size = Evaluate(sizeKeys, t, 1.0f);
+		sample.Rotation = Evaluate(rotationKeys, t, t);
+		samples.push_back(sample);
+	}
+
+	bufferOutdated = true;
+	return row;
+}
+
+int ParticleCurveAtlas::AddLinearRow(DirectX::XMFLOAT4 startColor, DirectX::XMFLOAT4 endColor, float startSize, float endSize)
+{
+	std::vector<ParticleColorKey> colorKeys = { { 0.0f, startColor }, { 1.0f, endColor } };
+	std::vector<ParticleCurveKey> sizeKeys = { { 0.0f, startSize }, { 1.0f, endSize } };
+	std::vector<ParticleCurveKey> rotationKeys = { { 0.0f, 0.0f }, { 1.0f, 1.0f } };
+	return AddRow(colorKeys, sizeKeys, rotationKeys);
+}
+
+ParticleCurveSample ParticleCurveAtlas::Sample(int row, float agePercent)
+{
+	// Same filtering as ParticleVertexShader.hlsl
+	float x = fminf(fmaxf(agePercent, 0.0f), 1.0f) * (SamplesPerRow - 1);
+	int i0 = (int)x;
+	int i1 = i0 + 1 < SamplesPerRow ? i0 + 1 : SamplesPerRow - 1;
+	float f = x - i0;
+
+	const ParticleCurveSample& a = samples[row * SamplesPerRow + i0];
+	const ParticleCurveSample& b = samples[row * SamplesPerRow + i1];
+
+	// Size, rotation and padding lerp together as a second vector
+	XMVECTOR blend = XMVectorReplicate(f);
+	ParticleCurveSample result;
+	XMStoreFloat4(&result.Color, XMVectorLerpV(XMLoadFloat4(&a.Color), XMLoadFloat4(&b.Color), blend));
+	XMFLOAT4 rest;
+	XMStoreFloat4(&rest, XMVectorLerpV(
+		XMVectorSet(a.Size, a.Rotation, 0, 0),
+		XMVectorSet(b.Size, b.Rotation, 0, 0),
+		blend));
+	result.Size = rest.x;
+	result.Rotation = rest.y;
+	result.padding = XMFLOAT2(0, 0);
+	return result;
+}
+
+float ParticleCurveAtlas::GetMaxSize(int row)
+{
+	// Filtering only blends neighbours, so the largest size is at a sample.  Read
+	// them through Sample, so bounds use exactly what the vertex shader will see.
+	float maxSize = 0;
+	for (int i = 0; i < SamplesPerRow; i++)
+		maxSize = fmaxf(maxSize, Sample(row, (float)i / (SamplesPerRow - 1)).Size);
+	return maxSize;
+}
+
+int ParticleCurveAtlas::GetRowCount()
+{
+	return (int)samples.size() / SamplesPerRow;
+}
+
+ID3D11ShaderResourceView* ParticleCurveAtlas::GetSRV(ID3D11Device * device)
+{
+	if (!bufferOutdated || samples.empty())
+		return srv;
+
+	if (buffer) { buffer->Release(); buffer = 0; }
+	if (srv) { srv->Release(); srv = 0; }
+
+	// Curves only change when rows are added, so the table can be immutable
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = &samples[0];
+
+	D3D11_BUFFER_DESC desc = {};
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	desc.CPUAccessFlags = 0;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	desc.StructureByteStride = sizeof(ParticleCurveSample);
+	desc.ByteWidth = sizeof(ParticleCurveSample) * (UINT)samples.size();
+	device->CreateBuffer(&desc, &data, &buffer);
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = (UINT)samples.size();
+	device->CreateShaderResourceView(buffer, &srvDesc, &srv);
+
+	bufferOutdated = false;
+	return srv;
+}
+
+float ParticleCurveAtlas::Evaluate(const std::vector<ParticleCurveKey>& keys, float t, float defaultValue)
+{
+	if (keys.empty())
+		return defaultValue;
+	if (t <= keys.front().Time)
+		return keys.front().Value;
+	if (t >= keys.back().Time)
+		return keys.back().Value;
+
+	for (size_t i = 1; i < keys.size(); i++)
+	{
+		if (t > keys[i].Time)
+			continue;
+
+		float span = keys[i].Time - keys[i - 1].Time;
+		float f = span > 0 ? (t - keys[i - 1].Time) / span : 1.0f;
+		return keys[i - 1].Value + (keys[i].Value - keys[i - 1].Value) * f;
+	}
+
+	return keys.back().Value;
+}
+
+DirectX::XMFLOAT4 ParticleCurveAtlas::Evaluate(const std::vector<ParticleColorKey>& keys, float t)
+{
+	if (keys.empty())
+		return XMFLOAT4(1, 1, 1, 1);
+	if (t <= keys.front().Time)
+		return keys.front().Color;
+	if (t >= keys.back().Time)
+		return keys.back().Color;
+
+	for (size_t i = 1; i < keys.size(); i++)
+	{
+		if (t > keys[i].Time)
+			continue;
+
+		float span = keys[i].Time - keys[i - 1].Time;
+		float f = span > 0 ? (t - keys[i - 1].Time) / span : 1.0f;
+
+		XMFLOAT4 color;
+		XMStoreFloat4(&color, XMVectorLerp(XMLoadFloat4(&keys[i - 1].Color), XMLoadFloat4(&keys[i].Color), f));
+		return color;
+	}
+
+	return keys.back().Color;
+}
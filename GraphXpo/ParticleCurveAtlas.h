@@ -0,0 +1,86 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <vector>
+
+// A color at a point in a Particle's life (Time from 0 to 1)
+struct ParticleColorKey
+{
+	float Time;
+	DirectX::XMFLOAT4 Color;
+};
+
+// A value at a point in a Particle's life (Time from 0 to 1)
+struct ParticleCurveKey
+{
+	float Time;
+	float Value;
+};
+
+// One baked step of a curve row, as laid out in the GPU buffer
+struct ParticleCurveSample
+{
+	DirectX::XMFLOAT4 Color;
+	float Size;
+	float Rotation;		// 0 - 1 blend from a Particle's start to end rotation
+	DirectX::XMFLOAT2 padding;
+};
+
+// --------------------------------------------------------
+// Over-lifetime curves for every Emitter, baked into rows of
+// a fixed number of samples and kept in one structured
+// buffer.  Any shape of curve then costs the same two loads
+// and a lerp per vertex.  The CPU reads the same table with
+// the same filtering through Sample(), which is what sizes
+// each Emitter's bounds.
+// --------------------------------------------------------
+class ParticleCurveAtlas
+{
+public:
+	static const int SamplesPerRow = 32;
+
+	ParticleCurveAtlas();
+	~ParticleCurveAtlas();
+
+	///<summary>
+	///Bake a row from key frames, which must be in increasing Time order.
+	///Returns the row's index.
+	///</summary>
+	int AddRow(const std::vector<ParticleColorKey>& colorKeys, const std::vector<ParticleCurveKey>& sizeKeys, const std::vector<ParticleCurveKey>& rotationKeys);
+
+	///<summary>
+	///Bake a row that lerps straight from start to end values, like the original Emitter did.
+	///</summary>
+	int AddLinearRow(DirectX::XMFLOAT4 startColor, DirectX::XMFLOAT4 endColor, float startSize, float endSize);
+
+	///<summary>
+	///Look up a row at agePercent (0 - 1), filtering between samples the same way the vertex shader does.
+	///</summary>
+	ParticleCurveSample Sample(int row, float agePercent);
+
+	///<summary>
+	///Largest size anywhere in the row, as Sample gives it.
+	///</summary>
+	float GetMaxSize(int row);
+
+	int GetRowCount();
+
+	///<summary>
+	///Get the view of the baked table, (re)creating the buffer if rows were added since last time.
+	///</summary>
+	ID3D11ShaderResourceView* GetSRV(ID3D11Device* device);
+
+private:
+	///<summary>
+	///Evaluate piecewise linear keys at time t, holding the end values outside them.
+	///</summary>
+	float Evaluate(const std::vector<ParticleCurveKey>& keys, float t, float defaultValue);
+	DirectX::XMFLOAT4 Evaluate(const std::vector<ParticleColorKey>& keys, float t);
+
+	std::vector<ParticleCurveSample> samples;	// Every row, one after another
+
+	bool bufferOutdated;
+	ID3D11Buffer* buffer;
+	ID3D11ShaderResourceView* srv;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <emmintrin.h>
+
+// --------------------------------------------------------
+// Four independent xoshiro128+ generators advanced in
+// lockstep, so a single call produces one random float
+// per SIMD lane.  Each Emitter owns one of these, which
+// keeps particle spawning deterministic per seed and free
+// of the hidden global state behind rand().
+// --------------------------------------------------------
+class ParticleRandom
+{
+public:
+	ParticleRandom(unsigned int seed = 0)
+	{
+		Seed(seed);
+	}
+
+	///<summary>
+	///Reset all four lanes to a sequence derived from the given seed.
+	///</summary>
+	void Seed(unsigned int seed)
+	{
+		// Expand the seed with splitmix64 so nearby seeds still
+		// produce unrelated streams (and the state is never all zero)
+		unsigned long long x = seed;
+		for (int i = 0; i < 16; i += 2)
+		{
+			x += 0x9E3779B97F4A7C15ull;
+			unsigned long long z = x;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			z = z ^ (z >> 31);
+
+			state[i] = (unsigned int)z;
+			state[i + 1] = (unsigned int)(z >> 32);
+		}
+	}
+
+	///<summary>
+	///Four uniform floats in [0, 1), one per lane.
+	///</summary>
+	DirectX::XMVECTOR NextFloat4()
+	{
+		// State is stored unaligned, since Emitters are heap allocated
+		// without any alignment guarantees on 32-bit builds
+		__m128i s0 = _mm_loadu_si128((const __m128i*)&state[0]);
+		__m128i s1 = _mm_loadu_si128((const __m128i*)&state[4]);
+		__m128i s2 = _mm_loadu_si128((const __m128i*)&state[8]);
+		__m128i s3 = _mm_loadu_si128((const __m128i*)&state[12]);
+
+		__m128i result = _mm_add_epi32(s0, s3);
+		__m128i t = _mm_slli_epi32(s1, 9);
+
+		s2 = _mm_xor_si128(s2, s0);
+		s3 = _mm_xor_si128(s3, s1);
+		s1 = _mm_xor_si128(s1, s2);
+		s0 = _mm_xor_si128(s0, s3);
+		s2 = _mm_xor_si128(s2, t);
+		s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+		_mm_storeu_si128((__m128i*)&state[0], s0);
+		_mm_storeu_si128((__m128i*)&state[4], s1);
+		_mm_storeu_si128((__m128i*)&state[8], s2);
+		_mm_storeu_si128((__m128i*)&state[12], s3);
+
+		// The top 24 bits convert exactly to a float in [0, 1)
+		return _mm_mul_ps(
+			_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)),
+			_mm_set1_ps(1.0f / 16777216.0f));
+	}
+
+	///<summary>
+	///Four uniform floats in [-1, 1), one per lane.
+	///</summary>
+	DirectX::XMVECTOR NextSignedFloat4()
+	{
+		return DirectX::XMVectorMultiplyAdd(NextFloat4(), DirectX::XMVectorReplicate(2.0f), DirectX::XMVectorReplicate(-1.0f));
+	}
+
+private:
+	unsigned int state[16]; // Lane-interleaved: word 0 of every lane, then word 1, and so on
+};
@@ -0,0 +1,460 @@
+#include "ParticleSystem.h"
+#include "RadixSort.h"
+#include <math.h>
+
+using namespace DirectX;
+
+ParticleSystem::ParticleSystem(ID3D11Device * device, ID3D11ShaderResourceView * texture, std::shared_ptr<SimpleVertexShader> vertexShader, std::shared_ptr<SimplePixelShader> pixelShader, WorkerPool * workerPool)
+{
+	this->device = device;
+	this->texture = texture;
+	this->vertexShader = vertexShader;
+	this->pixelShader = pixelShader;
+	this->workerPool = workerPool;
+
+	sorted = false;
+	visibleEmitterCount = 0;
+	lastBudgetTime = 0;
+	spawnsRequested = 0;
+	spawnsGranted = 0;
+	poolSize = 0;
+	buffersOutdated = true;
+	bytesUploaded = 0;
+
+	indexBuffer = 0;
+	particleBuffer = 0;
+	emitterParamsBuffer = 0;
+	drawListBuffer = 0;
+	particleSRV = 0;
+	emitterParamsSRV = 0;
+	drawListSRV = 0;
+}
+
+ParticleSystem::~ParticleSystem()
+{
+	for (size_t i = 0; i < emitters.size(); i++)
+		delete emitters[i];
+
+	ReleaseBuffers();
+}
+
+Emitter* ParticleSystem::AddEmitter(Emitter * emitter)
+{
+	emitter->SetEmitterIndex((unsigned int)emitters.size());
+	emitterBaseIndices.push_back(poolSize);
+	emitterVisible.push_back(true);
+	emitterAsleep.push_back(0);
+	emitters.push_back(emitter);
+
+	// Its bounds have to cover the largest size the LOD curve can give it
+	emitter->SetMaxSizeScale(GetMaxLODSizeScale());
+
+	poolSize += emitter->GetMaxParticles();
+	buffersOutdated = true;
+
+	return emitter;
+}
+
+void ParticleSystem::Update(float deltaTime, float currentTime)
+{
+	// Emitters share no state and each has its own random stream,
+	// so they can update on any thread in any order with the same result
+	auto updateEmitters = [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			// Draw wakes Emitters that come back into view
+			if (!emitterVisible[i])
+				emitterAsleep[i] = 1;
+			else
+				emitters[i]->Update(deltaTime, currentTime);
+		}
+	};
+
+	if (workerPool)
+		workerPool->ParallelFor((int)emitters.size(), 16, updateEmitters);
+	else
+		updateEmitters(0, (int)emitters.size());
+}
+
+void ParticleSystem::Prewarm(float duration, float currentTime)
+{
+	for (size_t i = 0; i < emitters.size(); i++)
+		emitters[i]->Prewarm(duration, currentTime);
+}
+
+void ParticleSystem::Draw(ID3D11DeviceContext * context, Camera * camera, float currentTime)
+{
+	if (poolSize == 0)
+		return;
+
+	// Give any Emitter without a curve its linear one before the atlas is uploaded
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		if (emitters[i]->GetCurveRow() < 0)
+			emitters[i]->UseLinearCurve(&curveAtlas);
+	}
+
+	if (buffersOutdated)
+		CreateBuffers();
+
+	UpdateVisibility(camera, currentTime);
+
+	// Emitters back in view catch up on everything missed while asleep,
+	// so Particles that died meanwhile are never uploaded or drawn
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		if (emitterVisible[i] && emitterAsleep[i])
+		{
+			emitters[i]->FastForward(currentTime);
+			emitterAsleep[i] = 0;
+		}
+	}
+
+	bytesUploaded = 0;
+
+	// Send each visible Emitter's new Particles to its range of the pool.
+	// Culled Emitters keep their pending count and catch up once visible.
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		if (!emitterVisible[i])
+			continue;
+
+		emitters[i]->UploadPending(context, particleBuffer, emitterBaseIndices[i]);
+		bytesUploaded += emitters[i]->GetBytesUploaded();
+	}
+
+	// Emitter values are tiny, so just resend the whole table
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	context->Map(emitterParamsBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	EmitterParams* params = (EmitterParams*)mapped.pData;
+	for (size_t i = 0; i < emitters.size(); i++)
+		params[i] = emitters[i]->GetParams();
+	context->Unmap(emitterParamsBuffer, 0);
+	bytesUploaded += sizeof(EmitterParams) * (unsigned int)emitters.size();
+
+	// Gather the live Particles of every Emitter into one list
+	int drawCount = 0;
+	context->Map(drawListBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped);
+	unsigned int* drawList = (unsigned int*)mapped.pData;
+	if (sorted)
+	{
+		drawCount = BuildSortedDrawList(sortDrawList.data(), camera, currentTime);
+		memcpy(drawList, sortDrawList.data(), sizeof(unsigned int) * drawCount);
+	}
+	else
+	{
+		for (size_t i = 0; i < emitters.size(); i++)
+		{
+			if (emitterVisible[i])
+				drawCount += emitters[i]->WriteDrawList(drawList + drawCount, emitterBaseIndices[i]);
+		}
+	}
+	context->Unmap(drawListBuffer, 0);
+	bytesUploaded += sizeof(unsigned int) * drawCount;
+
+	if (drawCount == 0)
+		return;
+
+	// Set up buffers
+	UINT stride = 0;
+	UINT offset = 0;
+	ID3D11Buffer* nullBuffer = 0;
+	context->IASetVertexBuffers(0, 1, &nullBuffer, &stride, &offset);
+	context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
+
+	// Set shaders
+	vertexShader->SetMatrix4x4("view", camera->GetViewMatrix());
+	vertexShader->SetMatrix4x4("projection", camera->GetProjectionMatrix());
+	vertexShader->SetFloat("currentTime", currentTime);
+	vertexShader->CopyAllBufferData();
+	vertexShader->SetShader();
+
+	ID3D11ShaderResourceView* srvs[4] = { particleSRV, emitterParamsSRV, drawListSRV, curveAtlas.GetSRV(device) };
+	context->VSSetShaderResources(0, 4, srvs);
+	pixelShader->SetShaderResourceView("particle", texture);
+	pixelShader->SetShader();
+
+	// Draw every Particle at once
+	context->DrawIndexed(drawCount * 6, 0, 0);
+}
+
+void ParticleSystem::SetLODCurve(const std::vector<ParticleLODPoint>& curve)
+{
+	lodCurve = curve;
+
+	float maxSizeScale = GetMaxLODSizeScale();
+	for (size_t i = 0; i < emitters.size(); i++)
+		emitters[i]->SetMaxSizeScale(maxSizeScale);
+}
+
+ParticleCurveAtlas* ParticleSystem::GetCurveAtlas()
+{
+	return &curveAtlas;
+}
+
+void ParticleSystem::SetParticleBudget(int maxLiveParticles)
+{
+	budget.SetMaxLiveParticles(maxLiveParticles);
+}
+
+int ParticleSystem::GetSpawnsRequested()
+{
+	return spawnsRequested;
+}
+
+int ParticleSystem::GetSpawnsGranted()
+{
+	return spawnsGranted;
+}
+
+int ParticleSystem::GetVisibleEmitterCount()
+{
+	return visibleEmitterCount;
+}
+
+void ParticleSystem::SetSorted(bool sorted)
+{
+	this->sorted = sorted;
+}
+
+bool ParticleSystem::IsSorted()
+{
+	return sorted;
+}
+
+unsigned int ParticleSystem::GetBytesUploaded()
+{
+	return bytesUploaded;
+}
+
+void ParticleSystem::CreateBuffers()
+{
+	ReleaseBuffers();
+
+	// Index buffer data - the same quad repeated for every Particle in the pool
+	unsigned int* indices = new unsigned int[poolSize * 6];
+	int indexCount = 0;
+	for (int i = 0; i < poolSize * 4; i += 4)
+	{
+		indices[indexCount++] = i;
+		indices[indexCount++] = i + 1;
+		indices[indexCount++] = i + 2;
+		indices[indexCount++] = i;
+		indices[indexCount++] = i + 2;
+		indices[indexCount++] = i + 3;
+	}
+	D3D11_SUBRESOURCE_DATA indexData = {};
+	indexData.pSysMem = indices;
+
+	// Index buffer
+	D3D11_BUFFER_DESC ibDesc = {};
+	ibDesc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	ibDesc.CPUAccessFlags = 0;
+	ibDesc.Usage = D3D11_USAGE_DEFAULT;
+	ibDesc.ByteWidth = sizeof(unsigned int) * poolSize * 6;
+	device->CreateBuffer(&ibDesc, &indexData, &indexBuffer);
+
+	delete[] indices;
+
+	// Particle pool - lives in GPU memory and only receives newly spawned Particles
+	D3D11_BUFFER_DESC poolDesc = {};
+	poolDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	poolDesc.CPUAccessFlags = 0;
+	poolDesc.Usage = D3D11_USAGE_DEFAULT;
+	poolDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	poolDesc.StructureByteStride = sizeof(Particle);
+	poolDesc.ByteWidth = sizeof(Particle) * poolSize;
+	device->CreateBuffer(&poolDesc, 0, &particleBuffer);
+
+	// Emitter table and draw list - rewritten every frame
+	D3D11_BUFFER_DESC paramsDesc = {};
+	paramsDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	paramsDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	paramsDesc.Usage = D3D11_USAGE_DYNAMIC;
+	paramsDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	paramsDesc.StructureByteStride = sizeof(EmitterParams);
+	paramsDesc.ByteWidth = sizeof(EmitterParams) * (UINT)emitters.size();
+	device->CreateBuffer(&paramsDesc, 0, &emitterParamsBuffer);
+
+	D3D11_BUFFER_DESC drawListDesc = paramsDesc;
+	drawListDesc.StructureByteStride = sizeof(unsigned int);
+	drawListDesc.ByteWidth = sizeof(unsigned int) * poolSize;
+	device->CreateBuffer(&drawListDesc, 0, &drawListBuffer);
+
+	// Views for the vertex shader
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = poolSize;
+	device->CreateShaderResourceView(particleBuffer, &srvDesc, &particleSRV);
+	device->CreateShaderResourceView(drawListBuffer, &srvDesc, &drawListSRV);
+
+	srvDesc.Buffer.NumElements = (UINT)emitters.size();
+	device->CreateShaderResourceView(emitterParamsBuffer, &srvDesc, &emitterParamsSRV);
+
+	// CPU side space for sorting
+	drawOffsets.resize(emitters.size() + 1);
+	sortKeys.resize(poolSize);
+	sortDrawList.resize(poolSize);
+	sortTempKeys.resize(poolSize);
+	sortTempDrawList.resize(poolSize);
+
+	// The new pool starts empty, so every live Particle has to be sent again
+	for (size_t i = 0; i < emitters.size(); i++)
+		emitters[i]->InvalidateUploads();
+
+	buffersOutdated = false;
+}
+
+void ParticleSystem::ReleaseBuffers()
+{
+	if (indexBuffer) { indexBuffer->Release(); indexBuffer = 0; }
+	if (particleBuffer) { particleBuffer->Release(); particleBuffer = 0; }
+	if (emitterParamsBuffer) { emitterParamsBuffer->Release(); emitterParamsBuffer = 0; }
+	if (drawListBuffer) { drawListBuffer->Release(); drawListBuffer = 0; }
+	if (particleSRV) { particleSRV->Release(); particleSRV = 0; }
+	if (emitterParamsSRV) { emitterParamsSRV->Release(); emitterParamsSRV = 0; }
+	if (drawListSRV) { drawListSRV->Release(); drawListSRV = 0; }
+}
+
+int ParticleSystem::BuildSortedDrawList(unsigned int * drawList, Camera * camera, float currentTime)
+{
+	// Where each Emitter's Particles start in the list.  Culled Emitters
+	// get no slots, as their part of the pool hasn't been kept up to date.
+	drawOffsets[0] = 0;
+	for (size_t i = 0; i < emitters.size(); i++)
+		drawOffsets[i + 1] = drawOffsets[i] + (emitterVisible[i] ? emitters[i]->GetLiveParticleCount() : 0);
+	int drawCount = drawOffsets[emitters.size()];
+
+	// View space depth is the dot product with the view matrix's third
+	// column, which is a row here since the stored matrix is transposed
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4 depthAxis(view._31, view._32, view._33, view._34);
+
+	// Compute keys for slices of the list, which may span several Emitters
+	auto writeKeys = [&](int begin, int end)
+	{
+		for (size_t i = 0; i < emitters.size(); i++)
+		{
+			int first = max(begin, drawOffsets[i]);
+			int last = min(end, drawOffsets[i + 1]);
+			if (first >= last)
+				continue;
+
+			emitters[i]->WriteSortKeys(
+				&sortKeys[first],
+				&drawList[first],
+				emitterBaseIndices[i],
+				first - drawOffsets[i],
+				last - first,
+				depthAxis,
+				currentTime);
+		}
+	};
+
+	if (workerPool)
+		workerPool->ParallelFor(drawCount, 1024, writeKeys);
+	else
+		writeKeys(0, drawCount);
+
+	RadixSort(sortKeys.data(), drawList, sortTempKeys.data(), sortTempDrawList.data(), drawCount, workerPool);
+	return drawCount;
+}
+
+void ParticleSystem::UpdateVisibility(Camera * camera, float currentTime)
+{
+	// The camera stores its matrices transposed for HLSL
+	XMFLOAT4X4 view = camera->GetViewMatrix();
+	XMFLOAT4X4 projection = camera->GetProjectionMatrix();
+	XMMATRIX viewProjection = XMMatrixMultiply(
+		XMMatrixTranspose(XMLoadFloat4x4(&view)),
+		XMMatrixTranspose(XMLoadFloat4x4(&projection)));
+	Frustum frustum(viewProjection);
+	XMFLOAT3 cameraPosition = camera->transform.GetPosition();
+
+	budgetRequests.resize(emitters.size());
+	lodSpawnRateScales.resize(emitters.size());
+
+	visibleEmitterCount = 0;
+	spawnsRequested = 0;
+	spawnsGranted = 0;
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		AABB bounds = emitters[i]->GetBounds();
+		emitterVisible[i] = frustum.Intersects(bounds);
+		if (emitterVisible[i])
+			visibleEmitterCount++;
+
+		// Takes effect from the next Update
+		float distance = bounds.DistanceTo(cameraPosition);
+		ParticleLODPoint lod = EvaluateLOD(distance);
+		lodSpawnRateScales[i] = lod.SpawnRateScale;
+		emitters[i]->SetSizeScale(lod.SizeScale);
+
+		// Collect what the Emitters spawned since the last Draw
+		spawnsRequested += emitters[i]->GetSpawnsRequested();
+		spawnsGranted += emitters[i]->GetSpawnsGranted();
+		emitters[i]->ResetSpawnCounters();
+
+		// Culled Emitters sleep, so they need nothing from the budget until they wake up
+		ParticleBudgetRequest& request = budgetRequests[i];
+		request.Demand = emitterVisible[i] ? (int)ceilf(emitters[i]->GetSteadyStateCount() * lod.SpawnRateScale) : 0;
+
+		// Weight by priority and roughly how much of the screen the Emitter covers
+		XMFLOAT3 extents = bounds.GetExtents();
+		float radius = sqrtf(extents.x * extents.x + extents.y * extents.y + extents.z * extents.z);
+		float coverage = radius / max(distance, radius);
+		request.Weight = emitters[i]->GetPriority() * coverage * coverage;
+	}
+
+	// Hand out the budget
+	float deltaTime = max(currentTime - lastBudgetTime, 0.0f);
+	lastBudgetTime = currentTime;
+	budget.Allocate(budgetRequests, deltaTime, budgetQuotas, budgetSpawnRateScales);
+
+	for (size_t i = 0; i < emitters.size(); i++)
+	{
+		emitters[i]->SetLiveQuota(emitterVisible[i] ? budgetQuotas[i] : emitters[i]->GetMaxParticles());
+		emitters[i]->SetSpawnRateScale(lodSpawnRateScales[i] * budgetSpawnRateScales[i]);
+	}
+}
+
+float ParticleSystem::GetMaxLODSizeScale()
+{
+	// Interpolation never goes past the keys, so the largest key is the largest scale
+	float maxSizeScale = lodCurve.empty() ? 1.0f : lodCurve[0].SizeScale;
+	for (size_t i = 1; i < lodCurve.size(); i++)
+		maxSizeScale = max(maxSizeScale, lodCurve[i].SizeScale);
+	return maxSizeScale;
+}
+
+ParticleLODPoint ParticleSystem::EvaluateLOD(float distance)
+{
+	ParticleLODPoint result = { distance, 1.0f, 1.0f };
+	if (lodCurve.empty())
+		return result;
+
+	// Clamp outside the curve
+	if (distance <= lodCurve.front().Distance)
+		return lodCurve.front();
+	if (distance >= lodCurve.back().Distance)
+		return lodCurve.back();
+
+	// Interpolate between the keys on either side
+	for (size_t i = 1; i < lodCurve.size(); i++)
+	{
+		const ParticleLODPoint& a = lodCurve[i - 1];
+		const ParticleLODPoint& b = lodCurve[i];
+		if (distance > b.Distance)
+			continue;
+
+		float t = (b.Distance > a.Distance) ? (distance - a.Distance) / (b.Distance - a.Distance) : 1.0f;
+		result.SpawnRateScale = a.SpawnRateScale + (b.SpawnRateScale - a.SpawnRateScale) * t;
+		result.SizeScale = a.SizeScale + (b.SizeScale - a.SizeScale) * t;
+		break;
+	}
+
+	return result;
+}
@@ -0,0 +1,180 @@
+#pragma once
+
+#include <d3d11.h>
+#include <DirectXMath.h>
+#include <memory>
+#include <vector>
+#include "Bounds.h"
+#include "Camera.h"
+#include "Emitter.h"
+#include "ParticleBudget.h"
+#include "SimpleShader.h"
+#include "WorkerPool.h"
+
+// One key of a distance based level of detail curve.
+// Scales are linearly interpolated between keys.
+struct ParticleLODPoint
+{
+	float Distance;			// From the camera to the nearest point of an Emitter's bounds
+	float SpawnRateScale;
+	float SizeScale;
+};
+
+// --------------------------------------------------------
+// Owns every Emitter that shares a texture and shaders, and
+// draws all of their Particles with a single DrawIndexed.
+//
+// Each Emitter gets its own range of one pooled Particle
+// buffer.  Per-Emitter values live in a structured table
+// indexed by Particle::EmitterIndex, and a list of the live
+// pool indices tells the vertex shader what to draw.
+// --------------------------------------------------------
+class ParticleSystem
+{
+public:
+	ParticleSystem(
+		ID3D11Device* device,
+		ID3D11ShaderResourceView* texture,
+		std::shared_ptr<SimpleVertexShader> vertexShader,
+		std::shared_ptr<SimplePixelShader> pixelShader,
+		WorkerPool* workerPool = 0
+	);
+	~ParticleSystem();
+
+	///<summary>
+	///Take ownership of an Emitter and include it in future updates and draws.
+	///</summary>
+	Emitter* AddEmitter(Emitter* emitter);
+
+	///<summary>
+	///Update every visible Emitter, spread across the WorkerPool when there is one.
+	///Culled Emitters sleep until a Draw finds them back in view and fast forwards them to the present.
+	///</summary>
+	void Update(float deltaTime, float currentTime);
+
+	///<summary>
+	///Start every Emitter as though it had been running for duration seconds.
+	///</summary>
+	void Prewarm(float duration, float currentTime);
+
+	///<summary>
+	///Upload new Particles and draw every Emitter at once.
+	///</summary>
+	void Draw(ID3D11DeviceContext* context, Camera* camera, float currentTime);
+
+	///<summary>
+	///Set the distance LOD curve, with keys in increasing distance order.
+	///An empty curve (the default) keeps every Emitter at full detail.
+	///</summary>
+	void SetLODCurve(const std::vector<ParticleLODPoint>& curve);
+
+	///<summary>
+	///The over-lifetime curves shared by every Emitter.  Emitters that haven't picked
+	///a row get one baked from their start and end values when first drawn.
+	///</summary>
+	ParticleCurveAtlas* GetCurveAtlas();
+
+	///<summary>
+	///Cap the live Particles shared by all visible Emitters; 0 (the default) means no cap.
+	///</summary>
+	void SetParticleBudget(int maxLiveParticles);
+
+	///<summary>
+	///Spawns the Emitters asked for, and were allowed, between the last two Draws.
+	///</summary>
+	int GetSpawnsRequested();
+	int GetSpawnsGranted();
+
+	///<summary>
+	///Number of Emitters that were inside the view frustum during the last Draw.
+	///</summary>
+	int GetVisibleEmitterCount();
+
+	///<summary>
+	///Draw Particles back to front (for alpha blending) instead of in spawn order.
+	///</summary>
+	void SetSorted(bool sorted);
+	bool IsSorted();
+
+	///<summary>
+	///Number of bytes sent to the GPU by the most recent Draw.
+	///</summary>
+	unsigned int GetBytesUploaded();
+
+private:
+	///<summary>
+	///(Re)create the pooled GPU buffers to fit the current set of Emitters.
+	///</summary>
+	void CreateBuffers();
+	void ReleaseBuffers();
+
+	///<summary>
+	///Frustum cull every Emitter, apply the LOD curve based on its distance from the camera,
+	///and share the particle budget between the visible ones.
+	///</summary>
+	void UpdateVisibility(Camera* camera, float currentTime);
+
+	///<summary>
+	///Look up the LOD curve at the given distance.
+	///</summary>
+	ParticleLODPoint EvaluateLOD(float distance);
+
+	///<summary>
+	///The largest size scale anywhere on the LOD curve.
+	///</summary>
+	float GetMaxLODSizeScale();
+
+	///<summary>
+	///Fill drawList with every visible live Particle, ordered back to front for the given view.
+	///Returns the number of Particles in the list.
+	///</summary>
+	int BuildSortedDrawList(unsigned int* drawList, Camera* camera, float currentTime);
+
+	ID3D11Device* device;
+
+	std::vector<Emitter*> emitters;
+	std::vector<int> emitterBaseIndices;	// First pool element of each Emitter
+	int poolSize;							// Total Particles across all Emitters
+	bool buffersOutdated;					// Emitters were added since the buffers were made
+
+	ID3D11Buffer* indexBuffer;				// Shared quad indices, six per Particle
+	ID3D11Buffer* particleBuffer;			// Pooled Particles of every Emitter
+	ID3D11Buffer* emitterParamsBuffer;		// One EmitterParams per Emitter
+	ID3D11Buffer* drawListBuffer;			// Pool indices of the Particles to draw
+	ID3D11ShaderResourceView* particleSRV;
+	ID3D11ShaderResourceView* emitterParamsSRV;
+	ID3D11ShaderResourceView* drawListSRV;
+
+	unsigned int bytesUploaded;
+
+	ParticleCurveAtlas curveAtlas;
+
+	// Culling and LOD - culled Emitters sleep instead of simulating, uploading or drawing
+	std::vector<ParticleLODPoint> lodCurve;
+	std::vector<bool> emitterVisible;
+	std::vector<char> emitterAsleep;		// Skipped an Update while culled (not vector<bool>, which workers can't write safely)
+	int visibleEmitterCount;
+
+	// Budget
+	ParticleBudget budget;
+	float lastBudgetTime;
+	std::vector<float> lodSpawnRateScales;
+	std::vector<ParticleBudgetRequest> budgetRequests;
+	std::vector<int> budgetQuotas;
+	std::vector<float> budgetSpawnRateScales;
+	int spawnsRequested;
+	int spawnsGranted;
+
+	// Sorting
+	bool sorted;
+	WorkerPool* workerPool;					// Not owned; null does everything on the calling thread
+	std::vector<int> drawOffsets;			// First draw list slot of each Emitter
+	std::vector<unsigned int> sortKeys;
+	std::vector<unsigned int> sortDrawList;
+	std::vector<unsigned int> sortTempKeys;
+	std::vector<unsigned int> sortTempDrawList;
+
+	ID3D11ShaderResourceView* texture;
+	std::shared_ptr<SimpleVertexShader> vertexShader;
+	std::shared_ptr<SimplePixelShader> pixelShader;
+};
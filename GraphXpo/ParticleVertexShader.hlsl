@@ -1,20 +1,8 @@
-
 cbuffer externalData : register(b0)
 {
 	matrix view;
 	matrix projection;
 
-	int startIndex;
-
-	float3 acceleration;
-
-	float4 startColor;
-	float4 endColor;
-
-	float startSize;
-	float endSize;
-
-	float lifetime;
 	float currentTime;
 };
 
@@ -28,9 +16,33 @@ struct Particle
 	float RotationStart;
 
 	float RotationEnd;
-	float3 padding;
+	uint EmitterIndex;
+	uint Flags;
+	float padding;
+};
+
+#define PARTICLE_FLAG_KILLED 1
+
+struct EmitterParams
+{
+	float3 Acceleration;
+	float Lifetime;
+
+	float SizeScale;
+	uint CurveRow;
+	float2 padding;
 };
 
+struct CurveSample
+{
+	float4 Color;
+	float Size;
+	float Rotation;
+	float2 padding;
+};
+
+#define CURVE_SAMPLES_PER_ROW 32
+
 
 // Defines the output data of our vertex shader
 struct VertexToPixel
@@ -40,7 +52,30 @@ struct VertexToPixel
 	float4 color		: TEXCOORD1;
 };
 
-StructuredBuffer<Particle> ParticleData : register(t0);
+StructuredBuffer<Particle> ParticleData : register(t0);		// Every Emitter's Particles
+StructuredBuffer<EmitterParams> EmitterData : register(t1);	// One entry per Emitter
+StructuredBuffer<uint> DrawList : register(t2);				// Which Particles to draw
+StructuredBuffer<CurveSample> CurveData : register(t3);		// Baked over-lifetime curves
+
+// Look up an emitter's curve row, filtering between samples
+// (matches ParticleCurveAtlas::Sample on the CPU)
+CurveSample SampleCurve(uint row, float agePercent)
+{
+	float x = saturate(agePercent) * (CURVE_SAMPLES_PER_ROW - 1);
+	uint i0 = (uint)x;
+	uint i1 = min(i0 + 1, CURVE_SAMPLES_PER_ROW - 1);
+	float f = x - i0;
+
+	CurveSample a = CurveData.Load(row * CURVE_SAMPLES_PER_ROW + i0);
+	CurveSample b = CurveData.Load(row * CURVE_SAMPLES_PER_ROW + i1);
+
+	CurveSample result;
+	result.Color = lerp(a.Color, b.Color, f);
+	result.Size = lerp(a.Size, b.Size, f);
+	result.Rotation = lerp(a.Rotation, b.Rotation, f);
+	result.padding = float2(0, 0);
+	return result;
+}
 
 // The entry point for our vertex shader
 VertexToPixel main(uint id : SV_VertexID)
@@ -52,18 +87,29 @@ VertexToPixel main(uint id : SV_VertexID)
 	uint particleID = id / 4; // Every group of 4 verts are ONE particle!
 	uint cornerID = id % 4;
 
-	// Grab one particle
-	Particle p = ParticleData.Load(particleID + startIndex);
+	// Grab one particle and the emitter it came from
+	Particle p = ParticleData.Load(DrawList.Load(particleID));
+	EmitterParams e = EmitterData.Load(p.EmitterIndex);
+
+	// Killed by a collision - collapse the quad so nothing is rasterized
+	if (p.Flags & PARTICLE_FLAG_KILLED)
+	{
+		output.position = float4(0, 0, 0, 0);
+		output.uv = float2(0, 0);
+		output.color = float4(0, 0, 0, 0);
+		return output;
+	}
 
 	// Calc the age percent
 	float t = currentTime - p.SpawnTime;
-	float agePercent = t / lifetime; // The "age percent": 0 - 1
+	float agePercent = t / e.Lifetime; // The "age percent": 0 - 1
 
 	// Calc anything based on time
-	float3 pos = acceleration * t * t / 2.0f + p.StartVelocity * t + p.StartPosition;
-	float4 color = lerp(startColor, endColor, agePercent);
-	float size = lerp(startSize, endSize, agePercent);
-	float rotation = lerp(p.RotationStart, p.RotationEnd, agePercent);
+	float3 pos = e.Acceleration * t * t / 2.0f + p.StartVelocity * t + p.StartPosition;
+	CurveSample curve = SampleCurve(e.CurveRow, agePercent);
+	float4 color = curve.Color;
+	float size = curve.Size * e.SizeScale;
+	float rotation = lerp(p.RotationStart, p.RotationEnd, curve.Rotation);
 
 	// Offsets for smaller triangles
 	float2 offsets[4];
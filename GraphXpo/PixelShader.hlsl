@@ -14,6 +14,16 @@ struct DirectionalLight
 };
 
 #define MAX_LIGHTS 6
+
+// Permutation switches, set by the variant wrappers (see ShaderVariants.cpp).
+// The defaults make this file the general version: normal mapped, with the
+// light count only known at runtime.
+#ifndef NORMAL_MAP
+#define NORMAL_MAP 1
+#endif
+#ifndef LIGHT_LIMIT
+#define LIGHT_LIMIT 0
+#endif
 cbuffer externalData : register(b0)
 {
 	PointLight lights[MAX_LIGHTS];
@@ -121,6 +131,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 	//normalize the normal from VS, as interpolation can result in non-unit vectors
 	input.normal = normalize(input.normal);
 
+#if NORMAL_MAP
 	//ensure that tangent is still orthogonal (again, interpolation can cause issues)
 	//implements the gram-schmidt process
 	input.tangent = normalize(input.tangent - dot(input.tangent, input.normal) * input.normal);
@@ -134,6 +145,7 @@ float4 main(VertexToPixel input) : SV_TARGET
 	
 	//Transform the normal from normal map to world space
 	input.normal = mul(unpackedNorm, TBN);
+#endif
 
 	
 	//calculate color according to diffuse and lighting ///////////////////////////////
@@ -143,10 +155,19 @@ float4 main(VertexToPixel input) : SV_TARGET
 	
 	//process all lights this frame
 	float3 lightColor = float3(0, 0, 0);
+#if LIGHT_LIMIT > 0
+	// A fixed count unrolls, and lights past lightCount are masked off without branching
+	[unroll]
+	for (int i = 0; i < LIGHT_LIMIT; i++)
+	{
+		lightColor += (i < lightCount) ? PointLights(lights[i], input) : float3(0, 0, 0);
+	}
+#else
 	for (int i = 0; i < lightCount; i++)
 	{
 		lightColor += PointLights(lights[i], input);
 	}
+#endif
 	lightColor += DirLight(dirLight, input);
 
 	float4 finalColor = surfaceColor * float4(lightColor,1); //apply lighting to the sampled surface color
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <string.h>
+#include <vector>
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// Map a float to an unsigned key with the same ordering,
+// so floats can be radix sorted as plain integers.
+// --------------------------------------------------------
+inline unsigned int FloatToSortKey(float value)
+{
+	unsigned int bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	// Negative floats sort backwards, so flip all their bits;
+	// positive ones just need to land above the negatives
+	return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+// --------------------------------------------------------
+// Stable least-significant-digit radix sort of unsigned
+// integer keys, carrying a value along with each key.
+//
+// Every 8-bit pass counts digits per chunk in parallel,
+// turns the counts into per-chunk output offsets, then
+// scatters each chunk in parallel.  Chunks are fixed for
+// the whole sort, so the result is identical no matter how
+// many threads run it.
+//
+// tempKeys/tempValues must hold count entries; the sorted
+// result always ends up back in keys/values.
+// --------------------------------------------------------
+template<typename Key, typename Value>
+void RadixSort(Key* keys, Value* values, Key* tempKeys, Value* tempValues, int count, WorkerPool* pool)
+{
+	const int RadixBits = 8;
+	const int Buckets = 1 << RadixBits;
+	const int Passes = sizeof(Key) * 8 / RadixBits;
+	const int MinChunkSize = 4096;
+
+	if (count <= 1)
+		return;
+
+	// Split the input into chunks that stay the same for every pass
+	int chunkCount = pool ? (int)pool->GetThreadCount() * 2 : 1;
+	int chunkSize = (count + chunkCount - 1) / chunkCount;
+	if (chunkSize < MinChunkSize)
+		chunkSize = MinChunkSize;
+	chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	std::vector<int> offsets(chunkCount * Buckets);
+
+	Key* srcKeys = keys;
+	Value* srcValues = values;
+	Key* dstKeys = tempKeys;
+	Value* dstValues = tempValues;
+
+	for (int pass = 0; pass < Passes; pass++)
+	{
+		int shift = pass * RadixBits;
+
+		// Count the digits in each chunk
+		auto countDigits = [&](int firstChunk, int lastChunk)
+		{
+			for (int c = firstChunk; c < lastChunk; c++)
+			{
+				int* histogram = &offsets[c * Buckets];
+				memset(histogram, 0, sizeof(int) * Buckets);
+
+				int end = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+				for (int i = c * chunkSize; i < end; i++)
+					histogram[(srcKeys[i] >> shift) & (Buckets - 1)]++;
+			}
+		};
+
+		// Turn counts into where each chunk writes each digit: all of
+		// digit 0 (chunk by chunk), then all of digit 1, and so on
+		auto prefixSum = [&]()
+		{
+			int total = 0;
+			for (int d = 0; d < Buckets; d++)
+			{
+				for (int c = 0; c < chunkCount; c++)
+				{
+					int n = offsets[c * Buckets + d];
+					offsets[c * Buckets + d] = total;
+					total += n;
+				}
+			}
+		};
+
+		// Move every entry to its place
+		auto scatter = [&](int firstChunk, int lastChunk)
+		{
+			for (int c = firstChunk; c < lastChunk; c++)
+			{
+				int* next = &offsets[c * Buckets];
+
+				int end = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+				for (int i = c * chunkSize; i < end; i++)
+				{
+					int to = next[(srcKeys[i] >> shift) & (Buckets - 1)]++;
+					dstKeys[to] = srcKeys[i];
+					dstValues[to] = srcValues[i];
+				}
+			}
+		};
+
+		if (pool)
+			pool->ParallelFor(chunkCount, 1, countDigits);
+		else
+			countDigits(0, chunkCount);
+
+		// When every key has the same digit this pass would only copy, so skip it
+		bool allSame = false;
+		for (int d = 0; d < Buckets; d++)
+		{
+			int n = 0;
+			for (int c = 0; c < chunkCount; c++)
+				n += offsets[c * Buckets + d];
+			if (n == count)
+				allSame = true;
+			if (n != 0)
+				break;
+		}
+		if (allSame)
+			continue;
+
+		prefixSum();
+
+		if (pool)
+			pool->ParallelFor(chunkCount, 1, scatter);
+		else
+			scatter(0, chunkCount);
+
+		// The output of this pass is the input of the next
+		Key* swapKeys = srcKeys; srcKeys = dstKeys; dstKeys = swapKeys;
+		Value* swapValues = srcValues; srcValues = dstValues; dstValues = swapValues;
+	}
+
+	// An odd number of scattering passes leaves the result in the temp arrays
+	if (srcKeys != keys)
+	{
+		memcpy(keys, srcKeys, sizeof(Key) * count);
+		memcpy(values, srcValues, sizeof(Value) * count);
+	}
+}
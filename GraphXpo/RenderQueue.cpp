@@ -0,0 +1,151 @@
+#include "RenderQueue.h"
+#include "RadixSort.h"
+
+static uint64_t Field(unsigned int value, unsigned int bits, unsigned int shift)
+{
+	return ((uint64_t)value & ((1ull << bits) - 1)) << shift;
+}
+
+static unsigned int GetField(uint64_t key, unsigned int bits, unsigned int shift)
+{
+	return (unsigned int)((key >> shift) & ((1ull << bits) - 1));
+}
+
+// Two draws can only share an overflow ID's binding by chance
+static bool FieldChanged(unsigned int previous, unsigned int next, unsigned int overflowID)
+{
+	return previous != next || next == overflowID;
+}
+
+RenderQueue::RenderQueue()
+{
+	// One bucket per pass until told otherwise: sorted purely by state
+	for (unsigned int i = 0; i < (1 << PassBits); i++)
+	{
+		depthRanges[i].Buckets = 1;
+		depthRanges[i].MaxDepth = 1.0f;
+	}
+
+	stats = RenderQueueStats();
+}
+
+uint64_t RenderQueue::MakeKey(unsigned int pass, unsigned int depthBucket, unsigned int shader, unsigned int material, unsigned int mesh)
+{
+	return Field(pass, PassBits, PassShift) |
+		Field(depthBucket, DepthBits, DepthShift) |
+		Field(shader, ShaderBits, ShaderShift) |
+		Field(material, MaterialBits, MaterialShift) |
+		Field(mesh, MeshBits, MeshShift);
+}
+
+unsigned int RenderQueue::GetPass(uint64_t key) { return GetField(key, PassBits, PassShift); }
+unsigned int RenderQueue::GetDepthBucket(uint64_t key) { return GetField(key, DepthBits, DepthShift); }
+unsigned int RenderQueue::GetShader(uint64_t key) { return GetField(key, ShaderBits, ShaderShift); }
+unsigned int RenderQueue::GetMaterial(uint64_t key) { return GetField(key, MaterialBits, MaterialShift); }
+unsigned int RenderQueue::GetMesh(uint64_t key) { return GetField(key, MeshBits, MeshShift); }
+
+unsigned int RenderQueue::Diff(uint64_t previous, uint64_t next)
+{
+	unsigned int changes = 0;
+	if (GetPass(previous) != GetPass(next)) changes |= RenderChangePass;
+	if (FieldChanged(GetShader(previous), GetShader(next), ShaderOverflowID)) changes |= RenderChangeShader | RenderChangeMaterial;
+	if (FieldChanged(GetMaterial(previous), GetMaterial(next), MaterialOverflowID)) changes |= RenderChangeMaterial;
+	if (FieldChanged(GetMesh(previous), GetMesh(next), MeshOverflowID)) changes |= RenderChangeMesh;
+
+	// A new depth bucket alone needs nothing rebound
+	return changes;
+}
+
+void RenderQueue::SetDepthBuckets(unsigned int pass, unsigned int count, float maxDepth)
+{
+	if (pass >= (1 << PassBits))
+		return;
+
+	if (count < 1) count = 1;
+	if (count > (1 << DepthBits)) count = 1 << DepthBits;
+
+	depthRanges[pass].Buckets = count;
+	depthRanges[pass].MaxDepth = maxDepth > 0.0f ? maxDepth : 1.0f;
+}
+
+unsigned int RenderQueue::GetDepthBucket(unsigned int pass, float depth)
+{
+	const DepthRange& range = depthRanges[pass & ((1 << PassBits) - 1)];
+	if (range.Buckets == 1)
+		return 0;
+
+	float scaled = depth / range.MaxDepth * range.Buckets;
+	unsigned int bucket = scaled <= 0.0f ? 0 : (unsigned int)scaled;
+	if (bucket >= range.Buckets)
+		bucket = range.Buckets - 1;
+
+	// Blended draws go back to front
+	return pass == RenderPassTransparent ? range.Buckets - 1 - bucket : bucket;
+}
+
+template<typename Map, typename Key>
+unsigned int RenderQueue::NextID(Map& ids, const Key& key, unsigned int overflowID)
+{
+	auto found = ids.find(key);
+	if (found != ids.end())
+		return found->second;
+
+	// Numbers below the overflow ID each belong to one object; the rest share it
+	unsigned int id = ids.size() < overflowID ? (unsigned int)ids.size() : overflowID;
+	ids[key] = id;
+	return id;
+}
+
+unsigned int RenderQueue::GetShaderID(const void* vertexShader, const void* pixelShader)
+{
+	return NextID(shaderIDs, std::make_pair(vertexShader, pixelShader), ShaderOverflowID);
+}
+
+unsigned int RenderQueue::GetMaterialID(const void* material)
+{
+	return NextID(materialIDs, material, MaterialOverflowID);
+}
+
+unsigned int RenderQueue::GetMeshID(const void* mesh)
+{
+	return NextID(meshIDs, mesh, MeshOverflowID);
+}
+
+void RenderQueue::Clear()
+{
+	keys.clear();
+	items.clear();
+}
+
+void RenderQueue::Add(uint64_t key, unsigned int item)
+{
+	keys.push_back(key);
+	items.push_back(item);
+}
+
+void RenderQueue::Sort(WorkerPool* pool)
+{
+	tempKeys.resize(keys.size());
+	tempItems.resize(items.size());
+	RadixSort(keys.data(), items.data(), tempKeys.data(), tempItems.data(), (int)keys.size(), pool);
+}
+
+unsigned int RenderQueue::GetCount()
+{
+	return (unsigned int)keys.size();
+}
+
+uint64_t RenderQueue::GetKey(unsigned int index)
+{
+	return keys[index];
+}
+
+unsigned int RenderQueue::GetItem(unsigned int index)
+{
+	return items[index];
+}
+
+const RenderQueueStats& RenderQueue::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <stdint.h>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "WorkerPool.h"
+
+// Render passes, in the order they draw
+enum RenderPass
+{
+	RenderPassOpaque = 0,
+	RenderPassTransparent = 1
+};
+
+// What has to be rebound between one draw and the next
+enum RenderStateChange
+{
+	RenderChangePass = 1 << 0,
+	RenderChangeShader = 1 << 1,
+	RenderChangeMaterial = 1 << 2,
+	RenderChangeMesh = 1 << 3,
+	RenderChangeAll = RenderChangePass | RenderChangeShader | RenderChangeMaterial | RenderChangeMesh
+};
+
+// State switches made by the last Submit()
+struct RenderQueueStats
+{
+	unsigned int Draws;
+	unsigned int PassSwitches;
+	unsigned int ShaderSwitches;
+	unsigned int MaterialSwitches;
+	unsigned int MeshSwitches;		// Vertex and index buffers
+};
+
+// --------------------------------------------------------
+// Orders a frame's draws to change state as rarely as
+// possible.  Each draw is a 64-bit key, most significant
+// field first:
+//
+//   pass (4) | depth bucket (12) | shader (12) | material (16) | mesh (20)
+//
+// so a radix sort groups draws by pass, then coarse depth,
+// then shader, material and mesh.  Fields of neighbouring
+// keys that match don't need rebinding.
+//
+// Shaders, materials and meshes are numbered by pointer
+// the first time they're seen, and keep their numbers.
+// Once a field runs out, every later one shares its top
+// number, which Diff always counts as a change - so those
+// draws are still bound correctly, just never grouped.
+// --------------------------------------------------------
+class RenderQueue
+{
+public:
+	static const unsigned int PassBits = 4;
+	static const unsigned int DepthBits = 12;
+	static const unsigned int ShaderBits = 12;
+	static const unsigned int MaterialBits = 16;
+	static const unsigned int MeshBits = 20;
+
+	static const unsigned int MeshShift = 0;
+	static const unsigned int MaterialShift = MeshShift + MeshBits;
+	static const unsigned int ShaderShift = MaterialShift + MaterialBits;
+	static const unsigned int DepthShift = ShaderShift + ShaderBits;
+	static const unsigned int PassShift = DepthShift + DepthBits;
+
+	// Shared by every shader, material or mesh numbered past its field's width
+	static const unsigned int ShaderOverflowID = (1 << ShaderBits) - 1;
+	static const unsigned int MaterialOverflowID = (1 << MaterialBits) - 1;
+	static const unsigned int MeshOverflowID = (1 << MeshBits) - 1;
+
+	RenderQueue();
+
+	///<summary>
+	///Pack a draw's fields into a sort key.  Each is masked to its width.
+	///</summary>
+	static uint64_t MakeKey(unsigned int pass, unsigned int depthBucket, unsigned int shader, unsigned int material, unsigned int mesh);
+
+	static unsigned int GetPass(uint64_t key);
+	static unsigned int GetDepthBucket(uint64_t key);
+	static unsigned int GetShader(uint64_t key);
+	static unsigned int GetMaterial(uint64_t key);
+	static unsigned int GetMesh(uint64_t key);
+
+	///<summary>
+	///The RenderStateChange flags needed to go from one key's draw to the next.  A new shader
+	///also needs its material bound again, as material values live in the shader.  An overflow
+	///ID can stand for any number of objects, so it always counts as changed.
+	///</summary>
+	static unsigned int Diff(uint64_t previous, uint64_t next);
+
+	///<summary>
+	///How many depth buckets a pass splits [0, maxDepth] into - few enough that shaders
+	///still group, up to 4096.  Transparent passes fill them back to front.
+	///</summary>
+	void SetDepthBuckets(unsigned int pass, unsigned int count, float maxDepth);
+	unsigned int GetDepthBucket(unsigned int pass, float depth);
+
+	// Stable numbers for the key fields, or the field's overflow ID once it's full
+	unsigned int GetShaderID(const void* vertexShader, const void* pixelShader);
+	unsigned int GetMaterialID(const void* material);
+	unsigned int GetMeshID(const void* mesh);
+
+	///<summary>
+	///Empty the queue for a new frame.  IDs are kept.
+	///</summary>
+	void Clear();
+
+	///<summary>
+	///Queue a draw.  item is handed back to Submit() - an index into the caller's own list.
+	///</summary>
+	void Add(uint64_t key, unsigned int item);
+
+	///<summary>
+	///Radix sort the queued draws by key.  Draws with equal keys keep the order they were added in.
+	///</summary>
+	void Sort(WorkerPool* pool);
+
+	///<summary>
+	///Call draw(item, changes) for every queued draw in sorted order, where changes are the
+	///RenderStateChange flags against the draw before it (all of them for the first).
+	///</summary>
+	template<typename Draw>
+	void Submit(Draw draw);
+
+	unsigned int GetCount();
+	uint64_t GetKey(unsigned int index);
+	unsigned int GetItem(unsigned int index);
+	const RenderQueueStats& GetStats();
+
+private:
+	struct DepthRange
+	{
+		unsigned int Buckets;
+		float MaxDepth;
+	};
+
+	template<typename Map, typename Key>
+	static unsigned int NextID(Map& ids, const Key& key, unsigned int overflowID);
+
+	std::vector<uint64_t> keys;
+	std::vector<unsigned int> items;
+	std::vector<uint64_t> tempKeys;
+	std::vector<unsigned int> tempItems;
+
+	DepthRange depthRanges[1 << PassBits];
+
+	std::map<std::pair<const void*, const void*>, unsigned int> shaderIDs;
+	std::unordered_map<const void*, unsigned int> materialIDs;
+	std::unordered_map<const void*, unsigned int> meshIDs;
+
+	RenderQueueStats stats;
+};
+
+template<typename Draw>
+void RenderQueue::Submit(Draw draw)
+{
+	stats = RenderQueueStats();
+
+	for (unsigned int i = 0; i < keys.size(); i++)
+	{
+		unsigned int changes = i == 0 ? (unsigned int)RenderChangeAll : Diff(keys[i - 1], keys[i]);
+
+		if (changes & RenderChangePass) stats.PassSwitches++;
+		if (changes & RenderChangeShader) stats.ShaderSwitches++;
+		if (changes & RenderChangeMaterial) stats.MaterialSwitches++;
+		if (changes & RenderChangeMesh) stats.MeshSwitches++;
+		stats.Draws++;
+
+		draw(items[i], changes);
+	}
+}
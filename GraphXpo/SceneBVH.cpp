@@ -0,0 +1,695 @@
+#include "SceneBVH.h"
+#include <algorithm>
+#include <float.h>
+#include <math.h>
+#include <mutex>
+#include <stdint.h>
+#include <string.h>
+
+using namespace DirectX;
+
+// Ranges at least this big are measured and binned across the pool
+static const unsigned int ParallelRangeSize = 16 * 1024;
+
+// Relative cost of visiting a node versus testing a primitive
+static const float TraversalCost = 1.0f;
+
+static float SurfaceArea(const AABB& box)
+{
+	float x = box.Max.x - box.Min.x;
+	float y = box.Max.y - box.Min.y;
+	float z = box.Max.z - box.Min.z;
+	return 2.0f * (x * y + y * z + z * x);
+}
+
+// Plain compares, which become single instructions where fminf/fmaxf are library calls
+static float Smaller(float a, float b) { return a < b ? a : b; }
+static float Larger(float a, float b) { return a > b ? a : b; }
+
+// Grow a box by another, which may still be empty (inside out) -
+// AABB::Encapsulate would take an empty box's corners as points
+static void Merge(AABB& box, const AABB& other)
+{
+	box.Min = XMFLOAT3(Smaller(box.Min.x, other.Min.x), Smaller(box.Min.y, other.Min.y), Smaller(box.Min.z, other.Min.z));
+	box.Max = XMFLOAT3(Larger(box.Max.x, other.Max.x), Larger(box.Max.y, other.Max.y), Larger(box.Max.z, other.Max.z));
+}
+
+static void Merge(AABB& box, const XMFLOAT3& point)
+{
+	box.Min = XMFLOAT3(Smaller(box.Min.x, point.x), Smaller(box.Min.y, point.y), Smaller(box.Min.z, point.z));
+	box.Max = XMFLOAT3(Larger(box.Max.x, point.x), Larger(box.Max.y, point.y), Larger(box.Max.z, point.z));
+}
+
+static float Component(const XMFLOAT3& v, int axis)
+{
+	return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// Which of binCount bins a centroid falls in along an axis
+static unsigned int BinIndex(float centroid, float minimum, float scale, unsigned int binCount)
+{
+	int bin = (int)((centroid - minimum) * scale);
+	if (bin < 0) return 0;
+	if (bin >= (int)binCount) return binCount - 1;
+	return (unsigned int)bin;
+}
+
+static void SetNodeBounds(BVHNode& node, const AABB& bounds)
+{
+	node.Min = bounds.Min;
+	node.Max = bounds.Max;
+}
+
+// Signed distance of a box's center from a plane, and how far the box reaches towards it
+static void PlaneDistance(const XMFLOAT4& plane, const XMFLOAT3& min, const XMFLOAT3& max, float& distance, float& reach)
+{
+	float cx = (min.x + max.x) * 0.5f, cy = (min.y + max.y) * 0.5f, cz = (min.z + max.z) * 0.5f;
+	float ex = (max.x - min.x) * 0.5f, ey = (max.y - min.y) * 0.5f, ez = (max.z - min.z) * 0.5f;
+	distance = plane.x * cx + plane.y * cy + plane.z * cz + plane.w;
+	reach = fabsf(plane.x) * ex + fabsf(plane.y) * ey + fabsf(plane.z) * ez;
+}
+
+// Where a ray enters a box, if it does before maxDistance
+static bool RayEntersBox(const XMFLOAT3& origin, const XMFLOAT3& inverseDirection, const XMFLOAT3& min, const XMFLOAT3& max, float maxDistance, float& entry)
+{
+	float x1 = (min.x - origin.x) * inverseDirection.x, x2 = (max.x - origin.x) * inverseDirection.x;
+	float y1 = (min.y - origin.y) * inverseDirection.y, y2 = (max.y - origin.y) * inverseDirection.y;
+	float z1 = (min.z - origin.z) * inverseDirection.z, z2 = (max.z - origin.z) * inverseDirection.z;
+
+	float enter = Larger(Larger(Smaller(x1, x2), Smaller(y1, y2)), Larger(Smaller(z1, z2), 0.0f));
+	float exit = Smaller(Smaller(Larger(x1, x2), Larger(y1, y2)), Smaller(Larger(z1, z2), maxDistance));
+	entry = enter;
+	return enter <= exit;
+}
+
+static bool BoxesTouch(const XMFLOAT3& minA, const XMFLOAT3& maxA, const XMFLOAT3& minB, const XMFLOAT3& maxB)
+{
+	return minA.x <= maxB.x && maxA.x >= minB.x &&
+		minA.y <= maxB.y && maxA.y >= minB.y &&
+		minA.z <= maxB.z && maxA.z >= minB.z;
+}
+
+SceneBVH::SceneBVH()
+{
+	nodeMemory = 0;
+	nodes = 0;
+	nodeCount = 0;
+	buildBounds = 0;
+	stats = BVHQueryStats();
+}
+
+SceneBVH::~SceneBVH()
+{
+	delete[] nodeMemory;
+}
+
+void SceneBVH::AllocateNodes(unsigned int count)
+{
+	delete[] nodeMemory;
+
+	// new[] only promises 16 bytes, so align by hand to a cache line
+	nodeMemory = new unsigned char[sizeof(BVHNode) * count + 63];
+	nodes = (BVHNode*)(((uintptr_t)nodeMemory + 63) & ~(uintptr_t)63);
+	nodeCount = count;
+}
+
+void SceneBVH::Build(const AABB* bounds, const unsigned int* ids, unsigned int count, WorkerPool* pool)
+{
+	buildBounds = bounds;
+	centroids.resize(count);
+	order.resize(count);
+
+	auto prepare = [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			centroids[i] = bounds[i].GetCenter();
+			order[i] = i;
+		}
+	};
+	if (pool)
+		pool->ParallelFor((int)count, (int)ParallelRangeSize, prepare);
+	else
+		prepare(0, (int)count);
+
+	// Node 0 is the root and node 1 is left empty, so every pair of siblings starts on an even index
+	std::vector<BVHNode> built;
+	built.reserve(count * 2 + 2);
+	built.resize(2);
+	memset(built.data(), 0, sizeof(BVHNode) * 2);
+
+	if (count > 0)
+	{
+		AABB rootBounds, rootCentroids;
+		MeasureRange(0, count, rootBounds, rootCentroids, pool);
+		SetNodeBounds(built[0], rootBounds);
+
+		// Split the big nodes here, spreading each split across the pool, until
+		// there are enough independent subtrees to keep every thread busy
+		std::vector<BuildTask> pending;
+		std::vector<BuildTask> subtrees;
+		BuildTask root = { 0, 0, count, rootCentroids };
+		pending.push_back(root);
+
+		unsigned int subtreeSize = pool ? count / (pool->GetThreadCount() * 8) : count;
+		if (subtreeSize < 1024)
+			subtreeSize = 1024;
+
+		while (!pending.empty())
+		{
+			BuildTask task = pending.back();
+			pending.pop_back();
+
+			AABB taskBounds(built[task.Node].Min, built[task.Node].Max);
+			unsigned int leftCount = task.Count > subtreeSize ? SplitRange(task.First, task.Count, taskBounds, task.CentroidBounds, pool) : 0;
+			if (leftCount == 0)
+			{
+				subtrees.push_back(task);
+				continue;
+			}
+
+			unsigned int left = (unsigned int)built.size();
+			built.resize(left + 2);
+			built[task.Node].LeftFirst = left;
+			built[task.Node].Count = 0;
+
+			for (unsigned int c = 0; c < 2; c++)
+			{
+				BuildTask child;
+				child.Node = left + c;
+				child.First = c == 0 ? task.First : task.First + leftCount;
+				child.Count = c == 0 ? leftCount : task.Count - leftCount;
+
+				AABB childBounds;
+				MeasureRange(child.First, child.Count, childBounds, child.CentroidBounds, pool);
+				SetNodeBounds(built[child.Node], childBounds);
+				pending.push_back(child);
+			}
+		}
+
+		// Build the subtrees side by side.  Each works on its own range of the
+		// primitive order and its own node list, so they share nothing.
+		std::vector<std::vector<BVHNode>> locals(subtrees.size());
+		auto buildSubtrees = [&](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+				BuildSubtree(subtrees[i], built[subtrees[i].Node], locals[i]);
+		};
+		if (pool)
+			pool->ParallelFor((int)subtrees.size(), 1, buildSubtrees);
+		else
+			buildSubtrees(0, (int)subtrees.size());
+
+		// Stitch them on after the top of the tree, moving their child indices along
+		for (size_t i = 0; i < subtrees.size(); i++)
+		{
+			if (locals[i].empty())
+				continue;
+
+			unsigned int offset = (unsigned int)built.size();
+			built[subtrees[i].Node].LeftFirst += offset;
+			for (size_t n = 0; n < locals[i].size(); n++)
+			{
+				BVHNode node = locals[i][n];
+				if (node.Count == 0)
+					node.LeftFirst += offset;
+				built.push_back(node);
+			}
+		}
+	}
+
+	AllocateNodes((unsigned int)built.size());
+	memcpy(nodes, built.data(), sizeof(BVHNode) * built.size());
+
+	// Keep the primitives in leaf order, so leaves read them sequentially
+	primitiveBounds.resize(count);
+	primitiveIds.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		primitiveBounds[i] = bounds[order[i]];
+		primitiveIds[i] = ids[order[i]];
+	}
+
+	lastCullingPlane.assign(nodeCount, 0);
+
+	buildBounds = 0;
+	centroids.clear();
+	centroids.shrink_to_fit();
+	order.clear();
+	order.shrink_to_fit();
+}
+
+void SceneBVH::MeasureRange(unsigned int first, unsigned int count, AABB& bounds, AABB& centroidBounds, WorkerPool* pool)
+{
+	bounds = AABB();
+	centroidBounds = AABB();
+
+	std::mutex mutex;
+	auto measure = [&](int begin, int end)
+	{
+		AABB chunkBounds, chunkCentroids;
+		for (int i = begin; i < end; i++)
+		{
+			unsigned int primitive = order[first + i];
+			Merge(chunkBounds, buildBounds[primitive]);
+			Merge(chunkCentroids, centroids[primitive]);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		Merge(bounds, chunkBounds);
+		Merge(centroidBounds, chunkCentroids);
+	};
+
+	if (pool && count >= ParallelRangeSize)
+		pool->ParallelFor((int)count, (int)ParallelRangeSize / 4, measure);
+	else
+		measure(0, (int)count);
+}
+
+unsigned int SceneBVH::SplitRange(unsigned int first, unsigned int count, const AABB& bounds, const AABB& centroidBounds, WorkerPool* pool)
+{
+	if (count <= 1)
+		return 0;
+
+	// Small ranges don't need every bin
+	unsigned int binCount = count < BinCount ? count : BinCount;
+
+	float scales[3];
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float extent = Component(centroidBounds.Max, axis) - Component(centroidBounds.Min, axis);
+		scales[axis] = extent > 0.0f ? binCount / extent : 0.0f;
+	}
+
+	// Drop every centroid into a bin along each axis
+	Bin bins[3][BinCount];
+	for (int axis = 0; axis < 3; axis++)
+		for (unsigned int b = 0; b < binCount; b++)
+			bins[axis][b].Count = 0;
+
+	auto fill = [&](Bin (*target)[BinCount], int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			unsigned int primitive = order[first + i];
+			for (int axis = 0; axis < 3; axis++)
+			{
+				if (scales[axis] == 0.0f)
+					continue;
+
+				unsigned int b = BinIndex(Component(centroids[primitive], axis), Component(centroidBounds.Min, axis), scales[axis], binCount);
+				Merge(target[axis][b].Bounds, buildBounds[primitive]);
+				target[axis][b].Count++;
+			}
+		}
+	};
+
+	if (pool && count >= ParallelRangeSize)
+	{
+		// Each chunk fills its own bins, then adds them in
+		std::mutex mutex;
+		pool->ParallelFor((int)count, (int)ParallelRangeSize / 4, [&](int begin, int end)
+		{
+			Bin chunkBins[3][BinCount];
+			for (int axis = 0; axis < 3; axis++)
+				for (unsigned int b = 0; b < binCount; b++)
+					chunkBins[axis][b].Count = 0;
+
+			fill(chunkBins, begin, end);
+
+			std::lock_guard<std::mutex> lock(mutex);
+			for (int axis = 0; axis < 3; axis++)
+			{
+				for (unsigned int b = 0; b < binCount; b++)
+				{
+					Merge(bins[axis][b].Bounds, chunkBins[axis][b].Bounds);
+					bins[axis][b].Count += chunkBins[axis][b].Count;
+				}
+			}
+		});
+	}
+	else
+		fill(bins, 0, (int)count);
+
+	// Sweep each axis for the plane between bins with the lowest surface area cost
+	int bestAxis = -1;
+	unsigned int bestBin = 0;
+	float bestCost = FLT_MAX;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (scales[axis] == 0.0f)
+			continue;
+
+		float rightArea[BinCount];
+		unsigned int rightCount[BinCount];
+		AABB right;
+		unsigned int rightTotal = 0;
+		for (unsigned int b = binCount - 1; b > 0; b--)
+		{
+			Merge(right, bins[axis][b].Bounds);
+			rightTotal += bins[axis][b].Count;
+			rightArea[b] = rightTotal ? SurfaceArea(right) : 0.0f;
+			rightCount[b] = rightTotal;
+		}
+
+		AABB left;
+		unsigned int leftTotal = 0;
+		for (unsigned int b = 1; b < binCount; b++)
+		{
+			Merge(left, bins[axis][b - 1].Bounds);
+			leftTotal += bins[axis][b - 1].Count;
+			if (leftTotal == 0 || rightCount[b] == 0)
+				continue;
+
+			float cost = leftTotal * SurfaceArea(left) + rightCount[b] * rightArea[b];
+			if (cost < bestCost)
+			{
+				bestCost = cost;
+				bestAxis = axis;
+				bestBin = b;
+			}
+		}
+	}
+
+	// Stay a leaf when small enough and splitting doesn't pay
+	float leafCost = count * SurfaceArea(bounds);
+	float splitCost = TraversalCost * SurfaceArea(bounds) + bestCost;
+	if (count <= MaxLeafSize && (bestAxis < 0 || leafCost <= splitCost))
+		return 0;
+
+	unsigned int* begin = &order[first];
+	unsigned int* end = begin + count;
+	unsigned int leftCount = 0;
+	if (bestAxis >= 0)
+	{
+		float minimum = Component(centroidBounds.Min, bestAxis);
+		float scale = scales[bestAxis];
+		unsigned int* middle = std::partition(begin, end, [&](unsigned int primitive)
+		{
+			return BinIndex(Component(centroids[primitive], bestAxis), minimum, scale, binCount) < bestBin;
+		});
+		leftCount = (unsigned int)(middle - begin);
+	}
+
+	// Every centroid in the same place - any split is as good as another
+	if (leftCount == 0 || leftCount == count)
+		leftCount = count / 2;
+
+	return leftCount;
+}
+
+void SceneBVH::BuildSubtree(const BuildTask& task, BVHNode& root, std::vector<BVHNode>& local)
+{
+	struct Item
+	{
+		int Node;	// Index into local, or -1 for root
+		unsigned int First;
+		unsigned int Count;
+		AABB CentroidBounds;
+	};
+
+	std::vector<Item> items;
+	Item first = { -1, task.First, task.Count, task.CentroidBounds };
+	items.push_back(first);
+
+	while (!items.empty())
+	{
+		Item item = items.back();
+		items.pop_back();
+
+		BVHNode* node = item.Node < 0 ? &root : &local[item.Node];
+		AABB bounds(node->Min, node->Max);
+		unsigned int leftCount = SplitRange(item.First, item.Count, bounds, item.CentroidBounds, 0);
+		if (leftCount == 0)
+		{
+			node->LeftFirst = item.First;
+			node->Count = item.Count;
+			continue;
+		}
+
+		// Growing local moves its nodes, so look this one up again afterwards
+		unsigned int left = (unsigned int)local.size();
+		local.resize(left + 2);
+		node = item.Node < 0 ? &root : &local[item.Node];
+		node->LeftFirst = left;
+		node->Count = 0;
+
+		for (unsigned int c = 0; c < 2; c++)
+		{
+			Item child;
+			child.Node = (int)(left + c);
+			child.First = c == 0 ? item.First : item.First + leftCount;
+			child.Count = c == 0 ? leftCount : item.Count - leftCount;
+
+			AABB childBounds;
+			MeasureRange(child.First, child.Count, childBounds, child.CentroidBounds, 0);
+			SetNodeBounds(local[child.Node], childBounds);
+			items.push_back(child);
+		}
+	}
+}
+
+unsigned int SceneBVH::Cull(const Frustum& frustum, unsigned int* visible)
+{
+	stats = BVHQueryStats();
+	if (primitiveIds.empty())
+		return 0;
+
+	unsigned int visibleCount = 0;
+	stack.clear();
+	TraversalEntry root = { 0, 0x3F, 0.0f };
+	stack.push_back(root);
+
+	while (!stack.empty())
+	{
+		TraversalEntry entry = stack.back();
+		stack.pop_back();
+		stats.NodesVisited++;
+
+		const BVHNode& node = nodes[entry.Node];
+		unsigned int mask = entry.PlaneMask;
+
+		// Start with the plane that culled this node last time - with a
+		// steady camera it probably still does
+		unsigned int firstPlane = lastCullingPlane[entry.Node];
+		bool outside = false;
+		for (unsigned int k = 0; k < 6; k++)
+		{
+			unsigned int p = (firstPlane + k) % 6;
+			if (!(mask & (1u << p)))
+				continue;
+
+			float distance, reach;
+			PlaneDistance(frustum.planes[p], node.Min, node.Max, distance, reach);
+			if (distance + reach < 0)
+			{
+				lastCullingPlane[entry.Node] = (unsigned char)p;
+				outside = true;
+				break;
+			}
+
+			// Wholly on the inside - nothing below needs this plane
+			if (distance - reach >= 0)
+				mask &= ~(1u << p);
+		}
+		if (outside)
+			continue;
+
+		if (mask == 0)
+		{
+			AddSubtree(entry.Node, visible, visibleCount);
+			continue;
+		}
+
+		if (node.Count == 0)
+		{
+			TraversalEntry left = { node.LeftFirst, mask, 0.0f };
+			TraversalEntry right = { node.LeftFirst + 1, mask, 0.0f };
+			stack.push_back(right);
+			stack.push_back(left);
+			continue;
+		}
+
+		// A leaf crossing a plane - test its primitives against what's left
+		for (unsigned int i = node.LeftFirst; i < node.LeftFirst + node.Count; i++)
+		{
+			stats.PrimitivesTested++;
+
+			bool primitiveOutside = false;
+			for (unsigned int p = 0; p < 6 && !primitiveOutside; p++)
+			{
+				if (!(mask & (1u << p)))
+					continue;
+
+				float distance, reach;
+				PlaneDistance(frustum.planes[p], primitiveBounds[i].Min, primitiveBounds[i].Max, distance, reach);
+				primitiveOutside = distance + reach < 0;
+			}
+
+			if (!primitiveOutside)
+				visible[visibleCount++] = primitiveIds[i];
+		}
+	}
+
+	stats.Results = visibleCount;
+	return visibleCount;
+}
+
+void SceneBVH::AddSubtree(unsigned int node, unsigned int* results, unsigned int& resultCount)
+{
+	// Primitives were partitioned in place, so a subtree's are one contiguous run -
+	// find it from the leftmost and rightmost leaves
+	unsigned int leftmost = node;
+	while (nodes[leftmost].Count == 0)
+		leftmost = nodes[leftmost].LeftFirst;
+
+	unsigned int rightmost = node;
+	while (nodes[rightmost].Count == 0)
+		rightmost = nodes[rightmost].LeftFirst + 1;
+
+	unsigned int first = nodes[leftmost].LeftFirst;
+	unsigned int end = nodes[rightmost].LeftFirst + nodes[rightmost].Count;
+	for (unsigned int i = first; i < end; i++)
+		results[resultCount++] = primitiveIds[i];
+}
+
+bool SceneBVH::Raycast(DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 direction, float maxDistance, unsigned int& id, float& distance)
+{
+	stats = BVHQueryStats();
+	if (primitiveIds.empty())
+		return false;
+
+	// Dividing by zero gives infinities, which the slab test handles
+	XMFLOAT3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+
+	float nearest = maxDistance;
+	bool hit = false;
+
+	float rootEntry;
+	if (!RayEntersBox(origin, inverseDirection, nodes[0].Min, nodes[0].Max, nearest, rootEntry))
+		return false;
+
+	stack.clear();
+	TraversalEntry root = { 0, 0, rootEntry };
+	stack.push_back(root);
+
+	while (!stack.empty())
+	{
+		TraversalEntry entry = stack.back();
+		stack.pop_back();
+
+		// Something closer was found since this was queued
+		if (entry.Distance > nearest)
+			continue;
+
+		stats.NodesVisited++;
+		const BVHNode& node = nodes[entry.Node];
+
+		if (node.Count > 0)
+		{
+			for (unsigned int i = node.LeftFirst; i < node.LeftFirst + node.Count; i++)
+			{
+				stats.PrimitivesTested++;
+
+				float entryDistance;
+				if (RayEntersBox(origin, inverseDirection, primitiveBounds[i].Min, primitiveBounds[i].Max, nearest, entryDistance) && (!hit || entryDistance < nearest))
+				{
+					nearest = entryDistance;
+					id = primitiveIds[i];
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		// Visit the nearer child first, so it can rule out the farther one
+		TraversalEntry children[2];
+		unsigned int childCount = 0;
+		for (unsigned int c = 0; c < 2; c++)
+		{
+			const BVHNode& child = nodes[node.LeftFirst + c];
+			float entryDistance;
+			if (RayEntersBox(origin, inverseDirection, child.Min, child.Max, nearest, entryDistance))
+			{
+				TraversalEntry childEntry = { node.LeftFirst + c, 0, entryDistance };
+				children[childCount++] = childEntry;
+			}
+		}
+
+		if (childCount == 2 && children[1].Distance < children[0].Distance)
+			std::swap(children[0], children[1]);
+		for (unsigned int c = childCount; c > 0; c--)
+			stack.push_back(children[c - 1]);
+	}
+
+	if (hit)
+	{
+		distance = nearest;
+		stats.Results = 1;
+	}
+	return hit;
+}
+
+unsigned int SceneBVH::Overlap(const AABB& box, unsigned int* results)
+{
+	stats = BVHQueryStats();
+	if (primitiveIds.empty() || !BoxesTouch(nodes[0].Min, nodes[0].Max, box.Min, box.Max))
+		return 0;
+
+	unsigned int resultCount = 0;
+	stack.clear();
+	TraversalEntry root = { 0, 0, 0.0f };
+	stack.push_back(root);
+
+	while (!stack.empty())
+	{
+		TraversalEntry entry = stack.back();
+		stack.pop_back();
+		stats.NodesVisited++;
+
+		const BVHNode& node = nodes[entry.Node];
+		if (node.Count > 0)
+		{
+			for (unsigned int i = node.LeftFirst; i < node.LeftFirst + node.Count; i++)
+			{
+				stats.PrimitivesTested++;
+				if (BoxesTouch(primitiveBounds[i].Min, primitiveBounds[i].Max, box.Min, box.Max))
+					results[resultCount++] = primitiveIds[i];
+			}
+			continue;
+		}
+
+		for (unsigned int c = 0; c < 2; c++)
+		{
+			const BVHNode& child = nodes[node.LeftFirst + c];
+			if (BoxesTouch(child.Min, child.Max, box.Min, box.Max))
+			{
+				TraversalEntry childEntry = { node.LeftFirst + c, 0, 0.0f };
+				stack.push_back(childEntry);
+			}
+		}
+	}
+
+	stats.Results = resultCount;
+	return resultCount;
+}
+
+unsigned int SceneBVH::GetNodeCount()
+{
+	return nodeCount;
+}
+
+unsigned int SceneBVH::GetPrimitiveCount()
+{
+	return (unsigned int)primitiveIds.size();
+}
+
+const BVHNode* SceneBVH::GetNodes()
+{
+	return nodes;
+}
+
+const BVHQueryStats& SceneBVH::GetStats()
+{
+	return stats;
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <vector>
+#include "Bounds.h"
+#include "WorkerPool.h"
+
+// --------------------------------------------------------
+// One node of a SceneBVH - 32 bytes, so a pair of siblings
+// fills one 64 byte cache line.
+//
+// Count == 0 marks an interior node whose children sit at
+// LeftFirst and LeftFirst + 1; otherwise it is a leaf over
+// primitives [LeftFirst, LeftFirst + Count).
+// --------------------------------------------------------
+struct BVHNode
+{
+	DirectX::XMFLOAT3 Min;
+	unsigned int LeftFirst;
+	DirectX::XMFLOAT3 Max;
+	unsigned int Count;
+};
+
+// Work done by the last query
+struct BVHQueryStats
+{
+	unsigned int NodesVisited;
+	unsigned int PrimitivesTested;
+	unsigned int Results;
+};
+
+// --------------------------------------------------------
+// Bounding volume hierarchy over boxes that don't move.
+//
+// Built top down with a binned surface area heuristic.
+// Big nodes bin their primitives across the WorkerPool;
+// once there are enough independent subtrees, those are
+// built on their own threads and stitched together.
+//
+// Nodes live in one flat, 64 byte aligned array.  Siblings
+// are neighbours starting on even indices, so testing both
+// children of a node touches a single cache line.
+// --------------------------------------------------------
+class SceneBVH
+{
+public:
+	static const unsigned int MaxLeafSize = 4;
+	static const unsigned int BinCount = 16;
+
+	SceneBVH();
+	~SceneBVH();
+
+	///<summary>
+	///Build over count boxes, replacing any earlier build.  Queries return ids[i] for bounds[i].
+	///pool may be null to build on the calling thread alone.
+	///</summary>
+	void Build(const AABB* bounds, const unsigned int* ids, unsigned int count, WorkerPool* pool);
+
+	///<summary>
+	///Write the ids of the boxes that may be inside the frustum and return how many.  visible must hold
+	///GetPrimitiveCount() entries.  Nodes wholly inside a plane stop testing it, and each node first tries
+	///the plane that culled it last time, so small camera moves cost few tests.
+	///</summary>
+	unsigned int Cull(const Frustum& frustum, unsigned int* visible);
+
+	///<summary>
+	///Find the nearest box the ray enters within maxDistance.  direction need not be normalized;
+	///distance is in multiples of it.  Returns false if nothing is hit.
+	///</summary>
+	bool Raycast(DirectX::XMFLOAT3 origin, DirectX::XMFLOAT3 direction, float maxDistance, unsigned int& id, float& distance);
+
+	///<summary>
+	///Write the ids of the boxes touching box and return how many.  results must hold GetPrimitiveCount() entries.
+	///</summary>
+	unsigned int Overlap(const AABB& box, unsigned int* results);
+
+	unsigned int GetNodeCount();
+	unsigned int GetPrimitiveCount();
+	const BVHNode* GetNodes();
+	const BVHQueryStats& GetStats();
+
+private:
+	struct Bin
+	{
+		AABB Bounds;
+		unsigned int Count;
+	};
+
+	// A node whose primitives are still to be split
+	struct BuildTask
+	{
+		unsigned int Node;
+		unsigned int First;
+		unsigned int Count;
+		AABB CentroidBounds;
+	};
+
+	// A node still to visit in a query
+	struct TraversalEntry
+	{
+		unsigned int Node;
+		unsigned int PlaneMask;	// Frustum planes the node might still cross
+		float Distance;			// Where a ray enters the node
+	};
+
+	///<summary>
+	///Box and centroid box of a range of primitives, across the pool if there are many.
+	///</summary>
+	void MeasureRange(unsigned int first, unsigned int count, AABB& bounds, AABB& centroidBounds, WorkerPool* pool);
+
+	///<summary>
+	///Pick the cheapest split of a range and partition it.  Returns the size of the left half,
+	///or 0 if the range should stay a leaf.
+	///</summary>
+	unsigned int SplitRange(unsigned int first, unsigned int count, const AABB& bounds, const AABB& centroidBounds, WorkerPool* pool);
+
+	///<summary>
+	///Build a task's whole subtree on this thread.  Children go into local, numbered from 0;
+	///Build() moves them to their place in the node array.
+	///</summary>
+	void BuildSubtree(const BuildTask& task, BVHNode& root, std::vector<BVHNode>& local);
+
+	void AllocateNodes(unsigned int count);
+
+	///<summary>
+	///Add every primitive under a node, with no more tests.
+	///</summary>
+	void AddSubtree(unsigned int node, unsigned int* results, unsigned int& resultCount);
+
+	// The built tree
+	unsigned char* nodeMemory;
+	BVHNode* nodes;
+	unsigned int nodeCount;
+	std::vector<AABB> primitiveBounds;		// In leaf order
+	std::vector<unsigned int> primitiveIds;	// In leaf order
+	std::vector<unsigned char> lastCullingPlane;	// Per node, the plane that last culled it
+
+	// Scratch used while building
+	const AABB* buildBounds;
+	std::vector<DirectX::XMFLOAT3> centroids;
+	std::vector<unsigned int> order;
+
+	std::vector<TraversalEntry> stack;
+	BVHQueryStats stats;
+};
@@ -0,0 +1,343 @@
+#pragma once
+
+// --------------------------------------------------------
+// GENERATED by tools/generate_cbuffers.py - do not edit.
+//
+// C++ versions of each shader's constant buffers, laid
+// out by HLSL's packing rules, for SetBufferData().
+// --------------------------------------------------------
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+// An HLSL array whose elements don't fill a register: each
+// element but the last is padded out to 16 bytes
+template<typename T, unsigned int N>
+struct ShaderArray
+{
+	struct Element
+	{
+		T Value;
+		unsigned char Padding[16 - sizeof(T) % 16];
+	};
+
+	Element Elements[N - 1];
+	T Last;
+
+	T& operator[](unsigned int i) { return i == N - 1 ? Last : Elements[i].Value; }
+	const T& operator[](unsigned int i) const { return i == N - 1 ? Last : Elements[i].Value; }
+};
+
+namespace ShaderConstants
+{
+	// BloomBlurHorizontalPS.hlsl
+	namespace BloomBlurHorizontalPS
+	{
+		struct Data
+		{
+			static const char* BufferName() { return "Data"; }
+			static const unsigned int Register = 0;
+
+			float pixelWidth;
+			float padding0[3];
+		};
+		static_assert(offsetof(Data, pixelWidth) == 0, "Data.pixelWidth is misplaced");
+		static_assert(sizeof(Data) == 16, "Data is the wrong size");
+	}
+
+	// BloomBlurVerticalPS.hlsl
+	namespace BloomBlurVerticalPS
+	{
+		struct Data
+		{
+			static const char* BufferName() { return "Data"; }
+			static const unsigned int Register = 0;
+
+			float pixelHeight;
+			float padding0[3];
+		};
+		static_assert(offsetof(Data, pixelHeight) == 0, "Data.pixelHeight is misplaced");
+		static_assert(sizeof(Data) == 16, "Data is the wrong size");
+	}
+
+	// FoldingVert.hlsl
+	namespace FoldingVert
+	{
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			DirectX::XMFLOAT4X4 world;
+			DirectX::XMFLOAT4X4 invTransWorld;
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+			float evolution;
+			float padding0[3];
+		};
+		static_assert(offsetof(ExternalData, world) == 0, "externalData.world is misplaced");
+		static_assert(offsetof(ExternalData, invTransWorld) == 64, "externalData.invTransWorld is misplaced");
+		static_assert(offsetof(ExternalData, view) == 128, "externalData.view is misplaced");
+		static_assert(offsetof(ExternalData, projection) == 192, "externalData.projection is misplaced");
+		static_assert(offsetof(ExternalData, evolution) == 256, "externalData.evolution is misplaced");
+		static_assert(sizeof(ExternalData) == 272, "externalData is the wrong size");
+	}
+
+	// MotionBlurPS.hlsl
+	namespace MotionBlurPS
+	{
+		struct Data
+		{
+			static const char* BufferName() { return "Data"; }
+			static const unsigned int Register = 0;
+
+			float pixelWidth;
+			float pixelHeight;
+			float blurV;
+			float blurH;
+		};
+		static_assert(offsetof(Data, pixelWidth) == 0, "Data.pixelWidth is misplaced");
+		static_assert(offsetof(Data, pixelHeight) == 4, "Data.pixelHeight is misplaced");
+		static_assert(offsetof(Data, blurV) == 8, "Data.blurV is misplaced");
+		static_assert(offsetof(Data, blurH) == 12, "Data.blurH is misplaced");
+		static_assert(sizeof(Data) == 16, "Data is the wrong size");
+	}
+
+	// ParticleVertexShader.hlsl
+	namespace ParticleVertexShader
+	{
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+			float currentTime;
+			float padding0[3];
+		};
+		static_assert(offsetof(ExternalData, view) == 0, "externalData.view is misplaced");
+		static_assert(offsetof(ExternalData, projection) == 64, "externalData.projection is misplaced");
+		static_assert(offsetof(ExternalData, currentTime) == 128, "externalData.currentTime is misplaced");
+		static_assert(sizeof(ExternalData) == 144, "externalData is the wrong size");
+	}
+
+	// PBRPixelShader.hlsl
+	namespace PBRPixelShader
+	{
+		struct PointLight
+		{
+			float Range;
+			DirectX::XMFLOAT3 Position;
+			DirectX::XMFLOAT3 Color;
+			float Intensity;
+			DirectX::XMFLOAT4X4 viewProjection[6];
+		};
+		static_assert(offsetof(PointLight, Range) == 0, "PointLight.Range is misplaced");
+		static_assert(offsetof(PointLight, Position) == 4, "PointLight.Position is misplaced");
+		static_assert(offsetof(PointLight, Color) == 16, "PointLight.Color is misplaced");
+		static_assert(offsetof(PointLight, Intensity) == 28, "PointLight.Intensity is misplaced");
+		static_assert(offsetof(PointLight, viewProjection) == 32, "PointLight.viewProjection is misplaced");
+		static_assert(sizeof(PointLight) == 416, "PointLight is the wrong size");
+
+		struct DirectionalLight
+		{
+			DirectX::XMFLOAT4 Direction;
+			DirectX::XMFLOAT4 Color;
+			float Intensity;
+			float padding0[3];
+		};
+		static_assert(offsetof(DirectionalLight, Direction) == 0, "DirectionalLight.Direction is misplaced");
+		static_assert(offsetof(DirectionalLight, Color) == 16, "DirectionalLight.Color is misplaced");
+		static_assert(offsetof(DirectionalLight, Intensity) == 32, "DirectionalLight.Intensity is misplaced");
+		static_assert(sizeof(DirectionalLight) == 48, "DirectionalLight is the wrong size");
+
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			PointLight lights[6];
+			DirectionalLight dirLight;
+			int lightCount;
+			DirectX::XMFLOAT3 cameraPos;
+			DirectX::XMFLOAT4X4 view;
+		};
+		static_assert(offsetof(ExternalData, lights) == 0, "externalData.lights is misplaced");
+		static_assert(offsetof(ExternalData, dirLight) == 2496, "externalData.dirLight is misplaced");
+		static_assert(offsetof(ExternalData, lightCount) == 2544, "externalData.lightCount is misplaced");
+		static_assert(offsetof(ExternalData, cameraPos) == 2548, "externalData.cameraPos is misplaced");
+		static_assert(offsetof(ExternalData, view) == 2560, "externalData.view is misplaced");
+		static_assert(sizeof(ExternalData) == 2624, "externalData is the wrong size");
+	}
+
+	// PixelShader.hlsl
+	namespace PixelShader
+	{
+		struct PointLight
+		{
+			float Range;
+			DirectX::XMFLOAT3 Position;
+			DirectX::XMFLOAT3 Color;
+			float Intensity;
+			DirectX::XMFLOAT4X4 viewProjection[6];
+		};
+		static_assert(offsetof(PointLight, Range) == 0, "PointLight.Range is misplaced");
+		static_assert(offsetof(PointLight, Position) == 4, "PointLight.Position is misplaced");
+		static_assert(offsetof(PointLight, Color) == 16, "PointLight.Color is misplaced");
+		static_assert(offsetof(PointLight, Intensity) == 28, "PointLight.Intensity is misplaced");
+		static_assert(offsetof(PointLight, viewProjection) == 32, "PointLight.viewProjection is misplaced");
+		static_assert(sizeof(PointLight) == 416, "PointLight is the wrong size");
+
+		struct DirectionalLight
+		{
+			DirectX::XMFLOAT4 Direction;
+			DirectX::XMFLOAT4 Color;
+			float Intensity;
+			float padding0[3];
+		};
+		static_assert(offsetof(DirectionalLight, Direction) == 0, "DirectionalLight.Direction is misplaced");
+		static_assert(offsetof(DirectionalLight, Color) == 16, "DirectionalLight.Color is misplaced");
+		static_assert(offsetof(DirectionalLight, Intensity) == 32, "DirectionalLight.Intensity is misplaced");
+		static_assert(sizeof(DirectionalLight) == 48, "DirectionalLight is the wrong size");
+
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			PointLight lights[6];
+			DirectionalLight dirLight;
+			int lightCount;
+			int isRefractive;
+			float padding0[2];
+			DirectX::XMFLOAT3 cameraPos;
+			float padding1;
+			DirectX::XMFLOAT4X4 view;
+		};
+		static_assert(offsetof(ExternalData, lights) == 0, "externalData.lights is misplaced");
+		static_assert(offsetof(ExternalData, dirLight) == 2496, "externalData.dirLight is misplaced");
+		static_assert(offsetof(ExternalData, lightCount) == 2544, "externalData.lightCount is misplaced");
+		static_assert(offsetof(ExternalData, isRefractive) == 2548, "externalData.isRefractive is misplaced");
+		static_assert(offsetof(ExternalData, cameraPos) == 2560, "externalData.cameraPos is misplaced");
+		static_assert(offsetof(ExternalData, view) == 2576, "externalData.view is misplaced");
+		static_assert(sizeof(ExternalData) == 2640, "externalData is the wrong size");
+	}
+
+	// shadowVS.hlsl
+	namespace shadowVS
+	{
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			DirectX::XMFLOAT4X4 world;
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+		};
+		static_assert(offsetof(ExternalData, world) == 0, "externalData.world is misplaced");
+		static_assert(offsetof(ExternalData, view) == 64, "externalData.view is misplaced");
+		static_assert(offsetof(ExternalData, projection) == 128, "externalData.projection is misplaced");
+		static_assert(sizeof(ExternalData) == 192, "externalData is the wrong size");
+	}
+
+	// SkyVertexShader.hlsl
+	namespace SkyVertexShader
+	{
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+		};
+		static_assert(offsetof(ExternalData, view) == 0, "externalData.view is misplaced");
+		static_assert(offsetof(ExternalData, projection) == 64, "externalData.projection is misplaced");
+		static_assert(sizeof(ExternalData) == 128, "externalData is the wrong size");
+	}
+
+	// VertexShader.hlsl
+	namespace VertexShader
+	{
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			DirectX::XMFLOAT4X4 world;
+			DirectX::XMFLOAT4X4 invTransWorld;
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+			float uvScale;
+			float padding0[3];
+		};
+		static_assert(offsetof(ExternalData, world) == 0, "externalData.world is misplaced");
+		static_assert(offsetof(ExternalData, invTransWorld) == 64, "externalData.invTransWorld is misplaced");
+		static_assert(offsetof(ExternalData, view) == 128, "externalData.view is misplaced");
+		static_assert(offsetof(ExternalData, projection) == 192, "externalData.projection is misplaced");
+		static_assert(offsetof(ExternalData, uvScale) == 256, "externalData.uvScale is misplaced");
+		static_assert(sizeof(ExternalData) == 272, "externalData is the wrong size");
+	}
+
+	// WaterPixelShader.hlsl
+	namespace WaterPixelShader
+	{
+		struct PointLight
+		{
+			float Range;
+			DirectX::XMFLOAT3 Position;
+			DirectX::XMFLOAT3 Color;
+			float Intensity;
+			DirectX::XMFLOAT4X4 viewProjection[6];
+		};
+		static_assert(offsetof(PointLight, Range) == 0, "PointLight.Range is misplaced");
+		static_assert(offsetof(PointLight, Position) == 4, "PointLight.Position is misplaced");
+		static_assert(offsetof(PointLight, Color) == 16, "PointLight.Color is misplaced");
+		static_assert(offsetof(PointLight, Intensity) == 28, "PointLight.Intensity is misplaced");
+		static_assert(offsetof(PointLight, viewProjection) == 32, "PointLight.viewProjection is misplaced");
+		static_assert(sizeof(PointLight) == 416, "PointLight is the wrong size");
+
+		struct DirectionalLight
+		{
+			DirectX::XMFLOAT4 Direction;
+			DirectX::XMFLOAT4 Color;
+			float Intensity;
+			float padding0[3];
+		};
+		static_assert(offsetof(DirectionalLight, Direction) == 0, "DirectionalLight.Direction is misplaced");
+		static_assert(offsetof(DirectionalLight, Color) == 16, "DirectionalLight.Color is misplaced");
+		static_assert(offsetof(DirectionalLight, Intensity) == 32, "DirectionalLight.Intensity is misplaced");
+		static_assert(sizeof(DirectionalLight) == 48, "DirectionalLight is the wrong size");
+
+		struct ExternalData
+		{
+			static const char* BufferName() { return "externalData"; }
+			static const unsigned int Register = 0;
+
+			PointLight lights[6];
+			DirectionalLight dirLight;
+			int lightCount;
+			DirectX::XMFLOAT3 cameraPos;
+			DirectX::XMFLOAT3 scale;
+			float totalTime;
+			DirectX::XMFLOAT4X4 view;
+			DirectX::XMFLOAT4X4 projection;
+			int width;
+			int height;
+			float padding0[2];
+		};
+		static_assert(offsetof(ExternalData, lights) == 0, "externalData.lights is misplaced");
+		static_assert(offsetof(ExternalData, dirLight) == 2496, "externalData.dirLight is misplaced");
+		static_assert(offsetof(ExternalData, lightCount) == 2544, "externalData.lightCount is misplaced");
+		static_assert(offsetof(ExternalData, cameraPos) == 2548, "externalData.cameraPos is misplaced");
+		static_assert(offsetof(ExternalData, scale) == 2560, "externalData.scale is misplaced");
+		static_assert(offsetof(ExternalData, totalTime) == 2572, "externalData.totalTime is misplaced");
+		static_assert(offsetof(ExternalData, view) == 2576, "externalData.view is misplaced");
+		static_assert(offsetof(ExternalData, projection) == 2640, "externalData.projection is misplaced");
+		static_assert(offsetof(ExternalData, width) == 2704, "externalData.width is misplaced");
+		static_assert(offsetof(ExternalData, height) == 2708, "externalData.height is misplaced");
+		static_assert(sizeof(ExternalData) == 2720, "externalData is the wrong size");
+	}
+}
@@ -0,0 +1,287 @@
+#include "ShaderLibrary.h"
+#include "ShaderReflectionCache.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+ShaderLibrary::ShaderLibrary(ID3D11Device* device, ID3D11DeviceContext* context, WorkerPool* workerPool)
+{
+	this->device = device;
+	this->context = context;
+	this->workerPool = workerPool;
+
+	loadMilliseconds = 0.0;
+	shaderMilliseconds = 0.0;
+	stateHits = 0;
+	stateMisses = 0;
+}
+
+ShaderLibrary::~ShaderLibrary()
+{
+	// Shaders are shared_ptrs, so they live on in whoever still holds them
+	ReleaseStates(rasterizerStates);
+	ReleaseStates(blendStates);
+	ReleaseStates(depthStencilStates);
+	ReleaseStates(samplerStates);
+}
+
+std::shared_ptr<SimpleVertexShader> ShaderLibrary::AddVertexShader(const wchar_t* file)
+{
+	std::wstring key = std::wstring(L"vs:") + file;
+	auto found = shaderIndices.find(key);
+	if (found != shaderIndices.end())
+		return std::static_pointer_cast<SimpleVertexShader>(shaders[found->second].Shader);
+
+	std::shared_ptr<SimpleVertexShader> shader = std::make_shared<SimpleVertexShader>(device, context);
+	ShaderEntry entry = { file, shader, false, false, 0.0 };
+	shaderIndices[key] = (unsigned int)shaders.size();
+	shaders.push_back(entry);
+	return shader;
+}
+
+std::shared_ptr<SimplePixelShader> ShaderLibrary::AddPixelShader(const wchar_t* file)
+{
+	std::wstring key = std::wstring(L"ps:") + file;
+	auto found = shaderIndices.find(key);
+	if (found != shaderIndices.end())
+		return std::static_pointer_cast<SimplePixelShader>(shaders[found->second].Shader);
+
+	std::shared_ptr<SimplePixelShader> shader = std::make_shared<SimplePixelShader>(device, context);
+	ShaderEntry entry = { file, shader, false, false, 0.0 };
+	shaderIndices[key] = (unsigned int)shaders.size();
+	shaders.push_back(entry);
+	return shader;
+}
+
+bool ShaderLibrary::LoadAll()
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::vector<unsigned int> pending;
+	for (unsigned int i = 0; i < shaders.size(); i++)
+	{
+		if (!shaders[i].Loaded)
+			pending.push_back(i);
+	}
+
+	// Each shader is file I/O, shader creation and reflection, none of which
+	// touch the immediate context, so they're independent.  One per chunk,
+	// as a single shader can take far longer than the others.
+	auto load = [&](int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			ShaderEntry& entry = shaders[pending[i]];
+			std::chrono::steady_clock::time_point shaderStart = std::chrono::steady_clock::now();
+
+			entry.Failed = !entry.Shader->LoadShaderFile(entry.File.c_str());
+			entry.Loaded = true;
+
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - shaderStart;
+			entry.Milliseconds = elapsed.count();
+		}
+	};
+	if (workerPool)
+		workerPool->ParallelFor((int)pending.size(), 1, load);
+	else
+		load(0, (int)pending.size());
+
+	bool allLoaded = true;
+	shaderMilliseconds = 0.0;
+	for (unsigned int i = 0; i < pending.size(); i++)
+	{
+		shaderMilliseconds += shaders[pending[i]].Milliseconds;
+		if (shaders[pending[i]].Failed)
+			allLoaded = false;
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	loadMilliseconds = elapsed.count();
+	return allLoaded;
+}
+
+// Descriptions copied field by field over zeroed memory, so the padding after
+// their byte-sized members is always zero and equal descriptions have equal
+// bytes.  BOOLs are folded to 0 or 1, as any non-zero value means TRUE.
+static void MakeStateKey(const D3D11_RASTERIZER_DESC& desc, D3D11_RASTERIZER_DESC& key)
+{
+	memset(&key, 0, sizeof(key));
+	key.FillMode = desc.FillMode;
+	key.CullMode = desc.CullMode;
+	key.FrontCounterClockwise = desc.FrontCounterClockwise != FALSE;
+	key.DepthBias = desc.DepthBias;
+	key.DepthBiasClamp = desc.DepthBiasClamp;
+	key.SlopeScaledDepthBias = desc.SlopeScaledDepthBias;
+	key.DepthClipEnable = desc.DepthClipEnable != FALSE;
+	key.ScissorEnable = desc.ScissorEnable != FALSE;
+	key.MultisampleEnable = desc.MultisampleEnable != FALSE;
+	key.AntialiasedLineEnable = desc.AntialiasedLineEnable != FALSE;
+}
+
+static void MakeStateKey(const D3D11_BLEND_DESC& desc, D3D11_BLEND_DESC& key)
+{
+	memset(&key, 0, sizeof(key));
+	key.AlphaToCoverageEnable = desc.AlphaToCoverageEnable != FALSE;
+	key.IndependentBlendEnable = desc.IndependentBlendEnable != FALSE;
+	for (int i = 0; i < 8; i++)
+	{
+		const D3D11_RENDER_TARGET_BLEND_DESC& target = desc.RenderTarget[i];
+		D3D11_RENDER_TARGET_BLEND_DESC& keyTarget = key.RenderTarget[i];
+		keyTarget.BlendEnable = target.BlendEnable != FALSE;
+		keyTarget.SrcBlend = target.SrcBlend;
+		keyTarget.DestBlend = target.DestBlend;
+		keyTarget.BlendOp = target.BlendOp;
+		keyTarget.SrcBlendAlpha = target.SrcBlendAlpha;
+		keyTarget.DestBlendAlpha = target.DestBlendAlpha;
+		keyTarget.BlendOpAlpha = target.BlendOpAlpha;
+		keyTarget.RenderTargetWriteMask = target.RenderTargetWriteMask;
+	}
+}
+
+static void MakeStateKey(const D3D11_DEPTH_STENCILOP_DESC& desc, D3D11_DEPTH_STENCILOP_DESC& key)
+{
+	key.StencilFailOp = desc.StencilFailOp;
+	key.StencilDepthFailOp = desc.StencilDepthFailOp;
+	key.StencilPassOp = desc.StencilPassOp;
+	key.StencilFunc = desc.StencilFunc;
+}
+
+static void MakeStateKey(const D3D11_DEPTH_STENCIL_DESC& desc, D3D11_DEPTH_STENCIL_DESC& key)
+{
+	memset(&key, 0, sizeof(key));
+	key.DepthEnable = desc.DepthEnable != FALSE;
+	key.DepthWriteMask = desc.DepthWriteMask;
+	key.DepthFunc = desc.DepthFunc;
+	key.StencilEnable = desc.StencilEnable != FALSE;
+	key.StencilReadMask = desc.StencilReadMask;
+	key.StencilWriteMask = desc.StencilWriteMask;
+	MakeStateKey(desc.FrontFace, key.FrontFace);
+	MakeStateKey(desc.BackFace, key.BackFace);
+}
+
+static void MakeStateKey(const D3D11_SAMPLER_DESC& desc, D3D11_SAMPLER_DESC& key)
+{
+	memset(&key, 0, sizeof(key));
+	key.Filter = desc.Filter;
+	key.AddressU = desc.AddressU;
+	key.AddressV = desc.AddressV;
+	key.AddressW = desc.AddressW;
+	key.MipLODBias = desc.MipLODBias;
+	key.MaxAnisotropy = desc.MaxAnisotropy;
+	key.ComparisonFunc = desc.ComparisonFunc;
+	for (int i = 0; i < 4; i++)
+		key.BorderColor[i] = desc.BorderColor[i];
+	key.MinLOD = desc.MinLOD;
+	key.MaxLOD = desc.MaxLOD;
+}
+
+template<typename Desc, typename State, typename Create>
+State* ShaderLibrary::FindState(StateMap<Desc, State>& map, const Desc& desc, Create create)
+{
+	// Hash and compare a copy with known padding, never the caller's bytes
+	Desc key;
+	MakeStateKey(desc, key);
+
+	std::lock_guard<std::mutex> lock(stateMutex);
+
+	uint64_t hash = ShaderReflectionCache::Hash(&key, sizeof(Desc));
+	auto found = map.find(hash);
+	if (found != map.end() && memcmp(&found->second.Description, &key, sizeof(Desc)) == 0)
+	{
+		stateHits++;
+		found->second.Object->AddRef();
+		return found->second.Object;
+	}
+
+	stateMisses++;
+	State* object = 0;
+	if (FAILED(create(&desc, &object)))
+		return 0;
+
+	// A colliding description just goes uncached.  The key is copied bytewise,
+	// as copying the struct needn't keep its padding zeroed.
+	if (found == map.end())
+	{
+		StateEntry<Desc, State>& entry = map[hash];
+		memcpy(&entry.Description, &key, sizeof(Desc));
+		entry.Object = object;
+		object->AddRef();
+	}
+	return object;
+}
+
+template<typename Desc, typename State>
+void ShaderLibrary::ReleaseStates(StateMap<Desc, State>& map)
+{
+	for (auto& entry : map)
+		entry.second.Object->Release();
+	map.clear();
+}
+
+ID3D11RasterizerState* ShaderLibrary::GetRasterizerState(const D3D11_RASTERIZER_DESC& desc)
+{
+	return FindState(rasterizerStates, desc, [this](const D3D11_RASTERIZER_DESC* d, ID3D11RasterizerState** s) { return device->CreateRasterizerState(d, s); });
+}
+
+ID3D11BlendState* ShaderLibrary::GetBlendState(const D3D11_BLEND_DESC& desc)
+{
+	return FindState(blendStates, desc, [this](const D3D11_BLEND_DESC* d, ID3D11BlendState** s) { return device->CreateBlendState(d, s); });
+}
+
+ID3D11DepthStencilState* ShaderLibrary::GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc)
+{
+	return FindState(depthStencilStates, desc, [this](const D3D11_DEPTH_STENCIL_DESC* d, ID3D11DepthStencilState** s) { return device->CreateDepthStencilState(d, s); });
+}
+
+ID3D11SamplerState* ShaderLibrary::GetSamplerState(const D3D11_SAMPLER_DESC& desc)
+{
+	return FindState(samplerStates, desc, [this](const D3D11_SAMPLER_DESC* d, ID3D11SamplerState** s) { return device->CreateSamplerState(d, s); });
+}
+
+void ShaderLibrary::Report()
+{
+	printf("\nShaders: %u in %.1f ms on %u threads (%.1f ms one by one), %u failed\n",
+		GetShaderCount(), loadMilliseconds, workerPool ? workerPool->GetThreadCount() : 1, shaderMilliseconds, GetFailedCount());
+	for (unsigned int i = 0; i < shaders.size(); i++)
+	{
+		if (shaders[i].Failed)
+			printf("  Failed to load %ls\n", shaders[i].File.c_str());
+	}
+	printf("State objects: %u made, %u reused\n", stateMisses, stateHits);
+}
+
+unsigned int ShaderLibrary::GetShaderCount()
+{
+	return (unsigned int)shaders.size();
+}
+
+unsigned int ShaderLibrary::GetFailedCount()
+{
+	unsigned int failed = 0;
+	for (unsigned int i = 0; i < shaders.size(); i++)
+	{
+		if (shaders[i].Failed)
+			failed++;
+	}
+	return failed;
+}
+
+double ShaderLibrary::GetLoadMilliseconds()
+{
+	return loadMilliseconds;
+}
+
+double ShaderLibrary::GetShaderMilliseconds()
+{
+	return shaderMilliseconds;
+}
+
+unsigned int ShaderLibrary::GetStateHits()
+{
+	return stateHits;
+}
+
+unsigned int ShaderLibrary::GetStateMisses()
+{
+	return stateMisses;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "SimpleShader.h"
+#include "WorkerPool.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Every shader the game uses, loaded together across the
+// WorkerPool, plus the pipeline state objects made from
+// descriptions.
+//
+// Add*Shader() hands back the shader straight away as a
+// handle; it is filled in by the next LoadAll().  Asking
+// for the same file twice gives the same shader.
+// --------------------------------------------------------
+class ShaderLibrary
+{
+public:
+	///<summary>
+	///workerPool may be null to load on the calling thread alone.
+	///</summary>
+	ShaderLibrary(ID3D11Device* device, ID3D11DeviceContext* context, WorkerPool* workerPool);
+	~ShaderLibrary();
+
+	std::shared_ptr<SimpleVertexShader> AddVertexShader(const wchar_t* file);
+	std::shared_ptr<SimplePixelShader> AddPixelShader(const wchar_t* file);
+
+	///<summary>
+	///Load every shader added since the last call, one per task.  Blocks until all are done.
+	///Returns false if any failed; those shaders stay invalid.
+	///</summary>
+	bool LoadAll();
+
+	///<summary>
+	///Shared state objects, made once per distinct description - compared by value, so padding
+	///and how a BOOL spells TRUE don't matter.  Like the device's Create calls,
+	///each returns a reference the caller must Release.  Null if the device rejects the description.
+	///</summary>
+	ID3D11RasterizerState* GetRasterizerState(const D3D11_RASTERIZER_DESC& desc);
+	ID3D11BlendState* GetBlendState(const D3D11_BLEND_DESC& desc);
+	ID3D11DepthStencilState* GetDepthStencilState(const D3D11_DEPTH_STENCIL_DESC& desc);
+	ID3D11SamplerState* GetSamplerState(const D3D11_SAMPLER_DESC& desc);
+
+	///<summary>
+	///Print how the last LoadAll() went, naming any shader that failed.
+	///</summary>
+	void Report();
+
+	unsigned int GetShaderCount();
+	unsigned int GetFailedCount();
+	double GetLoadMilliseconds();		// Wall time of the last LoadAll()
+	double GetShaderMilliseconds();		// Summed time of each shader in it, as if loaded one by one
+	unsigned int GetStateHits();
+	unsigned int GetStateMisses();
+
+private:
+	struct ShaderEntry
+	{
+		std::wstring File;
+		std::shared_ptr<ISimpleShader> Shader;
+		bool Loaded;
+		bool Failed;
+		double Milliseconds;
+	};
+
+	template<typename Desc, typename State>
+	struct StateEntry
+	{
+		Desc Description;
+		State* Object;
+	};
+
+	template<typename Desc, typename State>
+	using StateMap = std::unordered_map<uint64_t, StateEntry<Desc, State>>;
+
+	///<summary>
+	///Look up a description's state object, creating it with create(desc, &object) on a miss.
+	///</summary>
+	template<typename Desc, typename State, typename Create>
+	State* FindState(StateMap<Desc, State>& map, const Desc& desc, Create create);
+
+	template<typename Desc, typename State>
+	void ReleaseStates(StateMap<Desc, State>& map);
+
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	WorkerPool* workerPool;
+
+	std::vector<ShaderEntry> shaders;
+	std::unordered_map<std::wstring, unsigned int> shaderIndices;	// Keyed by stage and file name
+	double loadMilliseconds;
+	double shaderMilliseconds;
+
+	std::mutex stateMutex;
+	StateMap<D3D11_RASTERIZER_DESC, ID3D11RasterizerState> rasterizerStates;
+	StateMap<D3D11_BLEND_DESC, ID3D11BlendState> blendStates;
+	StateMap<D3D11_DEPTH_STENCIL_DESC, ID3D11DepthStencilState> depthStencilStates;
+	StateMap<D3D11_SAMPLER_DESC, ID3D11SamplerState> samplerStates;
+	unsigned int stateHits;
+	unsigned int stateMisses;
+};
@@ -0,0 +1,341 @@
+#include "ShaderReflectionCache.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const uint32_t FileMagic = 0x43525353;	// "SSRC"
+	const uint32_t FileVersion = 2;
+
+	// Appends little-endian values to a byte vector
+	struct Writer
+	{
+		std::vector<unsigned char>& bytes;
+
+		void U32(uint32_t value)
+		{
+			for (int i = 0; i < 4; i++)
+				bytes.push_back((unsigned char)(value >> (i * 8)));
+		}
+
+		void U64(uint64_t value)
+		{
+			U32((uint32_t)value);
+			U32((uint32_t)(value >> 32));
+		}
+
+		void String(const std::string& value)
+		{
+			U32((uint32_t)value.size());
+			bytes.insert(bytes.end(), value.begin(), value.end());
+		}
+	};
+
+	// Reads values back, failing (rather than reading past the end) on truncated data
+	struct Reader
+	{
+		const unsigned char* bytes;
+		size_t size;
+		size_t position;
+
+		bool U32(uint32_t& value)
+		{
+			if (size - position < 4)
+				return false;
+
+			value = 0;
+			for (int i = 0; i < 4; i++)
+				value |= (uint32_t)bytes[position + i] << (i * 8);
+			position += 4;
+			return true;
+		}
+
+		bool U64(uint64_t& value)
+		{
+			uint32_t low, high;
+			if (!U32(low) || !U32(high))
+				return false;
+
+			value = ((uint64_t)high << 32) | low;
+			return true;
+		}
+
+		bool String(std::string& value)
+		{
+			uint32_t length;
+			if (!U32(length) || size - position < length)
+				return false;
+
+			value.assign((const char*)bytes + position, length);
+			position += length;
+			return true;
+		}
+
+		// A count of items that each take at least minimumSize bytes, so a
+		// corrupt count can't make us reserve a huge vector
+		bool Count(uint32_t& count, size_t minimumSize)
+		{
+			return U32(count) && count <= (size - position) / minimumSize;
+		}
+	};
+
+	void WriteResources(Writer& writer, const std::vector<ReflectedResource>& resources)
+	{
+		writer.U32((uint32_t)resources.size());
+		for (const ReflectedResource& resource : resources)
+		{
+			writer.String(resource.Name);
+			writer.U32(resource.BindIndex);
+		}
+	}
+
+	bool ReadResources(Reader& reader, std::vector<ReflectedResource>& resources)
+	{
+		uint32_t count;
+		if (!reader.Count(count, 8))
+			return false;
+
+		resources.resize(count);
+		for (ReflectedResource& resource : resources)
+		{
+			uint32_t bindIndex;
+			if (!reader.String(resource.Name) || !reader.U32(bindIndex))
+				return false;
+			resource.BindIndex = bindIndex;
+		}
+		return true;
+	}
+}
+
+ShaderReflectionCache::ShaderReflectionCache(const std::string& path)
+{
+	this->path = path;
+	modified = false;
+	hits = 0;
+	misses = 0;
+}
+
+ShaderReflectionCache::~ShaderReflectionCache()
+{
+}
+
+bool ShaderReflectionCache::Load()
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	Reader reader = { bytes.data(), bytes.size(), 0 };
+
+	uint32_t magic, version, count;
+	if (!reader.U32(magic) || magic != FileMagic ||
+		!reader.U32(version) || version != FileVersion ||
+		!reader.Count(count, 20))
+		return false;
+
+	std::lock_guard<std::mutex> lock(entryLock);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint64_t hash, bytecodeSize;
+		uint32_t entrySize;
+		if (!reader.U64(hash) || !reader.U64(bytecodeSize) || !reader.U32(entrySize) ||
+			reader.size - reader.position < entrySize)
+			return false;
+
+		// Entries are checked when they're used, not here
+		Entry& entry = entries[hash];
+		entry.BytecodeSize = bytecodeSize;
+		entry.Bytes.assign(bytes.begin() + reader.position, bytes.begin() + reader.position + entrySize);
+		reader.position += entrySize;
+	}
+
+	return true;
+}
+
+bool ShaderReflectionCache::Save()
+{
+	std::lock_guard<std::mutex> lock(entryLock);
+	if (!modified)
+		return true;
+
+	std::vector<unsigned char> bytes;
+	Writer writer = { bytes };
+	writer.U32(FileMagic);
+	writer.U32(FileVersion);
+	writer.U32((uint32_t)entries.size());
+	for (const auto& e : entries)
+	{
+		writer.U64(e.first);
+		writer.U64(e.second.BytecodeSize);
+		writer.U32((uint32_t)e.second.Bytes.size());
+		bytes.insert(bytes.end(), e.second.Bytes.begin(), e.second.Bytes.end());
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		return false;
+
+	file.write((const char*)bytes.data(), bytes.size());
+	if (!file)
+		return false;
+
+	modified = false;
+	return true;
+}
+
+bool ShaderReflectionCache::Find(const void* bytecode, size_t size, ShaderReflectionData& data)
+{
+	uint64_t hash = Hash(bytecode, size);
+
+	std::lock_guard<std::mutex> lock(entryLock);
+	auto e = entries.find(hash);
+	if (e != entries.end() && e->second.BytecodeSize == size &&
+		Deserialize(e->second.Bytes.data(), e->second.Bytes.size(), data))
+	{
+		hits++;
+		return true;
+	}
+
+	misses++;
+	return false;
+}
+
+void ShaderReflectionCache::Store(const void* bytecode, size_t size, const ShaderReflectionData& data)
+{
+	Entry entry;
+	entry.BytecodeSize = size;
+	Serialize(data, entry.Bytes);
+
+	uint64_t hash = Hash(bytecode, size);
+
+	std::lock_guard<std::mutex> lock(entryLock);
+	entries[hash] = std::move(entry);
+	modified = true;
+}
+
+unsigned int ShaderReflectionCache::GetHitCount()
+{
+	return hits;
+}
+
+unsigned int ShaderReflectionCache::GetMissCount()
+{
+	return misses;
+}
+
+uint64_t ShaderReflectionCache::Hash(const void* data, size_t size)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+void ShaderReflectionCache::Serialize(const ShaderReflectionData& data, std::vector<unsigned char>& bytes)
+{
+	bytes.clear();
+	Writer writer = { bytes };
+
+	writer.U32((uint32_t)data.ConstantBuffers.size());
+	for (const ReflectedConstantBuffer& cb : data.ConstantBuffers)
+	{
+		writer.String(cb.Name);
+		writer.U32(cb.Type);
+		writer.U32(cb.BindIndex);
+		writer.U32(cb.Size);
+		writer.U32((uint32_t)cb.Variables.size());
+		for (const ReflectedVariable& var : cb.Variables)
+		{
+			writer.String(var.Name);
+			writer.U32(var.ByteOffset);
+			writer.U32(var.Size);
+		}
+	}
+
+	WriteResources(writer, data.Textures);
+	WriteResources(writer, data.Samplers);
+
+	writer.U32((uint32_t)data.InputParameters.size());
+	for (const ReflectedInputParameter& input : data.InputParameters)
+	{
+		writer.String(input.SemanticName);
+		writer.U32(input.SemanticIndex);
+		writer.U32(input.ComponentType);
+		writer.U32(input.Mask);
+	}
+}
+
+bool ShaderReflectionCache::Deserialize(const unsigned char* bytes, size_t size, ShaderReflectionData& data)
+{
+	// Read into a copy, so a bad entry leaves data as it was rather than half filled
+	ShaderReflectionData result;
+	Reader reader = { bytes, size, 0 };
+
+	uint32_t cbCount;
+	if (!reader.Count(cbCount, 20))
+		return false;
+
+	result.ConstantBuffers.resize(cbCount);
+	for (ReflectedConstantBuffer& cb : result.ConstantBuffers)
+	{
+		uint32_t type, bindIndex, cbSize, varCount;
+		if (!reader.String(cb.Name) || !reader.U32(type) || !reader.U32(bindIndex) ||
+			!reader.U32(cbSize) || !reader.Count(varCount, 12))
+			return false;
+
+		cb.Type = type;
+		cb.BindIndex = bindIndex;
+		cb.Size = cbSize;
+
+		cb.Variables.resize(varCount);
+		for (ReflectedVariable& var : cb.Variables)
+		{
+			uint32_t offset, varSize;
+			if (!reader.String(var.Name) || !reader.U32(offset) || !reader.U32(varSize))
+				return false;
+
+			// A variable outside its buffer would have us write past the local copy
+			if (offset > cbSize || varSize > cbSize - offset)
+				return false;
+
+			var.ByteOffset = offset;
+			var.Size = varSize;
+		}
+	}
+
+	if (!ReadResources(reader, result.Textures) || !ReadResources(reader, result.Samplers))
+		return false;
+
+	uint32_t inputCount;
+	if (!reader.Count(inputCount, 16))
+		return false;
+
+	result.InputParameters.resize(inputCount);
+	for (ReflectedInputParameter& input : result.InputParameters)
+	{
+		uint32_t semanticIndex, componentType, mask;
+		if (!reader.String(input.SemanticName) || !reader.U32(semanticIndex) ||
+			!reader.U32(componentType) || !reader.U32(mask))
+			return false;
+
+		// Only xyzw exist
+		if (mask > 15)
+			return false;
+
+		input.SemanticIndex = semanticIndex;
+		input.ComponentType = componentType;
+		input.Mask = mask;
+	}
+
+	if (reader.position != size)
+		return false;
+
+	data = std::move(result);
+	return true;
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// The parts of a shader's reflection that SimpleShader uses,
+// flattened into plain tables.  Nothing in here depends on
+// Direct3D, so it can be saved, loaded and checked anywhere.
+// --------------------------------------------------------
+struct ReflectedVariable
+{
+	std::string Name;
+	unsigned int ByteOffset;
+	unsigned int Size;
+};
+
+struct ReflectedConstantBuffer
+{
+	std::string Name;
+	unsigned int Type;		// A D3D_CBUFFER_TYPE
+	unsigned int BindIndex;
+	unsigned int Size;
+	std::vector<ReflectedVariable> Variables;
+};
+
+struct ReflectedResource
+{
+	std::string Name;
+	unsigned int BindIndex;
+};
+
+// One element of the input signature - what a vertex shader reads per vertex
+struct ReflectedInputParameter
+{
+	std::string SemanticName;
+	unsigned int SemanticIndex;
+	unsigned int ComponentType;	// A D3D_REGISTER_COMPONENT_TYPE
+	unsigned int Mask;			// Which of xyzw are used
+};
+
+struct ShaderReflectionData
+{
+	std::vector<ReflectedConstantBuffer> ConstantBuffers;
+	std::vector<ReflectedResource> Textures;	// In the order they were reflected
+	std::vector<ReflectedResource> Samplers;
+	std::vector<ReflectedInputParameter> InputParameters;
+};
+
+// --------------------------------------------------------
+// Reflection results for compiled shaders, keyed by a hash
+// of the shader bytecode and kept in a file between runs so
+// that loading a shader we've seen before needs no D3DReflect.
+//
+// A changed shader hashes differently, so stale entries are
+// never used - they just sit in the file until it's deleted.
+// Find() and Store() may be called from several threads.
+// --------------------------------------------------------
+class ShaderReflectionCache
+{
+public:
+	ShaderReflectionCache(const std::string& path);
+	~ShaderReflectionCache();
+
+	///<summary>
+	///Read the cache file, if there is one.  Returns false if it was missing or unreadable.
+	///</summary>
+	bool Load();
+
+	///<summary>
+	///Write the cache file if anything was stored since it was loaded.
+	///</summary>
+	bool Save();
+
+	///<summary>
+	///Look up the reflection for some shader bytecode.  Returns false on a miss.
+	///</summary>
+	bool Find(const void* bytecode, size_t size, ShaderReflectionData& data);
+
+	///<summary>
+	///Remember the reflection for some shader bytecode.
+	///</summary>
+	void Store(const void* bytecode, size_t size, const ShaderReflectionData& data);
+
+	unsigned int GetHitCount();
+	unsigned int GetMissCount();
+
+	// 64 bit FNV-1a
+	static uint64_t Hash(const void* data, size_t size);
+
+	// To and from the compact binary form kept in the file.  Deserialize
+	// leaves data untouched when the bytes are bad.
+	static void Serialize(const ShaderReflectionData& data, std::vector<unsigned char>& bytes);
+	static bool Deserialize(const unsigned char* bytes, size_t size, ShaderReflectionData& data);
+
+private:
+	// Bytecode size is kept alongside the hash as a cheap second check
+	struct Entry
+	{
+		uint64_t BytecodeSize;
+		std::vector<unsigned char> Bytes;
+	};
+
+	std::string path;
+	std::unordered_map<uint64_t, Entry> entries;
+	std::mutex entryLock;
+	bool modified;
+
+	unsigned int hits;
+	unsigned int misses;
+};
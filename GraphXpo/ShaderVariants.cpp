@@ -0,0 +1,188 @@
+#include "ShaderVariants.h"
+
+// The permutations compiled by the project - each file is a wrapper that
+// sets NORMAL_MAP and LIGHT_LIMIT and includes the base shader.  The base
+// shaders themselves are the runtime light count versions.
+const ShaderVariantEntry PixelShaderVariants[] =
+{
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeatureNormalMap>>(L"PixelShader.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeatureLights2>>(L"PixelShader_L2.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeatureLights4>>(L"PixelShader_L4.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeatureLights6>>(L"PixelShader_L6.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeatureNormalMap, ShaderFeatureLights2>>(L"PixelShader_N_L2.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeatureNormalMap, ShaderFeatureLights4>>(L"PixelShader_N_L4.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeatureNormalMap, ShaderFeatureLights6>>(L"PixelShader_N_L6.cso"),
+
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeaturePbr, ShaderFeatureNormalMap>>(L"PBRPixelShader.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeaturePbr, ShaderFeatureLights2>>(L"PBRPixelShader_L2.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeaturePbr, ShaderFeatureLights4>>(L"PBRPixelShader_L4.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeaturePbr, ShaderFeatureLights6>>(L"PBRPixelShader_L6.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeaturePbr, ShaderFeatureNormalMap, ShaderFeatureLights2>>(L"PBRPixelShader_N_L2.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeaturePbr, ShaderFeatureNormalMap, ShaderFeatureLights4>>(L"PBRPixelShader_N_L4.cso"),
+	MakeShaderVariantEntry<ShaderVariant<ShaderFeaturePbr, ShaderFeatureNormalMap, ShaderFeatureLights6>>(L"PBRPixelShader_N_L6.cso"),
+};
+
+const unsigned int PixelShaderVariantCount = sizeof(PixelShaderVariants) / sizeof(PixelShaderVariants[0]);
+
+unsigned int ShaderLightBucket(unsigned int lightCount)
+{
+	if (lightCount <= 2) return ShaderFeatureLights2;
+	if (lightCount <= 4) return ShaderFeatureLights4;
+	if (lightCount <= 6) return ShaderFeatureLights6;
+	return 0;
+}
+
+unsigned int ShaderLightLimit(unsigned int key)
+{
+	return ((key & ShaderFeatureLightMask) >> ShaderFeatureLightShift) * 2;
+}
+
+unsigned int ShaderVariantKey(bool normalMap, bool pbr, bool shadows, unsigned int lightCount)
+{
+	unsigned int key = ShaderLightBucket(lightCount);
+	if (normalMap) key |= ShaderFeatureNormalMap;
+	if (pbr) key |= ShaderFeaturePbr;
+	if (shadows) key |= ShaderFeatureShadows;
+	return key;
+}
+
+int SelectShaderVariant(const ShaderVariantEntry* table, unsigned int count, unsigned int key)
+{
+	unsigned int switches = key & ~ShaderFeatureLightMask;
+	unsigned int lights = key & ShaderFeatureLightMask;
+
+	int best = -1;
+	unsigned int bestScore = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		unsigned int variantSwitches = table[i].Key & ~ShaderFeatureLightMask;
+		unsigned int variantLights = table[i].Key & ShaderFeatureLightMask;
+
+		// PBR is a different shading model, not an optional extra
+		if ((variantSwitches ^ switches) & ShaderFeaturePbr)
+			continue;
+
+		// Anything else the variant does, the material has to support
+		if (variantSwitches & ~switches)
+			continue;
+
+		// A fixed light loop has to reach every light
+		if (variantLights != 0 && (lights == 0 || variantLights < lights))
+			continue;
+
+		// Each matching switch outweighs any light fit, and a fixed
+		// loop beats a runtime one, the tighter the better
+		unsigned int score = 1;
+		for (unsigned int bit = ShaderFeatureNormalMap; bit <= ShaderFeatureShadows; bit <<= 1)
+		{
+			if (variantSwitches & bit)
+				score += 8;
+		}
+		if (variantLights != 0)
+			score += 4 - ((variantLights - lights) >> ShaderFeatureLightShift);
+
+		if (score > bestScore)
+		{
+			best = (int)i;
+			bestScore = score;
+		}
+	}
+
+	return best;
+}
+
+ShaderVariantSet::ShaderVariantSet(ID3D11Device* device, ID3D11DeviceContext* context, const ShaderVariantEntry* table, unsigned int count)
+{
+	this->device = device;
+	this->context = context;
+	this->table = table;
+	this->count = count;
+	shaders.resize(count);
+	constantBufferRing = 0;
+	stateCache = 0;
+}
+
+ShaderVariantSet::~ShaderVariantSet()
+{
+	// Shaders are shared_ptrs, and materials may still hold them
+}
+
+void ShaderVariantSet::SetConstantBufferRing(ConstantBufferRing* ring)
+{
+	constantBufferRing = ring;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (shaders[i])
+			shaders[i]->SetConstantBufferRing(ring);
+	}
+}
+
+void ShaderVariantSet::SetStateCache(DeviceStateCache* cache)
+{
+	stateCache = cache;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (shaders[i])
+			shaders[i]->SetStateCache(cache);
+	}
+}
+
+void ShaderVariantSet::Load()
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (shaders[i])
+			continue;
+
+		shaders[i] = std::make_shared<SimplePixelShader>(device, context);
+		shaders[i]->LoadShaderFile(table[i].File);
+		if (constantBufferRing)
+			shaders[i]->SetConstantBufferRing(constantBufferRing);
+		if (stateCache)
+			shaders[i]->SetStateCache(stateCache);
+	}
+}
+
+void ShaderVariantSet::Request(ShaderLibrary* library)
+{
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (!shaders[i])
+			shaders[i] = library->AddPixelShader(table[i].File);
+	}
+}
+
+int ShaderVariantSet::Select(unsigned int key)
+{
+	return SelectShaderVariant(table, count, key);
+}
+
+const ShaderVariantEntry* ShaderVariantSet::GetEntry(int index)
+{
+	if (index < 0 || (unsigned int)index >= count)
+		return 0;
+	return &table[index];
+}
+
+std::shared_ptr<SimplePixelShader> ShaderVariantSet::GetShader(int index)
+{
+	if (index < 0 || (unsigned int)index >= count)
+		return nullptr;
+	return shaders[index];
+}
+
+bool ShaderVariantSet::Apply(Material* material, unsigned int lightCount)
+{
+	unsigned int key = ShaderVariantKey(
+		material->GetNormal() != nullptr,
+		material->GetMetalness() != nullptr || material->GetRoughness() != nullptr,
+		false,	// Nothing samples shadow maps yet
+		lightCount);
+
+	int index = Select(key);
+	if (index < 0 || !shaders[index] || !shaders[index]->IsShaderValid())
+		return false;
+
+	material->UseVariant(shaders[index], &table[index]);
+	return true;
+}
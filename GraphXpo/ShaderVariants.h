@@ -0,0 +1,158 @@
+#pragma once
+
+#include "SimpleShader.h"
+#include "Material.h"
+#include "MaterialParameterBlock.h"
+#include "ConstantBufferRing.h"
+#include "DeviceStateCache.h"
+#include "ShaderLibrary.h"
+#include <memory>
+#include <vector>
+
+// Features a material can ask of its pixel shader, which together make a
+// variant key.  The low bits are switches; the top two are a light count bucket.
+enum ShaderFeature
+{
+	ShaderFeatureNormalMap = 1 << 0,
+	ShaderFeaturePbr = 1 << 1,
+	ShaderFeatureShadows = 1 << 2,
+
+	// Light count buckets - none means the count is only known at runtime
+	ShaderFeatureLightShift = 3,
+	ShaderFeatureLights2 = 1 << ShaderFeatureLightShift,
+	ShaderFeatureLights4 = 2 << ShaderFeatureLightShift,
+	ShaderFeatureLights6 = 3 << ShaderFeatureLightShift,
+	ShaderFeatureLightMask = 3 << ShaderFeatureLightShift
+};
+
+///<summary>
+///The smallest light bucket holding lightCount lights, or 0 if there are too many for any.
+///</summary>
+unsigned int ShaderLightBucket(unsigned int lightCount);
+
+///<summary>
+///The number of lights a key's bucket loops over, or 0 for a runtime count.
+///</summary>
+unsigned int ShaderLightLimit(unsigned int key);
+
+///<summary>
+///Build a variant key from what a material has and what the scene needs.
+///</summary>
+unsigned int ShaderVariantKey(bool normalMap, bool pbr, bool shadows, unsigned int lightCount);
+
+// Ors a list of ShaderFeatures together at compile time
+template<unsigned int... Features>
+struct ShaderFeatureBits
+{
+	static const unsigned int Value = 0;
+};
+
+template<unsigned int First, unsigned int... Rest>
+struct ShaderFeatureBits<First, Rest...>
+{
+	static const unsigned int Value = First | ShaderFeatureBits<Rest...>::Value;
+};
+
+// --------------------------------------------------------
+// One compiled permutation, described at compile time.
+// BindResources() writes only the textures this variant
+// samples - the feature checks are constants, so each
+// instantiation is just its own handful of Set calls.
+// --------------------------------------------------------
+template<unsigned int... Features>
+struct ShaderVariant
+{
+	static const unsigned int Key = ShaderFeatureBits<Features...>::Value;
+	static const bool NormalMap = (Key & ShaderFeatureNormalMap) != 0;
+	static const bool Pbr = (Key & ShaderFeaturePbr) != 0;
+	static const bool Shadows = (Key & ShaderFeatureShadows) != 0;
+
+	static void BindResources(Material* material, MaterialParameterBlock* block)
+	{
+		const MaterialParams& params = material->GetParams();
+		block->SetSamplerState(params.BasicSampler, material->GetSamplerState());
+		block->SetShaderResourceView(params.DiffuseTexture, material->GetDiffuse());
+
+		if (NormalMap)
+			block->SetShaderResourceView(params.NormalTexture, material->GetNormal());
+
+		if (Pbr)
+		{
+			block->SetShaderResourceView(params.MetallicTexture, material->GetMetalness());
+			block->SetShaderResourceView(params.RoughnessTexture, material->GetRoughness());
+		}
+		else
+		{
+			block->SetShaderResourceView(params.SpecularTexture, material->GetSpecular());
+		}
+	}
+};
+
+// A row of the key-to-variant table
+struct ShaderVariantEntry
+{
+	unsigned int Key;
+	const wchar_t* File;
+	void (*BindResources)(Material* material, MaterialParameterBlock* block);
+};
+
+template<typename Variant>
+ShaderVariantEntry MakeShaderVariantEntry(const wchar_t* file)
+{
+	ShaderVariantEntry entry = { Variant::Key, file, &Variant::BindResources };
+	return entry;
+}
+
+// Every precompiled permutation of PixelShader.hlsl and PBRPixelShader.hlsl
+extern const ShaderVariantEntry PixelShaderVariants[];
+extern const unsigned int PixelShaderVariantCount;
+
+///<summary>
+///Pick the best variant for a key, or -1 if none can be used.  A variant never has a switch the key
+///lacks (it would sample missing textures), must match on PBR, and must loop over enough lights.
+///Among those, more matching switches win, then the tightest light loop.
+///</summary>
+int SelectShaderVariant(const ShaderVariantEntry* table, unsigned int count, unsigned int key);
+
+// --------------------------------------------------------
+// Loads a table's variants and switches materials over to
+// the right one for their textures and the scene's lights
+// --------------------------------------------------------
+class ShaderVariantSet
+{
+public:
+	ShaderVariantSet(ID3D11Device* device, ID3D11DeviceContext* context, const ShaderVariantEntry* table, unsigned int count);
+	~ShaderVariantSet();
+
+	// Applied to every variant.  Neither is owned by the set.
+	void SetConstantBufferRing(ConstantBufferRing* ring);
+	void SetStateCache(DeviceStateCache* cache);
+
+	///<summary>
+	///Load every variant's compiled shader.
+	///</summary>
+	void Load();
+
+	///<summary>
+	///Queue every variant in a library instead, to be loaded with the rest by its LoadAll().
+	///</summary>
+	void Request(ShaderLibrary* library);
+
+	int Select(unsigned int key);
+	const ShaderVariantEntry* GetEntry(int index);
+	std::shared_ptr<SimplePixelShader> GetShader(int index);
+
+	///<summary>
+	///Move a material onto the variant that fits it.  Returns false, leaving it alone, if none does.
+	///</summary>
+	bool Apply(Material* material, unsigned int lightCount);
+
+private:
+	ID3D11Device* device;
+	ID3D11DeviceContext* context;
+	const ShaderVariantEntry* table;
+	unsigned int count;
+	std::vector<std::shared_ptr<SimplePixelShader>> shaders;	// Null until loaded
+	ConstantBufferRing* constantBufferRing;
+	DeviceStateCache* stateCache;
+};
@@ -1,4 +1,283 @@
 #include "SimpleShader.h"
+#include "ConstantBufferRing.h"
+
+#include <algorithm>
+
+SimpleShaderFrameStats ISimpleShader::frameStats = {};
+ShaderReflectionCache* ISimpleShader::reflectionCache = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+// ------ SHADER METADATA -----------------------------------------------------
+///////////////////////////////////////////////////////////////////////////////
+
+// --------------------------------------------------------
+// Rounds a byte offset up to a multiple of alignment
+// --------------------------------------------------------
+static size_t AlignOffset(size_t offset, size_t alignment)
+{
+	return (offset + alignment - 1) & ~(alignment - 1);
+}
+
+// --------------------------------------------------------
+// Constructor - starts empty
+// --------------------------------------------------------
+SimpleShaderMetadata::SimpleShaderMetadata()
+{
+	memory = 0;
+	Clear();
+}
+
+// --------------------------------------------------------
+// Destructor
+// --------------------------------------------------------
+SimpleShaderMetadata::~SimpleShaderMetadata()
+{
+	Clear();
+}
+
+// --------------------------------------------------------
+// Frees the allocation and empties every table
+// --------------------------------------------------------
+void SimpleShaderMetadata::Clear()
+{
+	delete[] memory;
+	memory = 0;
+	size = 0;
+
+	constantBuffers = 0;
+	constantBufferCount = 0;
+	variables = 0;
+	variableCount = 0;
+	shaderResourceViews = 0;
+	shaderResourceViewCount = 0;
+	samplers = 0;
+	samplerCount = 0;
+	slots = 0;
+	slotMask = 0;
+	names = 0;
+}
+
+// --------------------------------------------------------
+// Lays out all of a shader's reflection data in one
+// allocation.  In order:
+//  - Each constant buffer's local data, 16 byte aligned
+//  - The constant buffers
+//  - Every buffer's variables, grouped by buffer and
+//    sorted by offset
+//  - SRVs, then samplers
+//  - The name hash table, at most half full
+//  - The names themselves, null terminated
+//
+// The constant buffers' D3D buffers are left null, for
+// the shader to create.
+// --------------------------------------------------------
+void SimpleShaderMetadata::Build(const ShaderReflectionData& data)
+{
+	Clear();
+
+	constantBufferCount = (unsigned int)data.ConstantBuffers.size();
+	shaderResourceViewCount = (unsigned int)data.Textures.size();
+	samplerCount = (unsigned int)data.Samplers.size();
+
+	// Count everything up first
+	size_t dataBytes = 0;
+	size_t nameBytes = 0;
+	for (const ReflectedConstantBuffer& buffer : data.ConstantBuffers)
+	{
+		dataBytes += AlignOffset(buffer.Size, 16);
+		nameBytes += buffer.Name.size() + 1;
+		variableCount += (unsigned int)buffer.Variables.size();
+		for (const ReflectedVariable& var : buffer.Variables)
+			nameBytes += var.Name.size() + 1;
+	}
+	for (const ReflectedResource& resource : data.Textures)
+		nameBytes += resource.Name.size() + 1;
+	for (const ReflectedResource& resource : data.Samplers)
+		nameBytes += resource.Name.size() + 1;
+
+	unsigned int nameCount = constantBufferCount + variableCount + shaderResourceViewCount + samplerCount;
+	unsigned int slotCount = 4;
+	while (slotCount < nameCount * 2)
+		slotCount *= 2;
+	slotMask = slotCount - 1;
+
+	// Place each array
+	size_t bufferOffset = AlignOffset(dataBytes, alignof(SimpleConstantBuffer));
+	size_t variableOffset = AlignOffset(bufferOffset + sizeof(SimpleConstantBuffer) * constantBufferCount, alignof(SimpleShaderVariable));
+	size_t srvOffset = AlignOffset(variableOffset + sizeof(SimpleShaderVariable) * variableCount, alignof(SimpleSRV));
+	size_t samplerOffset = AlignOffset(srvOffset + sizeof(SimpleSRV) * shaderResourceViewCount, alignof(SimpleSampler));
+	size_t slotOffset = AlignOffset(samplerOffset + sizeof(SimpleSampler) * samplerCount, alignof(NameSlot));
+	size_t nameOffset = slotOffset + sizeof(NameSlot) * slotCount;
+	size = nameOffset + nameBytes;
+
+	// new[] is aligned enough for the local data (16 bytes on x64)
+	memory = new unsigned char[size];
+	ZeroMemory(memory, size);
+	constantBuffers = (SimpleConstantBuffer*)(memory + bufferOffset);
+	variables = (SimpleShaderVariable*)(memory + variableOffset);
+	shaderResourceViews = (SimpleSRV*)(memory + srvOffset);
+	samplers = (SimpleSampler*)(memory + samplerOffset);
+	slots = (NameSlot*)(memory + slotOffset);
+	names = (char*)(memory + nameOffset);
+
+	for (unsigned int i = 0; i < slotCount; i++)
+		slots[i].Index = EmptySlot;
+
+	// Fill it in
+	unsigned int nextName = 0;
+	size_t nextData = 0;
+	unsigned int nextVariable = 0;
+	for (unsigned int b = 0; b < constantBufferCount; b++)
+	{
+		const ReflectedConstantBuffer& buffer = data.ConstantBuffers[b];
+		SimpleConstantBuffer* cb = &constantBuffers[b];
+
+		InsertName(ConstantBufferName, b, buffer.Name, nextName);
+		cb->Name = names + nextName;
+		nextName += (unsigned int)buffer.Name.size() + 1;
+
+		cb->Type = (D3D_CBUFFER_TYPE)buffer.Type;
+		cb->Size = buffer.Size;
+		cb->BindIndex = buffer.BindIndex;
+		cb->ConstantBuffer = 0;
+		cb->LocalDataBuffer = memory + nextData;
+		nextData += AlignOffset(buffer.Size, 16);
+
+		// Nothing is on the GPU yet, so the first copy sends everything
+		cb->Dirty = true;
+		cb->DirtyStart = 0;
+		cb->DirtyEnd = buffer.Size;
+		cb->InRing = false;
+		cb->RingFrame = 0;
+		cb->RingFirstConstant = 0;
+		cb->RingConstantCount = 0;
+
+		// Variables go in offset order, which packoffset can make
+		// differ from the order they were declared in
+		std::vector<unsigned int> order(buffer.Variables.size());
+		for (unsigned int v = 0; v < order.size(); v++)
+			order[v] = v;
+		std::stable_sort(order.begin(), order.end(),
+			[&](unsigned int a, unsigned int c) { return buffer.Variables[a].ByteOffset < buffer.Variables[c].ByteOffset; });
+
+		cb->Variables = variables + nextVariable;
+		cb->VariableCount = (unsigned int)buffer.Variables.size();
+		for (unsigned int v : order)
+		{
+			const ReflectedVariable& var = buffer.Variables[v];
+			InsertName(VariableName, nextVariable, var.Name, nextName);
+			nextName += (unsigned int)var.Name.size() + 1;
+
+			variables[nextVariable].ConstantBufferIndex = b;
+			variables[nextVariable].ByteOffset = var.ByteOffset;
+			variables[nextVariable].Size = var.Size;
+			nextVariable++;
+		}
+	}
+
+	for (unsigned int i = 0; i < shaderResourceViewCount; i++)
+	{
+		InsertName(TextureName, i, data.Textures[i].Name, nextName);
+		nextName += (unsigned int)data.Textures[i].Name.size() + 1;
+
+		shaderResourceViews[i].Index = i;
+		shaderResourceViews[i].BindIndex = data.Textures[i].BindIndex;
+	}
+
+	for (unsigned int i = 0; i < samplerCount; i++)
+	{
+		InsertName(SamplerName, i, data.Samplers[i].Name, nextName);
+		nextName += (unsigned int)data.Samplers[i].Name.size() + 1;
+
+		samplers[i].Index = i;
+		samplers[i].BindIndex = data.Samplers[i].BindIndex;
+	}
+}
+
+// --------------------------------------------------------
+// FNV-1a over the kind and the name
+// --------------------------------------------------------
+unsigned int SimpleShaderMetadata::HashName(unsigned int kind, const char* name, size_t length)
+{
+	unsigned int hash = 2166136261u ^ kind;
+	hash *= 16777619u;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char)name[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// --------------------------------------------------------
+// Copies a name into the name characters and adds it to
+// the hash table.  Later duplicates of a name are ignored,
+// as they would be by a map insert.
+// --------------------------------------------------------
+void SimpleShaderMetadata::InsertName(unsigned int kind, unsigned int index, const std::string& name, unsigned int nameOffset)
+{
+	memcpy(names + nameOffset, name.c_str(), name.size() + 1);
+
+	if (FindName(kind, name) != EmptySlot)
+		return;
+
+	unsigned int hash = HashName(kind, name.c_str(), name.size());
+	unsigned int slot = hash & slotMask;
+	while (slots[slot].Index != EmptySlot)
+		slot = (slot + 1) & slotMask;
+
+	slots[slot].Hash = hash;
+	slots[slot].Kind = kind;
+	slots[slot].Index = index;
+	slots[slot].NameOffset = nameOffset;
+}
+
+// --------------------------------------------------------
+// Looks up a name of the given kind, returning the index
+// into that kind's array or EmptySlot
+// --------------------------------------------------------
+unsigned int SimpleShaderMetadata::FindName(unsigned int kind, const std::string& name)
+{
+	if (!slots)
+		return EmptySlot;
+
+	unsigned int hash = HashName(kind, name.c_str(), name.size());
+	for (unsigned int slot = hash & slotMask; slots[slot].Index != EmptySlot; slot = (slot + 1) & slotMask)
+	{
+		if (slots[slot].Hash == hash && slots[slot].Kind == kind &&
+			strcmp(names + slots[slot].NameOffset, name.c_str()) == 0)
+			return slots[slot].Index;
+	}
+	return EmptySlot;
+}
+
+// --------------------------------------------------------
+// Name lookups for each kind
+// --------------------------------------------------------
+SimpleConstantBuffer* SimpleShaderMetadata::FindConstantBuffer(const std::string& name)
+{
+	unsigned int index = FindName(ConstantBufferName, name);
+	return index == EmptySlot ? 0 : &constantBuffers[index];
+}
+
+SimpleShaderVariable* SimpleShaderMetadata::FindVariable(const std::string& name)
+{
+	unsigned int index = FindName(VariableName, name);
+	return index == EmptySlot ? 0 : &variables[index];
+}
+
+const SimpleSRV* SimpleShaderMetadata::FindShaderResourceView(const std::string& name)
+{
+	unsigned int index = FindName(TextureName, name);
+	return index == EmptySlot ? 0 : &shaderResourceViews[index];
+}
+
+const SimpleSampler* SimpleShaderMetadata::FindSampler(const std::string& name)
+{
+	unsigned int index = FindName(SamplerName, name);
+	return index == EmptySlot ? 0 : &samplers[index];
+}
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // ------ BASE SIMPLE SHADER --------------------------------------------------
@@ -16,7 +295,22 @@ ISimpleShader::ISimpleShader(ID3D11Device* device, ID3D11DeviceContext* context)
 	// Set up fields
 	constantBufferCount = 0;
 	constantBuffers = 0;
+	layoutID = 0;
+	shaderValid = false;
 	shaderBlob = 0;
+
+	constantBufferRing = 0;
+	stateCache = 0;
+
+	// Partial constant buffer updates need Direct3D 11.1 and driver support
+	deviceContext1 = 0;
+	partialBufferUpdates = false;
+	if (SUCCEEDED(context->QueryInterface(&deviceContext1)))
+	{
+		D3D11_FEATURE_DATA_D3D11_OPTIONS options = {};
+		if (SUCCEEDED(device->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))))
+			partialBufferUpdates = options.ConstantBufferPartialUpdate != 0;
+	}
 }
 
 // --------------------------------------------------------
@@ -27,6 +321,8 @@ ISimpleShader::~ISimpleShader()
 	// Derived class destructors will call this class's CleanUp method
 	if(shaderBlob)
 		shaderBlob->Release();
+	if (deviceContext1)
+		deviceContext1->Release();
 }
 
 // --------------------------------------------------------
@@ -35,30 +331,15 @@ ISimpleShader::~ISimpleShader()
 // --------------------------------------------------------
 void ISimpleShader::CleanUp()
 {
-	// Handle constant buffers and local data buffers
+	// Handle constant buffers - their local data is in the metadata
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
 		constantBuffers[i].ConstantBuffer->Release();
-		delete[] constantBuffers[i].LocalDataBuffer;
-	}
-
-	if (constantBuffers)
-	{
-		delete[] constantBuffers;
-		constantBufferCount = 0;
-	}
-
-	for (unsigned int i = 0; i < shaderResourceViews.size(); i++)
-		delete shaderResourceViews[i];
-	
-	for (unsigned int i = 0; i < samplerStates.size(); i++)
-		delete samplerStates[i];
 
-	// Clean up tables
-	varTable.clear();
-	cbTable.clear();
-	samplerTable.clear();
-	textureTable.clear();
+	// Everything else goes in one go
+	metadata.Clear();
+	constantBuffers = 0;
+	constantBufferCount = 0;
+	layoutID = 0;
 }
 
 // --------------------------------------------------------
@@ -79,14 +360,37 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		return false;
 	}
 
+	// Get information about this shader and its variables, buffers, etc.
+	// from the cache if we've seen this bytecode before, or by reflection
+	ShaderReflectionData reflection;
+	const void* bytecode = shaderBlob->GetBufferPointer();
+	size_t bytecodeSize = shaderBlob->GetBufferSize();
+	if (!reflectionCache || !reflectionCache->Find(bytecode, bytecodeSize, reflection))
+	{
+		Reflect(reflection);
+		if (reflectionCache)
+			reflectionCache->Store(bytecode, bytecodeSize, reflection);
+	}
+
 	// Create the shader - Calls an overloaded version of this abstract
 	// method in the appropriate child class
-	shaderValid = CreateShader(shaderBlob);
+	shaderValid = CreateShader(shaderBlob, reflection);
 	if (!shaderValid)
 	{
 		return false;
 	}
 
+	// All set
+	BuildTables(reflection);
+	return true;
+}
+
+// --------------------------------------------------------
+// Uses shader reflection to flatten out the constant buffers,
+// their variables and the bound resources of the loaded shader
+// --------------------------------------------------------
+void ISimpleShader::Reflect(ShaderReflectionData& data)
+{
 	// Set up shader reflection to get information about
 	// this shader and its variables,  buffers, etc.
 	ID3D11ShaderReflection* refl;
@@ -100,10 +404,6 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 	D3D11_SHADER_DESC shaderDesc;
 	refl->GetDesc(&shaderDesc);
 
-	// Get the number of buffers and make the resource array
-	constantBufferCount = shaderDesc.ConstantBuffers;
-	constantBuffers = new SimpleConstantBuffer[constantBufferCount];
-	
 	// Handle bound resources (like shaders and samplers)
 	unsigned int resourceCount = shaderDesc.BoundResources;
 	for (unsigned int r = 0; r < resourceCount; r++)
@@ -113,36 +413,22 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		refl->GetResourceBindingDesc(r, &resourceDesc);
 
 		// Check the type
+		ReflectedResource resource = { resourceDesc.Name, resourceDesc.BindPoint };
 		switch (resourceDesc.Type)
 		{
 		case D3D_SIT_TEXTURE: // A texture resource
-		{
-			// Create the SRV wrapper
-			SimpleSRV* srv = new SimpleSRV();
-			srv->BindIndex = resourceDesc.BindPoint;				// Shader bind point
-			srv->Index = (unsigned int)shaderResourceViews.size();	// Raw index
-
-			textureTable.insert(std::pair<std::string, SimpleSRV*>(resourceDesc.Name, srv));
-			shaderResourceViews.push_back(srv);
-		}
+			data.Textures.push_back(resource);
 			break;
 
 		case D3D_SIT_SAMPLER: // A sampler resource
-		{
-			// Create the sampler wrapper
-			SimpleSampler* samp = new SimpleSampler();
-			samp->BindIndex = resourceDesc.BindPoint;			// Shader bind point
-			samp->Index = (unsigned int)samplerStates.size();	// Raw index
-
-			samplerTable.insert(std::pair<std::string, SimpleSampler*>(resourceDesc.Name, samp));
-			samplerStates.push_back(samp);
-		}
+			data.Samplers.push_back(resource);
 			break;
 		}
 	}
 
 	// Loop through all constant buffers
-	for (unsigned int b = 0; b < constantBufferCount; b++)
+	data.ConstantBuffers.resize(shaderDesc.ConstantBuffers);
+	for (unsigned int b = 0; b < shaderDesc.ConstantBuffers; b++)
 	{
 		// Get this buffer
 		ID3D11ShaderReflectionConstantBuffer* cb =
@@ -151,36 +437,20 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		// Get the description of this buffer
 		D3D11_SHADER_BUFFER_DESC bufferDesc;
 		cb->GetDesc(&bufferDesc);
-		
-		// Save the type, which we reference when setting these buffers
-		constantBuffers[b].Type = bufferDesc.Type;
 
 		// Get the description of the resource binding, so
 		// we know exactly how it's bound in the shader
 		D3D11_SHADER_INPUT_BIND_DESC bindDesc;
 		refl->GetResourceBindingDescByName(bufferDesc.Name, &bindDesc);
-		
-		// Set up the buffer and put its pointer in the table
-		constantBuffers[b].BindIndex = bindDesc.BindPoint;
-		constantBuffers[b].Name = bufferDesc.Name;
-		cbTable.insert(std::pair<std::string, SimpleConstantBuffer*>(bufferDesc.Name, &constantBuffers[b]));
 
-		// Create this constant buffer
-		D3D11_BUFFER_DESC newBuffDesc;
-		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
-		newBuffDesc.ByteWidth = max(bufferDesc.Size, 16); // NEW: Must be multiple of 16
-		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-		newBuffDesc.CPUAccessFlags = 0;
-		newBuffDesc.MiscFlags = 0;
-		newBuffDesc.StructureByteStride = 0;
-		device->CreateBuffer(&newBuffDesc, 0, &constantBuffers[b].ConstantBuffer);
-
-		// Set up the data buffer for this constant buffer
-		constantBuffers[b].Size = bufferDesc.Size;
-		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
-		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
+		ReflectedConstantBuffer& buffer = data.ConstantBuffers[b];
+		buffer.Name = bufferDesc.Name;
+		buffer.Type = bufferDesc.Type;
+		buffer.BindIndex = bindDesc.BindPoint;
+		buffer.Size = bufferDesc.Size;
 
 		// Loop through all variables in this buffer
+		buffer.Variables.resize(bufferDesc.Variables);
 		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
 		{
 			// Get this variable
@@ -191,24 +461,94 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 			D3D11_SHADER_VARIABLE_DESC varDesc;
 			var->GetDesc(&varDesc);
 
-			// Create the variable struct
-			SimpleShaderVariable varStruct;
-			varStruct.ConstantBufferIndex = b;
-			varStruct.ByteOffset = varDesc.StartOffset;
-			varStruct.Size = varDesc.Size;
-			
-			// Get a string version
-			std::string varName(varDesc.Name);
-
-			// Add this variable to the table and the constant buffer
-			varTable.insert(std::pair<std::string, SimpleShaderVariable>(varName, varStruct));
-			constantBuffers[b].Variables.push_back(varStruct);
+			buffer.Variables[v].Name = varDesc.Name;
+			buffer.Variables[v].ByteOffset = varDesc.StartOffset;
+			buffer.Variables[v].Size = varDesc.Size;
 		}
 	}
 
-	// All set
+	// The input signature, which vertex shaders build their input layout from
+	data.InputParameters.resize(shaderDesc.InputParameters);
+	for (unsigned int i = 0; i < shaderDesc.InputParameters; i++)
+	{
+		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
+		refl->GetInputParameterDesc(i, &paramDesc);
+
+		ReflectedInputParameter& input = data.InputParameters[i];
+		input.SemanticName = paramDesc.SemanticName;
+		input.SemanticIndex = paramDesc.SemanticIndex;
+		input.ComponentType = paramDesc.ComponentType;
+		input.Mask = paramDesc.Mask;
+	}
+
 	refl->Release();
-	return true;
+}
+
+// --------------------------------------------------------
+// Creates the constant buffers, resource wrappers and lookup
+// tables from flattened reflection data
+// --------------------------------------------------------
+void ISimpleShader::BuildTables(const ShaderReflectionData& data)
+{
+	// Lay out the buffers, variables, resources and names
+	metadata.Build(data);
+	constantBuffers = metadata.GetConstantBuffers();
+	constantBufferCount = metadata.GetConstantBufferCount();
+	layoutID = HashLayout(data);
+
+	// Create the constant buffers themselves
+	for (unsigned int b = 0; b < constantBufferCount; b++)
+	{
+		D3D11_BUFFER_DESC newBuffDesc;
+		newBuffDesc.Usage = D3D11_USAGE_DEFAULT;
+		newBuffDesc.ByteWidth = max(constantBuffers[b].Size, 16); // NEW: Must be multiple of 16
+		newBuffDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+		newBuffDesc.CPUAccessFlags = 0;
+		newBuffDesc.MiscFlags = 0;
+		newBuffDesc.StructureByteStride = 0;
+		device->CreateBuffer(&newBuffDesc, 0, &constantBuffers[b].ConstantBuffer);
+	}
+}
+
+// --------------------------------------------------------
+// Hashes the names, sizes and offsets of every constant buffer
+// and variable, so shaders with the same layout get the same ID
+// --------------------------------------------------------
+unsigned int ISimpleShader::HashLayout(const ShaderReflectionData& data)
+{
+	std::vector<unsigned char> bytes;
+	auto append = [&](const void* value, size_t size)
+	{
+		bytes.insert(bytes.end(), (const unsigned char*)value, (const unsigned char*)value + size);
+	};
+
+	for (size_t b = 0; b < data.ConstantBuffers.size(); b++)
+	{
+		const ReflectedConstantBuffer& buffer = data.ConstantBuffers[b];
+		append(buffer.Name.c_str(), buffer.Name.size() + 1);
+		append(&buffer.Size, sizeof(buffer.Size));
+		for (size_t v = 0; v < buffer.Variables.size(); v++)
+		{
+			const ReflectedVariable& var = buffer.Variables[v];
+			append(var.Name.c_str(), var.Name.size() + 1);
+			append(&var.ByteOffset, sizeof(var.ByteOffset));
+			append(&var.Size, sizeof(var.Size));
+		}
+	}
+
+	// Fold to 32 bits, keeping 0 for "no layout"
+	uint64_t hash = ShaderReflectionCache::Hash(bytes.data(), bytes.size());
+	unsigned int id = (unsigned int)(hash ^ (hash >> 32));
+	return id != 0 ? id : 1;
+}
+
+// --------------------------------------------------------
+// Sets the cache that every shader loaded afterwards uses in
+// place of reflection.  The cache is not owned by the shaders.
+// --------------------------------------------------------
+void ISimpleShader::SetReflectionCache(ShaderReflectionCache* cache)
+{
+	reflectionCache = cache;
 }
 
 // --------------------------------------------------------
@@ -218,19 +558,13 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 // name - the name of the variable to look for
 // size - the size of the variable (for verification), or -1 to bypass
 // --------------------------------------------------------
-SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
+SimpleShaderVariable* ISimpleShader::FindVariable(const std::string& name, int size)
 {
 	// Look for the key
-	std::unordered_map<std::string, SimpleShaderVariable>::iterator result =
-		varTable.find(name);
-
-	// Did we find the key?
-	if (result == varTable.end())
+	SimpleShaderVariable* var = metadata.FindVariable(name);
+	if (var == 0)
 		return 0;
 
-	// Grab the result from the iterator
-	SimpleShaderVariable* var = &(result->second);
-
 	// Is the data size correct ?
 	if (size > 0 && var->Size != size)
 		return 0;
@@ -244,16 +578,7 @@ SimpleShaderVariable* ISimpleShader::FindVariable(std::string name, int size)
 // --------------------------------------------------------
 SimpleConstantBuffer* ISimpleShader::FindConstantBuffer(std::string name)
 {
-	// Look for the key
-	std::unordered_map<std::string, SimpleConstantBuffer*>::iterator result =
-		cbTable.find(name);
-
-	// Did we find the key?
-	if (result == cbTable.end())
-		return 0;
-
-	// Success
-	return result->second;
+	return metadata.FindConstantBuffer(name);
 }
 
 // --------------------------------------------------------
@@ -279,14 +604,9 @@ void ISimpleShader::CopyAllBufferData()
 	// Ensure the shader is valid
 	if (!shaderValid) return;
 
-	// Loop through the constant buffers and copy all data
+	// Loop through the constant buffers and copy any changed data
 	for (unsigned int i = 0; i < constantBufferCount; i++)
-	{
-		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer, 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
-	}
+		UploadBuffer(&constantBuffers[i]);
 }
 
 // --------------------------------------------------------
@@ -314,9 +634,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadBuffer(cb);
 }
 
 // --------------------------------------------------------
@@ -336,117 +654,441 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadBuffer(cb);
+}
+
+
+// --------------------------------------------------------
+// Copies the changed part of a constant buffer's local
+// data to the GPU, or nothing if it hasn't changed since
+// the last copy
+// --------------------------------------------------------
+void ISimpleShader::UploadBuffer(SimpleConstantBuffer* cb)
+{
+	if (constantBufferRing && constantBufferRing->IsEnabled() && cb->Type == D3D11_CT_CBUFFER)
+	{
+		// Data already in this frame's part of the ring is still good
+		if (!cb->Dirty && IsInRing(cb))
+		{
+			frameStats.BuffersSkipped++;
+			return;
+		}
+
+		// Append the whole buffer - it's a fresh copy, so there's no partial update
+		if (constantBufferRing->Upload(cb->LocalDataBuffer, cb->Size, &cb->RingFirstConstant, &cb->RingConstantCount))
+		{
+			cb->InRing = true;
+			cb->RingFrame = constantBufferRing->GetFrameIndex();
+			cb->Dirty = false;
+			frameStats.BuffersUploaded++;
+			frameStats.BytesUploaded += cb->Size;
+			return;
+		}
+
+		// The ring is full, so fall back to this shader's own buffer,
+		// which has missed every change that went to the ring
+		if (cb->InRing)
+		{
+			cb->InRing = false;
+			cb->Dirty = true;
+			cb->DirtyStart = 0;
+			cb->DirtyEnd = cb->Size;
+		}
+	}
+
+	if (!cb->Dirty)
+	{
+		frameStats.BuffersSkipped++;
+		return;
+	}
+
+	// Partial copies must cover whole 16 byte constants
+	unsigned int start = cb->DirtyStart & ~15u;
+	unsigned int end = min((cb->DirtyEnd + 15) & ~15u, cb->Size);
+
+	if (partialBufferUpdates && (start > 0 || end < cb->Size))
+	{
+		D3D11_BOX box = {};
+		box.left = start;
+		box.right = end;
+		box.top = 0;
+		box.bottom = 1;
+		box.front = 0;
+		box.back = 1;
+		deviceContext1->UpdateSubresource1(
+			cb->ConstantBuffer, 0, &box,
+			cb->LocalDataBuffer + start, 0, 0, 0);
+	}
+	else
+	{
+		// Copy the entire local data buffer
+		deviceContext->UpdateSubresource(
+			cb->ConstantBuffer, 0, 0,
+			cb->LocalDataBuffer, 0, 0);
+		start = 0;
+		end = cb->Size;
+	}
+
+	frameStats.BuffersUploaded++;
+	frameStats.BytesUploaded += end - start;
+	cb->Dirty = false;
+}
+
+// --------------------------------------------------------
+// Whether a constant buffer's latest data went into the
+// ring during this frame
+// --------------------------------------------------------
+bool ISimpleShader::IsInRing(SimpleConstantBuffer* cb)
+{
+	return cb->InRing && constantBufferRing && cb->RingFrame == constantBufferRing->GetFrameIndex();
+}
+
+// --------------------------------------------------------
+// Sets the ring that constant buffers are copied into, or
+// null to go back to this shader's own buffers
+// --------------------------------------------------------
+void ISimpleShader::SetConstantBufferRing(ConstantBufferRing* ring)
+{
+	constantBufferRing = ring;
+
+	// Whatever is in the shader's own buffers may be out of date
+	for (unsigned int i = 0; i < constantBufferCount; i++)
+	{
+		constantBuffers[i].InRing = false;
+		constantBuffers[i].Dirty = true;
+		constantBuffers[i].DirtyStart = 0;
+		constantBuffers[i].DirtyEnd = constantBuffers[i].Size;
+	}
+}
+
+// --------------------------------------------------------
+// Sets the state cache that bindings go through, or null
+// to bind straight on the context
+// --------------------------------------------------------
+void ISimpleShader::SetStateCache(DeviceStateCache* cache)
+{
+	stateCache = cache;
+}
+
+// --------------------------------------------------------
+// Binds a constant buffer (or its slice of the ring)
+// through the state cache
+// --------------------------------------------------------
+bool ISimpleShader::BindConstantBufferThroughCache(ShaderStage stage, SimpleConstantBuffer* cb)
+{
+	if (!stateCache)
+		return false;
+
+	if (IsInRing(cb))
+		stateCache->SetConstantBuffer(stage, cb->BindIndex, constantBufferRing->GetBuffer(), cb->RingFirstConstant, cb->RingConstantCount);
+	else
+		stateCache->SetConstantBuffer(stage, cb->BindIndex, cb->ConstantBuffer);
+	return true;
+}
+
+// --------------------------------------------------------
+// Gets the constant buffer counters, summed over every
+// shader since the last ResetFrameStats()
+// --------------------------------------------------------
+const SimpleShaderFrameStats& ISimpleShader::GetFrameStats()
+{
+	return frameStats;
+}
+
+// --------------------------------------------------------
+// Zeroes the constant buffer counters, e.g. at the start
+// of each frame
+// --------------------------------------------------------
+void ISimpleShader::ResetFrameStats()
+{
+	frameStats = {};
 }
 
+// --------------------------------------------------------
+// Sets a variable by name with arbitrary data of the specified size
+//
+// name - The name of the shader variable
+// data - The data to set in the buffer
+// size - The size of the data (this must match the variable's size)
+//
+// Returns true if data is copied, false if variable doesn't 
+// exist or sizes don't match
+// --------------------------------------------------------
+bool ISimpleShader::SetData(const std::string& name, const void* data, unsigned int size)
+{
+	// Look for the variable and verify
+	SimpleShaderVariable* var = FindVariable(name, size);
+	if (var == 0)
+		return false;
+
+	// Set it the same way a handle would
+	ParamHandle param = { var->ConstantBufferIndex, var->ByteOffset, var->Size, layoutID };
+	return SetData(param, data, size);
+}
+
+// --------------------------------------------------------
+// Sets INTEGER data
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(const std::string& name, int data)
+{
+	return this->SetData(name, (void*)(&data), sizeof(int));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat(const std::string& name, float data)
+{
+	return this->SetData(name, (void*)(&data), sizeof(float));
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT2 variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat2(const std::string& name, const float data[2])
+{
+	return this->SetData(name, (void*)data, sizeof(float) * 2);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT2 variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat2(const std::string& name, const DirectX::XMFLOAT2 data)
+{
+	return this->SetData(name, &data, sizeof(float) * 2);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT3 variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat3(const std::string& name, const float data[3])
+{
+	return this->SetData(name, (void*)data, sizeof(float) * 3);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT3 variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat3(const std::string& name, const DirectX::XMFLOAT3 data)
+{
+	return this->SetData(name, &data, sizeof(float) * 3);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT4 variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat4(const std::string& name, const float data[4])
+{
+	return this->SetData(name, (void*)data, sizeof(float) * 4);
+}
+
+// --------------------------------------------------------
+// Sets a FLOAT4 variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetFloat4(const std::string& name, const DirectX::XMFLOAT4 data)
+{
+	return this->SetData(name, &data, sizeof(float) * 4);
+}
+
+// --------------------------------------------------------
+// Sets a MATRIX (4x4) variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetMatrix4x4(const std::string& name, const float data[16])
+{
+	return this->SetData(name, (void*)data, sizeof(float) * 16);
+}
+
+// --------------------------------------------------------
+// Sets a MATRIX (4x4) variable by name in the local data buffer
+// --------------------------------------------------------
+bool ISimpleShader::SetMatrix4x4(const std::string& name, const DirectX::XMFLOAT4X4 data)
+{
+	return this->SetData(name, &data, sizeof(float) * 16);
+}
+
+// --------------------------------------------------------
+// Looks up a variable by name, so it can be set later
+// without any string copies or hashing
+//
+// name - The name of the shader variable
+//
+// Returns a handle, which is not IsValid() if the variable
+// doesn't exist
+// --------------------------------------------------------
+ParamHandle ISimpleShader::GetParam(const std::string& name)
+{
+	ParamHandle param = { 0, 0, 0, 0 };
+
+	SimpleShaderVariable* var = FindVariable(name, -1);
+	if (var == 0)
+		return param;
+
+	param.ConstantBufferIndex = var->ConstantBufferIndex;
+	param.ByteOffset = var->ByteOffset;
+	param.Size = var->Size;
+	param.LayoutID = layoutID;
+	return param;
+}
 
 // --------------------------------------------------------
-// Sets a variable by name with arbitrary data of the specified size
+// Sets a variable through a handle with arbitrary data
+// of the specified size
 //
-// name - The name of the shader variable
+// param - A handle from GetParam()
 // data - The data to set in the buffer
 // size - The size of the data (this must match the variable's size)
 //
-// Returns true if data is copied, false if variable doesn't 
-// exist or sizes don't match
+// Returns true if data is copied, false if the handle isn't
+// valid, came from a shader with a different layout, or
+// sizes don't match
 // --------------------------------------------------------
-bool ISimpleShader::SetData(std::string name, const void* data, unsigned int size)
+bool ISimpleShader::SetData(ParamHandle param, const void* data, unsigned int size)
 {
-	// Look for the variable and verify
-	SimpleShaderVariable* var = FindVariable(name, size);
-	if (var == 0)
+	// Verify the handle
+	if (!param.IsValid() || param.Size != size || param.LayoutID != layoutID || param.ConstantBufferIndex >= constantBufferCount)
+		return false;
+
+	// Never write outside the buffer, whatever the handle says
+	SimpleConstantBuffer* cb = &constantBuffers[param.ConstantBufferIndex];
+	if (param.ByteOffset > cb->Size || size > cb->Size - param.ByteOffset)
 		return false;
 
+	// Nothing to do if the bytes are already there
+	unsigned char* dest = cb->LocalDataBuffer + param.ByteOffset;
+	if (memcmp(dest, data, size) == 0)
+	{
+		frameStats.WritesSkipped++;
+		return true;
+	}
+
 	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	memcpy(dest, data, size);
+
+	// Grow the range the next copy has to send
+	if (cb->Dirty)
+	{
+		cb->DirtyStart = min(cb->DirtyStart, param.ByteOffset);
+		cb->DirtyEnd = max(cb->DirtyEnd, param.ByteOffset + size);
+	}
+	else
+	{
+		cb->Dirty = true;
+		cb->DirtyStart = param.ByteOffset;
+		cb->DirtyEnd = param.ByteOffset + size;
+	}
 
 	// Success
 	return true;
 }
 
 // --------------------------------------------------------
-// Sets INTEGER data
+// Sets INTEGER data through a handle
 // --------------------------------------------------------
-bool ISimpleShader::SetInt(std::string name, int data)
+bool ISimpleShader::SetInt(ParamHandle param, int data)
 {
-	return this->SetData(name, (void*)(&data), sizeof(int));
+	return this->SetData(param, &data, sizeof(int));
 }
 
 // --------------------------------------------------------
-// Sets a FLOAT variable by name in the local data buffer
+// Sets a FLOAT variable through a handle
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat(std::string name, float data)
+bool ISimpleShader::SetFloat(ParamHandle param, float data)
 {
-	return this->SetData(name, (void*)(&data), sizeof(float));
+	return this->SetData(param, &data, sizeof(float));
 }
 
 // --------------------------------------------------------
-// Sets a FLOAT2 variable by name in the local data buffer
+// Sets a FLOAT2 variable through a handle
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const float data[2])
+bool ISimpleShader::SetFloat2(ParamHandle param, const DirectX::XMFLOAT2& data)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 2);
+	return this->SetData(param, &data, sizeof(float) * 2);
 }
 
 // --------------------------------------------------------
-// Sets a FLOAT2 variable by name in the local data buffer
+// Sets a FLOAT3 variable through a handle
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat2(std::string name, const DirectX::XMFLOAT2 data)
+bool ISimpleShader::SetFloat3(ParamHandle param, const DirectX::XMFLOAT3& data)
 {
-	return this->SetData(name, &data, sizeof(float) * 2);
+	return this->SetData(param, &data, sizeof(float) * 3);
 }
 
 // --------------------------------------------------------
-// Sets a FLOAT3 variable by name in the local data buffer
+// Sets a FLOAT4 variable through a handle
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const float data[3])
+bool ISimpleShader::SetFloat4(ParamHandle param, const DirectX::XMFLOAT4& data)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 3);
+	return this->SetData(param, &data, sizeof(float) * 4);
 }
 
 // --------------------------------------------------------
-// Sets a FLOAT3 variable by name in the local data buffer
+// Sets a MATRIX (4x4) variable through a handle
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat3(std::string name, const DirectX::XMFLOAT3 data)
+bool ISimpleShader::SetMatrix4x4(ParamHandle param, const DirectX::XMFLOAT4X4& data)
 {
-	return this->SetData(name, &data, sizeof(float) * 3);
+	return this->SetData(param, &data, sizeof(float) * 16);
 }
 
 // --------------------------------------------------------
-// Sets a FLOAT4 variable by name in the local data buffer
+// Sets an entire constant buffer by name
+//
+// bufferName - The name of the constant buffer
+// data - The whole buffer's data, usually a ShaderConstants struct
+// size - The size of the data (this must match the buffer's size)
+//
+// Returns true if data is copied, false if the buffer doesn't
+// exist or sizes don't match
 // --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const float data[4])
+bool ISimpleShader::SetBufferData(const std::string& bufferName, const void* data, unsigned int size)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 4);
-}
+	SimpleConstantBuffer* cb = FindConstantBuffer(bufferName);
+	if (!cb)
+		return false;
 
-// --------------------------------------------------------
-// Sets a FLOAT4 variable by name in the local data buffer
-// --------------------------------------------------------
-bool ISimpleShader::SetFloat4(std::string name, const DirectX::XMFLOAT4 data)
-{
-	return this->SetData(name, &data, sizeof(float) * 4);
+	return SetBufferData((unsigned int)(cb - constantBuffers), data, size);
 }
 
 // --------------------------------------------------------
-// Sets a MATRIX (4x4) variable by name in the local data buffer
+// Sets an entire constant buffer by index, with one copy
+// of just the bytes that changed
 // --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const float data[16])
+bool ISimpleShader::SetBufferData(unsigned int index, const void* data, unsigned int size)
 {
-	return this->SetData(name, (void*)data, sizeof(float) * 16);
-}
+	if (index >= constantBufferCount || constantBuffers[index].Size != size)
+		return false;
 
-// --------------------------------------------------------
-// Sets a MATRIX (4x4) variable by name in the local data buffer
-// --------------------------------------------------------
-bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data)
-{
-	return this->SetData(name, &data, sizeof(float) * 16);
+	SimpleConstantBuffer* cb = &constantBuffers[index];
+	const unsigned char* source = (const unsigned char*)data;
+
+	// Find the range that differs, so partial updates stay partial
+	unsigned int start = 0;
+	while (start < size && source[start] == cb->LocalDataBuffer[start])
+		start++;
+
+	if (start == size)
+	{
+		frameStats.WritesSkipped++;
+		return true;
+	}
+
+	unsigned int end = size;
+	while (source[end - 1] == cb->LocalDataBuffer[end - 1])
+		end--;
+
+	memcpy(cb->LocalDataBuffer + start, source + start, end - start);
+
+	if (cb->Dirty)
+	{
+		cb->DirtyStart = min(cb->DirtyStart, start);
+		cb->DirtyEnd = max(cb->DirtyEnd, end);
+	}
+	else
+	{
+		cb->Dirty = true;
+		cb->DirtyStart = start;
+		cb->DirtyEnd = end;
+	}
+	return true;
 }
 
 // --------------------------------------------------------
@@ -464,16 +1106,7 @@ const SimpleShaderVariable* ISimpleShader::GetVariableInfo(std::string name)
 // --------------------------------------------------------
 const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(std::string name)
 {
-	// Look for the key
-	std::unordered_map<std::string, SimpleSRV*>::iterator result =
-		textureTable.find(name);
-
-	// Did we find the key?
-	if (result == textureTable.end())
-		return 0;
-
-	// Success
-	return result->second;
+	return metadata.FindShaderResourceView(name);
 }
 
 
@@ -485,10 +1118,10 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(std::string name)
 const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 {
 	// Valid index?
-	if (index >= shaderResourceViews.size()) return 0;
+	if (index >= metadata.GetShaderResourceViewCount()) return 0;
 
 	// Grab the bind index
-	return shaderResourceViews[index];
+	return &metadata.GetShaderResourceViews()[index];
 }
 
 
@@ -499,16 +1132,7 @@ const SimpleSRV* ISimpleShader::GetShaderResourceViewInfo(unsigned int index)
 // --------------------------------------------------------
 const SimpleSampler* ISimpleShader::GetSamplerInfo(std::string name)
 {
-	// Look for the key
-	std::unordered_map<std::string, SimpleSampler*>::iterator result =
-		samplerTable.find(name);
-
-	// Did we find the key?
-	if (result == samplerTable.end())
-		return 0;
-
-	// Success
-	return result->second;
+	return metadata.FindSampler(name);
 }
 
 // --------------------------------------------------------
@@ -519,10 +1143,10 @@ const SimpleSampler* ISimpleShader::GetSamplerInfo(std::string name)
 const SimpleSampler* ISimpleShader::GetSamplerInfo(unsigned int index)
 {
 	// Valid index?
-	if (index >= samplerStates.size()) return 0;
+	if (index >= metadata.GetSamplerCount()) return 0;
 
 	// Grab the bind index
-	return samplerStates[index];
+	return &metadata.GetSamplers()[index];
 }
 
 
@@ -629,10 +1253,11 @@ void SimpleVertexShader::CleanUp()
 // Creates the DirectX vertex shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What the shader uses, cached or freshly reflected
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -655,40 +1280,26 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 		return true;
 
 	// Vertex shader was created successfully, so we now use the
-	// shader code to re-reflect and create an input layout that 
+	// reflected input signature to create an input layout that
 	// matches what the vertex shader expects.  Code adapted from:
 	// https://takinginitiative.wordpress.com/2011/12/11/directx-1011-basic-shader-reflection-automatic-input-layout-creation/
 
-	// Reflect shader info
-	ID3D11ShaderReflection* refl;
-	D3DReflect(
-		shaderBlob->GetBufferPointer(),
-		shaderBlob->GetBufferSize(),
-		IID_ID3D11ShaderReflection,
-		(void**)&refl);
-	
-	// Get shader info
-	D3D11_SHADER_DESC shaderDesc;
-	refl->GetDesc(&shaderDesc);
-
-	// Read input layout description from shader info
+	// Read input layout description from the input signature
 	std::vector<D3D11_INPUT_ELEMENT_DESC> inputLayoutDesc;
-	for (unsigned int i = 0; i< shaderDesc.InputParameters; i++)
+	for (const ReflectedInputParameter& paramDesc : reflection.InputParameters)
 	{
-		D3D11_SIGNATURE_PARAMETER_DESC paramDesc;
-		refl->GetInputParameterDesc(i, &paramDesc);
-
 		// Check the semantic name for "_PER_INSTANCE"
 		std::string perInstanceStr = "_PER_INSTANCE";
-		std::string sem = paramDesc.SemanticName;
+		const std::string& sem = paramDesc.SemanticName;
 		int lenDiff = (int)sem.size() - (int)perInstanceStr.size();
 		bool isPerInstance = 
 			lenDiff >= 0 &&
 			sem.compare(lenDiff, perInstanceStr.size(), perInstanceStr) == 0;
 
-		// Fill out input element desc
+		// Fill out input element desc - the name stays alive in
+		// reflection until the layout has been created
 		D3D11_INPUT_ELEMENT_DESC elementDesc;
-		elementDesc.SemanticName = paramDesc.SemanticName;
+		elementDesc.SemanticName = sem.c_str();
 		elementDesc.SemanticIndex = paramDesc.SemanticIndex;
 		elementDesc.InputSlot = 0;
 		elementDesc.AlignedByteOffset = D3D11_APPEND_ALIGNED_ELEMENT;
@@ -737,14 +1348,13 @@ bool SimpleVertexShader::CreateShader(ID3DBlob* shaderBlob)
 
 	// Try to create Input Layout
 	HRESULT hr = device->CreateInputLayout(
-		&inputLayoutDesc[0], 
+		inputLayoutDesc.data(), 
 		(unsigned int)inputLayoutDesc.size(), 
 		shaderBlob->GetBufferPointer(), 
 		shaderBlob->GetBufferSize(),
 		&inputLayout);
 
-	// All done, clean up
-	refl->Release();
+	// All done
 	return true;
 }
 
@@ -758,8 +1368,16 @@ void SimpleVertexShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader and input layout
-	deviceContext->IASetInputLayout(inputLayout);
-	deviceContext->VSSetShader(shader, 0, 0);
+	if (stateCache)
+	{
+		stateCache->SetInputLayout(inputLayout);
+		stateCache->SetVertexShader(shader);
+	}
+	else
+	{
+		deviceContext->IASetInputLayout(inputLayout);
+		deviceContext->VSSetShader(shader, 0, 0);
+	}
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -768,11 +1386,29 @@ void SimpleVertexShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->VSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
+		// Let the state cache drop it if it's already bound
+		if (BindConstantBufferThroughCache(ShaderStage::Vertex, &constantBuffers[i]))
+			continue;
+
+		// This is a real constant buffer, so set it - from
+		// its slice of the ring if that's where its data went
+		if (IsInRing(&constantBuffers[i]))
+		{
+			ID3D11Buffer* ringBuffer = constantBufferRing->GetBuffer();
+			constantBufferRing->GetContext()->VSSetConstantBuffers1(
+				constantBuffers[i].BindIndex,
+				1,
+				&ringBuffer,
+				&constantBuffers[i].RingFirstConstant,
+				&constantBuffers[i].RingConstantCount);
+		}
+		else
+		{
+			deviceContext->VSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				&constantBuffers[i].ConstantBuffer);
+		}
 	}
 }
 
@@ -786,13 +1422,28 @@ void SimpleVertexShader::SetShaderAndCBs()
 // --------------------------------------------------------
 bool SimpleVertexShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	// Look for the variable and set it through its info
+	return SetShaderResourceView(GetShaderResourceViewInfo(name), srv);
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the vertex shader stage
+//
+// srvInfo - Info from GetShaderResourceViewInfo(), looked up ahead of time
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if srvInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleVertexShader::SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv)
+{
 	if (srvInfo == 0)
 		return false;
 
 	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->SetShaderResource(ShaderStage::Vertex, srvInfo->BindIndex, srv);
+	else
+		deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -808,13 +1459,28 @@ bool SimpleVertexShader::SetShaderResourceView(std::string name, ID3D11ShaderRes
 // --------------------------------------------------------
 bool SimpleVertexShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	// Look for the variable and set it through its info
+	return SetSamplerState(GetSamplerInfo(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the vertex shader stage
+//
+// sampInfo - Info from GetSamplerInfo(), looked up ahead of time
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if sampInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleVertexShader::SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState)
+{
 	if (sampInfo == 0)
 		return false;
 
-	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (stateCache)
+		stateCache->SetSampler(ShaderStage::Vertex, sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -855,10 +1521,11 @@ void SimplePixelShader::CleanUp()
 // Creates the DirectX pixel shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What the shader uses, cached or freshly reflected
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimplePixelShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -885,7 +1552,10 @@ void SimplePixelShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 	
 	// Set the shader
-	deviceContext->PSSetShader(shader, 0, 0);
+	if (stateCache)
+		stateCache->SetPixelShader(shader);
+	else
+		deviceContext->PSSetShader(shader, 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -894,11 +1564,29 @@ void SimplePixelShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->PSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
+		// Let the state cache drop it if it's already bound
+		if (BindConstantBufferThroughCache(ShaderStage::Pixel, &constantBuffers[i]))
+			continue;
+
+		// This is a real constant buffer, so set it - from
+		// its slice of the ring if that's where its data went
+		if (IsInRing(&constantBuffers[i]))
+		{
+			ID3D11Buffer* ringBuffer = constantBufferRing->GetBuffer();
+			constantBufferRing->GetContext()->PSSetConstantBuffers1(
+				constantBuffers[i].BindIndex,
+				1,
+				&ringBuffer,
+				&constantBuffers[i].RingFirstConstant,
+				&constantBuffers[i].RingConstantCount);
+		}
+		else
+		{
+			deviceContext->PSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				&constantBuffers[i].ConstantBuffer);
+		}
 	}
 }
 
@@ -912,13 +1600,28 @@ void SimplePixelShader::SetShaderAndCBs()
 // --------------------------------------------------------
 bool SimplePixelShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	// Look for the variable and set it through its info
+	return SetShaderResourceView(GetShaderResourceViewInfo(name), srv);
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the pixel shader stage
+//
+// srvInfo - Info from GetShaderResourceViewInfo(), looked up ahead of time
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if srvInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimplePixelShader::SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv)
+{
 	if (srvInfo == 0)
 		return false;
 
 	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->SetShaderResource(ShaderStage::Pixel, srvInfo->BindIndex, srv);
+	else
+		deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -934,13 +1637,28 @@ bool SimplePixelShader::SetShaderResourceView(std::string name, ID3D11ShaderReso
 // --------------------------------------------------------
 bool SimplePixelShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	// Look for the variable and set it through its info
+	return SetSamplerState(GetSamplerInfo(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the pixel shader stage
+//
+// sampInfo - Info from GetSamplerInfo(), looked up ahead of time
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if sampInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimplePixelShader::SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState)
+{
 	if (sampInfo == 0)
 		return false;
 
-	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (stateCache)
+		stateCache->SetSampler(ShaderStage::Pixel, sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -983,10 +1701,11 @@ void SimpleDomainShader::CleanUp()
 // Creates the DirectX domain shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What the shader uses, cached or freshly reflected
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleDomainShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleDomainShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -1013,7 +1732,10 @@ void SimpleDomainShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->DSSetShader(shader, 0, 0);
+	if (stateCache)
+		stateCache->SetDomainShader(shader);
+	else
+		deviceContext->DSSetShader(shader, 0, 0);
 
 	// Set the constant buffers
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1022,11 +1744,29 @@ void SimpleDomainShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->DSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
+		// Let the state cache drop it if it's already bound
+		if (BindConstantBufferThroughCache(ShaderStage::Domain, &constantBuffers[i]))
+			continue;
+
+		// This is a real constant buffer, so set it - from
+		// its slice of the ring if that's where its data went
+		if (IsInRing(&constantBuffers[i]))
+		{
+			ID3D11Buffer* ringBuffer = constantBufferRing->GetBuffer();
+			constantBufferRing->GetContext()->DSSetConstantBuffers1(
+				constantBuffers[i].BindIndex,
+				1,
+				&ringBuffer,
+				&constantBuffers[i].RingFirstConstant,
+				&constantBuffers[i].RingConstantCount);
+		}
+		else
+		{
+			deviceContext->DSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				&constantBuffers[i].ConstantBuffer);
+		}
 	}
 }
 
@@ -1040,13 +1780,28 @@ void SimpleDomainShader::SetShaderAndCBs()
 // --------------------------------------------------------
 bool SimpleDomainShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	// Look for the variable and set it through its info
+	return SetShaderResourceView(GetShaderResourceViewInfo(name), srv);
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the domain shader stage
+//
+// srvInfo - Info from GetShaderResourceViewInfo(), looked up ahead of time
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if srvInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleDomainShader::SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv)
+{
 	if (srvInfo == 0)
 		return false;
 
 	// Set the shader resource view
-	deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->SetShaderResource(ShaderStage::Domain, srvInfo->BindIndex, srv);
+	else
+		deviceContext->DSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -1062,13 +1817,28 @@ bool SimpleDomainShader::SetShaderResourceView(std::string name, ID3D11ShaderRes
 // --------------------------------------------------------
 bool SimpleDomainShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	// Look for the variable and set it through its info
+	return SetSamplerState(GetSamplerInfo(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the domain shader stage
+//
+// sampInfo - Info from GetSamplerInfo(), looked up ahead of time
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if sampInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleDomainShader::SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState)
+{
 	if (sampInfo == 0)
 		return false;
 
-	// Set the shader resource view
-	deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (stateCache)
+		stateCache->SetSampler(ShaderStage::Domain, sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->DSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -1110,10 +1880,11 @@ void SimpleHullShader::CleanUp()
 // Creates the DirectX hull shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What the shader uses, cached or freshly reflected
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleHullShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleHullShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -1140,7 +1911,10 @@ void SimpleHullShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->HSSetShader(shader, 0, 0);
+	if (stateCache)
+		stateCache->SetHullShader(shader);
+	else
+		deviceContext->HSSetShader(shader, 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1149,11 +1923,29 @@ void SimpleHullShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->HSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
+		// Let the state cache drop it if it's already bound
+		if (BindConstantBufferThroughCache(ShaderStage::Hull, &constantBuffers[i]))
+			continue;
+
+		// This is a real constant buffer, so set it - from
+		// its slice of the ring if that's where its data went
+		if (IsInRing(&constantBuffers[i]))
+		{
+			ID3D11Buffer* ringBuffer = constantBufferRing->GetBuffer();
+			constantBufferRing->GetContext()->HSSetConstantBuffers1(
+				constantBuffers[i].BindIndex,
+				1,
+				&ringBuffer,
+				&constantBuffers[i].RingFirstConstant,
+				&constantBuffers[i].RingConstantCount);
+		}
+		else
+		{
+			deviceContext->HSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				&constantBuffers[i].ConstantBuffer);
+		}
 	}
 }
 
@@ -1167,13 +1959,28 @@ void SimpleHullShader::SetShaderAndCBs()
 // --------------------------------------------------------
 bool SimpleHullShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	// Look for the variable and set it through its info
+	return SetShaderResourceView(GetShaderResourceViewInfo(name), srv);
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the hull shader stage
+//
+// srvInfo - Info from GetShaderResourceViewInfo(), looked up ahead of time
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if srvInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleHullShader::SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv)
+{
 	if (srvInfo == 0)
 		return false;
 
 	// Set the shader resource view
-	deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->SetShaderResource(ShaderStage::Hull, srvInfo->BindIndex, srv);
+	else
+		deviceContext->HSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -1189,13 +1996,28 @@ bool SimpleHullShader::SetShaderResourceView(std::string name, ID3D11ShaderResou
 // --------------------------------------------------------
 bool SimpleHullShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	// Look for the variable and set it through its info
+	return SetSamplerState(GetSamplerInfo(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the hull shader stage
+//
+// sampInfo - Info from GetSamplerInfo(), looked up ahead of time
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if sampInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleHullShader::SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState)
+{
 	if (sampInfo == 0)
 		return false;
 
-	// Set the shader resource view
-	deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (stateCache)
+		stateCache->SetSampler(ShaderStage::Hull, sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->HSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -1240,10 +2062,11 @@ void SimpleGeometryShader::CleanUp()
 // Creates the DirectX Geometry shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What the shader uses, cached or freshly reflected
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -1269,6 +2092,7 @@ bool SimpleGeometryShader::CreateShader(ID3DBlob* shaderBlob)
 // stream output, if possible.
 //
 // shaderBlob - The shader's compiled code
+// reflection - What the shader uses, cached or freshly reflected
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
@@ -1389,7 +2213,10 @@ void SimpleGeometryShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->GSSetShader(shader, 0, 0);
+	if (stateCache)
+		stateCache->SetGeometryShader(shader);
+	else
+		deviceContext->GSSetShader(shader, 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1398,11 +2225,29 @@ void SimpleGeometryShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->GSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
+		// Let the state cache drop it if it's already bound
+		if (BindConstantBufferThroughCache(ShaderStage::Geometry, &constantBuffers[i]))
+			continue;
+
+		// This is a real constant buffer, so set it - from
+		// its slice of the ring if that's where its data went
+		if (IsInRing(&constantBuffers[i]))
+		{
+			ID3D11Buffer* ringBuffer = constantBufferRing->GetBuffer();
+			constantBufferRing->GetContext()->GSSetConstantBuffers1(
+				constantBuffers[i].BindIndex,
+				1,
+				&ringBuffer,
+				&constantBuffers[i].RingFirstConstant,
+				&constantBuffers[i].RingConstantCount);
+		}
+		else
+		{
+			deviceContext->GSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				&constantBuffers[i].ConstantBuffer);
+		}
 	}
 }
 
@@ -1416,13 +2261,28 @@ void SimpleGeometryShader::SetShaderAndCBs()
 // --------------------------------------------------------
 bool SimpleGeometryShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	// Look for the variable and set it through its info
+	return SetShaderResourceView(GetShaderResourceViewInfo(name), srv);
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the geometry shader stage
+//
+// srvInfo - Info from GetShaderResourceViewInfo(), looked up ahead of time
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if srvInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleGeometryShader::SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv)
+{
 	if (srvInfo == 0)
 		return false;
 
 	// Set the shader resource view
-	deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->SetShaderResource(ShaderStage::Geometry, srvInfo->BindIndex, srv);
+	else
+		deviceContext->GSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -1438,13 +2298,28 @@ bool SimpleGeometryShader::SetShaderResourceView(std::string name, ID3D11ShaderR
 // --------------------------------------------------------
 bool SimpleGeometryShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	// Look for the variable and set it through its info
+	return SetSamplerState(GetSamplerInfo(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the geometry shader stage
+//
+// sampInfo - Info from GetSamplerInfo(), looked up ahead of time
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if sampInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleGeometryShader::SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState)
+{
 	if (sampInfo == 0)
 		return false;
 
-	// Set the shader resource view
-	deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (stateCache)
+		stateCache->SetSampler(ShaderStage::Geometry, sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->GSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -1505,10 +2380,11 @@ void SimpleComputeShader::CleanUp()
 // Creates the DirectX Compute shader
 //
 // shaderBlob - The shader's compiled code
+// reflection - What the shader uses, cached or freshly reflected
 //
 // Returns true if shader is created correctly, false otherwise
 // --------------------------------------------------------
-bool SimpleComputeShader::CreateShader(ID3DBlob* shaderBlob)
+bool SimpleComputeShader::CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection)
 {
 	// Clean up first, in the event this method is
 	// called more than once on the same object
@@ -1579,7 +2455,10 @@ void SimpleComputeShader::SetShaderAndCBs()
 	if (!shaderValid) return;
 
 	// Set the shader
-	deviceContext->CSSetShader(shader, 0, 0);
+	if (stateCache)
+		stateCache->SetComputeShader(shader);
+	else
+		deviceContext->CSSetShader(shader, 0, 0);
 
 	// Set the constant buffers?
 	for (unsigned int i = 0; i < constantBufferCount; i++)
@@ -1588,11 +2467,29 @@ void SimpleComputeShader::SetShaderAndCBs()
 		if (constantBuffers[i].Type != D3D11_CT_CBUFFER)
 			continue;
 
-		// This is a real constant buffer, so set it
-		deviceContext->CSSetConstantBuffers(
-			constantBuffers[i].BindIndex,
-			1,
-			&constantBuffers[i].ConstantBuffer);
+		// Let the state cache drop it if it's already bound
+		if (BindConstantBufferThroughCache(ShaderStage::Compute, &constantBuffers[i]))
+			continue;
+
+		// This is a real constant buffer, so set it - from
+		// its slice of the ring if that's where its data went
+		if (IsInRing(&constantBuffers[i]))
+		{
+			ID3D11Buffer* ringBuffer = constantBufferRing->GetBuffer();
+			constantBufferRing->GetContext()->CSSetConstantBuffers1(
+				constantBuffers[i].BindIndex,
+				1,
+				&ringBuffer,
+				&constantBuffers[i].RingFirstConstant,
+				&constantBuffers[i].RingConstantCount);
+		}
+		else
+		{
+			deviceContext->CSSetConstantBuffers(
+				constantBuffers[i].BindIndex,
+				1,
+				&constantBuffers[i].ConstantBuffer);
+		}
 	}
 }
 
@@ -1618,7 +2515,11 @@ void SimpleComputeShader::SetShaderAndCBs()
 // --------------------------------------------------------
 void SimpleComputeShader::DispatchByGroups(unsigned int groupsX, unsigned int groupsY, unsigned int groupsZ)
 {
-	deviceContext->Dispatch(groupsX, groupsY, groupsZ);
+	// The state cache sends any held bindings first
+	if (stateCache)
+		stateCache->Dispatch(groupsX, groupsY, groupsZ);
+	else
+		deviceContext->Dispatch(groupsX, groupsY, groupsZ);
 }
 
 // --------------------------------------------------------
@@ -1643,7 +2544,7 @@ void SimpleComputeShader::DispatchByGroups(unsigned int groupsX, unsigned int gr
 // --------------------------------------------------------
 void SimpleComputeShader::DispatchByThreads(unsigned int threadsX, unsigned int threadsY, unsigned int threadsZ)
 {
-	deviceContext->Dispatch(
+	DispatchByGroups(
 		max((unsigned int)ceil((float)threadsX / this->threadsX), 1),
 		max((unsigned int)ceil((float)threadsY / this->threadsY), 1),
 		max((unsigned int)ceil((float)threadsZ / this->threadsZ), 1));
@@ -1659,13 +2560,28 @@ void SimpleComputeShader::DispatchByThreads(unsigned int threadsX, unsigned int
 // --------------------------------------------------------
 bool SimpleComputeShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	// Look for the variable and set it through its info
+	return SetShaderResourceView(GetShaderResourceViewInfo(name), srv);
+}
+
+// --------------------------------------------------------
+// Sets a shader resource view in the compute shader stage
+//
+// srvInfo - Info from GetShaderResourceViewInfo(), looked up ahead of time
+// srv - The shader resource view of the texture in GPU memory
+//
+// Returns true if srvInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleComputeShader::SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv)
+{
 	if (srvInfo == 0)
 		return false;
 
 	// Set the shader resource view
-	deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+	if (stateCache)
+		stateCache->SetShaderResource(ShaderStage::Compute, srvInfo->BindIndex, srv);
+	else
+		deviceContext->CSSetShaderResources(srvInfo->BindIndex, 1, &srv);
 
 	// Success
 	return true;
@@ -1681,13 +2597,28 @@ bool SimpleComputeShader::SetShaderResourceView(std::string name, ID3D11ShaderRe
 // --------------------------------------------------------
 bool SimpleComputeShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	// Look for the variable and set it through its info
+	return SetSamplerState(GetSamplerInfo(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state in the compute shader stage
+//
+// sampInfo - Info from GetSamplerInfo(), looked up ahead of time
+// samplerState - The sampler state in GPU memory
+//
+// Returns true if sampInfo is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleComputeShader::SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState)
+{
 	if (sampInfo == 0)
 		return false;
 
-	// Set the shader resource view
-	deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (stateCache)
+		stateCache->SetSampler(ShaderStage::Compute, sampInfo->BindIndex, samplerState);
+	else
+		deviceContext->CSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -3,6 +3,7 @@
 #pragma comment(lib, "d3dcompiler.lib")
 
 #include <d3d11.h>
+#include <d3d11_1.h>
 #include <d3dcompiler.h>
 #include <DirectXMath.h>
 
@@ -10,6 +11,11 @@
 #include <vector>
 #include <string>
 
+#include "DeviceStateCache.h"
+#include "ShaderReflectionCache.h"
+
+class ConstantBufferRing;
+
 // --------------------------------------------------------
 // Used by simple shaders to store information about
 // specific variables in constant buffers
@@ -21,6 +27,25 @@ struct SimpleShaderVariable
 	unsigned int ConstantBufferIndex;
 };
 
+// --------------------------------------------------------
+// A shader variable's location, looked up once by name with
+// GetParam() so that setting it later needs no string
+// copies or hashing.
+//
+// Handles only work with the shader they came from, or one
+// with exactly the same constant buffer layout - the same
+// name can sit at different offsets in different shaders.
+// --------------------------------------------------------
+struct ParamHandle
+{
+	unsigned int ConstantBufferIndex;
+	unsigned int ByteOffset;
+	unsigned int Size;		// 0 if the variable doesn't exist
+	unsigned int LayoutID;	// The constant buffer layout the offset is in
+
+	bool IsValid() const { return Size != 0; }
+};
+
 // --------------------------------------------------------
 // Contains information about a specific
 // constant buffer in a shader, as well as
@@ -28,13 +53,37 @@ struct SimpleShaderVariable
 // --------------------------------------------------------
 struct SimpleConstantBuffer
 {
-	std::string Name;
+	const char* Name;
 	D3D_CBUFFER_TYPE Type;
 	unsigned int Size;
 	unsigned int BindIndex;
 	ID3D11Buffer* ConstantBuffer;
 	unsigned char* LocalDataBuffer;
-	std::vector<SimpleShaderVariable> Variables;
+	SimpleShaderVariable* Variables;	// Sorted by offset
+	unsigned int VariableCount;
+
+	// Bytes of the local data buffer changed since the last copy to the GPU
+	bool Dirty;
+	unsigned int DirtyStart;
+	unsigned int DirtyEnd;
+
+	// Where the data was last put in a ConstantBufferRing, if it was
+	bool InRing;
+	unsigned int RingFrame;
+	UINT RingFirstConstant;
+	UINT RingConstantCount;
+};
+
+// --------------------------------------------------------
+// Counts of constant buffer work across every shader
+// since the last ResetFrameStats()
+// --------------------------------------------------------
+struct SimpleShaderFrameStats
+{
+	unsigned int BuffersUploaded;
+	unsigned int BuffersSkipped;	// Copies skipped, as nothing had changed
+	unsigned int BytesUploaded;
+	unsigned int WritesSkipped;		// Sets skipped, as the bytes were already there
 };
 
 // --------------------------------------------------------
@@ -55,6 +104,77 @@ struct SimpleSampler
 	unsigned int BindIndex; // The register of the Sampler
 };
 
+// --------------------------------------------------------
+// All of one shader's reflection data - buffers, variables,
+// resources, names and the buffers' local data - in a single
+// allocation, with one open-addressing hash over every name
+// --------------------------------------------------------
+class SimpleShaderMetadata
+{
+public:
+	SimpleShaderMetadata();
+	~SimpleShaderMetadata();
+
+	// Lays everything out in a fresh allocation, replacing what was there
+	void Build(const ShaderReflectionData& data);
+	void Clear();
+
+	SimpleConstantBuffer* GetConstantBuffers() { return constantBuffers; }
+	unsigned int GetConstantBufferCount() { return constantBufferCount; }
+	const SimpleSRV* GetShaderResourceViews() { return shaderResourceViews; }
+	unsigned int GetShaderResourceViewCount() { return shaderResourceViewCount; }
+	const SimpleSampler* GetSamplers() { return samplers; }
+	unsigned int GetSamplerCount() { return samplerCount; }
+
+	// Name lookups, which return null if there's no such name
+	SimpleConstantBuffer* FindConstantBuffer(const std::string& name);
+	SimpleShaderVariable* FindVariable(const std::string& name);
+	const SimpleSRV* FindShaderResourceView(const std::string& name);
+	const SimpleSampler* FindSampler(const std::string& name);
+
+	// Bytes in the allocation
+	size_t GetSize() { return size; }
+
+private:
+	// The hash is over names of all kinds, so the kind is part of the key
+	enum NameKind
+	{
+		ConstantBufferName,
+		VariableName,
+		TextureName,
+		SamplerName
+	};
+
+	struct NameSlot
+	{
+		unsigned int Hash;
+		unsigned int Kind;
+		unsigned int Index;			// Into the kind's array, or EmptySlot
+		unsigned int NameOffset;	// Into the name characters
+	};
+
+	static const unsigned int EmptySlot = 0xFFFFFFFF;
+
+	static unsigned int HashName(unsigned int kind, const char* name, size_t length);
+	void InsertName(unsigned int kind, unsigned int index, const std::string& name, unsigned int nameOffset);
+	unsigned int FindName(unsigned int kind, const std::string& name);
+
+	unsigned char* memory;
+	size_t size;
+
+	SimpleConstantBuffer* constantBuffers;
+	unsigned int constantBufferCount;
+	SimpleShaderVariable* variables;
+	unsigned int variableCount;
+	SimpleSRV* shaderResourceViews;
+	unsigned int shaderResourceViewCount;
+	SimpleSampler* samplers;
+	unsigned int samplerCount;
+	NameSlot* slots;
+	unsigned int slotMask;		// Slot count - 1, which is a power of two
+	char* names;
+};
+
 // --------------------------------------------------------
 // Base abstract class for simplifying shader handling
 // --------------------------------------------------------
@@ -71,40 +191,74 @@ public:
 	// Simple helpers
 	bool IsShaderValid() { return shaderValid; }
 
+	// Copy constant buffers into a shared ring rather than this shader's own
+	// buffers, when the ring is enabled.  The ring is not owned by the shader.
+	void SetConstantBufferRing(ConstantBufferRing* ring);
+
+	// Bind through a state cache, which skips bindings that are already in
+	// place.  Draws must then go through the cache too.  Not owned by the shader.
+	void SetStateCache(DeviceStateCache* cache);
+
 	// Activating the shader and copying data
 	void SetShader();
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
 	void CopyBufferData(std::string bufferName);
 
+	// Looks up a variable once, for the handle-based setters below
+	ParamHandle GetParam(const std::string& name);
+
+	// Identifies this shader's constant buffer layout.  Shaders whose buffers and
+	// variables all match share an ID, and can use each other's handles.
+	unsigned int GetLayoutID() { return layoutID; }
+
 	// Sets arbitrary shader data
-	bool SetData(std::string name, const void* data, unsigned int size);
-
-	bool SetInt(std::string name, int data);
-	bool SetFloat(std::string name, float data);
-	bool SetFloat2(std::string name, const float data[2]);
-	bool SetFloat2(std::string name, const DirectX::XMFLOAT2 data);
-	bool SetFloat3(std::string name, const float data[3]);
-	bool SetFloat3(std::string name, const DirectX::XMFLOAT3 data);
-	bool SetFloat4(std::string name, const float data[4]);
-	bool SetFloat4(std::string name, const DirectX::XMFLOAT4 data);
-	bool SetMatrix4x4(std::string name, const float data[16]);
-	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
+	bool SetData(const std::string& name, const void* data, unsigned int size);
+
+	bool SetInt(const std::string& name, int data);
+	bool SetFloat(const std::string& name, float data);
+	bool SetFloat2(const std::string& name, const float data[2]);
+	bool SetFloat2(const std::string& name, const DirectX::XMFLOAT2 data);
+	bool SetFloat3(const std::string& name, const float data[3]);
+	bool SetFloat3(const std::string& name, const DirectX::XMFLOAT3 data);
+	bool SetFloat4(const std::string& name, const float data[4]);
+	bool SetFloat4(const std::string& name, const DirectX::XMFLOAT4 data);
+	bool SetMatrix4x4(const std::string& name, const float data[16]);
+	bool SetMatrix4x4(const std::string& name, const DirectX::XMFLOAT4X4 data);
+
+	// Sets shader data through handles from GetParam(), without any lookups
+	bool SetData(ParamHandle param, const void* data, unsigned int size);
+
+	bool SetInt(ParamHandle param, int data);
+	bool SetFloat(ParamHandle param, float data);
+	bool SetFloat2(ParamHandle param, const DirectX::XMFLOAT2& data);
+	bool SetFloat3(ParamHandle param, const DirectX::XMFLOAT3& data);
+	bool SetFloat4(ParamHandle param, const DirectX::XMFLOAT4& data);
+	bool SetMatrix4x4(ParamHandle param, const DirectX::XMFLOAT4X4& data);
+
+	// Sets a whole constant buffer at once, from a struct generated into
+	// ShaderConstants.h.  The struct's size must match the buffer's.
+	template<typename T>
+	bool SetBufferData(const T& data) { return SetBufferData(T::BufferName(), &data, sizeof(T)); }
+	bool SetBufferData(const std::string& bufferName, const void* data, unsigned int size);
+	bool SetBufferData(unsigned int index, const void* data, unsigned int size);
 
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
+	virtual bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv) = 0;
+	virtual bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState) = 0;
 
 	// Getting data about variables and resources
 	const SimpleShaderVariable* GetVariableInfo(std::string name);
 	
 	const SimpleSRV* GetShaderResourceViewInfo(std::string name);
 	const SimpleSRV* GetShaderResourceViewInfo(unsigned int index);
-	size_t GetShaderResourceViewCount() { return textureTable.size(); }
+	size_t GetShaderResourceViewCount() { return metadata.GetShaderResourceViewCount(); }
 	
 	const SimpleSampler* GetSamplerInfo(std::string name);
 	const SimpleSampler* GetSamplerInfo(unsigned int index);
-	size_t GetSamplerCount() { return samplerTable.size(); }
+	size_t GetSamplerCount() { return metadata.GetSamplerCount(); }
 
 	// Get data about constant buffers
 	unsigned int GetBufferCount();
@@ -114,6 +268,15 @@ public:
 	
 	// Misc getters
 	ID3DBlob* GetShaderBlob() { return shaderBlob; }
+	size_t GetMetadataSize() { return metadata.GetSize(); }
+
+	// Constant buffer upload counters, shared by all shaders
+	static const SimpleShaderFrameStats& GetFrameStats();
+	static void ResetFrameStats();
+
+	// Reflection results for shaders loaded from now on come from (and
+	// go into) this cache, when set.  Not owned by the shaders.
+	static void SetReflectionCache(ShaderReflectionCache* cache);
 
 protected:
 	
@@ -121,27 +284,47 @@ protected:
 	ID3DBlob* shaderBlob;
 	ID3D11Device* device;
 	ID3D11DeviceContext* deviceContext;
+	ID3D11DeviceContext1* deviceContext1;	// Null before Direct3D 11.1
+	bool partialBufferUpdates;				// Can copy part of a constant buffer
+	ConstantBufferRing* constantBufferRing;
+	DeviceStateCache* stateCache;
+
+	static SimpleShaderFrameStats frameStats;
+	static ShaderReflectionCache* reflectionCache;
 
 	// Resource counts
 	unsigned int constantBufferCount;
+	unsigned int layoutID;
 	
-	// Maps for variables and buffers
-	SimpleConstantBuffer*		constantBuffers; // For index-based lookup
-	std::vector<SimpleSRV*>		shaderResourceViews;
-	std::vector<SimpleSampler*>	samplerStates;
-	std::unordered_map<std::string, SimpleConstantBuffer*> cbTable;
-	std::unordered_map<std::string, SimpleShaderVariable> varTable;
-	std::unordered_map<std::string, SimpleSRV*> textureTable;
-	std::unordered_map<std::string, SimpleSampler*> samplerTable;
+	// Variables, buffers and resources, and the lookups for them
+	SimpleShaderMetadata	metadata;
+	SimpleConstantBuffer*	constantBuffers; // For index-based lookup, in the metadata
 
 	// Pure virtual functions for dealing with shader types
-	virtual bool CreateShader(ID3DBlob* shaderBlob) = 0;
+	virtual bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection) = 0;
 	virtual void SetShaderAndCBs() = 0;
 
 	virtual void CleanUp();
 
+	// Reflects the loaded shader blob, and builds this shader's
+	// buffers and tables from reflection data
+	void Reflect(ShaderReflectionData& data);
+	void BuildTables(const ShaderReflectionData& data);
+	static unsigned int HashLayout(const ShaderReflectionData& data);
+
+	// Copies a constant buffer's changed bytes, if any, to the GPU
+	void UploadBuffer(SimpleConstantBuffer* cb);
+
+	// Whether a buffer's latest data is in the ring for this frame, so it
+	// must be bound from there with XXSetConstantBuffers1
+	bool IsInRing(SimpleConstantBuffer* cb);
+
+	// Binds a constant buffer through the state cache, if there is one.
+	// Returns false if there isn't, and the caller must bind it itself.
+	bool BindConstantBufferThroughCache(ShaderStage stage, SimpleConstantBuffer* cb);
+
 	// Helpers for finding data by name
-	SimpleShaderVariable* FindVariable(std::string name, int size);
+	SimpleShaderVariable* FindVariable(const std::string& name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
 };
 
@@ -160,12 +343,14 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState);
 
 protected:
 	bool perInstanceCompatible;
 	ID3D11InputLayout* inputLayout;
 	ID3D11VertexShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -183,10 +368,12 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11PixelShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -203,10 +390,12 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11DomainShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -223,10 +412,12 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState);
 
 protected:
 	ID3D11HullShader* shader;
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
@@ -243,6 +434,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState);
 
 	bool CreateCompatibleStreamOutBuffer(ID3D11Buffer** buffer, int vertexCount);
 
@@ -257,7 +450,7 @@ protected:
 	bool allowStreamOutRasterization;
 	unsigned int streamOutVertexSize;
 
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection);
 	bool CreateShaderWithStreamOut(ID3DBlob* shaderBlob);
 	void SetShaderAndCBs();
 	void CleanUp();
@@ -282,6 +475,8 @@ public:
 
 	bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
+	bool SetShaderResourceView(const SimpleSRV* srvInfo, ID3D11ShaderResourceView* srv);
+	bool SetSamplerState(const SimpleSampler* sampInfo, ID3D11SamplerState* samplerState);
 	bool SetUnorderedAccessView(std::string name, ID3D11UnorderedAccessView* uav, unsigned int appendConsumeOffset = -1);
 
 	int GetUnorderedAccessViewIndex(std::string name);
@@ -295,7 +490,7 @@ protected:
 	unsigned int threadsZ;
 	unsigned int threadsTotal;
 
-	bool CreateShader(ID3DBlob* shaderBlob);
+	bool CreateShader(ID3DBlob* shaderBlob, const ShaderReflectionData& reflection);
 	void SetShaderAndCBs();
 	void CleanUp();
 };
\ No newline at end of file
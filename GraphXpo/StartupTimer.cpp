@@ -0,0 +1,47 @@
+#include "StartupTimer.h"
+#include <cstdio>
+
+StartupTimer::StartupTimer()
+{
+	running = false;
+}
+
+void StartupTimer::Begin(const char* name)
+{
+	End();
+
+	Phase phase = { name, 0.0 };
+	phases.push_back(phase);
+	phaseStart = std::chrono::steady_clock::now();
+	running = true;
+}
+
+void StartupTimer::End()
+{
+	if (!running)
+		return;
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - phaseStart;
+	phases.back().Milliseconds = elapsed.count();
+	running = false;
+}
+
+void StartupTimer::Report()
+{
+	double total = GetTotalMilliseconds();
+
+	printf("\nStartup: %.1f ms\n", total);
+	for (size_t i = 0; i < phases.size(); i++)
+	{
+		double share = total > 0.0 ? phases[i].Milliseconds / total * 100.0 : 0.0;
+		printf("  %-24s %8.1f ms  %5.1f%%\n", phases[i].Name, phases[i].Milliseconds, share);
+	}
+}
+
+double StartupTimer::GetTotalMilliseconds()
+{
+	double total = 0.0;
+	for (size_t i = 0; i < phases.size(); i++)
+		total += phases[i].Milliseconds;
+	return total;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+// --------------------------------------------------------
+// Times the phases of startup back to back, so the slow
+// ones stand out before the first frame.  Starting a phase
+// ends the one before it.
+// --------------------------------------------------------
+class StartupTimer
+{
+public:
+	StartupTimer();
+
+	///<summary>
+	///End the running phase, if any, and start timing a new one.  name must outlive the timer.
+	///</summary>
+	void Begin(const char* name);
+
+	///<summary>
+	///End the running phase without starting another.
+	///</summary>
+	void End();
+
+	///<summary>
+	///Print each phase's time and its share of the total.
+	///</summary>
+	void Report();
+
+	double GetTotalMilliseconds();
+
+private:
+	struct Phase
+	{
+		const char* Name;
+		double Milliseconds;
+	};
+
+	std::vector<Phase> phases;
+	std::chrono::steady_clock::time_point phaseStart;
+	bool running;
+};
@@ -12,6 +12,7 @@ Transform::Transform()
 	CalculateLocalDirections();
 
 	//now construct the default world matrix
+	version = 0;
 	CalculateWorldMatrix();
 }
 
@@ -306,6 +307,12 @@ void Transform::CalculateWorldMatrix()
 	XMStoreFloat4x4(&inverseTransposeWorld, XMMatrixInverse(nullptr, world));
 
 	matrixOutdated = false; //we have just updated the matrix, no need to recalculate yet
+	version++;
+}
+
+unsigned int Transform::GetVersion()
+{
+	return version;
 }
 
 
@@ -78,6 +78,11 @@ public:
 	///</summary>
 	void CalculateWorldMatrix();
 
+	///<summary>
+	///Bumped every time the world matrix is recalculated, so anything derived from it can tell it is stale.
+	///</summary>
+	unsigned int GetVersion();
+
 private:
 
 	///<summary>
@@ -91,6 +96,7 @@ private:
 	DirectX::XMFLOAT3 scale;	//vector multiplier of the entity's size
 	DirectX::XMFLOAT4X4 worldMatrix; //the combination of the above vectors. Transforms the entity to world coordinates
 	DirectX::XMFLOAT4X4 inverseTransposeWorld; //matrix maintaining the rotations, but inverting the scale. Useful for transforming normals.
+	unsigned int version; //how many times the world matrix has been calculated
 
 	//local direction vectors
 	DirectX::XMFLOAT3 forward;
@@ -0,0 +1,115 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(unsigned int threadCount)
+{
+	body = 0;
+	count = 0;
+	chunkSize = 1;
+	nextChunk = 0;
+	jobID = 0;
+	activeWorkers = 0;
+	shuttingDown = false;
+
+	// Leave a core for the calling thread, which also runs chunks
+	if (threadCount == 0)
+	{
+		unsigned int cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 0;
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		threads.emplace_back(&WorkerPool::WorkerMain, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		shuttingDown = true;
+	}
+	workReady.notify_all();
+
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+}
+
+void WorkerPool::ParallelFor(int count, int minChunkSize, const std::function<void(int, int)>& body)
+{
+	if (count <= 0)
+		return;
+
+	// Aim for a few chunks per thread so uneven chunks still balance out
+	int threadCount = (int)GetThreadCount();
+	int chunkSize = (count + threadCount * 4 - 1) / (threadCount * 4);
+	if (chunkSize < minChunkSize)
+		chunkSize = minChunkSize;
+	int chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	// Not worth waking anyone up
+	if (chunkCount == 1 || threads.empty())
+	{
+		body(0, count);
+		return;
+	}
+
+	std::lock_guard<std::mutex> jobLock(jobMutex);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->body = &body;
+		this->count = count;
+		this->chunkSize = chunkSize;
+		nextChunk = 0;
+		activeWorkers = (unsigned int)threads.size();
+		jobID++;
+	}
+	workReady.notify_all();
+
+	// Help out, then wait for the workers to let go of the job
+	RunChunks();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	workDone.wait(lock, [this] { return activeWorkers == 0; });
+	this->body = 0;
+}
+
+unsigned int WorkerPool::GetThreadCount()
+{
+	return (unsigned int)threads.size() + 1;
+}
+
+void WorkerPool::WorkerMain()
+{
+	unsigned int lastJobID = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workReady.wait(lock, [&] { return shuttingDown || jobID != lastJobID; });
+			if (shuttingDown)
+				return;
+			lastJobID = jobID;
+		}
+
+		RunChunks();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			activeWorkers--;
+		}
+		workDone.notify_one();
+	}
+}
+
+void WorkerPool::RunChunks()
+{
+	while (true)
+	{
+		int chunk = nextChunk.fetch_add(1);
+		int begin = chunk * chunkSize;
+		if (begin >= count)
+			return;
+
+		int end = begin + chunkSize < count ? begin + chunkSize : count;
+		(*body)(begin, end);
+	}
+}
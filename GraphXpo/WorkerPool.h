@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// A small, fixed set of worker threads for splitting loops
+// across cores.  ParallelFor blocks until all of the work
+// is done, with the calling thread helping out, so callers
+// never have to deal with futures or synchronization.
+// --------------------------------------------------------
+class WorkerPool
+{
+public:
+	///<summary>
+	///Start threadCount workers; 0 means one per core besides the calling thread.
+	///</summary>
+	WorkerPool(unsigned int threadCount = 0);
+	~WorkerPool();
+
+	///<summary>
+	///Call body(begin, end) over [0, count) in chunks of at least minChunkSize, spread across all threads.
+	///Returns once every chunk has finished.
+	///</summary>
+	void ParallelFor(int count, int minChunkSize, const std::function<void(int, int)>& body);
+
+	///<summary>
+	///Number of threads that take part in ParallelFor, including the caller.
+	///</summary>
+	unsigned int GetThreadCount();
+
+private:
+	///<summary>
+	///Loop run by each worker thread.
+	///</summary>
+	void WorkerMain();
+
+	///<summary>
+	///Claim and run chunks of the current job until none are left.
+	///</summary>
+	void RunChunks();
+
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable workReady;
+	std::condition_variable workDone;
+	std::mutex jobMutex;		// Only one ParallelFor may run at a time
+
+	// The current job
+	const std::function<void(int, int)>* body;
+	int count;
+	int chunkSize;
+	std::atomic<int> nextChunk;
+	unsigned int jobID;			// Bumped for each job so workers can tell new work apart
+	unsigned int activeWorkers;	// Workers still inside RunChunks for the current job
+	bool shuttingDown;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// --------------------------------------------------------
+// Timing for the benchmarks in this folder.  Each result is
+// the best of several runs, which is the least disturbed by
+// whatever else the machine is doing.
+// --------------------------------------------------------
+
+// Milliseconds for the fastest of repeats calls to run()
+template<typename Run>
+double BestMilliseconds(int repeats, Run run)
+{
+	double best = 1e30;
+	for (int i = 0; i < repeats; i++)
+	{
+		auto start = std::chrono::steady_clock::now();
+		run();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		if (elapsed.count() < best)
+			best = elapsed.count();
+	}
+	return best;
+}
+
+// Keeps a result alive so the work behind it can't be optimized away
+template<typename T>
+void KeepResult(const T& value)
+{
+	static volatile unsigned char sink;
+	const unsigned char* bytes = (const unsigned char*)&value;
+	for (size_t i = 0; i < sizeof(T); i++)
+		sink = sink ^ bytes[i];
+}
@@ -0,0 +1,129 @@
+#include "TestHarness.h"
+#include "Recording.h"
+#include "ConstantBufferAllocator.h"
+#include "ConstantBufferRing.h"
+
+TEST(AllocationsAreAligned)
+{
+	ConstantBufferAllocator allocator(4096, 3);
+	unsigned int offset = 1;
+
+	CHECK(allocator.Allocate(1, &offset));
+	CHECK_EQUAL(0u, offset);
+	CHECK(allocator.Allocate(272, &offset));
+	CHECK_EQUAL(256u, offset);
+	CHECK(allocator.Allocate(256, &offset));
+	CHECK_EQUAL(768u, offset);
+	CHECK_EQUAL(1024u, allocator.GetBytesUsed());
+}
+
+TEST(FrameSizeRoundsDownToWholeBlocks)
+{
+	ConstantBufferAllocator allocator(1000, 2);
+	CHECK_EQUAL(768u, allocator.GetFrameSize());
+	CHECK_EQUAL(1536u, allocator.GetTotalSize());
+
+	// Every region starts aligned
+	allocator.BeginFrame();
+	unsigned int offset = 0;
+	CHECK(allocator.Allocate(16, &offset));
+	CHECK_EQUAL(768u, offset);
+	CHECK_EQUAL(0u, offset % ConstantBufferAllocator::Alignment);
+}
+
+TEST(FullRegionRefusesAndCounts)
+{
+	ConstantBufferAllocator allocator(512, 2);
+	unsigned int offset = 0;
+
+	CHECK(allocator.Allocate(300, &offset));
+	offset = 12345;
+	CHECK(!allocator.Allocate(256, &offset));
+	CHECK_EQUAL(12345u, offset);
+	CHECK(!allocator.Allocate(0, &offset));
+	CHECK_EQUAL(2u, allocator.GetFailedAllocations());
+
+	// Never spills into the next frame's region
+	CHECK_EQUAL(512u, allocator.GetBytesUsed());
+
+	allocator.BeginFrame();
+	CHECK_EQUAL(0u, allocator.GetFailedAllocations());
+	CHECK(allocator.Allocate(512, &offset));
+	CHECK_EQUAL(512u, offset);
+}
+
+TEST(RegionsAreReusedFrameCountFramesLater)
+{
+	const unsigned int FrameCount = 3;
+	ConstantBufferAllocator allocator(1024, FrameCount);
+
+	// The first allocation of each frame, frame by frame, wrapping after FrameCount
+	for (unsigned int frame = 0; frame < FrameCount * 3; frame++)
+	{
+		unsigned int offset = 0;
+		CHECK(allocator.Allocate(64, &offset));
+		CHECK_EQUAL((frame % FrameCount) * 1024u, offset);
+		CHECK_EQUAL(frame % FrameCount == 0, allocator.IsFirstRegion());
+		CHECK_EQUAL(frame, allocator.GetFrameIndex());
+		allocator.BeginFrame();
+	}
+}
+
+TEST(RingDiscardsOncePerPass)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	ConstantBufferRing ring(&device, &context, 1024, 2);
+	CHECK(ring.IsEnabled());
+
+	float data[64] = { 1, 2, 3 };
+	UINT first = 0, count = 0;
+
+	// Frame 0 starts the first pass through the buffer
+	CHECK(ring.Upload(data, sizeof(data), &first, &count));
+	CHECK(ring.Upload(data, 16, &first, &count));
+	CHECK_EQUAL(16u, first);
+	CHECK_EQUAL(16u, count);
+
+	// Frame 1 is in the second region of the same pass; frame 2 starts a new pass
+	ring.BeginFrame();
+	CHECK(ring.Upload(data, 16, &first, &count));
+	CHECK_EQUAL(64u, first);
+	ring.BeginFrame();
+	CHECK(ring.Upload(data, 16, &first, &count));
+	CHECK_EQUAL(0u, first);
+
+	std::vector<RecordedCall> maps = context.CallsNamed("Map");
+	CHECK_EQUAL(4u, (unsigned int)maps.size());
+	CHECK_EQUAL(D3D11_MAP_WRITE_DISCARD, maps[0].MapType);
+	CHECK_EQUAL(D3D11_MAP_WRITE_NO_OVERWRITE, maps[1].MapType);
+	CHECK_EQUAL(D3D11_MAP_WRITE_NO_OVERWRITE, maps[2].MapType);
+	CHECK_EQUAL(D3D11_MAP_WRITE_DISCARD, maps[3].MapType);
+	CHECK_EQUAL(4u, context.CountCalls("Unmap"));
+
+	RecordingBuffer* buffer = (RecordingBuffer*)ring.GetBuffer();
+	CHECK_EQUAL(0, memcmp(buffer->Data.data() + 64 * 16, data, 16));
+}
+
+TEST(RingIsOffWithoutOffsetting)
+{
+	RecordingDevice device;
+	device.ConstantBufferOffsetting = false;
+	RecordingContext context;
+	ConstantBufferRing ring(&device, &context, 1024, 2);
+
+	float data[4] = {};
+	UINT first = 0, count = 0;
+	CHECK(!ring.IsEnabled());
+	CHECK(!ring.Upload(data, sizeof(data), &first, &count));
+	CHECK_EQUAL(0u, (unsigned int)context.Calls.size());
+}
+
+TEST(RingIsOffBeforeDirect3D11_1)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	context.Supports11_1 = false;
+	ConstantBufferRing ring(&device, &context, 1024, 2);
+	CHECK(!ring.IsEnabled());
+}
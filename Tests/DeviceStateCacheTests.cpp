@@ -0,0 +1,232 @@
+#include "TestHarness.h"
+#include "Recording.h"
+#include "DeviceStateCache.h"
+
+namespace
+{
+	// Views, samplers and shaders only need to be told apart
+	RecordingShaderResourceView srvs[4];
+	RecordingSamplerState samplerStates[2];
+	RecordingVertexShader vertexShaders[2];
+	RecordingPixelShader pixelShaders[2];
+	RecordingBuffer buffers[3];
+
+	std::vector<const void*> Objects(std::initializer_list<const void*> objects)
+	{
+		return std::vector<const void*>(objects);
+	}
+}
+
+TEST(RedundantShaderBindsAreDropped)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetVertexShader(&vertexShaders[0]);
+	cache.SetVertexShader(&vertexShaders[0]);
+	cache.SetPixelShader(&pixelShaders[0]);
+	cache.SetVertexShader(&vertexShaders[1]);
+	cache.SetPixelShader(&pixelShaders[0]);
+
+	CHECK_EQUAL(2u, context.CountCalls("VSSetShader"));
+	CHECK_EQUAL(1u, context.CountCalls("PSSetShader"));
+	CHECK_EQUAL(3u, cache.GetStats().CallsIssued);
+	CHECK_EQUAL(2u, cache.GetStats().CallsElided);
+}
+
+TEST(RedundantSlotBindsAreDropped)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.SetSampler(ShaderStage::Pixel, 0, &samplerStates[0]);
+	cache.Draw(3, 0);
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.SetSampler(ShaderStage::Pixel, 0, &samplerStates[0]);
+	cache.Draw(3, 0);
+
+	CHECK_EQUAL(1u, context.CountCalls("PSSetShaderResources"));
+	CHECK_EQUAL(1u, context.CountCalls("PSSetSamplers"));
+	CHECK_EQUAL(2u, context.CountCalls("Draw"));
+	CHECK_EQUAL(2u, cache.GetStats().CallsElided);
+}
+
+TEST(SlotBindsWaitForTheDraw)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	CHECK_EQUAL(0u, (unsigned int)context.Calls.size());
+
+	cache.DrawIndexed(6, 0, 0);
+	CHECK_EQUAL(2u, (unsigned int)context.Calls.size());
+	CHECK_EQUAL(std::string("PSSetShaderResources"), context.Calls[0].Name);
+	CHECK_EQUAL(std::string("DrawIndexed"), context.Calls[1].Name);
+}
+
+TEST(ChangedAndChangedBackBeforeTheDrawIsDropped)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.Flush();
+	context.Clear();
+
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[1]);
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.Flush();
+	CHECK_EQUAL(0u, (unsigned int)context.Calls.size());
+}
+
+TEST(AdjacentSlotsGoInOneCall)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetShaderResource(ShaderStage::Pixel, 2, &srvs[2]);
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.SetShaderResource(ShaderStage::Pixel, 1, &srvs[1]);
+	cache.Flush();
+
+	std::vector<RecordedCall> calls = context.CallsNamed("PSSetShaderResources");
+	CHECK_EQUAL(1u, (unsigned int)calls.size());
+	CHECK_EQUAL(0u, calls[0].StartSlot);
+	CHECK_EQUAL(3u, calls[0].Count);
+	CHECK(calls[0].Objects == Objects({ &srvs[0], &srvs[1], &srvs[2] }));
+	CHECK_EQUAL(1u, cache.GetStats().CallsIssued);
+	CHECK_EQUAL(2u, cache.GetStats().SlotsCoalesced);
+}
+
+TEST(KnownSlotsBridgeGapsInARun)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.SetShaderResource(ShaderStage::Pixel, 1, &srvs[1]);
+	cache.SetShaderResource(ShaderStage::Pixel, 2, &srvs[2]);
+	cache.Flush();
+	context.Clear();
+	cache.ResetStats();
+
+	// Slot 1 is unchanged, but resending it still saves a call
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[3]);
+	cache.SetShaderResource(ShaderStage::Pixel, 2, &srvs[0]);
+	cache.Flush();
+
+	std::vector<RecordedCall> calls = context.CallsNamed("PSSetShaderResources");
+	CHECK_EQUAL(1u, (unsigned int)calls.size());
+	CHECK_EQUAL(0u, calls[0].StartSlot);
+	CHECK(calls[0].Objects == Objects({ &srvs[3], &srvs[1], &srvs[0] }));
+	CHECK_EQUAL(1u, cache.GetStats().SlotsCoalesced);
+}
+
+TEST(UnknownSlotsSplitARun)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	// Nothing is known about slot 1, so it can't be sent in passing
+	cache.SetSampler(ShaderStage::Pixel, 0, &samplerStates[0]);
+	cache.SetSampler(ShaderStage::Pixel, 2, &samplerStates[1]);
+	cache.Flush();
+
+	std::vector<RecordedCall> calls = context.CallsNamed("PSSetSamplers");
+	CHECK_EQUAL(2u, (unsigned int)calls.size());
+	CHECK_EQUAL(0u, calls[0].StartSlot);
+	CHECK_EQUAL(1u, calls[0].Count);
+	CHECK_EQUAL(2u, calls[1].StartSlot);
+	CHECK_EQUAL(1u, calls[1].Count);
+}
+
+TEST(StagesAreKeptApart)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetShaderResource(ShaderStage::Vertex, 0, &srvs[0]);
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.Flush();
+
+	CHECK_EQUAL(1u, context.CountCalls("VSSetShaderResources"));
+	CHECK_EQUAL(1u, context.CountCalls("PSSetShaderResources"));
+}
+
+TEST(InvalidateSendsEverythingAgain)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetVertexShader(&vertexShaders[0]);
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.SetConstantBuffer(ShaderStage::Vertex, 0, &buffers[0]);
+	cache.Draw(3, 0);
+	context.Clear();
+
+	// Someone bound things on the context directly
+	cache.Invalidate();
+	cache.SetVertexShader(&vertexShaders[0]);
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.SetConstantBuffer(ShaderStage::Vertex, 0, &buffers[0]);
+	cache.Draw(3, 0);
+
+	CHECK_EQUAL(1u, context.CountCalls("VSSetShader"));
+	CHECK_EQUAL(1u, context.CountCalls("PSSetShaderResources"));
+	CHECK_EQUAL(1u, context.CountCalls("VSSetConstantBuffers"));
+}
+
+TEST(InvalidateDropsBindsNotYetSent)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetShaderResource(ShaderStage::Pixel, 0, &srvs[0]);
+	cache.Invalidate();
+	cache.Draw(3, 0);
+
+	CHECK_EQUAL(0u, context.CountCalls("PSSetShaderResources"));
+	CHECK_EQUAL(1u, context.CountCalls("Draw"));
+}
+
+TEST(SlicedConstantBuffersUseOffsets)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	// A whole buffer next to a slice goes in the same call, as a slice of everything
+	cache.SetConstantBuffer(ShaderStage::Vertex, 0, &buffers[0]);
+	cache.SetConstantBuffer(ShaderStage::Vertex, 1, &buffers[1], 32, 16);
+	cache.Flush();
+
+	std::vector<RecordedCall> calls = context.CallsNamed("VSSetConstantBuffers1");
+	CHECK_EQUAL(1u, (unsigned int)calls.size());
+	CHECK_EQUAL(0u, context.CountCalls("VSSetConstantBuffers"));
+	CHECK(calls[0].Objects == Objects({ &buffers[0], &buffers[1] }));
+	CHECK(calls[0].FirstConstants == std::vector<UINT>({ 0, 32 }));
+	CHECK(calls[0].ConstantCounts == std::vector<UINT>({ (UINT)D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT, 16 }));
+
+	// Another slice of the same buffer is a different binding
+	context.Clear();
+	cache.SetConstantBuffer(ShaderStage::Vertex, 1, &buffers[1], 32, 16);
+	cache.Flush();
+	CHECK_EQUAL(0u, (unsigned int)context.Calls.size());
+	cache.SetConstantBuffer(ShaderStage::Vertex, 1, &buffers[1], 48, 16);
+	cache.Flush();
+	CHECK_EQUAL(1u, context.CountCalls("VSSetConstantBuffers1"));
+}
+
+TEST(WholeConstantBuffersUsePlainBinds)
+{
+	RecordingContext context;
+	DeviceStateCache cache(&context);
+
+	cache.SetConstantBuffer(ShaderStage::Pixel, 0, &buffers[0]);
+	cache.SetConstantBuffer(ShaderStage::Pixel, 1, &buffers[1]);
+	cache.Flush();
+
+	CHECK_EQUAL(1u, context.CountCalls("PSSetConstantBuffers"));
+	CHECK_EQUAL(0u, context.CountCalls("PSSetConstantBuffers1"));
+}
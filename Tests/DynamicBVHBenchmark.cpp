@@ -0,0 +1,76 @@
+// Keeping a DynamicBVH over 100k proxies up to date while some of them move
+// every frame, against rebuilding a SceneBVH over everything each frame.
+#include "Bench.h"
+#include "Scenes.h"
+#include "DynamicBVH.h"
+#include "SceneBVH.h"
+
+using namespace DirectX;
+
+static const int Repeats = 5;
+static const int FramesPerRun = 10;
+static const unsigned int ProxyCount = 100000;
+
+int main()
+{
+	std::vector<AABB> start = MakeScene(ProxyCount, 3);
+	std::vector<unsigned int> ids(ProxyCount);
+	for (unsigned int i = 0; i < ProxyCount; i++)
+		ids[i] = i;
+
+	float halfWidth = 10.0f * sqrtf((float)ProxyCount);
+	Frustum frustum = MakeSceneFrustum(XMFLOAT3(0, 3, -halfWidth), XMFLOAT3(0, 0, 1), halfWidth);
+	std::vector<unsigned int> visible(ProxyCount);
+
+	// The whole scene rebuilt, as a static tree would have to be
+	SceneBVH scene;
+	double rebuild = BestMilliseconds(Repeats, [&]() { scene.Build(start.data(), ids.data(), ProxyCount, 0); });
+	double sceneCull = BestMilliseconds(Repeats, [&]() { KeepResult(scene.Cull(frustum, visible.data())); });
+	printf("%u proxies\n", ProxyCount);
+	printf("  SceneBVH rebuild    %9.2f ms, cull %.3f ms\n", rebuild, sceneCull);
+
+	float percents[] = { 1, 5, 10 };
+	for (float percent : percents)
+	{
+		DynamicBVH tree;
+		std::vector<AABB> boxes = start;
+		std::vector<int> proxies(ProxyCount);
+		for (unsigned int i = 0; i < ProxyCount; i++)
+			proxies[i] = tree.CreateProxy(boxes[i], i);
+
+		// Movers walk a little each frame, so most stay inside their fat bounds for a while
+		unsigned int moving = (unsigned int)(ProxyCount * percent / 100);
+		std::mt19937 generator(4);
+		std::uniform_real_distribution<float> step(-0.08f, 0.08f);
+		std::vector<XMFLOAT3> velocities(moving);
+		for (XMFLOAT3& velocity : velocities)
+			velocity = XMFLOAT3(step(generator), step(generator) * 0.25f, step(generator));
+
+		float startCost = tree.GetCost();
+		tree.ResetUpdateStats();
+		double update = BestMilliseconds(Repeats, [&]()
+		{
+			for (int frame = 0; frame < FramesPerRun; frame++)
+			{
+				// Every so many proxies, so the movers are spread over the scene
+				for (unsigned int m = 0; m < moving; m++)
+				{
+					unsigned int i = (unsigned int)((unsigned long long)m * ProxyCount / moving);
+					const XMFLOAT3& v = velocities[m];
+					AABB& box = boxes[i];
+					box = AABB(XMFLOAT3(box.Min.x + v.x, box.Min.y + v.y, box.Min.z + v.z), XMFLOAT3(box.Max.x + v.x, box.Max.y + v.y, box.Max.z + v.z));
+					tree.MoveProxy(proxies[i], box);
+				}
+				tree.Optimize(moving / 8 + 16);
+			}
+		}) / FramesPerRun;
+		double cull = BestMilliseconds(Repeats, [&]() { KeepResult(tree.Cull(frustum, visible.data())); });
+
+		const DynamicBVHUpdateStats& stats = tree.GetUpdateStats();
+		printf("  %2.0f%% moving (%u a frame):\n", percent, moving);
+		printf("    Update            %9.3f ms a frame, %.3f us a move (%.1f%% reinserted, %u rotations)\n",
+			update, update * 1000 / moving, 100.0 * stats.Reinserts / stats.Moves, stats.Rotations);
+		printf("    Cull              %9.3f ms, tree cost %.2fx what it was after inserting\n", cull, tree.GetCost() / startCost);
+	}
+	return 0;
+}
@@ -0,0 +1,291 @@
+#include "TestHarness.h"
+#include "Scenes.h"
+#include "DynamicBVH.h"
+#include <algorithm>
+
+using namespace DirectX;
+
+namespace
+{
+	const float Margin = 0.5f;
+
+	// The proxies a test has made, each with the box it last gave the tree
+	struct Scene
+	{
+		DynamicBVH Tree;
+		std::vector<int> Proxies;
+		std::vector<AABB> Boxes;
+		std::vector<unsigned int> Ids;
+		unsigned int NextId = 0;
+
+		Scene(const std::vector<AABB>& boxes)
+		{
+			Tree.SetMargin(Margin);
+			for (const AABB& box : boxes)
+				Add(box);
+		}
+
+		void Add(const AABB& box)
+		{
+			Proxies.push_back(Tree.CreateProxy(box, NextId));
+			Boxes.push_back(box);
+			Ids.push_back(NextId++);
+		}
+
+		void Remove(size_t index)
+		{
+			Tree.DestroyProxy(Proxies[index]);
+			Proxies[index] = Proxies.back(); Proxies.pop_back();
+			Boxes[index] = Boxes.back(); Boxes.pop_back();
+			Ids[index] = Ids.back(); Ids.pop_back();
+		}
+
+		bool Move(size_t index, const AABB& box)
+		{
+			Boxes[index] = box;
+			return Tree.MoveProxy(Proxies[index], box);
+		}
+	};
+
+	bool Contains(const AABB& outer, const AABB& inner)
+	{
+		return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y && outer.Min.z <= inner.Min.z &&
+			outer.Max.x >= inner.Max.x && outer.Max.y >= inner.Max.y && outer.Max.z >= inner.Max.z;
+	}
+
+	bool Touch(const AABB& a, const AABB& b)
+	{
+		return a.Min.x <= b.Max.x && a.Max.x >= b.Min.x && a.Min.y <= b.Max.y && a.Max.y >= b.Min.y && a.Min.z <= b.Max.z && a.Max.z >= b.Min.z;
+	}
+
+	bool SameBox(const AABB& a, const AABB& b)
+	{
+		return a.Min.x == b.Min.x && a.Min.y == b.Min.y && a.Min.z == b.Min.z && a.Max.x == b.Max.x && a.Max.y == b.Max.y && a.Max.z == b.Max.z;
+	}
+
+	AABB Offset(const AABB& box, float x, float y, float z)
+	{
+		return AABB(XMFLOAT3(box.Min.x + x, box.Min.y + y, box.Min.z + z), XMFLOAT3(box.Max.x + x, box.Max.y + y, box.Max.z + z));
+	}
+
+	// Walks the tree from the root checking everything the queries rely on: parent
+	// links that match the child links, each interior box exactly the union of its
+	// children's, and one leaf per live proxy whose fat bounds hold its real box
+	bool IsConsistent(Scene& scene)
+	{
+		DynamicBVH& tree = scene.Tree;
+		const DynamicBVHNode* nodes = tree.GetNodes();
+		if (tree.GetProxyCount() != scene.Proxies.size())
+			return false;
+		if (tree.GetRoot() == DynamicBVH::NullNode)
+			return scene.Proxies.empty();
+		if (nodes[tree.GetRoot()].Parent != DynamicBVH::NullNode)
+			return false;
+
+		std::vector<int> leaves;
+		std::vector<int> stack(1, tree.GetRoot());
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+			const DynamicBVHNode& node = nodes[index];
+
+			if (node.Left == DynamicBVH::NullNode)
+			{
+				if (node.Right != DynamicBVH::NullNode)
+					return false;
+				leaves.push_back(index);
+				continue;
+			}
+
+			if (node.Left < 0 || node.Right < 0 || nodes[node.Left].Parent != index || nodes[node.Right].Parent != index)
+				return false;
+
+			const AABB& left = nodes[node.Left].Bounds;
+			const AABB& right = nodes[node.Right].Bounds;
+			AABB both(
+				XMFLOAT3(std::min(left.Min.x, right.Min.x), std::min(left.Min.y, right.Min.y), std::min(left.Min.z, right.Min.z)),
+				XMFLOAT3(std::max(left.Max.x, right.Max.x), std::max(left.Max.y, right.Max.y), std::max(left.Max.z, right.Max.z)));
+			if (!SameBox(node.Bounds, both))
+				return false;
+
+			stack.push_back(node.Left);
+			stack.push_back(node.Right);
+		}
+
+		// Each proxy's leaf reached once, and nothing else
+		std::vector<int> proxies = scene.Proxies;
+		std::sort(leaves.begin(), leaves.end());
+		std::sort(proxies.begin(), proxies.end());
+		if (leaves != proxies)
+			return false;
+
+		for (size_t i = 0; i < scene.Proxies.size(); i++)
+		{
+			const DynamicBVHNode& leaf = nodes[scene.Proxies[i]];
+			const AABB& fat = tree.GetFatBounds(scene.Proxies[i]);
+			if (leaf.Id != scene.Ids[i] || !SameBox(fat, leaf.Bounds) || !Contains(fat, scene.Boxes[i]))
+				return false;
+
+			// And no fatter than a margin past the box it was made for, which holds
+			// the current box too - so at most twice the margin past that
+			AABB loosest = scene.Boxes[i];
+			loosest.Expand(2 * Margin);
+			if (!Contains(loosest, fat))
+				return false;
+		}
+		return true;
+	}
+
+	std::vector<unsigned int> Sorted(const unsigned int* ids, unsigned int count)
+	{
+		std::vector<unsigned int> sorted(ids, ids + count);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted;
+	}
+
+	// Queries answer for fat bounds, so brute force tests those
+	bool QueriesMatchBruteForce(Scene& scene, const Frustum& frustum, const AABB& box)
+	{
+		std::vector<unsigned int> visible, touching;
+		for (size_t i = 0; i < scene.Proxies.size(); i++)
+		{
+			const AABB& fat = scene.Tree.GetFatBounds(scene.Proxies[i]);
+			if (frustum.Intersects(fat))
+				visible.push_back(scene.Ids[i]);
+			if (Touch(fat, box))
+				touching.push_back(scene.Ids[i]);
+		}
+		std::sort(visible.begin(), visible.end());
+		std::sort(touching.begin(), touching.end());
+
+		std::vector<unsigned int> results(scene.Proxies.size() + 1);
+		unsigned int count = scene.Tree.Cull(frustum, results.data());
+		if (Sorted(results.data(), count) != visible)
+			return false;
+		count = scene.Tree.Overlap(box, results.data());
+		return Sorted(results.data(), count) == touching;
+	}
+}
+
+TEST(TreeStaysConsistentThroughMovesAndRemoves)
+{
+	const unsigned int count = 4000;
+	Scene scene(MakeScene(count, 51));
+	CHECK(IsConsistent(scene));
+
+	std::mt19937 generator(52);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float halfWidth = 10.0f * sqrtf((float)count);
+
+	bool consistent = true, matching = true;
+	unsigned int reinserts = 0;
+	for (int frame = 0; frame < 60; frame++)
+	{
+		// A tenth jitter in place, and a few of those jump across the scene
+		for (size_t i = 0; i < scene.Proxies.size() / 10; i++)
+		{
+			size_t index = (size_t)(unit(generator) * scene.Proxies.size()) % scene.Proxies.size();
+			float reach = unit(generator) < 0.05f ? halfWidth : 1.0f;
+			AABB moved = Offset(scene.Boxes[index], (unit(generator) * 2 - 1) * reach, (unit(generator) * 2 - 1) * reach, (unit(generator) * 2 - 1) * reach);
+			reinserts += scene.Move(index, moved) ? 1 : 0;
+		}
+
+		// Things leave and arrive
+		for (int i = 0; i < 20; i++)
+			scene.Remove((size_t)(unit(generator) * scene.Proxies.size()) % scene.Proxies.size());
+		std::vector<AABB> arrivals = MakeScene(15, 1000 + frame);
+		for (const AABB& box : arrivals)
+			scene.Add(box);
+
+		scene.Tree.Optimize(64);
+
+		consistent = consistent && IsConsistent(scene);
+		XMFLOAT3 position((unit(generator) * 2 - 1) * halfWidth, 5, (unit(generator) * 2 - 1) * halfWidth);
+		AABB box = Offset(AABB(XMFLOAT3(-20, -20, -20), XMFLOAT3(20, 20, 20)), position.x, position.y, position.z);
+		matching = matching && QueriesMatchBruteForce(scene, MakeSceneFrustum(position, XMFLOAT3(unit(generator) - 0.5f, 0, 1), halfWidth), box);
+	}
+
+	CHECK(consistent);
+	CHECK(matching);
+	CHECK_EQUAL(reinserts, scene.Tree.GetUpdateStats().Reinserts);
+	CHECK(reinserts > 0);
+}
+
+TEST(MovesInsideTheFatBoundsChangeNothing)
+{
+	Scene scene(MakeScene(500, 61));
+	scene.Tree.ResetUpdateStats();
+	float cost = scene.Tree.GetCost();
+
+	for (size_t i = 0; i < scene.Proxies.size(); i++)
+	{
+		AABB fat = scene.Tree.GetFatBounds(scene.Proxies[i]);
+		CHECK(!scene.Move(i, Offset(scene.Boxes[i], Margin * 0.9f, -Margin * 0.9f, 0)));
+		CHECK(SameBox(fat, scene.Tree.GetFatBounds(scene.Proxies[i])));
+	}
+
+	CHECK_EQUAL(500u, scene.Tree.GetUpdateStats().Moves);
+	CHECK_EQUAL(0u, scene.Tree.GetUpdateStats().Reinserts);
+	CHECK_EQUAL(cost, scene.Tree.GetCost());
+	CHECK(IsConsistent(scene));
+}
+
+TEST(MovesOutOfTheFatBoundsAreFoundInTheirNewPlace)
+{
+	Scene scene(MakeScene(2000, 71));
+	AABB far(XMFLOAT3(5000, 5000, 5000), XMFLOAT3(5001, 5001, 5001));
+	std::vector<unsigned int> results(scene.Proxies.size());
+
+	CHECK_EQUAL(0u, scene.Tree.Overlap(far, results.data()));
+	CHECK(scene.Move(17, far));
+	CHECK(IsConsistent(scene));
+	CHECK_EQUAL(1u, scene.Tree.Overlap(far, results.data()));
+	CHECK_EQUAL(scene.Ids[17], results[0]);
+	CHECK(Contains(scene.Tree.GetFatBounds(scene.Proxies[17]), far));
+}
+
+TEST(OptimizeOnlyEverLowersTheCost)
+{
+	// Inserted in a sweep along x, then scrambled, which leaves a poor tree
+	std::vector<AABB> boxes = MakeScene(3000, 81);
+	std::sort(boxes.begin(), boxes.end(), [](const AABB& a, const AABB& b) { return a.Min.x < b.Min.x; });
+	Scene scene(boxes);
+
+	std::mt19937 generator(82);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	for (size_t i = 0; i < scene.Proxies.size(); i += 3)
+		scene.Move(i, Offset(scene.Boxes[i], (unit(generator) * 2 - 1) * 300, 0, (unit(generator) * 2 - 1) * 300));
+
+	scene.Tree.ResetUpdateStats();
+	float cost = scene.Tree.GetCost();
+	for (int pass = 0; pass < 10; pass++)
+	{
+		scene.Tree.Optimize(1000);
+		float optimized = scene.Tree.GetCost();
+		CHECK(optimized <= cost);
+		cost = optimized;
+	}
+	CHECK(scene.Tree.GetUpdateStats().Rotations > 0);
+	CHECK(IsConsistent(scene));
+}
+
+TEST(RemovingEverythingLeavesAnEmptyTreeThatCanBeRefilled)
+{
+	Scene scene(MakeScene(300, 91));
+	while (!scene.Proxies.empty())
+		scene.Remove(scene.Proxies.size() / 2);
+
+	CHECK(IsConsistent(scene));
+	CHECK_EQUAL(DynamicBVH::NullNode, scene.Tree.GetRoot());
+	unsigned int results[1];
+	CHECK_EQUAL(0u, scene.Tree.Overlap(AABB(XMFLOAT3(-1e6f, -1e6f, -1e6f), XMFLOAT3(1e6f, 1e6f, 1e6f)), results));
+
+	// Freed nodes are reused
+	for (const AABB& box : MakeScene(300, 92))
+		scene.Add(box);
+	CHECK(IsConsistent(scene));
+	for (int proxy : scene.Proxies)
+		CHECK(proxy < 600);
+	CHECK(QueriesMatchBruteForce(scene, MakeSceneFrustum(XMFLOAT3(0, 5, -200), XMFLOAT3(0, 0, 1), 400), AABB(XMFLOAT3(-50, -50, -50), XMFLOAT3(50, 50, 50))));
+}
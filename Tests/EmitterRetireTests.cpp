@@ -0,0 +1,183 @@
+#include "TestHarness.h"
+#include "Emitter.h"
+#include <deque>
+
+using namespace DirectX;
+
+namespace
+{
+	const float Lifetime = 1.0f;
+	const float Interval = 0.0625f;	// Exact in binary, so spawn times are too
+
+	Emitter* MakeEmitter(int maxParticles)
+	{
+		Emitter* emitter = new Emitter(
+			maxParticles, 16, Lifetime, 0.1f, 1.0f,
+			XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+			XMFLOAT3(0, 0, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 1, 0),
+			XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0), XMFLOAT4(0, 0, 0, 0));
+
+		// Only the test's own SpawnBatch calls make Particles
+		emitter->SetSpawnRateScale(0.0f);
+		return emitter;
+	}
+
+	// The ring as the test expects it, retired by checking every Particle in turn
+	struct LinearRing
+	{
+		struct Slot
+		{
+			unsigned int Index;
+			float SpawnTime;
+		};
+
+		int MaxParticles;
+		unsigned int NextIndex;
+		std::deque<Slot> Live;
+
+		LinearRing(int maxParticles) : MaxParticles(maxParticles), NextIndex(0) {}
+
+		void Spawn(int count, float spawnTime)
+		{
+			count = std::min(count, MaxParticles - (int)Live.size());
+			for (int i = 0; i < count; i++)
+			{
+				Live.push_back({ NextIndex, spawnTime + i * Interval });
+				NextIndex = (NextIndex + 1) % MaxParticles;
+			}
+		}
+
+		void Retire(float currentTime)
+		{
+			std::deque<Slot> alive;
+			for (const Slot& slot : Live)
+			{
+				if (currentTime - slot.SpawnTime < Lifetime)
+					alive.push_back(slot);
+			}
+			Live = alive;
+		}
+	};
+
+	void Spawn(Emitter* emitter, LinearRing& ring, int count, float spawnTime)
+	{
+		emitter->SpawnBatch(count, spawnTime, Interval);
+		ring.Spawn(count, spawnTime);
+	}
+
+	// Update with no time passing only retires
+	bool RetireMatches(Emitter* emitter, LinearRing& ring, float currentTime)
+	{
+		emitter->Update(0.0f, currentTime);
+		ring.Retire(currentTime);
+
+		std::vector<unsigned int> drawList(ring.MaxParticles);
+		int count = emitter->WriteDrawList(drawList.data(), 0);
+		if (count != emitter->GetLiveParticleCount() || count != (int)ring.Live.size())
+			return false;
+		for (int i = 0; i < count; i++)
+		{
+			if (drawList[i] != ring.Live[i].Index)
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST(EmptyRingStaysEmpty)
+{
+	Emitter* emitter = MakeEmitter(16);
+	LinearRing ring(16);
+
+	CHECK(RetireMatches(emitter, ring, 0.0f));
+	CHECK(RetireMatches(emitter, ring, 100.0f));
+	CHECK_EQUAL(0, emitter->GetLiveParticleCount());
+
+	// And it still spawns from the start of the array afterwards
+	Spawn(emitter, ring, 3, 100.0f);
+	CHECK(RetireMatches(emitter, ring, 100.5f));
+	CHECK_EQUAL(3, emitter->GetLiveParticleCount());
+	delete emitter;
+}
+
+TEST(NothingRetiresWhileAllAreAlive)
+{
+	Emitter* emitter = MakeEmitter(16);
+	LinearRing ring(16);
+
+	Spawn(emitter, ring, 10, 0.0f);
+	CHECK(RetireMatches(emitter, ring, 0.5625f));
+	CHECK(RetireMatches(emitter, ring, 0.99f));
+	CHECK_EQUAL(10, emitter->GetLiveParticleCount());
+	delete emitter;
+}
+
+TEST(EverythingRetiresOnceAllHaveExpired)
+{
+	Emitter* emitter = MakeEmitter(16);
+	LinearRing ring(16);
+
+	// A full ring, so the binary search starts from the widest window
+	Spawn(emitter, ring, 16, 0.0f);
+	CHECK_EQUAL(16, emitter->GetLiveParticleCount());
+	CHECK(RetireMatches(emitter, ring, 15 * Interval + Lifetime));
+	CHECK_EQUAL(0, emitter->GetLiveParticleCount());
+	delete emitter;
+}
+
+TEST(ExactlyALifetimeOldIsExpired)
+{
+	Emitter* emitter = MakeEmitter(16);
+	LinearRing ring(16);
+
+	Spawn(emitter, ring, 10, 0.0f);
+	CHECK(RetireMatches(emitter, ring, 3 * Interval + Lifetime));
+	CHECK_EQUAL(6, emitter->GetLiveParticleCount());
+	delete emitter;
+}
+
+TEST(WrappedWindowRetiresInOrder)
+{
+	Emitter* emitter = MakeEmitter(16);
+	LinearRing ring(16);
+
+	// Move the live window to the end of the array, then spawn past it
+	Spawn(emitter, ring, 12, 0.0f);
+	CHECK(RetireMatches(emitter, ring, 9.5f * Interval + Lifetime));
+	Spawn(emitter, ring, 12, 1.0f);
+	CHECK_EQUAL(14, emitter->GetLiveParticleCount());
+
+	// Step through every boundary and between them, across the wrap
+	for (int step = 0; step <= 60; step++)
+	{
+		float currentTime = 1.5f + step * (Interval / 2);
+		CHECK(RetireMatches(emitter, ring, currentTime));
+	}
+	CHECK_EQUAL(0, emitter->GetLiveParticleCount());
+	delete emitter;
+}
+
+TEST(EveryWindowMatchesALinearScan)
+{
+	// Each start position and length of window, retired at each possible split
+	const int maxParticles = 8;
+	for (int start = 0; start < maxParticles; start++)
+	{
+		for (int count = 0; count <= maxParticles; count++)
+		{
+			for (int expired = 0; expired <= count; expired++)
+			{
+				Emitter* emitter = MakeEmitter(maxParticles);
+				LinearRing ring(maxParticles);
+
+				// Spawn and retire start Particles to move the window along
+				Spawn(emitter, ring, start, 0.0f);
+				RetireMatches(emitter, ring, 100.0f);
+
+				Spawn(emitter, ring, count, 200.0f);
+				CHECK(RetireMatches(emitter, ring, 200.0f + Lifetime + (expired - 0.5f) * Interval));
+				delete emitter;
+			}
+		}
+	}
+}
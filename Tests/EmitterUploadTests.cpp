@@ -0,0 +1,154 @@
+#include "TestHarness.h"
+#include "Recording.h"
+#include "Emitter.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT ParticleBytes = sizeof(Particle);
+
+	// Lives one second and never spawns on its own, so tests control every spawn
+	Emitter* MakeEmitter(int maxParticles)
+	{
+		Emitter* emitter = new Emitter(
+			maxParticles, 100, 1.0f, 0.1f, 1.0f,
+			XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+			XMFLOAT3(0, 0, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 1, 0),
+			XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(1, 1, 1), XMFLOAT4(0, 1, 0, 1),
+			7);
+		emitter->SetSpawnRateScale(0.0f);
+		return emitter;
+	}
+
+	RecordingBuffer* MakeParticleBuffer(RecordingDevice& device, int particleCount)
+	{
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = ParticleBytes * particleCount;
+		desc.Usage = D3D11_USAGE_DEFAULT;
+		ID3D11Buffer* buffer = 0;
+		device.CreateBuffer(&desc, 0, &buffer);
+		return (RecordingBuffer*)buffer;
+	}
+
+	float SpawnTimeAt(RecordingBuffer* buffer, int index)
+	{
+		Particle particle;
+		memcpy(&particle, buffer->Data.data() + ParticleBytes * index, ParticleBytes);
+		return particle.SpawnTime;
+	}
+}
+
+TEST(FewSpawnsUploadOnlyThemselves)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	RecordingBuffer* buffer = MakeParticleBuffer(device, 100000);
+	Emitter* emitter = MakeEmitter(100000);
+
+	emitter->SpawnBatch(10, 0.0f, 0.25f);
+	emitter->UploadPending(&context, buffer, 0);
+
+	std::vector<RecordedCall> updates = context.CallsNamed("UpdateSubresource");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK(updates[0].HasBox);
+	CHECK_EQUAL(0u, updates[0].Box.left);
+	CHECK_EQUAL(10 * ParticleBytes, updates[0].Box.right);
+	CHECK_EQUAL(10 * ParticleBytes, context.BytesUpdated());
+	CHECK_EQUAL(10 * ParticleBytes, emitter->GetBytesUploaded());
+	CHECK_EQUAL(2.25f, SpawnTimeAt(buffer, 9));
+
+	// Nothing new, nothing sent
+	context.Clear();
+	emitter->UploadPending(&context, buffer, 0);
+	CHECK_EQUAL(0u, context.CountCalls("UpdateSubresource"));
+	CHECK_EQUAL(0u, emitter->GetBytesUploaded());
+
+	delete emitter;
+}
+
+TEST(UploadsLandAfterBaseIndex)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	RecordingBuffer* buffer = MakeParticleBuffer(device, 200);
+	Emitter* emitter = MakeEmitter(100);
+
+	emitter->SpawnBatch(5, 2.0f, 0.0f);
+	emitter->UploadPending(&context, buffer, 100);
+
+	std::vector<RecordedCall> updates = context.CallsNamed("UpdateSubresource");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK_EQUAL(100 * ParticleBytes, updates[0].Box.left);
+	CHECK_EQUAL(105 * ParticleBytes, updates[0].Box.right);
+	CHECK_EQUAL(2.0f, SpawnTimeAt(buffer, 104));
+	CHECK_EQUAL(0.0f, SpawnTimeAt(buffer, 99));
+
+	delete emitter;
+}
+
+TEST(WrappedSpawnsUploadAsTwoRanges)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	RecordingBuffer* buffer = MakeParticleBuffer(device, 16);
+	Emitter* emitter = MakeEmitter(16);
+
+	// Fill most of the ring, then let all of it die
+	emitter->SpawnBatch(12, 0.0f, 0.0f);
+	emitter->UploadPending(&context, buffer, 0);
+	emitter->Update(0.0f, 1.5f);
+	CHECK_EQUAL(0, emitter->GetLiveParticleCount());
+
+	// The next eight run off the end of the ring and back to the start
+	context.Clear();
+	emitter->SpawnBatch(8, 1.5f, 0.0f);
+	emitter->UploadPending(&context, buffer, 0);
+
+	std::vector<RecordedCall> updates = context.CallsNamed("UpdateSubresource");
+	CHECK_EQUAL(2u, (unsigned int)updates.size());
+	CHECK_EQUAL(12 * ParticleBytes, updates[0].Box.left);
+	CHECK_EQUAL(16 * ParticleBytes, updates[0].Box.right);
+	CHECK_EQUAL(0u, updates[1].Box.left);
+	CHECK_EQUAL(4 * ParticleBytes, updates[1].Box.right);
+	CHECK_EQUAL(8 * ParticleBytes, emitter->GetBytesUploaded());
+	CHECK_EQUAL(1.5f, SpawnTimeAt(buffer, 15));
+	CHECK_EQUAL(1.5f, SpawnTimeAt(buffer, 0));
+
+	delete emitter;
+}
+
+TEST(ParticlesDeadBeforeUploadAreNotSent)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	RecordingBuffer* buffer = MakeParticleBuffer(device, 64);
+	Emitter* emitter = MakeEmitter(64);
+
+	emitter->SpawnBatch(10, 0.0f, 0.0f);
+	emitter->Update(0.0f, 1.5f);
+	emitter->UploadPending(&context, buffer, 0);
+
+	CHECK_EQUAL(0u, context.CountCalls("UpdateSubresource"));
+	CHECK_EQUAL(0u, emitter->GetBytesUploaded());
+
+	delete emitter;
+}
+
+TEST(InvalidateUploadsResendsEveryLiveParticle)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	RecordingBuffer* buffer = MakeParticleBuffer(device, 64);
+	Emitter* emitter = MakeEmitter(64);
+
+	emitter->SpawnBatch(20, 0.0f, 0.0f);
+	emitter->UploadPending(&context, buffer, 0);
+
+	context.Clear();
+	emitter->InvalidateUploads();
+	emitter->UploadPending(&context, buffer, 0);
+	CHECK_EQUAL(20 * ParticleBytes, context.BytesUpdated());
+
+	delete emitter;
+}
@@ -0,0 +1,85 @@
+// Frustum culling many volumes: the SIMD kernel, the same test one volume
+// at a time, and Frustum::Intersects on each box as the game used to.
+#include "Bench.h"
+#include "FrustumCuller.h"
+#include <random>
+
+using namespace DirectX;
+
+static const int Repeats = 10;
+
+int main()
+{
+#if defined(__AVX__)
+	printf("Kernel built for AVX\n");
+#else
+	printf("Kernel built for SSE\n");
+#endif
+
+	XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0, 0, 0, 0), XMVectorSet(0.3f, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 500.0f);
+	Frustum frustum(XMMatrixMultiply(view, projection));
+
+	unsigned int counts[] = { 10000, 100000, 1000000 };
+	for (unsigned int count : counts)
+	{
+		std::mt19937 generator(42);
+		std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+		std::uniform_real_distribution<float> size(0.1f, 5.0f);
+
+		FrustumCuller culler;
+		culler.Resize(count);
+		std::vector<AABB> boxes(count);
+		for (unsigned int i = 0; i < count; i++)
+		{
+			XMFLOAT3 center(position(generator), position(generator) * 0.1f, position(generator));
+			float extent = size(generator);
+			boxes[i] = AABB(XMFLOAT3(center.x - extent, center.y - extent, center.z - extent), XMFLOAT3(center.x + extent, center.y + extent, center.z + extent));
+			BoundingSphere sphere = { center, extent * 1.7320508f };
+			culler.SetBounds(i, boxes[i], sphere);
+		}
+
+		std::vector<unsigned int> visible(count);
+		unsigned int visibleCount = 0;
+		double kernel = BestMilliseconds(Repeats, [&]() { visibleCount = culler.Cull(frustum, visible.data()); });
+
+		// The raw kernels on the same data, without turning masks into a list
+		unsigned int blockCount = (count + FrustumCuller::Width - 1) / FrustumCuller::Width;
+		std::vector<float> cx(blockCount * FrustumCuller::Width), cy(cx.size()), cz(cx.size());
+		std::vector<float> ex(cx.size()), ey(cx.size()), ez(cx.size()), r(cx.size());
+		for (unsigned int i = 0; i < count; i++)
+		{
+			XMFLOAT3 center = boxes[i].GetCenter();
+			XMFLOAT3 extents = boxes[i].GetExtents();
+			cx[i] = center.x; cy[i] = center.y; cz[i] = center.z;
+			ex[i] = extents.x; ey[i] = extents.y; ez[i] = extents.z;
+			r[i] = extents.x * 1.7320508f;
+		}
+		std::vector<unsigned char> masks(blockCount);
+		double blocks = BestMilliseconds(Repeats, [&]()
+		{
+			FrustumCuller::CullBlocks(frustum, cx.data(), cy.data(), cz.data(), ex.data(), ey.data(), ez.data(), r.data(), blockCount, masks.data());
+			KeepResult(masks[0]);
+		});
+		double scalar = BestMilliseconds(Repeats, [&]()
+		{
+			FrustumCuller::CullBlocksScalar(frustum, cx.data(), cy.data(), cz.data(), ex.data(), ey.data(), ez.data(), r.data(), blockCount, masks.data());
+			KeepResult(masks[0]);
+		});
+
+		unsigned int intersecting = 0;
+		double perBox = BestMilliseconds(Repeats, [&]()
+		{
+			intersecting = 0;
+			for (unsigned int i = 0; i < count; i++)
+				intersecting += frustum.Intersects(boxes[i]) ? 1 : 0;
+		});
+
+		printf("%u volumes (%u visible, %u boxes intersecting):\n", count, visibleCount, intersecting);
+		printf("  FrustumCuller::Cull      %8.3f ms\n", kernel);
+		printf("  CullBlocks               %8.3f ms\n", blocks);
+		printf("  CullBlocksScalar         %8.3f ms  (%.1fx)\n", scalar, scalar / blocks);
+		printf("  Frustum::Intersects each %8.3f ms  (%.1fx)\n", perBox, perBox / blocks);
+	}
+	return 0;
+}
@@ -0,0 +1,142 @@
+#include "TestHarness.h"
+#include "FrustumCuller.h"
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	struct Volumes
+	{
+		std::vector<float> CenterX, CenterY, CenterZ;
+		std::vector<float> ExtentX, ExtentY, ExtentZ;
+		std::vector<float> Radius;
+	};
+
+	// Boxes of every size scattered around and behind the camera, including
+	// flat ones, points, and spheres much tighter and much looser than their box
+	Volumes MakeVolumes(unsigned int count, unsigned int seed)
+	{
+		std::mt19937 generator(seed);
+		std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+		std::uniform_real_distribution<float> size(0.0f, 20.0f);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		Volumes volumes;
+		for (unsigned int i = 0; i < count; i++)
+		{
+			volumes.CenterX.push_back(position(generator));
+			volumes.CenterY.push_back(position(generator));
+			volumes.CenterZ.push_back(position(generator));
+
+			float x = i % 7 == 0 ? 0.0f : size(generator);
+			float y = i % 11 == 0 ? 0.0f : size(generator);
+			float z = size(generator);
+			volumes.ExtentX.push_back(x);
+			volumes.ExtentY.push_back(y);
+			volumes.ExtentZ.push_back(z);
+			volumes.Radius.push_back(sqrtf(x * x + y * y + z * z) * (0.5f + unit(generator)));
+		}
+		return volumes;
+	}
+
+	Frustum MakeFrustum(XMFLOAT3 position, XMFLOAT3 direction)
+	{
+		XMMATRIX view = XMMatrixLookToLH(XMLoadFloat3(&position), XMLoadFloat3(&direction), XMVectorSet(0, 1, 0, 0));
+		XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 16.0f / 9.0f, 0.1f, 150.0f);
+		return Frustum(XMMatrixMultiply(view, projection));
+	}
+
+	std::vector<unsigned char> Masks(const Frustum& frustum, const Volumes& volumes, bool scalar)
+	{
+		unsigned int blockCount = (unsigned int)volumes.Radius.size() / FrustumCuller::Width;
+		std::vector<unsigned char> masks(blockCount, 0xCD);
+		(scalar ? FrustumCuller::CullBlocksScalar : FrustumCuller::CullBlocks)(frustum,
+			volumes.CenterX.data(), volumes.CenterY.data(), volumes.CenterZ.data(),
+			volumes.ExtentX.data(), volumes.ExtentY.data(), volumes.ExtentZ.data(),
+			volumes.Radius.data(), blockCount, masks.data());
+		return masks;
+	}
+}
+
+TEST(KernelMatchesTheScalarReference)
+{
+	Volumes volumes = MakeVolumes(FrustumCuller::Width * 2000, 5);
+
+	XMFLOAT3 cameras[][2] =
+	{
+		{ XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 1) },
+		{ XMFLOAT3(10, 50, -30), XMFLOAT3(1, -1, 0.5f) },
+		{ XMFLOAT3(-100, 0, 100), XMFLOAT3(-0.3f, 0.1f, -1) },
+	};
+
+	for (auto& camera : cameras)
+	{
+		Frustum frustum = MakeFrustum(camera[0], camera[1]);
+		std::vector<unsigned char> kernel = Masks(frustum, volumes, false);
+		std::vector<unsigned char> scalar = Masks(frustum, volumes, true);
+		CHECK(kernel == scalar);
+
+		// Not everything in or everything out, or the comparison proves little
+		unsigned int visible = 0;
+		for (unsigned char mask : scalar)
+			for (unsigned int lane = 0; lane < FrustumCuller::Width; lane++)
+				visible += (mask >> lane) & 1;
+		CHECK(visible > 0 && visible < volumes.Radius.size() / 2);
+	}
+}
+
+TEST(TouchingAPlaneCountsAsVisible)
+{
+	// An axis-aligned frustum that's easy to place things against: the left plane is x >= -1
+	Frustum frustum;
+	frustum.planes[0] = XMFLOAT4(1, 0, 0, 1);
+	for (int p = 1; p < 6; p++)
+		frustum.planes[p] = XMFLOAT4(0, 0, 0, 1);
+
+	Volumes volumes;
+	float centers[FrustumCuller::Width] = { -2, -2, -2, -3, -1, -0.5f, -5, -2.01f };
+	float extents[FrustumCuller::Width] = { 1, 1, 0.5f, 2, 0, 0, 4, 1 };
+	float radii[FrustumCuller::Width] = { 1, 0.5f, 1, 2, 0, 0, 100, 1 };
+	for (unsigned int i = 0; i < FrustumCuller::Width; i++)
+	{
+		volumes.CenterX.push_back(centers[i]);
+		volumes.CenterY.push_back(0);
+		volumes.CenterZ.push_back(0);
+		volumes.ExtentX.push_back(extents[i]);
+		volumes.ExtentY.push_back(0);
+		volumes.ExtentZ.push_back(0);
+		volumes.Radius.push_back(radii[i]);
+	}
+
+	// Touching, sphere short, box short, touching, point on the plane, inside, reaches, just short
+	unsigned char expected = 0x01 | 0x08 | 0x10 | 0x20 | 0x40;
+	CHECK_EQUAL(expected, Masks(frustum, volumes, false)[0]);
+	CHECK_EQUAL(expected, Masks(frustum, volumes, true)[0]);
+}
+
+TEST(CullListsVisibleVolumesAndIgnoresPadding)
+{
+	// The padding past 13 sits at the origin, which this camera can see
+	Frustum frustum = MakeFrustum(XMFLOAT3(0, 0, -10), XMFLOAT3(0, 0, 1));
+
+	FrustumCuller culler;
+	culler.Resize(13);
+	for (unsigned int i = 0; i < 13; i++)
+	{
+		// Even ones in front of the camera, odd ones behind it
+		float z = i % 2 == 0 ? (float)i : -50.0f - i;
+		AABB box(XMFLOAT3(-1, -1, z - 1), XMFLOAT3(1, 1, z + 1));
+		BoundingSphere sphere = { XMFLOAT3(0, 0, z), 2.0f };
+		culler.SetBounds(i, box, sphere);
+	}
+
+	std::vector<unsigned int> visible(culler.GetCount());
+	unsigned int visibleCount = culler.Cull(frustum, visible.data());
+	visible.resize(visibleCount);
+
+	CHECK(visible == std::vector<unsigned int>({ 0, 2, 4, 6, 8, 10, 12 }));
+	CHECK_EQUAL(13u, culler.GetStats().Tested);
+	CHECK_EQUAL(7u, culler.GetStats().Visible);
+	CHECK_EQUAL(6u, culler.GetStats().Culled);
+}
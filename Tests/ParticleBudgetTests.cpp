@@ -0,0 +1,137 @@
+#include "TestHarness.h"
+#include "Emitter.h"
+#include "ParticleBudget.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// 200 a second for a second, so it settles at 200 live Particles
+	Emitter* MakeEmitter(int maxParticles, unsigned int seed)
+	{
+		return new Emitter(
+			maxParticles, 200, 1.0f, 0.1f, 1.0f,
+			XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+			XMFLOAT3(0, 0, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 1, 0),
+			XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(1, 1, 1), XMFLOAT4(0, 1, 0, 1),
+			seed);
+	}
+}
+
+TEST(ShrinkingTheQuotaRetiresTheOldestAtOnce)
+{
+	Emitter* emitter = MakeEmitter(16, 1);
+	emitter->SetSpawnRateScale(0.0f);
+
+	emitter->SpawnBatch(12, 0.0f, 0.01f);
+	emitter->SetLiveQuota(4);
+	CHECK_EQUAL(4, emitter->GetLiveParticleCount());
+
+	unsigned int drawList[16];
+	CHECK_EQUAL(4, emitter->WriteDrawList(drawList, 0));
+	CHECK_EQUAL(8u, drawList[0]);
+	CHECK_EQUAL(11u, drawList[3]);
+
+	// Spawning is held to the quota too
+	emitter->SpawnBatch(4, 0.12f, 0.01f);
+	CHECK_EQUAL(4, emitter->GetLiveParticleCount());
+
+	// Wrap the ring, so the survivors straddle its end
+	emitter->SetLiveQuota(16);
+	emitter->SpawnBatch(8, 0.12f, 0.01f);
+	CHECK_EQUAL(12, emitter->GetLiveParticleCount());
+	emitter->SetLiveQuota(6);
+	CHECK_EQUAL(6, emitter->GetLiveParticleCount());
+
+	// The six newest are left, oldest first
+	unsigned int expected[] = { 14, 15, 0, 1, 2, 3 };
+	CHECK_EQUAL(6, emitter->WriteDrawList(drawList, 0));
+	for (int i = 0; i < 6; i++)
+		CHECK_EQUAL(expected[i], drawList[i]);
+
+	// Raising the quota again brings nothing back
+	emitter->SetLiveQuota(16);
+	CHECK_EQUAL(6, emitter->GetLiveParticleCount());
+
+	delete emitter;
+}
+
+TEST(NegativeQuotasMeanNone)
+{
+	Emitter* emitter = MakeEmitter(100, 2);
+	emitter->SpawnBatch(50, 0.0f, 0.001f);
+
+	emitter->SetLiveQuota(-5);
+	CHECK_EQUAL(0, emitter->GetLiveParticleCount());
+	emitter->SpawnBatch(10, 0.1f, 0.001f);
+	CHECK_EQUAL(0, emitter->GetLiveParticleCount());
+	emitter->Update(0.5f, 0.6f);
+	CHECK_EQUAL(0, emitter->GetLiveParticleCount());
+
+	delete emitter;
+}
+
+TEST(BudgetTotalIsNeverExceeded)
+{
+	const int EmitterCount = 6;
+	std::vector<Emitter*> emitters;
+	for (int i = 0; i < EmitterCount; i++)
+	{
+		emitters.push_back(MakeEmitter(400, 10 + i));
+		emitters[i]->SetPriority(1.0f + i);
+		emitters[i]->Prewarm(2.0f, 0.0f);
+	}
+
+	// Room for all of them to start with, then a sudden squeeze, a slow
+	// recovery, and another squeeze - checked straight after each change
+	ParticleBudget budget;
+	std::vector<ParticleBudgetRequest> requests(EmitterCount);
+	std::vector<int> quotas;
+	std::vector<float> scales;
+	int budgets[] = { 0, 300, 300, 600, 900, 1200, 150, 150, 0, 75 };
+
+	bool withinBudget = true;
+	float time = 0;
+	for (int step = 0; step < 10; step++)
+	{
+		budget.SetMaxLiveParticles(budgets[step]);
+		for (int frame = 0; frame < 30; frame++)
+		{
+			time += 1.0f / 60.0f;
+			for (int i = 0; i < EmitterCount; i++)
+			{
+				requests[i].Demand = emitters[i]->GetSteadyStateCount();
+				requests[i].Weight = emitters[i]->GetPriority();
+			}
+			budget.Allocate(requests, 1.0f / 60.0f, quotas, scales);
+
+			int total = 0;
+			for (int i = 0; i < EmitterCount; i++)
+			{
+				emitters[i]->SetLiveQuota(quotas[i]);
+				emitters[i]->SetSpawnRateScale(scales[i]);
+				total += emitters[i]->GetLiveParticleCount();
+			}
+			withinBudget = withinBudget && (budgets[step] == 0 || total <= budgets[step]);
+
+			total = 0;
+			for (int i = 0; i < EmitterCount; i++)
+			{
+				emitters[i]->Update(1.0f / 60.0f, time);
+				total += emitters[i]->GetLiveParticleCount();
+			}
+			withinBudget = withinBudget && (budgets[step] == 0 || total <= budgets[step]);
+		}
+	}
+	CHECK(withinBudget);
+
+	// The last squeeze took effect on the frame it happened
+	int total = 0;
+	for (Emitter* emitter : emitters)
+		total += emitter->GetLiveParticleCount();
+	CHECK(total <= 75);
+	CHECK(total > 0);
+
+	for (Emitter* emitter : emitters)
+		delete emitter;
+}
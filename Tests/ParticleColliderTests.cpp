@@ -0,0 +1,233 @@
+#include "TestHarness.h"
+#include "Emitter.h"
+#include "ParticleCollider.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const XMFLOAT3 Gravity(0, -9.8f, 0);
+
+	Particle MakeParticle(float spawnTime, XMFLOAT3 position, XMFLOAT3 velocity)
+	{
+		Particle p = {};
+		p.SpawnTime = spawnTime;
+		p.StartPosition = position;
+		p.StartVelocity = velocity;
+		return p;
+	}
+
+	// The closed-form path every Particle follows, as the vertex shader evaluates it
+	XMFLOAT3 PositionAt(const Particle& p, XMFLOAT3 a, float time)
+	{
+		float t = time - p.SpawnTime;
+		return XMFLOAT3(
+			p.StartPosition.x + p.StartVelocity.x * t + a.x * t * t / 2,
+			p.StartPosition.y + p.StartVelocity.y * t + a.y * t * t / 2,
+			p.StartPosition.z + p.StartVelocity.z * t + a.z * t * t / 2);
+	}
+
+	XMFLOAT3 VelocityAt(const Particle& p, XMFLOAT3 a, float time)
+	{
+		float t = time - p.SpawnTime;
+		return XMFLOAT3(p.StartVelocity.x + a.x * t, p.StartVelocity.y + a.y * t, p.StartVelocity.z + a.z * t);
+	}
+
+	bool Near(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		return fabsf(a.x - b.x) < 1e-4f && fabsf(a.y - b.y) < 1e-4f && fabsf(a.z - b.z) < 1e-4f;
+	}
+
+	float Dot(XMFLOAT3 a, XMFLOAT3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	XMFLOAT3 Add(XMFLOAT3 a, XMFLOAT3 b, float scale) { return XMFLOAT3(a.x + b.x * scale, a.y + b.y * scale, a.z + b.z * scale); }
+
+	// What a bounce off a surface with normal n should leave behind
+	XMFLOAT3 Reflected(XMFLOAT3 velocity, XMFLOAT3 n, float restitution, float friction)
+	{
+		float normalSpeed = Dot(velocity, n);
+		XMFLOAT3 tangent = Add(velocity, n, -normalSpeed);
+		return Add(XMFLOAT3(tangent.x * (1 - friction), tangent.y * (1 - friction), tangent.z * (1 - friction)), n, -normalSpeed * restitution);
+	}
+
+	bool SameParticle(const Particle& a, const Particle& b)
+	{
+		return memcmp(&a, &b, sizeof(Particle)) == 0;
+	}
+}
+
+TEST(PlanePushesOutAndReflects)
+{
+	ParticleCollider collider(ParticleCollisionResponse::Bounce, 0.5f, 0.1f);
+	collider.AddPlane(XMFLOAT3(0, 2, 0), 1.0f);	// y >= -1, normalized on the way in
+
+	Particle particles[3] =
+	{
+		MakeParticle(0.0f, XMFLOAT3(0, 1, 0), XMFLOAT3(2, -3, 1)),	// Falls through by 0.5
+		MakeParticle(0.0f, XMFLOAT3(0, -4, 0), XMFLOAT3(0, 8, 0)),	// Below, but already climbing out
+		MakeParticle(0.0f, XMFLOAT3(0, 5, 0), XMFLOAT3(1, 0, 0))	// Well above
+	};
+	Particle before[3];
+	std::copy(particles, particles + 3, before);
+
+	const float now = 0.5f;
+	std::vector<int> hits;
+	collider.Collide(particles, 0, 3, Gravity, now, hits);
+	CHECK(hits == std::vector<int>({ 0, 1 }));
+
+	// Onto the plane, with the velocity bounced
+	XMFLOAT3 fell = PositionAt(before[0], Gravity, now);
+	CHECK(Near(XMFLOAT3(fell.x, -1, fell.z), PositionAt(particles[0], Gravity, now)));
+	CHECK(Near(Reflected(VelocityAt(before[0], Gravity, now), XMFLOAT3(0, 1, 0), 0.5f, 0.1f), VelocityAt(particles[0], Gravity, now)));
+
+	// Pushed out, but it was already leaving, so its velocity is kept
+	XMFLOAT3 climbing = PositionAt(before[1], Gravity, now);
+	CHECK(Near(XMFLOAT3(climbing.x, -1, climbing.z), PositionAt(particles[1], Gravity, now)));
+	CHECK(Near(VelocityAt(before[1], Gravity, now), VelocityAt(particles[1], Gravity, now)));
+
+	CHECK(SameParticle(before[2], particles[2]));
+	CHECK_EQUAL(0u, particles[0].Flags);
+	CHECK_EQUAL(0.0f, particles[0].SpawnTime);
+}
+
+TEST(RebasedPathCarriesOnFromTheBounce)
+{
+	ParticleCollider collider(ParticleCollisionResponse::Bounce, 0.8f, 0.25f);
+	collider.AddPlane(XMFLOAT3(0, 1, 0), 0.0f);
+
+	Particle particle = MakeParticle(1.0f, XMFLOAT3(-1, 2, 3), XMFLOAT3(1.5f, 0, -0.5f));
+	const float now = 1.75f;
+	XMFLOAT3 position = PositionAt(particle, Gravity, now);
+	XMFLOAT3 velocity = VelocityAt(particle, Gravity, now);
+	CHECK(position.y < 0);
+
+	std::vector<int> hits;
+	collider.Collide(&particle, 0, 1, Gravity, now, hits);
+	CHECK_EQUAL(1u, (unsigned int)hits.size());
+	CHECK_EQUAL(1.0f, particle.SpawnTime);
+
+	// At the moment of the bounce, the new start values reproduce the bounced state
+	XMFLOAT3 bouncedVelocity = Reflected(velocity, XMFLOAT3(0, 1, 0), 0.8f, 0.25f);
+	CHECK(Near(XMFLOAT3(position.x, 0, position.z), PositionAt(particle, Gravity, now)));
+	CHECK(Near(bouncedVelocity, VelocityAt(particle, Gravity, now)));
+
+	// And afterwards it flies on from there under the same acceleration
+	const float dt = 0.1f;
+	XMFLOAT3 later = Add(Add(XMFLOAT3(position.x, 0, position.z), bouncedVelocity, dt), Gravity, dt * dt / 2);
+	CHECK(Near(later, PositionAt(particle, Gravity, now + dt)));
+}
+
+TEST(BoxesPushOutThroughTheNearestFace)
+{
+	// Turned 30 degrees about y, and longer along its own z
+	float angle = XM_PI / 6;
+	ParticleColliderBox box;
+	box.Center = XMFLOAT3(10, 0, -4);
+	box.Axes[0] = XMFLOAT3(cosf(angle), 0, -sinf(angle));
+	box.Axes[1] = XMFLOAT3(0, 1, 0);
+	box.Axes[2] = XMFLOAT3(sinf(angle), 0, cosf(angle));
+	box.HalfExtents = XMFLOAT3(2, 1, 3);
+
+	ParticleCollider collider(ParticleCollisionResponse::Bounce, 1.0f, 0.0f);
+	collider.AddBox(box);
+
+	// Just inside each of the six faces, moving inwards, with no gravity to muddy things
+	const XMFLOAT3 none(0, 0, 0);
+	float extents[3] = { 2, 1, 3 };
+	std::vector<Particle> particles;
+	std::vector<XMFLOAT3> normals;
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (float sign = -1; sign <= 1; sign += 2)
+		{
+			XMFLOAT3 n(box.Axes[axis].x * sign, box.Axes[axis].y * sign, box.Axes[axis].z * sign);
+			XMFLOAT3 inside = Add(box.Center, n, extents[axis] - 0.2f);
+			particles.push_back(MakeParticle(0.0f, inside, XMFLOAT3(-n.x + 0.3f, -n.y, -n.z)));
+			normals.push_back(n);
+		}
+	}
+	std::vector<Particle> before = particles;
+
+	std::vector<int> hits;
+	collider.Collide(particles.data(), 0, (int)particles.size(), none, 0.0f, hits);
+	CHECK_EQUAL(6u, (unsigned int)hits.size());
+
+	for (size_t i = 0; i < particles.size(); i++)
+	{
+		// On the face it was nearest, going back out the way it came
+		int axis = (int)i / 2;
+		XMFLOAT3 onFace = Add(box.Center, normals[i], extents[axis]);
+		XMFLOAT3 expectedPosition = Add(before[i].StartPosition, normals[i], 0.2f);
+		CHECK(fabsf(Dot(Add(expectedPosition, onFace, -1), normals[i])) < 1e-4f);
+		CHECK(Near(expectedPosition, PositionAt(particles[i], none, 0.0f)));
+		CHECK(Near(Reflected(before[i].StartVelocity, normals[i], 1.0f, 0.0f), VelocityAt(particles[i], none, 0.0f)));
+	}
+
+	// Off towards one end of the long axis, but nearer the top, so it leaves through the top
+	XMFLOAT3 offCenter = Add(Add(box.Center, box.Axes[1], 0.5f), box.Axes[2], 2.2f);
+	Particle deep = MakeParticle(0.0f, offCenter, XMFLOAT3(0, 0, 0));
+	hits.clear();
+	collider.Collide(&deep, 0, 1, none, 0.0f, hits);
+	CHECK(Near(Add(offCenter, box.Axes[1], 0.5f), deep.StartPosition));
+}
+
+TEST(KillResponseFlagsWithoutMoving)
+{
+	ParticleCollider collider(ParticleCollisionResponse::Kill);
+	collider.AddPlane(XMFLOAT3(0, 1, 0), 0.0f);
+
+	Particle particles[3] =
+	{
+		MakeParticle(0.0f, XMFLOAT3(0, -1, 0), XMFLOAT3(0, 0, 0)),
+		MakeParticle(0.0f, XMFLOAT3(0, 1, 0), XMFLOAT3(0, 0, 0)),
+		MakeParticle(0.0f, XMFLOAT3(0, -2, 0), XMFLOAT3(0, 0, 0))
+	};
+	particles[2].Flags = ParticleFlagKilled;
+	Particle before[3];
+	std::copy(particles, particles + 3, before);
+
+	std::vector<int> hits;
+	collider.Collide(particles, 0, 3, Gravity, 0.25f, hits);
+
+	// Killed ones aren't hit again
+	CHECK(hits == std::vector<int>({ 0 }));
+	CHECK_EQUAL((unsigned int)ParticleFlagKilled, particles[0].Flags);
+	before[0].Flags = ParticleFlagKilled;
+	for (int i = 0; i < 3; i++)
+		CHECK(SameParticle(before[i], particles[i]));
+}
+
+TEST(PartialBatchesTouchOnlyTheirParticles)
+{
+	ParticleCollider collider;
+	collider.AddPlane(XMFLOAT3(0, 1, 0), 0.0f);
+
+	const int start = 5;
+	for (int count = 1; count <= 23; count++)
+	{
+		// Everything below the plane, including the Particles on either side of the range
+		std::vector<Particle> particles;
+		for (int i = 0; i < start + count + 8; i++)
+			particles.push_back(MakeParticle(0.0f, XMFLOAT3((float)i, -1.0f - (i % 3), 0), XMFLOAT3(0, -1, 0)));
+		std::vector<Particle> before = particles;
+
+		std::vector<int> hits;
+		collider.Collide(particles.data(), start, count, Gravity, 0.1f, hits);
+
+		std::vector<int> expected;
+		for (int i = start; i < start + count; i++)
+			expected.push_back(i);
+		std::sort(hits.begin(), hits.end());
+		CHECK(hits == expected);
+
+		for (int i = 0; i < (int)particles.size(); i++)
+		{
+			bool inRange = i >= start && i < start + count;
+			if (inRange)
+				CHECK(fabsf(PositionAt(particles[i], Gravity, 0.1f).y) < 1e-4f);
+			else
+				CHECK(SameParticle(before[i], particles[i]));
+		}
+	}
+}
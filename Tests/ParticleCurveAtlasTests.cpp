@@ -0,0 +1,143 @@
+#include "TestHarness.h"
+#include "Recording.h"
+#include "ParticleCurveAtlas.h"
+#include <math.h>
+
+using namespace DirectX;
+
+namespace
+{
+	const int Last = ParticleCurveAtlas::SamplesPerRow - 1;
+
+	// Three rows whose ends differ, so reading past a row's edge shows:
+	// sizes 0 to 31 (one per sample), a step from 100 to 200, and a
+	// three-key color with the default size and rotation
+	void AddRows(ParticleCurveAtlas& atlas)
+	{
+		atlas.AddLinearRow(XMFLOAT4(0, 0, 0, 1), XMFLOAT4(1, 1, 1, 0), 0.0f, (float)Last);
+		atlas.AddRow(
+			{ { 0.0f, XMFLOAT4(1, 0, 0, 1) } },
+			{ { 0.0f, 100.0f }, { 0.49f, 100.0f }, { 0.51f, 200.0f }, { 1.0f, 200.0f } },
+			{ { 0.0f, 0.25f } });
+		atlas.AddRow(
+			{ { 0.0f, XMFLOAT4(1, 1, 0, 1) }, { 0.3f, XMFLOAT4(1, 0.5f, 0, 1) }, { 1.0f, XMFLOAT4(0.2f, 0.2f, 0.2f, 0) } },
+			{}, {});
+	}
+
+	// The rows as they were sent to the GPU
+	const ParticleCurveSample* Baked(RecordingDevice& device, ParticleCurveAtlas& atlas)
+	{
+		atlas.GetSRV(&device);
+		return (const ParticleCurveSample*)device.Buffers.back()->Data.data();
+	}
+
+	bool Near(float a, float b)
+	{
+		return fabsf(a - b) <= 1e-4f * fmaxf(1.0f, fabsf(b));
+	}
+
+	bool Near(const ParticleCurveSample& a, const ParticleCurveSample& b)
+	{
+		return Near(a.Color.x, b.Color.x) && Near(a.Color.y, b.Color.y) && Near(a.Color.z, b.Color.z) &&
+			Near(a.Color.w, b.Color.w) && Near(a.Size, b.Size) && Near(a.Rotation, b.Rotation);
+	}
+
+	bool Same(const ParticleCurveSample& a, const ParticleCurveSample& b)
+	{
+		return a.Color.x == b.Color.x && a.Color.y == b.Color.y && a.Color.z == b.Color.z &&
+			a.Color.w == b.Color.w && a.Size == b.Size && a.Rotation == b.Rotation;
+	}
+
+	ParticleCurveSample Halfway(const ParticleCurveSample& a, const ParticleCurveSample& b)
+	{
+		ParticleCurveSample half = {};
+		half.Color = XMFLOAT4((a.Color.x + b.Color.x) / 2, (a.Color.y + b.Color.y) / 2, (a.Color.z + b.Color.z) / 2, (a.Color.w + b.Color.w) / 2);
+		half.Size = (a.Size + b.Size) / 2;
+		half.Rotation = (a.Rotation + b.Rotation) / 2;
+		return half;
+	}
+}
+
+TEST(SamplingAtATexelGivesThatTexel)
+{
+	RecordingDevice device;
+	ParticleCurveAtlas atlas;
+	AddRows(atlas);
+	const ParticleCurveSample* baked = Baked(device, atlas);
+
+	for (int row = 0; row < atlas.GetRowCount(); row++)
+		for (int i = 0; i <= Last; i++)
+			CHECK(Near(atlas.Sample(row, (float)i / Last), baked[row * ParticleCurveAtlas::SamplesPerRow + i]));
+
+	// The linear row holds one size per sample
+	CHECK(Near(baked[7].Size, 7.0f));
+}
+
+TEST(SamplingBetweenTexelsBlendsTheTwo)
+{
+	RecordingDevice device;
+	ParticleCurveAtlas atlas;
+	AddRows(atlas);
+	const ParticleCurveSample* baked = Baked(device, atlas);
+
+	for (int row = 0; row < atlas.GetRowCount(); row++)
+	{
+		const ParticleCurveSample* samples = baked + row * ParticleCurveAtlas::SamplesPerRow;
+		for (int i = 0; i < Last; i++)
+			CHECK(Near(atlas.Sample(row, (i + 0.5f) / Last), Halfway(samples[i], samples[i + 1])));
+	}
+
+	// Inside the step, between the last 100 and the first 200
+	CHECK(Near(atlas.Sample(1, 15.5f / Last).Size, 150.0f));
+}
+
+TEST(RowEdgesStayInTheirRow)
+{
+	RecordingDevice device;
+	ParticleCurveAtlas atlas;
+	AddRows(atlas);
+	const ParticleCurveSample* baked = Baked(device, atlas);
+
+	for (int row = 0; row < atlas.GetRowCount(); row++)
+	{
+		const ParticleCurveSample* samples = baked + row * ParticleCurveAtlas::SamplesPerRow;
+		CHECK(Same(samples[0], atlas.Sample(row, 0.0f)));
+		CHECK(Same(samples[Last], atlas.Sample(row, 1.0f)));
+
+		// Ages outside 0 - 1 clamp rather than reading the neighbouring rows
+		CHECK(Same(samples[0], atlas.Sample(row, -0.5f)));
+		CHECK(Same(samples[Last], atlas.Sample(row, 1.5f)));
+	}
+
+	CHECK_EQUAL(200.0f, atlas.Sample(1, 1.0f).Size);
+	CHECK_EQUAL(100.0f, atlas.Sample(1, 0.0f).Size);
+	CHECK_EQUAL(1.0f, atlas.Sample(2, 0.0f).Size);
+}
+
+TEST(MaxSizeIsTheLargestSample)
+{
+	ParticleCurveAtlas atlas;
+	AddRows(atlas);
+	CHECK(Near(atlas.GetMaxSize(0), (float)Last));
+	CHECK_EQUAL(200.0f, atlas.GetMaxSize(1));
+	CHECK_EQUAL(1.0f, atlas.GetMaxSize(2));
+}
+
+TEST(TableIsOnlyRebuiltForNewRows)
+{
+	RecordingDevice device;
+	ParticleCurveAtlas atlas;
+	CHECK(atlas.GetSRV(&device) == nullptr);
+
+	AddRows(atlas);
+	ID3D11ShaderResourceView* first = atlas.GetSRV(&device);
+	CHECK(first != nullptr);
+	CHECK(atlas.GetSRV(&device) == first);
+	CHECK_EQUAL(1u, (unsigned int)device.Buffers.size());
+	CHECK_EQUAL(3u * ParticleCurveAtlas::SamplesPerRow * sizeof(ParticleCurveSample), device.Buffers[0]->Desc.ByteWidth);
+
+	atlas.AddLinearRow(XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 1), 1.0f, 1.0f);
+	atlas.GetSRV(&device);
+	CHECK_EQUAL(2u, (unsigned int)device.Buffers.size());
+	CHECK_EQUAL(4u * ParticleCurveAtlas::SamplesPerRow * sizeof(ParticleCurveSample), device.Buffers[1]->Desc.ByteWidth);
+}
@@ -0,0 +1,87 @@
+#include "TestHarness.h"
+#include "Recording.h"
+#include "ParticleSystem.h"
+#include "WorkerPool.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const int EmitterCount = 200;
+	const int MaxParticles = 500;
+
+	// A few seconds of a scene full of different Emitters, updated at a
+	// ragged frame rate, then every live Particle copied out byte for byte
+	std::vector<unsigned char> Simulate(WorkerPool* pool, std::vector<int>& liveCounts)
+	{
+		ParticleSystem system(0, 0, 0, 0, pool);
+		std::vector<Emitter*> emitters;
+		for (int i = 0; i < EmitterCount; i++)
+		{
+			emitters.push_back(system.AddEmitter(new Emitter(
+				MaxParticles, 50 + (i * 37) % 400, 0.5f + (i % 7) * 0.25f, 0.1f, 1.0f,
+				XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+				XMFLOAT3((float)i, 0, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 1, 0),
+				XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(1, 1, 1), XMFLOAT4(0, 1, 0, 1),
+				1000 + i)));
+		}
+
+		float time = 0;
+		for (int frame = 0; frame < 120; frame++)
+		{
+			float deltaTime = 1.0f / 60.0f + (frame % 5) * 0.004f;
+			time += deltaTime;
+			system.Update(deltaTime, time);
+		}
+
+		RecordingDevice device;
+		RecordingContext context;
+		D3D11_BUFFER_DESC desc = {};
+		desc.ByteWidth = sizeof(Particle) * MaxParticles * EmitterCount;
+		ID3D11Buffer* buffer = 0;
+		device.CreateBuffer(&desc, 0, &buffer);
+
+		liveCounts.clear();
+		for (int i = 0; i < EmitterCount; i++)
+		{
+			emitters[i]->InvalidateUploads();
+			emitters[i]->UploadPending(&context, buffer, i * MaxParticles);
+			liveCounts.push_back(emitters[i]->GetLiveParticleCount());
+		}
+		return ((RecordingBuffer*)buffer)->Data;
+	}
+}
+
+TEST(ParallelUpdateMatchesSerialUpdate)
+{
+	std::vector<int> serialCounts;
+	std::vector<unsigned char> serial = Simulate(0, serialCounts);
+
+	// Something must have happened for the comparison to mean anything
+	int serialLive = 0;
+	for (int count : serialCounts)
+		serialLive += count;
+	CHECK(serialLive > EmitterCount * 10);
+
+	// More threads than cores still has to interleave the same way
+	unsigned int threadCounts[] = { 1, 3, 7 };
+	for (unsigned int threads : threadCounts)
+	{
+		WorkerPool pool(threads);
+		std::vector<int> parallelCounts;
+		std::vector<unsigned char> parallel = Simulate(&pool, parallelCounts);
+
+		CHECK(parallelCounts == serialCounts);
+		CHECK(parallel == serial);
+	}
+}
+
+TEST(SameSeedSameParticles)
+{
+	std::vector<int> firstCounts, secondCounts;
+	std::vector<unsigned char> first = Simulate(0, firstCounts);
+	std::vector<unsigned char> second = Simulate(0, secondCounts);
+
+	CHECK(firstCounts == secondCounts);
+	CHECK(first == second);
+}
@@ -0,0 +1,84 @@
+// Cost of making Particles: the per-Emitter SIMD random stream against
+// rand(), and spawning a whole batch at once against one Particle a call.
+#include "Bench.h"
+#include "Emitter.h"
+#include "ParticleRandom.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace DirectX;
+
+static const int FloatCount = 1 << 22;
+static const int SpawnCount = 100000;
+static const int Repeats = 5;
+
+static Emitter* MakeEmitter()
+{
+	return new Emitter(
+		SpawnCount, 1000, 5.0f, 0.1f, 1.0f,
+		XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+		XMFLOAT3(0, 0, 0), XMFLOAT3(0, -1, 0), XMFLOAT3(0, 1, 0),
+		XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(1, 1, 1), XMFLOAT4(0, 1, 0, 1),
+		1234);
+}
+
+// Time spawn() on a fresh, empty Emitter, best of Repeats
+template<typename Spawn>
+static double TimeSpawning(Spawn spawn)
+{
+	double best = 1e30;
+	for (int i = 0; i < Repeats; i++)
+	{
+		Emitter* emitter = MakeEmitter();
+		double ms = BestMilliseconds(1, [&]() { spawn(emitter); });
+		if (emitter->GetLiveParticleCount() != SpawnCount)
+			printf("  (spawned %d, expected %d)\n", emitter->GetLiveParticleCount(), SpawnCount);
+		delete emitter;
+		if (ms < best)
+			best = ms;
+	}
+	return best;
+}
+
+int main()
+{
+	printf("Random floats (%d):\n", FloatCount);
+
+	ParticleRandom random(1234);
+	double simd = BestMilliseconds(Repeats, [&]()
+	{
+		XMVECTOR sum = XMVectorZero();
+		for (int i = 0; i < FloatCount; i += 4)
+			sum = XMVectorAdd(sum, random.NextFloat4());
+		KeepResult(sum);
+	});
+
+	srand(1234);
+	double scalar = BestMilliseconds(Repeats, [&]()
+	{
+		float sum = 0;
+		for (int i = 0; i < FloatCount; i++)
+			sum += (float)rand() / RAND_MAX;
+		KeepResult(sum);
+	});
+
+	printf("  ParticleRandom::NextFloat4  %8.2f ms\n", simd);
+	printf("  rand()                      %8.2f ms  (%.1fx)\n", scalar, scalar / simd);
+
+	printf("Spawning %d Particles:\n", SpawnCount);
+
+	double batch = TimeSpawning([](Emitter* emitter)
+	{
+		emitter->SpawnBatch(SpawnCount, 0.0f, 0.001f);
+	});
+
+	double single = TimeSpawning([](Emitter* emitter)
+	{
+		for (int i = 0; i < SpawnCount; i++)
+			emitter->SpawnParticle(i * 0.001f);
+	});
+
+	printf("  SpawnBatch                  %8.2f ms\n", batch);
+	printf("  SpawnParticle each          %8.2f ms  (%.1fx)\n", single, single / batch);
+	return 0;
+}
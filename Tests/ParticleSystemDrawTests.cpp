@@ -0,0 +1,239 @@
+#include "TestHarness.h"
+#include "ShaderFixture.h"
+#include "ParticleSystem.h"
+
+using namespace DirectX;
+
+namespace
+{
+	const UINT ParticleBytes = sizeof(Particle);
+
+	// Never spawns on its own, so tests control every spawn
+	Emitter* MakeEmitter(int maxParticles, XMFLOAT3 position)
+	{
+		Emitter* emitter = new Emitter(
+			maxParticles, 100, 1.0f, 0.1f, 1.0f,
+			XMFLOAT4(1, 1, 1, 1), XMFLOAT4(1, 1, 1, 0),
+			position, XMFLOAT3(0, -1, 0), XMFLOAT3(0, 1, 0),
+			XMFLOAT3(0.5f, 0.5f, 0.5f), XMFLOAT3(1, 1, 1), XMFLOAT4(0, 1, 0, 1),
+			3);
+		emitter->SetSpawnRateScale(0.0f);
+		return emitter;
+	}
+
+	ShaderReflectionData MakeParticleVertexReflection()
+	{
+		ShaderReflectionData data;
+		ReflectedConstantBuffer externalData = { "externalData", 0, 0, 144, {} };
+		externalData.Variables.push_back({ "view", 0, 64 });
+		externalData.Variables.push_back({ "projection", 64, 64 });
+		externalData.Variables.push_back({ "currentTime", 128, 4 });
+		data.ConstantBuffers.push_back(externalData);
+		return data;
+	}
+
+	ShaderReflectionData MakeParticlePixelReflection()
+	{
+		ShaderReflectionData data;
+		data.Textures.push_back({ "particle", 0 });
+		data.Samplers.push_back({ "trilinear", 0 });
+		return data;
+	}
+
+	// A particle system on the recording device, looked at from just behind the origin
+	struct DrawScene
+	{
+		ShaderFixture Fixture;
+		Camera View;
+		ParticleSystem* System;
+
+		DrawScene()
+		{
+			std::shared_ptr<SimpleVertexShader> vertexShader(Fixture.Load<SimpleVertexShader>("ParticleDrawVS", MakeParticleVertexReflection()));
+			std::shared_ptr<SimplePixelShader> pixelShader(Fixture.Load<SimplePixelShader>("ParticleDrawPS", MakeParticlePixelReflection()));
+			System = new ParticleSystem(&Fixture.Device, 0, vertexShader, pixelShader);
+			View.UpdateProjectionMatrix(1280, 720);
+		}
+
+		~DrawScene()
+		{
+			delete System;
+		}
+
+		void Draw(float currentTime)
+		{
+			Fixture.Context.Clear();
+			System->Draw(&Fixture.Context, &View, currentTime);
+		}
+
+		// The newest buffer made with the given stride and usage
+		RecordingBuffer* FindBuffer(UINT stride, D3D11_USAGE usage)
+		{
+			for (size_t i = Fixture.Device.Buffers.size(); i-- > 0;)
+			{
+				RecordingBuffer* buffer = Fixture.Device.Buffers[i];
+				if (buffer->Desc.StructureByteStride == stride && buffer->Desc.Usage == usage)
+					return buffer;
+			}
+			return 0;
+		}
+
+		RecordingBuffer* ParticlePool() { return FindBuffer(ParticleBytes, D3D11_USAGE_DEFAULT); }
+		RecordingBuffer* DrawList() { return FindBuffer(sizeof(unsigned int), D3D11_USAGE_DYNAMIC); }
+		RecordingBuffer* EmitterTable() { return FindBuffer(sizeof(EmitterParams), D3D11_USAGE_DYNAMIC); }
+
+		std::vector<RecordedCall> PoolUpdates()
+		{
+			std::vector<RecordedCall> updates;
+			for (const RecordedCall& call : Fixture.Context.CallsNamed("UpdateSubresource"))
+			{
+				if (call.Resource == ParticlePool())
+					updates.push_back(call);
+			}
+			return updates;
+		}
+
+		Particle PoolParticle(int index)
+		{
+			Particle particle;
+			memcpy(&particle, ParticlePool()->Data.data() + ParticleBytes * index, ParticleBytes);
+			return particle;
+		}
+
+		unsigned int DrawListEntry(int index)
+		{
+			return ((unsigned int*)DrawList()->Data.data())[index];
+		}
+	};
+
+	// Whether every upload lands inside one of the given pool ranges [first, end)
+	bool UploadsStayInRanges(const std::vector<RecordedCall>& updates, const std::vector<std::pair<int, int>>& ranges)
+	{
+		for (const RecordedCall& update : updates)
+		{
+			bool inside = false;
+			for (const std::pair<int, int>& range : ranges)
+			{
+				if (update.Box.left >= range.first * ParticleBytes && update.Box.right <= range.second * ParticleBytes)
+					inside = true;
+			}
+			if (!inside)
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST(SharedPoolDrawsEveryEmitterAtOnce)
+{
+	DrawScene scene;
+	Emitter* small = scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(-1, 0, 0)));
+	Emitter* medium = scene.System->AddEmitter(MakeEmitter(20, XMFLOAT3(0, 0, 0)));
+	Emitter* large = scene.System->AddEmitter(MakeEmitter(30, XMFLOAT3(1, 0, 0)));
+	small->SpawnBatch(4, 0.0f, 0.01f);
+	medium->SpawnBatch(7, 0.0f, 0.01f);
+	large->SpawnBatch(30, 0.0f, 0.01f);
+
+	scene.Draw(0.5f);
+	CHECK_EQUAL(3, scene.System->GetVisibleEmitterCount());
+
+	// One pool for all three, and one draw of every live Particle
+	CHECK_EQUAL(60u * ParticleBytes, scene.ParticlePool()->Desc.ByteWidth);
+	std::vector<RecordedCall> draws = scene.Fixture.Context.CallsNamed("DrawIndexed");
+	CHECK_EQUAL(1u, (unsigned int)draws.size());
+	CHECK_EQUAL(6u * (4 + 7 + 30), draws[0].IndexCount);
+
+	// Each Emitter sends its new Particles to its own range in one go
+	std::vector<RecordedCall> updates = scene.PoolUpdates();
+	CHECK_EQUAL(3u, (unsigned int)updates.size());
+	CHECK_EQUAL(0u, updates[0].Box.left);
+	CHECK_EQUAL(4 * ParticleBytes, updates[0].Box.right);
+	CHECK_EQUAL(10 * ParticleBytes, updates[1].Box.left);
+	CHECK_EQUAL(17 * ParticleBytes, updates[1].Box.right);
+	CHECK_EQUAL(30 * ParticleBytes, updates[2].Box.left);
+	CHECK_EQUAL(60 * ParticleBytes, updates[2].Box.right);
+
+	// The table and the draw list are each written once
+	CHECK_EQUAL(2u, scene.Fixture.Context.CountCalls("Map"));
+	CHECK_EQUAL(2u, scene.Fixture.Context.CountCalls("Unmap"));
+}
+
+TEST(DrawListPointsIntoEachEmittersRange)
+{
+	DrawScene scene;
+	scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(-1, 0, 0)))->SpawnBatch(3, 0.0f, 0.01f);
+	scene.System->AddEmitter(MakeEmitter(20, XMFLOAT3(1, 0, 0)))->SpawnBatch(2, 0.0f, 0.01f);
+
+	scene.Draw(0.5f);
+
+	CHECK_EQUAL(0u, scene.DrawListEntry(0));
+	CHECK_EQUAL(1u, scene.DrawListEntry(1));
+	CHECK_EQUAL(2u, scene.DrawListEntry(2));
+	CHECK_EQUAL(10u, scene.DrawListEntry(3));
+	CHECK_EQUAL(11u, scene.DrawListEntry(4));
+
+	// Each Particle names its Emitter's row of the table
+	CHECK_EQUAL(0u, scene.PoolParticle(2).EmitterIndex);
+	CHECK_EQUAL(1u, scene.PoolParticle(10).EmitterIndex);
+	EmitterParams* table = (EmitterParams*)scene.EmitterTable()->Data.data();
+	CHECK_EQUAL(2u * (UINT)sizeof(EmitterParams), scene.EmitterTable()->Desc.ByteWidth);
+	CHECK_EQUAL(1.0f, table[1].Lifetime);
+}
+
+TEST(QuietFramesUploadNoParticles)
+{
+	DrawScene scene;
+	Emitter* first = scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(-1, 0, 0)));
+	scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(1, 0, 0)))->SpawnBatch(5, 0.0f, 0.01f);
+	scene.Draw(0.1f);
+
+	// Nothing spawned, so only the table and draw list go up
+	scene.Draw(0.2f);
+	CHECK_EQUAL(0u, (unsigned int)scene.PoolUpdates().size());
+	CHECK_EQUAL(1u, scene.Fixture.Context.CountCalls("DrawIndexed"));
+	CHECK_EQUAL(2u, scene.Fixture.Context.CountCalls("Map"));
+
+	// Only the Emitter that spawned uploads
+	first->SpawnBatch(2, 0.2f, 0.01f);
+	scene.Draw(0.3f);
+	std::vector<RecordedCall> updates = scene.PoolUpdates();
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK_EQUAL(0u, updates[0].Box.left);
+	CHECK_EQUAL(2 * ParticleBytes, updates[0].Box.right);
+	CHECK_EQUAL(6u * 7, scene.Fixture.Context.CallsNamed("DrawIndexed")[0].IndexCount);
+}
+
+TEST(CulledEmittersKeepTheirRangeButAreNotDrawn)
+{
+	DrawScene scene;
+	scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(0, 0, 0)))->SpawnBatch(3, 0.0f, 0.01f);
+	scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(0, 0, -50)))->SpawnBatch(6, 0.0f, 0.01f);
+	scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(0, 0, 5)))->SpawnBatch(4, 0.0f, 0.01f);
+
+	scene.Draw(0.5f);
+	CHECK_EQUAL(2, scene.System->GetVisibleEmitterCount());
+	CHECK_EQUAL(6u * (3 + 4), scene.Fixture.Context.CallsNamed("DrawIndexed")[0].IndexCount);
+	CHECK(UploadsStayInRanges(scene.PoolUpdates(), { { 0, 10 }, { 20, 30 } }));
+	CHECK_EQUAL(2u, (unsigned int)scene.PoolUpdates().size());
+	CHECK_EQUAL(20u, scene.DrawListEntry(3));
+}
+
+TEST(AddingAnEmitterRebuildsThePoolAndResends)
+{
+	DrawScene scene;
+	scene.System->AddEmitter(MakeEmitter(10, XMFLOAT3(-1, 0, 0)))->SpawnBatch(4, 0.0f, 0.01f);
+	scene.Draw(0.1f);
+	RecordingBuffer* oldPool = scene.ParticlePool();
+
+	scene.System->AddEmitter(MakeEmitter(20, XMFLOAT3(1, 0, 0)))->SpawnBatch(5, 0.1f, 0.01f);
+	scene.Draw(0.2f);
+
+	// The new pool starts empty, so the first Emitter's Particles go again
+	CHECK(scene.ParticlePool() != oldPool);
+	CHECK_EQUAL(30u * ParticleBytes, scene.ParticlePool()->Desc.ByteWidth);
+	std::vector<RecordedCall> updates = scene.PoolUpdates();
+	CHECK_EQUAL(2u, (unsigned int)updates.size());
+	CHECK(UploadsStayInRanges(updates, { { 0, 4 }, { 10, 15 } }));
+	CHECK_EQUAL(1u, scene.PoolParticle(12).EmitterIndex);
+	CHECK_EQUAL(6u * 9, scene.Fixture.Context.CallsNamed("DrawIndexed")[0].IndexCount);
+}
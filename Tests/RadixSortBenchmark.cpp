@@ -0,0 +1,86 @@
+// Sorting particle depth keys, as ParticleSystem's sorted mode does every
+// frame: RadixSort on one thread and on the WorkerPool, against std::sort.
+#include "Bench.h"
+#include "RadixSort.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+static const int Repeats = 5;
+
+// Depths spread over a typical view range, keyed the way WriteSortKeys does
+static std::vector<unsigned int> MakeKeys(int count)
+{
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<float> depth(0.1f, 500.0f);
+
+	std::vector<unsigned int> keys(count);
+	for (int i = 0; i < count; i++)
+		keys[i] = ~FloatToSortKey(depth(generator));
+	return keys;
+}
+
+static double TimeRadixSort(const std::vector<unsigned int>& original, WorkerPool* pool)
+{
+	int count = (int)original.size();
+	std::vector<unsigned int> keys, values(count), tempKeys(count), tempValues(count);
+
+	double best = 1e30;
+	for (int r = 0; r < Repeats; r++)
+	{
+		keys = original;
+		for (int i = 0; i < count; i++)
+			values[i] = i;
+
+		double ms = BestMilliseconds(1, [&]()
+		{
+			RadixSort(keys.data(), values.data(), tempKeys.data(), tempValues.data(), count, pool);
+		});
+		best = ms < best ? ms : best;
+
+		if (!std::is_sorted(keys.begin(), keys.end()))
+			printf("  (radix sort left keys out of order)\n");
+	}
+	return best;
+}
+
+static double TimeStdSort(const std::vector<unsigned int>& original)
+{
+	int count = (int)original.size();
+	std::vector<unsigned long long> pairs(count);
+
+	double best = 1e30;
+	for (int r = 0; r < Repeats; r++)
+	{
+		// Key in the high half, index in the low half, so it sorts like the radix sort
+		for (int i = 0; i < count; i++)
+			pairs[i] = ((unsigned long long)original[i] << 32) | (unsigned int)i;
+
+		double ms = BestMilliseconds(1, [&]() { std::sort(pairs.begin(), pairs.end()); });
+		best = ms < best ? ms : best;
+	}
+	return best;
+}
+
+int main()
+{
+	WorkerPool pool;
+	printf("WorkerPool threads: %u\n", pool.GetThreadCount());
+
+	int counts[] = { 100000, 1000000 };
+	for (int count : counts)
+	{
+		std::vector<unsigned int> keys = MakeKeys(count);
+
+		double serial = TimeRadixSort(keys, 0);
+		double parallel = TimeRadixSort(keys, &pool);
+		double standard = TimeStdSort(keys);
+
+		printf("%d particles:\n", count);
+		printf("  RadixSort, one thread   %8.2f ms  (%.0f M keys/s)\n", serial, count / serial / 1000.0);
+		printf("  RadixSort, WorkerPool   %8.2f ms  (%.0f M keys/s)\n", parallel, count / parallel / 1000.0);
+		printf("  std::sort               %8.2f ms  (%.0f M keys/s)\n", standard, count / standard / 1000.0);
+	}
+	return 0;
+}
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <d3d11.h>
+#include <d3d11_1.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Stand-ins for the Direct3D device and context that do
+// nothing but remember what they were asked to do, so code
+// that talks to the GPU can be checked without one.
+//
+// Buffers keep a CPU copy of their contents, which updates
+// and maps write into.  Everything the device creates is
+// owned by the device; Release() on it does nothing.
+// --------------------------------------------------------
+
+// A buffer with its description and contents
+struct RecordingBuffer : ID3D11Buffer
+{
+	D3D11_BUFFER_DESC Desc;
+	std::vector<unsigned char> Data;
+
+	void GetDesc(D3D11_BUFFER_DESC* desc) override { *desc = Desc; }
+};
+
+struct RecordingShaderResourceView : ID3D11ShaderResourceView {};
+struct RecordingSamplerState : ID3D11SamplerState {};
+struct RecordingRasterizerState : ID3D11RasterizerState {};
+struct RecordingDepthStencilState : ID3D11DepthStencilState {};
+struct RecordingBlendState : ID3D11BlendState {};
+struct RecordingInputLayout : ID3D11InputLayout {};
+struct RecordingVertexShader : ID3D11VertexShader {};
+struct RecordingPixelShader : ID3D11PixelShader {};
+
+// One call to the context
+struct RecordedCall
+{
+	std::string Name;					// The method, e.g. "PSSetShaderResources"
+	UINT StartSlot = 0;
+	UINT Count = 0;
+	std::vector<const void*> Objects;	// What was bound, in slot order
+	std::vector<UINT> FirstConstants;	// XXSetConstantBuffers1 only
+	std::vector<UINT> ConstantCounts;
+	ID3D11Resource* Resource = 0;		// Updates and maps
+	bool HasBox = false;
+	D3D11_BOX Box = {};
+	UINT CopyFlags = 0;
+	D3D11_MAP MapType = D3D11_MAP_READ;
+	UINT ByteCount = 0;					// Bytes written by an update
+	UINT IndexCount = 0;				// DrawIndexed only
+};
+
+// One element of an input layout the device was asked to create
+struct RecordedInputElement
+{
+	std::string SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	D3D11_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+#define RECORDING_STAGE(prefix, shaderType) \
+	void prefix##SetShader(shaderType* shader, ID3D11ClassInstance* const*, UINT) override \
+	{ \
+		Record(#prefix "SetShader", 0, 1, (void* const*)&shader); \
+	} \
+	void prefix##SetConstantBuffers(UINT start, UINT count, ID3D11Buffer* const* buffers) override \
+	{ \
+		Record(#prefix "SetConstantBuffers", start, count, (void* const*)buffers); \
+	} \
+	void prefix##SetConstantBuffers1(UINT start, UINT count, ID3D11Buffer* const* buffers, const UINT* firstConstants, const UINT* constantCounts) override \
+	{ \
+		RecordedCall& call = Record(#prefix "SetConstantBuffers1", start, count, (void* const*)buffers); \
+		call.FirstConstants.assign(firstConstants, firstConstants + count); \
+		call.ConstantCounts.assign(constantCounts, constantCounts + count); \
+	} \
+	void prefix##SetShaderResources(UINT start, UINT count, ID3D11ShaderResourceView* const* srvs) override \
+	{ \
+		Record(#prefix "SetShaderResources", start, count, (void* const*)srvs); \
+	} \
+	void prefix##SetSamplers(UINT start, UINT count, ID3D11SamplerState* const* samplers) override \
+	{ \
+		Record(#prefix "SetSamplers", start, count, (void* const*)samplers); \
+	}
+
+class RecordingContext : public ID3D11DeviceContext1
+{
+public:
+	std::vector<RecordedCall> Calls;
+
+	// Whether QueryInterface hands out ID3D11DeviceContext1
+	bool Supports11_1 = true;
+
+	void Clear() { Calls.clear(); }
+
+	unsigned int CountCalls(const std::string& name) const
+	{
+		unsigned int count = 0;
+		for (const RecordedCall& call : Calls)
+			if (call.Name == name)
+				count++;
+		return count;
+	}
+
+	std::vector<RecordedCall> CallsNamed(const std::string& name) const
+	{
+		std::vector<RecordedCall> found;
+		for (const RecordedCall& call : Calls)
+			if (call.Name == name)
+				found.push_back(call);
+		return found;
+	}
+
+	// Bytes written by UpdateSubresource and UpdateSubresource1 since the last Clear()
+	unsigned int BytesUpdated() const
+	{
+		unsigned int bytes = 0;
+		for (const RecordedCall& call : Calls)
+			bytes += call.ByteCount;
+		return bytes;
+	}
+
+	HRESULT QueryInterface(REFIID id, void** object) override
+	{
+		if (Supports11_1 && &id == &__uuidof(ID3D11DeviceContext1))
+		{
+			*object = static_cast<ID3D11DeviceContext1*>(this);
+			return S_OK;
+		}
+
+		*object = 0;
+		return E_NOINTERFACE;
+	}
+
+	RECORDING_STAGE(VS, ID3D11VertexShader)
+	RECORDING_STAGE(PS, ID3D11PixelShader)
+	RECORDING_STAGE(DS, ID3D11DomainShader)
+	RECORDING_STAGE(HS, ID3D11HullShader)
+	RECORDING_STAGE(GS, ID3D11GeometryShader)
+	RECORDING_STAGE(CS, ID3D11ComputeShader)
+
+	void IASetInputLayout(ID3D11InputLayout* layout) override { Record("IASetInputLayout", 0, 1, (void* const*)&layout); }
+	void IASetVertexBuffers(UINT start, UINT count, ID3D11Buffer* const* buffers, const UINT*, const UINT*) override { Record("IASetVertexBuffers", start, count, (void* const*)buffers); }
+	void IASetIndexBuffer(ID3D11Buffer* buffer, DXGI_FORMAT, UINT) override { Record("IASetIndexBuffer", 0, 1, (void* const*)&buffer); }
+	void IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY) override { Record("IASetPrimitiveTopology", 0, 0, 0); }
+
+	void Draw(UINT, UINT) override { Record("Draw", 0, 0, 0); }
+	void DrawIndexed(UINT indexCount, UINT, INT) override { Record("DrawIndexed", 0, 0, 0).IndexCount = indexCount; }
+	void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) override { Record("DrawIndexedInstanced", 0, 0, 0); }
+	void Dispatch(UINT, UINT, UINT) override { Record("Dispatch", 0, 0, 0); }
+
+	void OMSetRenderTargets(UINT count, ID3D11RenderTargetView* const* rtvs, ID3D11DepthStencilView*) override { Record("OMSetRenderTargets", 0, count, (void* const*)rtvs); }
+	void OMSetBlendState(ID3D11BlendState* state, const FLOAT[4], UINT) override { Record("OMSetBlendState", 0, 1, (void* const*)&state); }
+	void OMSetDepthStencilState(ID3D11DepthStencilState* state, UINT) override { Record("OMSetDepthStencilState", 0, 1, (void* const*)&state); }
+	void RSSetState(ID3D11RasterizerState* state) override { Record("RSSetState", 0, 1, (void* const*)&state); }
+
+	HRESULT Map(ID3D11Resource* resource, UINT, D3D11_MAP mapType, UINT, D3D11_MAPPED_SUBRESOURCE* mapped) override
+	{
+		RecordingBuffer* buffer = dynamic_cast<RecordingBuffer*>(resource);
+		if (!buffer)
+			return E_FAIL;
+
+		RecordedCall& call = Record("Map", 0, 0, 0);
+		call.Resource = resource;
+		call.MapType = mapType;
+
+		mapped->pData = buffer->Data.data();
+		mapped->RowPitch = (UINT)buffer->Data.size();
+		mapped->DepthPitch = (UINT)buffer->Data.size();
+		return S_OK;
+	}
+
+	void Unmap(ID3D11Resource* resource, UINT) override
+	{
+		Record("Unmap", 0, 0, 0).Resource = resource;
+	}
+
+	void UpdateSubresource(ID3D11Resource* resource, UINT, const D3D11_BOX* box, const void* data, UINT, UINT) override
+	{
+		Update("UpdateSubresource", resource, box, data, 0);
+	}
+
+	void UpdateSubresource1(ID3D11Resource* resource, UINT, const D3D11_BOX* box, const void* data, UINT, UINT, UINT copyFlags) override
+	{
+		Update("UpdateSubresource1", resource, box, data, copyFlags);
+	}
+
+private:
+	RecordedCall& Record(const char* name, UINT start, UINT count, void* const* objects)
+	{
+		RecordedCall call;
+		call.Name = name;
+		call.StartSlot = start;
+		call.Count = count;
+		if (objects)
+			call.Objects.assign(objects, objects + count);
+		Calls.push_back(call);
+		return Calls.back();
+	}
+
+	// Buffers only - a box's left and right are byte offsets
+	void Update(const char* name, ID3D11Resource* resource, const D3D11_BOX* box, const void* data, UINT copyFlags)
+	{
+		RecordedCall& call = Record(name, 0, 0, 0);
+		call.Resource = resource;
+		call.CopyFlags = copyFlags;
+
+		RecordingBuffer* buffer = dynamic_cast<RecordingBuffer*>(resource);
+		UINT left = box ? box->left : 0;
+		UINT right = box ? box->right : (buffer ? (UINT)buffer->Data.size() : 0);
+		call.HasBox = box != 0;
+		if (box)
+			call.Box = *box;
+		call.ByteCount = right - left;
+
+		if (buffer && right <= buffer->Data.size())
+			memcpy(buffer->Data.data() + left, data, right - left);
+	}
+};
+
+#undef RECORDING_STAGE
+
+class RecordingDevice : public ID3D11Device
+{
+public:
+	std::vector<RecordedInputElement> InputElements;	// From the last CreateInputLayout
+	std::vector<RecordingBuffer*> Buffers;				// Every buffer created, oldest first
+
+	// Reported through CheckFeatureSupport
+	bool ConstantBufferPartialUpdate = true;
+	bool ConstantBufferOffsetting = true;
+	bool MapNoOverwriteOnDynamicConstantBuffer = true;
+
+	unsigned int StatesCreated = 0;		// Rasterizer, depth-stencil, blend and sampler states
+	bool RejectStates = false;			// Fail every state creation, as for an invalid description
+
+	HRESULT CreateBuffer(const D3D11_BUFFER_DESC* desc, const D3D11_SUBRESOURCE_DATA* initialData, ID3D11Buffer** buffer) override
+	{
+		RecordingBuffer* created = Own(new RecordingBuffer());
+		created->Desc = *desc;
+		created->Data.resize(desc->ByteWidth);
+		if (initialData && initialData->pSysMem)
+			memcpy(created->Data.data(), initialData->pSysMem, desc->ByteWidth);
+
+		Buffers.push_back(created);
+		*buffer = created;
+		return S_OK;
+	}
+
+	HRESULT CreateShaderResourceView(ID3D11Resource*, const D3D11_SHADER_RESOURCE_VIEW_DESC*, ID3D11ShaderResourceView** srv) override
+	{
+		*srv = Own(new RecordingShaderResourceView());
+		return S_OK;
+	}
+
+	HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC*, ID3D11SamplerState** sampler) override
+	{
+		return CreateState(new RecordingSamplerState(), sampler);
+	}
+
+	HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC*, ID3D11RasterizerState** state) override
+	{
+		return CreateState(new RecordingRasterizerState(), state);
+	}
+
+	HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC*, ID3D11DepthStencilState** state) override
+	{
+		return CreateState(new RecordingDepthStencilState(), state);
+	}
+
+	HRESULT CreateBlendState(const D3D11_BLEND_DESC*, ID3D11BlendState** state) override
+	{
+		return CreateState(new RecordingBlendState(), state);
+	}
+
+	HRESULT CreateVertexShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11VertexShader** shader) override
+	{
+		*shader = Own(new RecordingVertexShader());
+		return S_OK;
+	}
+
+	HRESULT CreatePixelShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11PixelShader** shader) override
+	{
+		*shader = Own(new RecordingPixelShader());
+		return S_OK;
+	}
+
+	HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC* elements, UINT count, const void*, SIZE_T, ID3D11InputLayout** layout) override
+	{
+		InputElements.clear();
+		for (UINT i = 0; i < count; i++)
+		{
+			InputElements.push_back({ elements[i].SemanticName, elements[i].SemanticIndex, elements[i].Format,
+				elements[i].InputSlot, elements[i].InputSlotClass, elements[i].InstanceDataStepRate });
+		}
+
+		*layout = Own(new RecordingInputLayout());
+		return S_OK;
+	}
+
+	HRESULT CheckFeatureSupport(D3D11_FEATURE feature, void* data, UINT size) override
+	{
+		if (feature != D3D11_FEATURE_D3D11_OPTIONS || size != sizeof(D3D11_FEATURE_DATA_D3D11_OPTIONS))
+			return E_FAIL;
+
+		D3D11_FEATURE_DATA_D3D11_OPTIONS* options = (D3D11_FEATURE_DATA_D3D11_OPTIONS*)data;
+		memset(options, 0, sizeof(*options));
+		options->ConstantBufferPartialUpdate = ConstantBufferPartialUpdate;
+		options->ConstantBufferOffsetting = ConstantBufferOffsetting;
+		options->MapNoOverwriteOnDynamicConstantBuffer = MapNoOverwriteOnDynamicConstantBuffer;
+		return S_OK;
+	}
+
+private:
+	template<typename T>
+	T* Own(T* object)
+	{
+		objects.emplace_back(object);
+		return object;
+	}
+
+	template<typename T, typename Interface>
+	HRESULT CreateState(T* object, Interface** state)
+	{
+		if (RejectStates)
+		{
+			delete object;
+			*state = 0;
+			return E_FAIL;
+		}
+
+		StatesCreated++;
+		*state = Own(object);
+		return S_OK;
+	}
+
+	std::vector<std::unique_ptr<IUnknown>> objects;
+};
@@ -0,0 +1,188 @@
+#include "TestHarness.h"
+#include "RenderQueue.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <random>
+
+TEST(KeysRoundTripTheirFields)
+{
+	uint64_t key = RenderQueue::MakeKey(1, 4095, 123, 65535, 1048575);
+	CHECK_EQUAL(1u, RenderQueue::GetPass(key));
+	CHECK_EQUAL(4095u, RenderQueue::GetDepthBucket(key));
+	CHECK_EQUAL(123u, RenderQueue::GetShader(key));
+	CHECK_EQUAL(65535u, RenderQueue::GetMaterial(key));
+	CHECK_EQUAL(1048575u, RenderQueue::GetMesh(key));
+
+	// The fields fill all 64 bits without overlapping
+	CHECK_EQUAL(64u, RenderQueue::PassShift + RenderQueue::PassBits);
+	CHECK_EQUAL(~0ull, RenderQueue::MakeKey(15, 4095, 4095, 65535, 1048575));
+}
+
+TEST(OversizedFieldsAreMaskedToTheirWidth)
+{
+	// A material number past 16 bits mustn't spill into the shader field
+	uint64_t key = RenderQueue::MakeKey(0, 0, 7, 0x10001, 0x100002);
+	CHECK_EQUAL(7u, RenderQueue::GetShader(key));
+	CHECK_EQUAL(1u, RenderQueue::GetMaterial(key));
+	CHECK_EQUAL(2u, RenderQueue::GetMesh(key));
+}
+
+TEST(KeysOrderByPassThenDepthThenState)
+{
+	CHECK(RenderQueue::MakeKey(0, 4095, 4095, 65535, 1048575) < RenderQueue::MakeKey(1, 0, 0, 0, 0));
+	CHECK(RenderQueue::MakeKey(0, 1, 0, 0, 0) > RenderQueue::MakeKey(0, 0, 4095, 65535, 1048575));
+	CHECK(RenderQueue::MakeKey(0, 0, 1, 0, 0) > RenderQueue::MakeKey(0, 0, 0, 65535, 1048575));
+	CHECK(RenderQueue::MakeKey(0, 0, 0, 1, 0) > RenderQueue::MakeKey(0, 0, 0, 0, 1048575));
+}
+
+TEST(DiffReportsWhatChanged)
+{
+	uint64_t base = RenderQueue::MakeKey(0, 3, 1, 2, 3);
+
+	CHECK_EQUAL(0u, RenderQueue::Diff(base, base));
+	CHECK_EQUAL(0u, RenderQueue::Diff(base, RenderQueue::MakeKey(0, 9, 1, 2, 3)));
+	CHECK_EQUAL((unsigned int)RenderChangeMesh, RenderQueue::Diff(base, RenderQueue::MakeKey(0, 3, 1, 2, 4)));
+	CHECK_EQUAL((unsigned int)RenderChangeMaterial, RenderQueue::Diff(base, RenderQueue::MakeKey(0, 3, 1, 5, 3)));
+	CHECK_EQUAL((unsigned int)RenderChangePass, RenderQueue::Diff(base, RenderQueue::MakeKey(1, 3, 1, 2, 3)));
+
+	// Material values live in the shader, so a new shader needs them again
+	CHECK_EQUAL((unsigned int)(RenderChangeShader | RenderChangeMaterial), RenderQueue::Diff(base, RenderQueue::MakeKey(0, 3, 2, 2, 3)));
+	CHECK_EQUAL((unsigned int)RenderChangeAll, RenderQueue::Diff(base, RenderQueue::MakeKey(1, 0, 0, 0, 0)));
+}
+
+TEST(DepthBucketsRunBackToFrontWhenTransparent)
+{
+	RenderQueue queue;
+	CHECK_EQUAL(0u, queue.GetDepthBucket(RenderPassOpaque, 500.0f));
+
+	queue.SetDepthBuckets(RenderPassOpaque, 4, 100.0f);
+	queue.SetDepthBuckets(RenderPassTransparent, 4, 100.0f);
+	CHECK_EQUAL(0u, queue.GetDepthBucket(RenderPassOpaque, -5.0f));
+	CHECK_EQUAL(1u, queue.GetDepthBucket(RenderPassOpaque, 30.0f));
+	CHECK_EQUAL(3u, queue.GetDepthBucket(RenderPassOpaque, 1000.0f));
+	CHECK_EQUAL(3u, queue.GetDepthBucket(RenderPassTransparent, 10.0f));
+	CHECK_EQUAL(0u, queue.GetDepthBucket(RenderPassTransparent, 99.0f));
+
+	// Clamped to what the key can hold
+	queue.SetDepthBuckets(RenderPassOpaque, 100000, 1.0f);
+	CHECK_EQUAL(4095u, queue.GetDepthBucket(RenderPassOpaque, 1.0f));
+}
+
+TEST(IDsAreStableAndPerKind)
+{
+	RenderQueue queue;
+	int a, b, c;
+
+	CHECK_EQUAL(0u, queue.GetShaderID(&a, &b));
+	CHECK_EQUAL(1u, queue.GetShaderID(&a, &c));
+	CHECK_EQUAL(0u, queue.GetShaderID(&a, &b));
+	CHECK_EQUAL(0u, queue.GetMaterialID(&c));
+	CHECK_EQUAL(1u, queue.GetMaterialID(&a));
+	CHECK_EQUAL(0u, queue.GetMeshID(&a));
+
+	queue.Clear();
+	CHECK_EQUAL(1u, queue.GetMaterialID(&a));
+}
+
+TEST(IDsStopAtTheOverflowID)
+{
+	RenderQueue queue;
+	std::vector<char> objects(RenderQueue::MaterialOverflowID + 3);
+
+	// Every number below the overflow ID is one object's own...
+	bool unique = true;
+	for (unsigned int i = 0; i < RenderQueue::MaterialOverflowID; i++)
+		unique = unique && queue.GetMaterialID(&objects[i]) == i;
+	CHECK(unique);
+
+	// ...and the rest share it, rather than wrapping round onto material 0
+	for (unsigned int i = RenderQueue::MaterialOverflowID; i < objects.size(); i++)
+		CHECK_EQUAL(RenderQueue::MaterialOverflowID, queue.GetMaterialID(&objects[i]));
+	CHECK_EQUAL(0u, queue.GetMaterialID(&objects[0]));
+	CHECK_EQUAL(RenderQueue::MaterialOverflowID, RenderQueue::GetMaterial(RenderQueue::MakeKey(0, 0, 0, queue.GetMaterialID(&objects.back()), 0)));
+
+	int pixelShader;
+	for (unsigned int i = 0; i < RenderQueue::ShaderOverflowID; i++)
+		queue.GetShaderID(&objects[i], &pixelShader);
+	CHECK_EQUAL(RenderQueue::ShaderOverflowID, queue.GetShaderID(&objects.back(), &pixelShader));
+	CHECK_EQUAL(1u, queue.GetShaderID(&objects[1], &pixelShader));
+}
+
+TEST(OverflowIDsAlwaysRebind)
+{
+	uint64_t sharedShader = RenderQueue::MakeKey(0, 0, RenderQueue::ShaderOverflowID, 1, 1);
+	uint64_t sharedMaterial = RenderQueue::MakeKey(0, 0, 1, RenderQueue::MaterialOverflowID, 1);
+	uint64_t sharedMesh = RenderQueue::MakeKey(0, 0, 1, 1, RenderQueue::MeshOverflowID);
+
+	// Equal keys, but each could be a different object underneath
+	CHECK_EQUAL((unsigned int)(RenderChangeShader | RenderChangeMaterial), RenderQueue::Diff(sharedShader, sharedShader));
+	CHECK_EQUAL((unsigned int)RenderChangeMaterial, RenderQueue::Diff(sharedMaterial, sharedMaterial));
+	CHECK_EQUAL((unsigned int)RenderChangeMesh, RenderQueue::Diff(sharedMesh, sharedMesh));
+
+	RenderQueue queue;
+	for (unsigned int i = 0; i < 4; i++)
+		queue.Add(sharedMesh, i);
+	queue.Sort(0);
+	queue.Submit([](unsigned int, unsigned int) {});
+	CHECK_EQUAL(4u, queue.GetStats().MeshSwitches);
+	CHECK_EQUAL(1u, queue.GetStats().MaterialSwitches);
+}
+
+TEST(SortMatchesAStableSort)
+{
+	std::mt19937 generator(99);
+	std::vector<std::pair<uint64_t, unsigned int>> expected;
+
+	// Plenty of equal keys, to see that they keep their order
+	RenderQueue queue;
+	for (unsigned int i = 0; i < 20000; i++)
+	{
+		uint64_t key = RenderQueue::MakeKey(generator() % 2, generator() % 8, generator() % 4, generator() % 16, generator() % 32);
+		queue.Add(key, i);
+		expected.push_back({ key, i });
+	}
+	std::stable_sort(expected.begin(), expected.end(),
+		[](const std::pair<uint64_t, unsigned int>& a, const std::pair<uint64_t, unsigned int>& b) { return a.first < b.first; });
+
+	WorkerPool pool(3);
+	queue.Sort(&pool);
+
+	CHECK_EQUAL((unsigned int)expected.size(), queue.GetCount());
+	bool same = true;
+	for (unsigned int i = 0; i < queue.GetCount(); i++)
+		same = same && queue.GetKey(i) == expected[i].first && queue.GetItem(i) == expected[i].second;
+	CHECK(same);
+}
+
+TEST(SubmitReportsChangesBetweenDraws)
+{
+	RenderQueue queue;
+	queue.Add(RenderQueue::MakeKey(0, 0, 1, 1, 2), 0);
+	queue.Add(RenderQueue::MakeKey(0, 0, 0, 0, 0), 1);
+	queue.Add(RenderQueue::MakeKey(0, 0, 1, 1, 1), 2);
+	queue.Add(RenderQueue::MakeKey(0, 0, 0, 0, 0), 3);
+	queue.Add(RenderQueue::MakeKey(1, 0, 0, 0, 0), 4);
+	queue.Sort(0);
+
+	std::vector<unsigned int> order, changes;
+	queue.Submit([&](unsigned int item, unsigned int change)
+	{
+		order.push_back(item);
+		changes.push_back(change);
+	});
+
+	CHECK(order == std::vector<unsigned int>({ 1, 3, 2, 0, 4 }));
+	CHECK(changes == std::vector<unsigned int>({
+		(unsigned int)RenderChangeAll,
+		0u,
+		(unsigned int)(RenderChangeShader | RenderChangeMaterial | RenderChangeMesh),
+		(unsigned int)RenderChangeMesh,
+		(unsigned int)RenderChangeAll }));
+
+	const RenderQueueStats& stats = queue.GetStats();
+	CHECK_EQUAL(5u, stats.Draws);
+	CHECK_EQUAL(2u, stats.PassSwitches);
+	CHECK_EQUAL(3u, stats.ShaderSwitches);
+	CHECK_EQUAL(3u, stats.MaterialSwitches);
+	CHECK_EQUAL(4u, stats.MeshSwitches);
+}
@@ -0,0 +1,102 @@
+// Building a SceneBVH over generated scenes of 1k to 1M boxes, on one thread
+// and on the WorkerPool, then culling, overlap and ray queries against it
+// next to testing every box.
+#include "Bench.h"
+#include "Scenes.h"
+#include "SceneBVH.h"
+#include "WorkerPool.h"
+
+using namespace DirectX;
+
+static const int Repeats = 5;
+static const int QueryCount = 200;
+
+int main()
+{
+	WorkerPool pool;
+	printf("WorkerPool with %u threads\n", pool.GetThreadCount());
+
+	unsigned int counts[] = { 1000, 10000, 100000, 1000000 };
+	for (unsigned int count : counts)
+	{
+		std::vector<AABB> boxes = MakeScene(count, 7);
+		std::vector<unsigned int> ids(count);
+		for (unsigned int i = 0; i < count; i++)
+			ids[i] = i;
+
+		// Big builds are slow enough that fewer runs will do
+		int buildRepeats = count >= 1000000 ? 2 : Repeats;
+		SceneBVH bvh;
+		double serialBuild = BestMilliseconds(buildRepeats, [&]() { bvh.Build(boxes.data(), ids.data(), count, 0); });
+		double poolBuild = BestMilliseconds(buildRepeats, [&]() { bvh.Build(boxes.data(), ids.data(), count, &pool); });
+
+		// A camera on the ground looking across the scene
+		float halfWidth = 10.0f * sqrtf((float)count);
+		Frustum frustum = MakeSceneFrustum(XMFLOAT3(-halfWidth * 0.5f, 3, -halfWidth * 0.5f), XMFLOAT3(1, 0, 0.6f), halfWidth);
+		std::vector<unsigned int> results(count);
+		unsigned int visible = 0;
+		double cull = BestMilliseconds(Repeats, [&]() { visible = bvh.Cull(frustum, results.data()); });
+		double bruteCull = BestMilliseconds(Repeats, [&]()
+		{
+			unsigned int found = 0;
+			for (unsigned int i = 0; i < count; i++)
+				if (frustum.Intersects(boxes[i]))
+					results[found++] = i;
+			KeepResult(found);
+		});
+
+		// Small boxes and rays scattered over the scene
+		std::mt19937 generator(8);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+		std::vector<AABB> queryBoxes(QueryCount);
+		std::vector<XMFLOAT3> origins(QueryCount), directions(QueryCount);
+		for (int q = 0; q < QueryCount; q++)
+		{
+			XMFLOAT3 center((unit(generator) * 2 - 1) * halfWidth, unit(generator) * 40, (unit(generator) * 2 - 1) * halfWidth);
+			queryBoxes[q] = AABB(XMFLOAT3(center.x - 5, center.y - 5, center.z - 5), XMFLOAT3(center.x + 5, center.y + 5, center.z + 5));
+			origins[q] = center;
+			XMFLOAT3 target = boxes[(q * 7919u) % count].GetCenter();
+			directions[q] = XMFLOAT3(target.x - center.x, target.y - center.y, target.z - center.z);
+		}
+
+		double overlap = BestMilliseconds(Repeats, [&]()
+		{
+			unsigned int found = 0;
+			for (int q = 0; q < QueryCount; q++)
+				found += bvh.Overlap(queryBoxes[q], results.data());
+			KeepResult(found);
+		});
+		double bruteOverlap = BestMilliseconds(Repeats, [&]()
+		{
+			unsigned int found = 0;
+			for (int q = 0; q < QueryCount; q++)
+			{
+				const AABB& query = queryBoxes[q];
+				for (unsigned int i = 0; i < count; i++)
+				{
+					const AABB& b = boxes[i];
+					found += b.Min.x <= query.Max.x && b.Max.x >= query.Min.x && b.Min.y <= query.Max.y &&
+						b.Max.y >= query.Min.y && b.Min.z <= query.Max.z && b.Max.z >= query.Min.z;
+				}
+			}
+			KeepResult(found);
+		});
+
+		double raycast = BestMilliseconds(Repeats, [&]()
+		{
+			unsigned int hits = 0, id;
+			float distance;
+			for (int q = 0; q < QueryCount; q++)
+				hits += bvh.Raycast(origins[q], directions[q], 2.0f, id, distance);
+			KeepResult(hits);
+		});
+
+		printf("%u boxes (%u nodes, %u visible):\n", count, bvh.GetNodeCount(), visible);
+		printf("  Build, one thread   %9.2f ms\n", serialBuild);
+		printf("  Build, WorkerPool   %9.2f ms\n", poolBuild);
+		printf("  Cull                %9.3f ms   every box %9.3f ms  (%.1fx)\n", cull, bruteCull, bruteCull / cull);
+		printf("  %d Overlaps        %9.3f ms   every box %9.3f ms  (%.1fx)\n", QueryCount, overlap, bruteOverlap, bruteOverlap / overlap);
+		printf("  %d Raycasts        %9.3f ms\n", QueryCount, raycast);
+	}
+	return 0;
+}
@@ -0,0 +1,318 @@
+#include "TestHarness.h"
+#include "Scenes.h"
+#include "SceneBVH.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <cstdint>
+
+using namespace DirectX;
+
+namespace
+{
+	// Ids that aren't just the index, so a mix-up between the two shows
+	unsigned int IdOf(unsigned int index) { return index * 3 + 7; }
+
+	std::vector<unsigned int> MakeIds(unsigned int count)
+	{
+		std::vector<unsigned int> ids(count);
+		for (unsigned int i = 0; i < count; i++)
+			ids[i] = IdOf(i);
+		return ids;
+	}
+
+	std::vector<unsigned int> Sorted(const unsigned int* ids, unsigned int count)
+	{
+		std::vector<unsigned int> sorted(ids, ids + count);
+		std::sort(sorted.begin(), sorted.end());
+		return sorted;
+	}
+
+	// The answers the tree has to give, found by testing every box
+
+	std::vector<unsigned int> BruteForceCull(const std::vector<AABB>& boxes, const Frustum& frustum)
+	{
+		std::vector<unsigned int> visible;
+		for (unsigned int i = 0; i < boxes.size(); i++)
+			if (frustum.Intersects(boxes[i]))
+				visible.push_back(IdOf(i));
+		return visible;
+	}
+
+	std::vector<unsigned int> BruteForceOverlap(const std::vector<AABB>& boxes, const AABB& box)
+	{
+		std::vector<unsigned int> touching;
+		for (unsigned int i = 0; i < boxes.size(); i++)
+		{
+			const AABB& b = boxes[i];
+			if (b.Min.x <= box.Max.x && b.Max.x >= box.Min.x && b.Min.y <= box.Max.y && b.Max.y >= box.Min.y && b.Min.z <= box.Max.z && b.Max.z >= box.Min.z)
+				touching.push_back(IdOf(i));
+		}
+		return touching;
+	}
+
+	// Where the ray enters a box, the same slab test the tree uses - down to
+	// multiplying by the inverse direction, so distances match to the bit
+	bool RayEnters(const AABB& box, XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, float& entry)
+	{
+		XMFLOAT3 inverse(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+		float x1 = (box.Min.x - origin.x) * inverse.x, x2 = (box.Max.x - origin.x) * inverse.x;
+		float y1 = (box.Min.y - origin.y) * inverse.y, y2 = (box.Max.y - origin.y) * inverse.y;
+		float z1 = (box.Min.z - origin.z) * inverse.z, z2 = (box.Max.z - origin.z) * inverse.z;
+		float enter = std::max(std::max(std::min(x1, x2), std::min(y1, y2)), std::max(std::min(z1, z2), 0.0f));
+		float exit = std::min(std::min(std::max(x1, x2), std::max(y1, y2)), std::min(std::max(z1, z2), maxDistance));
+		entry = enter;
+		return enter <= exit;
+	}
+
+	bool BruteForceRaycast(const std::vector<AABB>& boxes, XMFLOAT3 origin, XMFLOAT3 direction, float maxDistance, float& nearest)
+	{
+		bool hit = false;
+		nearest = maxDistance;
+		for (const AABB& box : boxes)
+		{
+			float entry;
+			if (RayEnters(box, origin, direction, nearest, entry) && (!hit || entry < nearest))
+			{
+				nearest = entry;
+				hit = true;
+			}
+		}
+		return hit;
+	}
+
+	bool Contains(const BVHNode& outer, const BVHNode& inner)
+	{
+		return outer.Min.x <= inner.Min.x && outer.Min.y <= inner.Min.y && outer.Min.z <= inner.Min.z &&
+			outer.Max.x >= inner.Max.x && outer.Max.y >= inner.Max.y && outer.Max.z >= inner.Max.z;
+	}
+
+	// Every child inside its parent, siblings paired on even indices, and the
+	// leaves sharing out the primitives with none left over or counted twice
+	bool IsWellFormed(SceneBVH& bvh)
+	{
+		const BVHNode* nodes = bvh.GetNodes();
+		if ((uintptr_t)nodes % 64 != 0)
+			return false;
+
+		std::vector<int> covered(bvh.GetPrimitiveCount(), 0);
+		std::vector<unsigned int> stack(1, 0);
+		unsigned int reached = 1;
+		while (!stack.empty())
+		{
+			const BVHNode& node = nodes[stack.back()];
+			stack.pop_back();
+
+			if (node.Count > 0)
+			{
+				if (node.LeftFirst + node.Count > covered.size())
+					return false;
+				for (unsigned int i = node.LeftFirst; i < node.LeftFirst + node.Count; i++)
+					covered[i]++;
+				continue;
+			}
+
+			if (node.LeftFirst % 2 != 0 || node.LeftFirst + 1 >= bvh.GetNodeCount())
+				return false;
+			for (unsigned int c = 0; c < 2; c++)
+			{
+				if (!Contains(node, nodes[node.LeftFirst + c]))
+					return false;
+				stack.push_back(node.LeftFirst + c);
+				reached++;
+			}
+		}
+
+		// Root, the empty slot after it, and every node once
+		if (reached + 1 != bvh.GetNodeCount())
+			return false;
+		for (int c : covered)
+			if (c != 1)
+				return false;
+		return true;
+	}
+
+	// Cameras at ground level and up high, looking across and down the scene
+	std::vector<Frustum> MakeCameras(unsigned int count)
+	{
+		float halfWidth = 10.0f * sqrtf((float)count);
+		std::vector<Frustum> cameras;
+		cameras.push_back(MakeSceneFrustum(XMFLOAT3(0, 2, 0), XMFLOAT3(0, 0, 1), halfWidth));
+		cameras.push_back(MakeSceneFrustum(XMFLOAT3(-halfWidth, 10, -halfWidth), XMFLOAT3(1, -0.1f, 1), halfWidth * 3));
+		cameras.push_back(MakeSceneFrustum(XMFLOAT3(halfWidth * 0.3f, 200, 0), XMFLOAT3(0.2f, -1, 0.3f), 400));
+		cameras.push_back(MakeSceneFrustum(XMFLOAT3(0, 20, -halfWidth * 2), XMFLOAT3(0, 0, -1), halfWidth));
+		return cameras;
+	}
+}
+
+TEST(CullMatchesBruteForce)
+{
+	WorkerPool pool(3);
+	unsigned int counts[] = { 1, 7, 1000, 10000, 100000 };
+	for (unsigned int count : counts)
+	{
+		std::vector<AABB> boxes = MakeScene(count, count);
+		std::vector<unsigned int> ids = MakeIds(count);
+		SceneBVH bvh;
+		bvh.Build(boxes.data(), ids.data(), count, &pool);
+		CHECK(IsWellFormed(bvh));
+
+		std::vector<unsigned int> visible(count);
+		for (const Frustum& frustum : MakeCameras(count))
+		{
+			std::vector<unsigned int> expected = BruteForceCull(boxes, frustum);
+
+			// Twice, since the second pass starts from the planes that culled each node the first time
+			for (int pass = 0; pass < 2; pass++)
+			{
+				unsigned int visibleCount = bvh.Cull(frustum, visible.data());
+				CHECK(Sorted(visible.data(), visibleCount) == expected);
+				CHECK_EQUAL(visibleCount, bvh.GetStats().Results);
+			}
+		}
+	}
+}
+
+TEST(OverlapMatchesBruteForce)
+{
+	const unsigned int count = 20000;
+	std::vector<AABB> boxes = MakeScene(count, 11);
+	std::vector<unsigned int> ids = MakeIds(count);
+	SceneBVH bvh;
+	bvh.Build(boxes.data(), ids.data(), count, 0);
+
+	std::mt19937 generator(12);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float halfWidth = 10.0f * sqrtf((float)count);
+
+	std::vector<unsigned int> results(count);
+	for (int q = 0; q < 200; q++)
+	{
+		// From points to boxes bigger than the scene, and the scene's own boxes
+		AABB box;
+		if (q % 5 == 0)
+			box = boxes[q * 97 % count];
+		else
+		{
+			XMFLOAT3 center((unit(generator) * 2 - 1) * halfWidth, unit(generator) * 40, (unit(generator) * 2 - 1) * halfWidth);
+			float size = q % 7 == 0 ? 0.0f : powf(unit(generator), 3) * halfWidth;
+			box = AABB(XMFLOAT3(center.x - size, center.y - size, center.z - size), XMFLOAT3(center.x + size, center.y + size, center.z + size));
+		}
+
+		unsigned int found = bvh.Overlap(box, results.data());
+		CHECK(Sorted(results.data(), found) == BruteForceOverlap(boxes, box));
+	}
+}
+
+TEST(RaycastFindsTheNearestBox)
+{
+	const unsigned int count = 20000;
+	std::vector<AABB> boxes = MakeScene(count, 21);
+	std::vector<unsigned int> ids = MakeIds(count);
+	SceneBVH bvh;
+	bvh.Build(boxes.data(), ids.data(), count, 0);
+
+	std::mt19937 generator(22);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	float halfWidth = 10.0f * sqrtf((float)count);
+
+	int hits = 0;
+	for (int r = 0; r < 500; r++)
+	{
+		XMFLOAT3 origin((unit(generator) * 2 - 1) * halfWidth, unit(generator) * 40, (unit(generator) * 2 - 1) * halfWidth);
+		XMFLOAT3 direction(unit(generator) * 2 - 1, unit(generator) - 0.8f, unit(generator) * 2 - 1);
+		if (r % 2 == 0)
+		{
+			// Aimed at a box, which may be far off or hidden behind others
+			XMFLOAT3 target = boxes[r * 131 % count].GetCenter();
+			direction = XMFLOAT3(target.x - origin.x, target.y - origin.y, target.z - origin.z);
+		}
+		if (r % 10 == 0)
+			direction = XMFLOAT3(0, -1, 0);	// Straight down, so two of the components are zero
+		float maxDistance = r % 3 == 0 ? 50.0f : 1e6f;
+
+		float expectedDistance;
+		bool expectedHit = BruteForceRaycast(boxes, origin, direction, maxDistance, expectedDistance);
+
+		unsigned int id = 0;
+		float distance = -1;
+		bool hit = bvh.Raycast(origin, direction, maxDistance, id, distance);
+		CHECK_EQUAL(expectedHit, hit);
+		if (!hit || !expectedHit)
+			continue;
+		hits++;
+
+		// Boxes can tie, so check the distance, and that the box hit is really there
+		CHECK_EQUAL(expectedDistance, distance);
+		float entry;
+		CHECK(id >= 7 && (id - 7) % 3 == 0 && (id - 7) / 3 < count);
+		CHECK(RayEnters(boxes[(id - 7) / 3], origin, direction, maxDistance, entry) && entry == distance);
+	}
+
+	// Enough of both to mean something
+	CHECK(hits > 50 && hits < 450);
+}
+
+TEST(PoolBuildsTheSameSetsAsOneThread)
+{
+	const unsigned int count = 100000;
+	std::vector<AABB> boxes = MakeScene(count, 31);
+	std::vector<unsigned int> ids = MakeIds(count);
+
+	WorkerPool pool(4);
+	SceneBVH serial, parallel;
+	serial.Build(boxes.data(), ids.data(), count, 0);
+	parallel.Build(boxes.data(), ids.data(), count, &pool);
+	CHECK(IsWellFormed(serial));
+	CHECK(IsWellFormed(parallel));
+
+	std::vector<unsigned int> a(count), b(count);
+	for (const Frustum& frustum : MakeCameras(count))
+	{
+		unsigned int aCount = serial.Cull(frustum, a.data());
+		unsigned int bCount = parallel.Cull(frustum, b.data());
+		CHECK(Sorted(a.data(), aCount) == Sorted(b.data(), bCount));
+	}
+}
+
+TEST(IdenticalBoxesStillBuild)
+{
+	// Every centroid in one place, so no split can separate them
+	const unsigned int count = 5000;
+	std::vector<AABB> boxes(count, AABB(XMFLOAT3(-1, -1, -1), XMFLOAT3(1, 1, 1)));
+	std::vector<unsigned int> ids = MakeIds(count);
+	SceneBVH bvh;
+	bvh.Build(boxes.data(), ids.data(), count, 0);
+	CHECK(IsWellFormed(bvh));
+
+	std::vector<unsigned int> results(count);
+	CHECK_EQUAL(count, bvh.Overlap(AABB(XMFLOAT3(0, 0, 0), XMFLOAT3(0, 0, 0)), results.data()));
+	CHECK(Sorted(results.data(), count) == ids);
+	CHECK_EQUAL(count, bvh.Cull(MakeSceneFrustum(XMFLOAT3(0, 0, -10), XMFLOAT3(0, 0, 1), 100), results.data()));
+	CHECK_EQUAL(0u, bvh.Cull(MakeSceneFrustum(XMFLOAT3(0, 0, -10), XMFLOAT3(0, 0, -1), 100), results.data()));
+}
+
+TEST(RebuildingReplacesTheTree)
+{
+	std::vector<AABB> first = MakeScene(3000, 41);
+	std::vector<AABB> second = MakeScene(500, 42);
+	std::vector<unsigned int> ids = MakeIds(3000);
+
+	SceneBVH bvh;
+	bvh.Build(first.data(), ids.data(), 3000, 0);
+	bvh.Build(second.data(), ids.data(), 500, 0);
+	CHECK_EQUAL(500u, bvh.GetPrimitiveCount());
+	CHECK(IsWellFormed(bvh));
+
+	AABB everything(XMFLOAT3(-1e6f, -1e6f, -1e6f), XMFLOAT3(1e6f, 1e6f, 1e6f));
+	std::vector<unsigned int> results(3000);
+	unsigned int found = bvh.Overlap(everything, results.data());
+	CHECK(Sorted(results.data(), found) == MakeIds(500));
+
+	// And down to nothing
+	bvh.Build(first.data(), ids.data(), 0, 0);
+	unsigned int id;
+	float distance;
+	CHECK_EQUAL(0u, bvh.Overlap(everything, results.data()));
+	CHECK_EQUAL(0u, bvh.Cull(MakeCameras(100)[0], results.data()));
+	CHECK(!bvh.Raycast(XMFLOAT3(0, 0, 0), XMFLOAT3(1, 0, 0), 1e6f, id, distance));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <random>
+#include <vector>
+#include "Bounds.h"
+
+// --------------------------------------------------------
+// Generated scenes for the BVH tests and benchmarks: boxes
+// of mixed sizes, most scattered over a large ground area
+// and some piled up in dense clusters, the way props and
+// debris gather in a real level.
+// --------------------------------------------------------
+inline std::vector<AABB> MakeScene(unsigned int count, unsigned int seed)
+{
+	std::mt19937 generator(seed);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	// The area grows with the count, so density stays about the same
+	float halfWidth = 10.0f * sqrtf((float)count);
+	std::vector<DirectX::XMFLOAT3> clusters(8 + count / 2000);
+	for (DirectX::XMFLOAT3& cluster : clusters)
+		cluster = DirectX::XMFLOAT3((unit(generator) * 2 - 1) * halfWidth, unit(generator) * 20.0f, (unit(generator) * 2 - 1) * halfWidth);
+
+	std::vector<AABB> boxes(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		DirectX::XMFLOAT3 center;
+		if (i % 4 == 0)
+		{
+			const DirectX::XMFLOAT3& cluster = clusters[i / 4 % clusters.size()];
+			center = DirectX::XMFLOAT3(cluster.x + unit(generator) * 6 - 3, cluster.y + unit(generator) * 6 - 3, cluster.z + unit(generator) * 6 - 3);
+		}
+		else
+			center = DirectX::XMFLOAT3((unit(generator) * 2 - 1) * halfWidth, unit(generator) * 40.0f, (unit(generator) * 2 - 1) * halfWidth);
+
+		// Mostly small, a few large, some flat
+		float size = unit(generator);
+		size = i % 50 == 0 ? 20.0f * size : 0.2f + 2.0f * size * size;
+		float height = i % 9 == 0 ? 0.0f : size * (0.5f + unit(generator));
+		boxes[i] = AABB(
+			DirectX::XMFLOAT3(center.x - size, center.y - height, center.z - size),
+			DirectX::XMFLOAT3(center.x + size, center.y + height, center.z + size));
+	}
+	return boxes;
+}
+
+// A camera standing somewhere in a scene made by MakeScene, looking along direction
+inline Frustum MakeSceneFrustum(DirectX::XMFLOAT3 position, DirectX::XMFLOAT3 direction, float farDistance)
+{
+	DirectX::XMMATRIX view = DirectX::XMMatrixLookToLH(DirectX::XMLoadFloat3(&position), DirectX::XMLoadFloat3(&direction), DirectX::XMVectorSet(0, 1, 0, 0));
+	DirectX::XMMATRIX projection = DirectX::XMMatrixPerspectiveFovLH(DirectX::XM_PIDIV4, 16.0f / 9.0f, 0.1f, farDistance);
+	return Frustum(DirectX::XMMatrixMultiply(view, projection));
+}
@@ -0,0 +1,82 @@
+#include "TestHarness.h"
+#include "Shaders/PackingConstants.h"
+
+using namespace ShaderConstants::PackingEdgeCases;
+
+// The generated static_asserts only check the C++ structs against the
+// generator's own sums.  These offsets are worked out by hand from HLSL's
+// packing rules, so a mistake in the generator doesn't check itself.
+
+namespace
+{
+	template<typename Buffer, typename Member>
+	size_t OffsetOf(const Buffer& buffer, const Member& member)
+	{
+		return (const char*)&member - (const char*)&buffer;
+	}
+}
+
+TEST(VectorsPackUntilTheyWouldCrossARegister)
+{
+	Vectors buffer;
+	CHECK_EQUAL((size_t)0, OffsetOf(buffer, buffer.position));
+	CHECK_EQUAL((size_t)12, OffsetOf(buffer, buffer.intensity));
+	CHECK_EQUAL((size_t)16, OffsetOf(buffer, buffer.uv));
+	CHECK_EQUAL((size_t)32, OffsetOf(buffer, buffer.straddle));
+	CHECK_EQUAL((size_t)44, OffsetOf(buffer, buffer.tail));
+	CHECK_EQUAL((size_t)48, sizeof(Vectors));
+}
+
+TEST(ArrayElementsEachStartARegister)
+{
+	Arrays buffer;
+	CHECK_EQUAL((size_t)0, OffsetOf(buffer, buffer.weights[0]));
+	CHECK_EQUAL((size_t)16, OffsetOf(buffer, buffer.weights[1]));
+	CHECK_EQUAL((size_t)32, OffsetOf(buffer, buffer.weights[2]));
+	CHECK_EQUAL((size_t)36, OffsetOf(buffer, buffer.afterWeights));
+
+	CHECK_EQUAL((size_t)48, OffsetOf(buffer, buffer.offsets[0]));
+	CHECK_EQUAL((size_t)64, OffsetOf(buffer, buffer.offsets[1]));
+	CHECK_EQUAL((size_t)72, OffsetOf(buffer, buffer.afterOffsets));
+
+	CHECK_EQUAL((size_t)80, OffsetOf(buffer, buffer.colors[0]));
+	CHECK_EQUAL((size_t)96, OffsetOf(buffer, buffer.colors[1]));
+	CHECK_EQUAL((size_t)112, sizeof(Arrays));
+}
+
+TEST(ArrayElementsAreWrittenWhereHLSLReadsThem)
+{
+	Arrays buffer = {};
+	buffer.weights[0] = 1.0f;
+	buffer.weights[1] = 2.0f;
+	buffer.weights[2] = 3.0f;
+
+	const float* floats = (const float*)&buffer;
+	CHECK_EQUAL(1.0f, floats[0]);
+	CHECK_EQUAL(2.0f, floats[4]);
+	CHECK_EQUAL(3.0f, floats[8]);
+}
+
+TEST(MatricesStartARegisterAndShareTheirLast)
+{
+	Matrices buffer;
+	CHECK_EQUAL((size_t)0, OffsetOf(buffer, buffer.single));
+	CHECK_EQUAL((size_t)16, OffsetOf(buffer, buffer.rotation));
+	CHECK_EQUAL((size_t)60, OffsetOf(buffer, buffer.afterRotation));
+	CHECK_EQUAL((size_t)64, OffsetOf(buffer, buffer.rows));
+	CHECK_EQUAL((size_t)128, OffsetOf(buffer, buffer.world));
+	CHECK_EQUAL((size_t)192, sizeof(Matrices));
+}
+
+TEST(StructsStartAndEndOnRegisters)
+{
+	Structs buffer;
+	CHECK_EQUAL((size_t)32, sizeof(Light));
+	CHECK_EQUAL((size_t)0, OffsetOf(buffer, buffer.lead));
+	CHECK_EQUAL((size_t)16, OffsetOf(buffer, buffer.light));
+	CHECK_EQUAL((size_t)28, OffsetOf(buffer, buffer.light.range));
+	CHECK_EQUAL((size_t)48, OffsetOf(buffer, buffer.afterLight));
+	CHECK_EQUAL((size_t)64, OffsetOf(buffer, buffer.lights[0]));
+	CHECK_EQUAL((size_t)96, OffsetOf(buffer, buffer.lights[1]));
+	CHECK_EQUAL((size_t)128, sizeof(Structs));
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Recording.h"
+#include "ShaderReflectionCache.h"
+#include "SimpleShader.h"
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// Loads real SimpleShaders onto the recording device with
+// no compiled bytecode and no D3DReflect.  Each shader's
+// "bytecode" is just its name, written to a temporary file,
+// and the reflection the test describes is put in the cache
+// under it beforehand.
+// --------------------------------------------------------
+class ShaderFixture
+{
+public:
+	RecordingDevice Device;
+	RecordingContext Context;
+
+	ShaderFixture() : cache((std::filesystem::temp_directory_path() / "GraphXpoTestsReflection.bin").string())
+	{
+		ISimpleShader::SetReflectionCache(&cache);
+	}
+
+	~ShaderFixture()
+	{
+		ISimpleShader::SetReflectionCache(0);
+		for (const std::string& file : files)
+			remove(file.c_str());
+	}
+
+	// Write the shader's bytecode file and cache its reflection, without loading it.
+	// Returns the file to load.
+	std::wstring Prepare(const std::string& name, const ShaderReflectionData& reflection)
+	{
+		std::string file = (std::filesystem::temp_directory_path() / ("GraphXpoTests_" + name + ".cso")).string();
+		FILE* out = fopen(file.c_str(), "wb");
+		fwrite(name.data(), 1, name.size(), out);
+		fclose(out);
+		files.push_back(file);
+
+		cache.Store(name.data(), name.size(), reflection);
+		return std::wstring(file.begin(), file.end());
+	}
+
+	// The shader is the caller's to delete
+	template<typename Shader>
+	Shader* Load(const std::string& name, const ShaderReflectionData& reflection)
+	{
+		std::wstring file = Prepare(name, reflection);
+		Shader* shader = new Shader(&Device, &Context);
+		shader->LoadShaderFile(file.c_str());
+		return shader;
+	}
+
+private:
+	ShaderReflectionCache cache;
+	std::vector<std::string> files;
+};
+
+// The per-object constant buffer of VertexShader.hlsl
+inline ShaderReflectionData MakeEntityVertexReflection()
+{
+	ShaderReflectionData data;
+
+	ReflectedConstantBuffer externalData = { "externalData", 0, 0, 272, {} };
+	externalData.Variables.push_back({ "world", 0, 64 });
+	externalData.Variables.push_back({ "invTransWorld", 64, 64 });
+	externalData.Variables.push_back({ "view", 128, 64 });
+	externalData.Variables.push_back({ "projection", 192, 64 });
+	externalData.Variables.push_back({ "uvScale", 256, 4 });
+	data.ConstantBuffers.push_back(externalData);
+
+	// Component types are D3D_REGISTER_COMPONENT_TYPE: 3 is float
+	data.InputParameters.push_back({ "POSITION", 0, 3, 7 });
+	data.InputParameters.push_back({ "TEXCOORD", 0, 3, 3 });
+	data.InputParameters.push_back({ "NORMAL", 0, 3, 7 });
+	data.InputParameters.push_back({ "TANGENT", 0, 3, 7 });
+	return data;
+}
@@ -0,0 +1,226 @@
+#include "TestHarness.h"
+#include "ShaderFixture.h"
+#include "ShaderLibrary.h"
+#include "StartupTimer.h"
+#include "WorkerPool.h"
+
+namespace
+{
+	// Descriptions are filled over memory of the given byte, as a stack
+	// variable set member by member would leave its padding
+	D3D11_BLEND_DESC MakeBlend(unsigned char fill, BOOL enable, BYTE writeMask)
+	{
+		D3D11_BLEND_DESC desc;
+		memset(&desc, fill, sizeof(desc));
+		desc.AlphaToCoverageEnable = FALSE;
+		desc.IndependentBlendEnable = FALSE;
+		for (int i = 0; i < 8; i++)
+		{
+			desc.RenderTarget[i].BlendEnable = enable;
+			desc.RenderTarget[i].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+			desc.RenderTarget[i].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+			desc.RenderTarget[i].BlendOp = D3D11_BLEND_OP_ADD;
+			desc.RenderTarget[i].SrcBlendAlpha = D3D11_BLEND_ONE;
+			desc.RenderTarget[i].DestBlendAlpha = D3D11_BLEND_ZERO;
+			desc.RenderTarget[i].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+			desc.RenderTarget[i].RenderTargetWriteMask = writeMask;
+		}
+		return desc;
+	}
+
+	D3D11_DEPTH_STENCIL_DESC MakeDepthStencil(unsigned char fill, D3D11_DEPTH_WRITE_MASK writeMask)
+	{
+		D3D11_DEPTH_STENCIL_DESC desc;
+		memset(&desc, fill, sizeof(desc));
+		desc.DepthEnable = TRUE;
+		desc.DepthWriteMask = writeMask;
+		desc.DepthFunc = D3D11_COMPARISON_LESS_EQUAL;
+		desc.StencilEnable = FALSE;
+		desc.StencilReadMask = 0xFF;
+		desc.StencilWriteMask = 0xFF;
+		desc.FrontFace.StencilFailOp = D3D11_STENCIL_OP_KEEP;
+		desc.FrontFace.StencilDepthFailOp = D3D11_STENCIL_OP_KEEP;
+		desc.FrontFace.StencilPassOp = D3D11_STENCIL_OP_KEEP;
+		desc.FrontFace.StencilFunc = D3D11_COMPARISON_ALWAYS;
+		desc.BackFace = desc.FrontFace;
+		return desc;
+	}
+
+	D3D11_RASTERIZER_DESC MakeRasterizer(D3D11_CULL_MODE cull)
+	{
+		D3D11_RASTERIZER_DESC desc = {};
+		desc.FillMode = D3D11_FILL_SOLID;
+		desc.CullMode = cull;
+		desc.DepthClipEnable = TRUE;
+		return desc;
+	}
+
+	// Two shaders that load and one whose file is missing, added to the library
+	struct LoadScene
+	{
+		ShaderFixture Fixture;
+		ShaderLibrary Library;
+		std::shared_ptr<SimpleVertexShader> Vertex;
+		std::shared_ptr<SimplePixelShader> Pixel;
+		std::shared_ptr<SimplePixelShader> Missing;
+
+		LoadScene(WorkerPool* workerPool) : Library(&Fixture.Device, &Fixture.Context, workerPool)
+		{
+			std::wstring vertexFile = Fixture.Prepare("LibraryVS", MakeEntityVertexReflection());
+			std::wstring pixelFile = Fixture.Prepare("LibraryPS", ShaderReflectionData());
+
+			Vertex = Library.AddVertexShader(vertexFile.c_str());
+			Pixel = Library.AddPixelShader(pixelFile.c_str());
+			Missing = Library.AddPixelShader(L"GraphXpoTests_NoSuchShader.cso");
+		}
+	};
+
+	void CheckLoadCounts(WorkerPool* workerPool)
+	{
+		LoadScene scene(workerPool);
+		CHECK_EQUAL(3u, scene.Library.GetShaderCount());
+		CHECK(!scene.Vertex->IsShaderValid());
+
+		CHECK(!scene.Library.LoadAll());
+		CHECK_EQUAL(1u, scene.Library.GetFailedCount());
+		CHECK(scene.Vertex->IsShaderValid());
+		CHECK(scene.Pixel->IsShaderValid());
+		CHECK(!scene.Missing->IsShaderValid());
+	}
+}
+
+TEST(EqualBlendStatesAreSharedWhateverThePadding)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	ShaderLibrary library(&device, &context, 0);
+
+	D3D11_BLEND_DESC zeroed = MakeBlend(0x00, TRUE, D3D11_COLOR_WRITE_ENABLE_ALL);
+	D3D11_BLEND_DESC garbage = MakeBlend(0xCD, TRUE, D3D11_COLOR_WRITE_ENABLE_ALL);
+	CHECK(memcmp(&zeroed, &garbage, sizeof(zeroed)) != 0);
+
+	ID3D11BlendState* first = library.GetBlendState(zeroed);
+	ID3D11BlendState* second = library.GetBlendState(garbage);
+	CHECK(first != 0);
+	CHECK(first == second);
+	CHECK_EQUAL(1u, device.StatesCreated);
+	CHECK_EQUAL(1u, library.GetStateMisses());
+	CHECK_EQUAL(1u, library.GetStateHits());
+}
+
+TEST(AnyNonZeroBoolIsTheSameState)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	ShaderLibrary library(&device, &context, 0);
+
+	ID3D11BlendState* one = library.GetBlendState(MakeBlend(0x00, TRUE, D3D11_COLOR_WRITE_ENABLE_ALL));
+	ID3D11BlendState* other = library.GetBlendState(MakeBlend(0x00, 7, D3D11_COLOR_WRITE_ENABLE_ALL));
+	CHECK(one == other);
+	CHECK_EQUAL(1u, device.StatesCreated);
+}
+
+TEST(EqualDepthStencilStatesAreSharedWhateverThePadding)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	ShaderLibrary library(&device, &context, 0);
+
+	ID3D11DepthStencilState* first = library.GetDepthStencilState(MakeDepthStencil(0x00, D3D11_DEPTH_WRITE_MASK_ALL));
+	ID3D11DepthStencilState* second = library.GetDepthStencilState(MakeDepthStencil(0xCD, D3D11_DEPTH_WRITE_MASK_ALL));
+	CHECK(first != 0);
+	CHECK(first == second);
+	CHECK_EQUAL(1u, device.StatesCreated);
+}
+
+TEST(DifferentDescriptionsGetTheirOwnStates)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	ShaderLibrary library(&device, &context, 0);
+
+	// Only the byte-sized write mask differs, right beside the padding
+	ID3D11BlendState* all = library.GetBlendState(MakeBlend(0x00, TRUE, D3D11_COLOR_WRITE_ENABLE_ALL));
+	ID3D11BlendState* red = library.GetBlendState(MakeBlend(0x00, TRUE, D3D11_COLOR_WRITE_ENABLE_RED));
+	CHECK(all != red);
+
+	ID3D11DepthStencilState* writes = library.GetDepthStencilState(MakeDepthStencil(0x00, D3D11_DEPTH_WRITE_MASK_ALL));
+	ID3D11DepthStencilState* readOnly = library.GetDepthStencilState(MakeDepthStencil(0x00, D3D11_DEPTH_WRITE_MASK_ZERO));
+	CHECK(writes != readOnly);
+
+	ID3D11RasterizerState* back = library.GetRasterizerState(MakeRasterizer(D3D11_CULL_BACK));
+	ID3D11RasterizerState* none = library.GetRasterizerState(MakeRasterizer(D3D11_CULL_NONE));
+	CHECK(back != none);
+	CHECK(back == library.GetRasterizerState(MakeRasterizer(D3D11_CULL_BACK)));
+
+	CHECK_EQUAL(6u, device.StatesCreated);
+	CHECK_EQUAL(6u, library.GetStateMisses());
+	CHECK_EQUAL(1u, library.GetStateHits());
+}
+
+TEST(RejectedDescriptionsAreNotCached)
+{
+	RecordingDevice device;
+	RecordingContext context;
+	ShaderLibrary library(&device, &context, 0);
+
+	device.RejectStates = true;
+	CHECK(library.GetRasterizerState(MakeRasterizer(D3D11_CULL_BACK)) == 0);
+
+	// Asked again, the device gets another chance rather than a cached failure
+	device.RejectStates = false;
+	CHECK(library.GetRasterizerState(MakeRasterizer(D3D11_CULL_BACK)) != 0);
+	CHECK_EQUAL(1u, device.StatesCreated);
+	CHECK_EQUAL(2u, library.GetStateMisses());
+	CHECK_EQUAL(0u, library.GetStateHits());
+}
+
+TEST(AddingAFileTwiceGivesTheSameShader)
+{
+	LoadScene scene(0);
+	std::wstring vertexFile = scene.Fixture.Prepare("LibraryVS", MakeEntityVertexReflection());
+
+	CHECK(scene.Library.AddVertexShader(vertexFile.c_str()) == scene.Vertex);
+	CHECK_EQUAL(3u, scene.Library.GetShaderCount());
+}
+
+TEST(LoadAllCountsFailuresOnTheCallingThread)
+{
+	CheckLoadCounts(0);
+}
+
+TEST(LoadAllCountsFailuresOnWorkers)
+{
+	WorkerPool workerPool(4);
+	CheckLoadCounts(&workerPool);
+}
+
+TEST(LoadAllOnlyLoadsWhatWasAddedSince)
+{
+	LoadScene scene(0);
+	CHECK(!scene.Library.LoadAll());
+
+	// The earlier failure is still counted, but isn't retried
+	std::wstring laterFile = scene.Fixture.Prepare("LibraryLaterPS", ShaderReflectionData());
+	std::shared_ptr<SimplePixelShader> later = scene.Library.AddPixelShader(laterFile.c_str());
+	CHECK(scene.Library.LoadAll());
+	CHECK(later->IsShaderValid());
+	CHECK_EQUAL(4u, scene.Library.GetShaderCount());
+	CHECK_EQUAL(1u, scene.Library.GetFailedCount());
+}
+
+TEST(StartupPhasesAddUpToTheTotal)
+{
+	StartupTimer timer;
+	CHECK_EQUAL(0.0, timer.GetTotalMilliseconds());
+
+	timer.Begin("First");
+	timer.Begin("Second");
+	timer.End();
+	double total = timer.GetTotalMilliseconds();
+	CHECK(total >= 0.0);
+
+	// Ending again adds nothing
+	timer.End();
+	CHECK_EQUAL(total, timer.GetTotalMilliseconds());
+}
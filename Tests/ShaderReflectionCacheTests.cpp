@@ -0,0 +1,322 @@
+#include "TestHarness.h"
+#include "ShaderFixture.h"
+#include "ShaderReflectionCache.h"
+#include <d3dcompiler.h>
+
+#include <cstdio>
+
+namespace
+{
+	// Something shaped like a lit vertex shader with an instanced transform
+	ShaderReflectionData MakeReflection()
+	{
+		ShaderReflectionData data;
+
+		ReflectedConstantBuffer perFrame = { "perFrame", 0, 0, 144, {} };
+		perFrame.Variables.push_back({ "view", 0, 64 });
+		perFrame.Variables.push_back({ "projection", 64, 64 });
+		perFrame.Variables.push_back({ "cameraPos", 128, 12 });
+		data.ConstantBuffers.push_back(perFrame);
+
+		ReflectedConstantBuffer perObject = { "perObject", 0, 1, 64, {} };
+		perObject.Variables.push_back({ "world", 0, 64 });
+		data.ConstantBuffers.push_back(perObject);
+
+		data.Textures.push_back({ "diffuseTexture", 0 });
+		data.Textures.push_back({ "normalTexture", 1 });
+		data.Samplers.push_back({ "basicSampler", 0 });
+
+		// Component types are D3D_REGISTER_COMPONENT_TYPE: 1 uint, 2 sint, 3 float
+		data.InputParameters.push_back({ "POSITION", 0, 3, 7 });
+		data.InputParameters.push_back({ "TEXCOORD", 0, 3, 3 });
+		data.InputParameters.push_back({ "NORMAL", 0, 3, 7 });
+		data.InputParameters.push_back({ "WORLD_PER_INSTANCE", 2, 3, 15 });
+		data.InputParameters.push_back({ "BONE", 0, 1, 1 });
+		return data;
+	}
+
+	bool SameReflection(const ShaderReflectionData& a, const ShaderReflectionData& b)
+	{
+		if (a.ConstantBuffers.size() != b.ConstantBuffers.size() ||
+			a.Textures.size() != b.Textures.size() ||
+			a.Samplers.size() != b.Samplers.size() ||
+			a.InputParameters.size() != b.InputParameters.size())
+			return false;
+
+		for (size_t i = 0; i < a.ConstantBuffers.size(); i++)
+		{
+			const ReflectedConstantBuffer& x = a.ConstantBuffers[i];
+			const ReflectedConstantBuffer& y = b.ConstantBuffers[i];
+			if (x.Name != y.Name || x.Type != y.Type || x.BindIndex != y.BindIndex ||
+				x.Size != y.Size || x.Variables.size() != y.Variables.size())
+				return false;
+
+			for (size_t v = 0; v < x.Variables.size(); v++)
+			{
+				if (x.Variables[v].Name != y.Variables[v].Name ||
+					x.Variables[v].ByteOffset != y.Variables[v].ByteOffset ||
+					x.Variables[v].Size != y.Variables[v].Size)
+					return false;
+			}
+		}
+
+		for (size_t i = 0; i < a.Textures.size(); i++)
+			if (a.Textures[i].Name != b.Textures[i].Name || a.Textures[i].BindIndex != b.Textures[i].BindIndex)
+				return false;
+
+		for (size_t i = 0; i < a.Samplers.size(); i++)
+			if (a.Samplers[i].Name != b.Samplers[i].Name || a.Samplers[i].BindIndex != b.Samplers[i].BindIndex)
+				return false;
+
+		for (size_t i = 0; i < a.InputParameters.size(); i++)
+		{
+			const ReflectedInputParameter& x = a.InputParameters[i];
+			const ReflectedInputParameter& y = b.InputParameters[i];
+			if (x.SemanticName != y.SemanticName || x.SemanticIndex != y.SemanticIndex ||
+				x.ComponentType != y.ComponentType || x.Mask != y.Mask)
+				return false;
+		}
+		return true;
+	}
+
+	void PutU32(std::vector<unsigned char>& bytes, size_t at, uint32_t value)
+	{
+		for (int i = 0; i < 4; i++)
+			bytes[at + i] = (unsigned char)(value >> (i * 8));
+	}
+}
+
+TEST(RoundTripKeepsEverything)
+{
+	ShaderReflectionData original = MakeReflection();
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(original, bytes);
+
+	ShaderReflectionData loaded;
+	CHECK(ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), loaded));
+	CHECK(SameReflection(original, loaded));
+}
+
+TEST(RoundTripEmpty)
+{
+	ShaderReflectionData original;
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(original, bytes);
+
+	ShaderReflectionData loaded = MakeReflection();
+	CHECK(ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), loaded));
+	CHECK(SameReflection(original, loaded));
+}
+
+TEST(TruncatedDataIsRejected)
+{
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(MakeReflection(), bytes);
+
+	// Every prefix ends part way through something
+	for (size_t size = 0; size < bytes.size(); size++)
+	{
+		ShaderReflectionData loaded;
+		CHECK(!ShaderReflectionCache::Deserialize(bytes.data(), size, loaded));
+	}
+}
+
+TEST(TrailingBytesAreRejected)
+{
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(MakeReflection(), bytes);
+	bytes.push_back(0);
+
+	ShaderReflectionData loaded;
+	CHECK(!ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), loaded));
+}
+
+TEST(HugeCountsAreRejected)
+{
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(MakeReflection(), bytes);
+
+	// The constant buffer count comes first
+	PutU32(bytes, 0, 0xFFFFFFFF);
+	ShaderReflectionData loaded;
+	CHECK(!ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), loaded));
+}
+
+TEST(VariableOutsideItsBufferIsRejected)
+{
+	ShaderReflectionData data = MakeReflection();
+	data.ConstantBuffers[1].Variables[0].ByteOffset = 16;	// 16 + 64 > 64
+
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(data, bytes);
+
+	ShaderReflectionData loaded;
+	CHECK(!ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), loaded));
+}
+
+TEST(InputMaskPastWIsRejected)
+{
+	ShaderReflectionData data = MakeReflection();
+	data.InputParameters[2].Mask = 16;
+
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(data, bytes);
+
+	ShaderReflectionData loaded;
+	CHECK(!ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), loaded));
+}
+
+TEST(FileRoundTripAndStaleVersion)
+{
+	const char* path = "ShaderReflectionCacheTests.cache";
+	const unsigned char bytecode[] = { 'D', 'X', 'B', 'C', 1, 2, 3, 4 };
+	ShaderReflectionData original = MakeReflection();
+
+	{
+		ShaderReflectionCache cache(path);
+		cache.Store(bytecode, sizeof(bytecode), original);
+		CHECK(cache.Save());
+	}
+
+	{
+		ShaderReflectionCache cache(path);
+		CHECK(cache.Load());
+
+		ShaderReflectionData loaded;
+		CHECK(cache.Find(bytecode, sizeof(bytecode), loaded));
+		CHECK(SameReflection(original, loaded));
+
+		// Same hash input, different size
+		CHECK(!cache.Find(bytecode, sizeof(bytecode) - 1, loaded));
+		CHECK_EQUAL(1u, cache.GetHitCount());
+		CHECK_EQUAL(1u, cache.GetMissCount());
+	}
+
+	// A file from an older version is ignored rather than misread
+	{
+		FILE* file = std::fopen(path, "r+b");
+		CHECK(file != nullptr);
+		if (file)
+		{
+			const unsigned char version[4] = { 1, 0, 0, 0 };
+			std::fseek(file, 4, SEEK_SET);
+			std::fwrite(version, 1, 4, file);
+			std::fclose(file);
+		}
+
+		ShaderReflectionCache cache(path);
+		CHECK(!cache.Load());
+	}
+
+	std::remove(path);
+}
+
+TEST(VertexShaderInputLayoutComesFromTheCache)
+{
+	ShaderFixture fixture;
+	unsigned int reflectCalls = ShimReflectCalls();
+
+	// Component types are D3D_REGISTER_COMPONENT_TYPE: 1 uint, 2 sint, 3 float
+	ShaderReflectionData reflection;
+	reflection.InputParameters.push_back({ "POSITION", 0, 3, 7 });
+	reflection.InputParameters.push_back({ "TEXCOORD", 0, 3, 3 });
+	reflection.InputParameters.push_back({ "BONE", 0, 1, 1 });
+	reflection.InputParameters.push_back({ "OFFSET", 0, 2, 15 });
+	reflection.InputParameters.push_back({ "WORLD_PER_INSTANCE", 2, 3, 15 });
+	SimpleVertexShader* shader = fixture.Load<SimpleVertexShader>("CachedLayoutVS", reflection);
+
+	CHECK(shader->IsShaderValid());
+	CHECK(shader->GetInputLayout() != nullptr);
+	CHECK(shader->GetPerInstanceCompatible());
+	CHECK_EQUAL(reflectCalls, ShimReflectCalls());
+
+	const std::vector<RecordedInputElement>& elements = fixture.Device.InputElements;
+	CHECK_EQUAL(5u, (unsigned int)elements.size());
+	if (elements.size() == 5)
+	{
+		CHECK_EQUAL(std::string("POSITION"), elements[0].SemanticName);
+		CHECK_EQUAL(DXGI_FORMAT_R32G32B32_FLOAT, elements[0].Format);
+		CHECK_EQUAL(DXGI_FORMAT_R32G32_FLOAT, elements[1].Format);
+		CHECK_EQUAL(DXGI_FORMAT_R32_UINT, elements[2].Format);
+		CHECK_EQUAL(DXGI_FORMAT_R32G32B32A32_SINT, elements[3].Format);
+		CHECK_EQUAL(D3D11_INPUT_PER_VERTEX_DATA, elements[3].InputSlotClass);
+
+		CHECK_EQUAL(std::string("WORLD_PER_INSTANCE"), elements[4].SemanticName);
+		CHECK_EQUAL(2u, elements[4].SemanticIndex);
+		CHECK_EQUAL(DXGI_FORMAT_R32G32B32A32_FLOAT, elements[4].Format);
+		CHECK_EQUAL(1u, elements[4].InputSlot);
+		CHECK_EQUAL(D3D11_INPUT_PER_INSTANCE_DATA, elements[4].InputSlotClass);
+		CHECK_EQUAL(1u, elements[4].InstanceDataStepRate);
+	}
+
+	delete shader;
+}
+
+TEST(RejectedEntryLeavesTheDataAlone)
+{
+	ShaderReflectionData data = MakeReflection();
+	data.InputParameters[2].Mask = 16;
+
+	// Fails after the buffers and resources have been read
+	std::vector<unsigned char> bytes;
+	ShaderReflectionCache::Serialize(data, bytes);
+
+	ShaderReflectionData loaded;
+	CHECK(!ShaderReflectionCache::Deserialize(bytes.data(), bytes.size(), loaded));
+	CHECK(SameReflection(ShaderReflectionData(), loaded));
+}
+
+namespace
+{
+	// Stands in for D3DReflect on a pixel shader with two textures and a sampler
+	struct TextureReflection : ID3D11ShaderReflection
+	{
+		HRESULT GetDesc(D3D11_SHADER_DESC* desc) override
+		{
+			*desc = D3D11_SHADER_DESC();
+			desc->BoundResources = 3;
+			return S_OK;
+		}
+
+		HRESULT GetResourceBindingDesc(UINT index, D3D11_SHADER_INPUT_BIND_DESC* desc) override
+		{
+			const char* names[] = { "diffuseTexture", "normalTexture", "basicSampler" };
+			*desc = D3D11_SHADER_INPUT_BIND_DESC();
+			desc->Name = names[index];
+			desc->Type = index < 2 ? D3D_SIT_TEXTURE : D3D_SIT_SAMPLER;
+			desc->BindPoint = index < 2 ? index : 0;
+			return S_OK;
+		}
+	};
+}
+
+TEST(CorruptEntryIsReflectedWithoutDuplicates)
+{
+	ShaderFixture fixture;
+	TextureReflection reflector;
+	ShimReflector() = &reflector;
+	unsigned int reflectCalls = ShimReflectCalls();
+
+	// The cached entry has the same resources, but is rejected at its input signature
+	ShaderReflectionData corrupt;
+	corrupt.Textures.push_back({ "diffuseTexture", 0 });
+	corrupt.Textures.push_back({ "normalTexture", 1 });
+	corrupt.Samplers.push_back({ "basicSampler", 0 });
+	corrupt.InputParameters.push_back({ "TEXCOORD", 0, 3, 16 });
+	SimplePixelShader* shader = fixture.Load<SimplePixelShader>("CorruptEntryPS", corrupt);
+	ShimReflector() = 0;
+
+	CHECK(shader->IsShaderValid());
+	CHECK_EQUAL(reflectCalls + 1, ShimReflectCalls());
+	CHECK_EQUAL(2u, (unsigned int)shader->GetShaderResourceViewCount());
+	CHECK_EQUAL(1u, (unsigned int)shader->GetSamplerCount());
+	if (shader->GetShaderResourceViewCount() == 2)
+	{
+		CHECK_EQUAL(0u, shader->GetShaderResourceViewInfo(0u)->BindIndex);
+		CHECK_EQUAL(1u, shader->GetShaderResourceViewInfo(1u)->BindIndex);
+	}
+	CHECK_EQUAL(1u, shader->GetShaderResourceViewInfo("normalTexture")->BindIndex);
+	CHECK_EQUAL(0u, shader->GetSamplerInfo("basicSampler")->BindIndex);
+
+	delete shader;
+}
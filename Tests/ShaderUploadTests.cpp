@@ -0,0 +1,186 @@
+#include "TestHarness.h"
+#include "ShaderFixture.h"
+
+using namespace DirectX;
+
+namespace
+{
+	// Loaded and given its first, whole-buffer copy, with the recording cleared after
+	SimpleVertexShader* LoadUploaded(ShaderFixture& fixture, const std::string& name, const ShaderReflectionData& reflection)
+	{
+		SimpleVertexShader* shader = fixture.Load<SimpleVertexShader>(name, reflection);
+		shader->CopyAllBufferData();
+		fixture.Context.Clear();
+		ISimpleShader::ResetFrameStats();
+		return shader;
+	}
+
+	XMFLOAT4X4 Translation(float x)
+	{
+		XMFLOAT4X4 matrix;
+		XMStoreFloat4x4(&matrix, XMMatrixTranslation(x, 0, 0));
+		return matrix;
+	}
+
+	// The GPU's copy of the buffer has to end up the same as the shader's
+	bool BufferMatches(SimpleVertexShader* shader)
+	{
+		const SimpleConstantBuffer* cb = shader->GetBufferInfo(0u);
+		RecordingBuffer* buffer = (RecordingBuffer*)cb->ConstantBuffer;
+		return buffer->Data.size() == cb->Size && memcmp(buffer->Data.data(), cb->LocalDataBuffer, cb->Size) == 0;
+	}
+}
+
+TEST(FirstCopySendsTheWholeBuffer)
+{
+	ShaderFixture fixture;
+	SimpleVertexShader* shader = fixture.Load<SimpleVertexShader>("UploadFirstVS", MakeEntityVertexReflection());
+	CHECK(shader->IsShaderValid());
+
+	shader->CopyAllBufferData();
+
+	std::vector<RecordedCall> updates = fixture.Context.CallsNamed("UpdateSubresource");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK(!updates[0].HasBox);
+	CHECK_EQUAL(272u, updates[0].ByteCount);
+	CHECK_EQUAL(0u, fixture.Context.CountCalls("UpdateSubresource1"));
+
+	delete shader;
+}
+
+TEST(OneSetSendsOnlyItsConstants)
+{
+	ShaderFixture fixture;
+	SimpleVertexShader* shader = LoadUploaded(fixture, "UploadOneVS", MakeEntityVertexReflection());
+
+	shader->SetMatrix4x4("view", Translation(3));
+	shader->CopyAllBufferData();
+
+	std::vector<RecordedCall> updates = fixture.Context.CallsNamed("UpdateSubresource1");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK(updates[0].HasBox);
+	CHECK_EQUAL(128u, updates[0].Box.left);
+	CHECK_EQUAL(192u, updates[0].Box.right);
+	CHECK_EQUAL(0u, fixture.Context.CountCalls("UpdateSubresource"));
+	CHECK_EQUAL(1u, ISimpleShader::GetFrameStats().BuffersUploaded);
+	CHECK_EQUAL(64u, ISimpleShader::GetFrameStats().BytesUploaded);
+	CHECK(BufferMatches(shader));
+
+	delete shader;
+}
+
+TEST(SeveralSetsSendOneRangeCoveringThem)
+{
+	ShaderFixture fixture;
+	SimpleVertexShader* shader = LoadUploaded(fixture, "UploadSeveralVS", MakeEntityVertexReflection());
+
+	shader->SetMatrix4x4("invTransWorld", Translation(1));
+	shader->SetMatrix4x4("projection", Translation(2));
+	shader->CopyAllBufferData();
+
+	std::vector<RecordedCall> updates = fixture.Context.CallsNamed("UpdateSubresource1");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK_EQUAL(64u, updates[0].Box.left);
+	CHECK_EQUAL(256u, updates[0].Box.right);
+	CHECK(BufferMatches(shader));
+
+	delete shader;
+}
+
+TEST(RangesRoundOutToWholeConstants)
+{
+	ShaderFixture fixture;
+
+	// A float that doesn't start a 16 byte constant
+	ShaderReflectionData reflection;
+	ReflectedConstantBuffer cb = { "perObject", 0, 0, 64, {} };
+	cb.Variables.push_back({ "tint", 0, 16 });
+	cb.Variables.push_back({ "scale", 20, 4 });
+	cb.Variables.push_back({ "offset", 48, 16 });
+	reflection.ConstantBuffers.push_back(cb);
+	SimpleVertexShader* shader = LoadUploaded(fixture, "UploadRoundVS", reflection);
+
+	shader->SetFloat("scale", 2.0f);
+	shader->CopyAllBufferData();
+
+	std::vector<RecordedCall> updates = fixture.Context.CallsNamed("UpdateSubresource1");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK_EQUAL(16u, updates[0].Box.left);
+	CHECK_EQUAL(32u, updates[0].Box.right);
+	CHECK_EQUAL(16u, ISimpleShader::GetFrameStats().BytesUploaded);
+	CHECK(BufferMatches(shader));
+
+	delete shader;
+}
+
+TEST(SettingEverythingSendsTheWholeBuffer)
+{
+	ShaderFixture fixture;
+	SimpleVertexShader* shader = LoadUploaded(fixture, "UploadAllVS", MakeEntityVertexReflection());
+
+	shader->SetMatrix4x4("world", Translation(1));
+	shader->SetFloat("uvScale", 2.0f);
+	shader->CopyAllBufferData();
+
+	std::vector<RecordedCall> updates = fixture.Context.CallsNamed("UpdateSubresource");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK(!updates[0].HasBox);
+	CHECK_EQUAL(0u, fixture.Context.CountCalls("UpdateSubresource1"));
+	CHECK(BufferMatches(shader));
+
+	delete shader;
+}
+
+TEST(UnchangedBuffersAreSkipped)
+{
+	ShaderFixture fixture;
+	SimpleVertexShader* shader = LoadUploaded(fixture, "UploadSkipVS", MakeEntityVertexReflection());
+
+	// Nothing set
+	shader->CopyAllBufferData();
+	CHECK_EQUAL(0u, (unsigned int)fixture.Context.Calls.size());
+	CHECK_EQUAL(1u, ISimpleShader::GetFrameStats().BuffersSkipped);
+
+	// Set to what's already there
+	shader->SetFloat("uvScale", 0.0f);
+	shader->CopyAllBufferData();
+	CHECK_EQUAL(0u, (unsigned int)fixture.Context.Calls.size());
+	CHECK_EQUAL(1u, ISimpleShader::GetFrameStats().WritesSkipped);
+	CHECK_EQUAL(2u, ISimpleShader::GetFrameStats().BuffersSkipped);
+	CHECK_EQUAL(0u, ISimpleShader::GetFrameStats().BytesUploaded);
+
+	delete shader;
+}
+
+TEST(WithoutDirect3D11_1EveryCopyIsWhole)
+{
+	ShaderFixture fixture;
+	fixture.Context.Supports11_1 = false;
+	SimpleVertexShader* shader = LoadUploaded(fixture, "UploadOldVS", MakeEntityVertexReflection());
+
+	shader->SetMatrix4x4("view", Translation(3));
+	shader->CopyAllBufferData();
+
+	CHECK_EQUAL(0u, fixture.Context.CountCalls("UpdateSubresource1"));
+	std::vector<RecordedCall> updates = fixture.Context.CallsNamed("UpdateSubresource");
+	CHECK_EQUAL(1u, (unsigned int)updates.size());
+	CHECK_EQUAL(272u, updates[0].ByteCount);
+	CHECK(BufferMatches(shader));
+
+	delete shader;
+}
+
+TEST(WithoutDriverSupportEveryCopyIsWhole)
+{
+	ShaderFixture fixture;
+	fixture.Device.ConstantBufferPartialUpdate = false;
+	SimpleVertexShader* shader = LoadUploaded(fixture, "UploadNoPartialVS", MakeEntityVertexReflection());
+
+	shader->SetMatrix4x4("view", Translation(3));
+	shader->CopyAllBufferData();
+
+	CHECK_EQUAL(0u, fixture.Context.CountCalls("UpdateSubresource1"));
+	CHECK_EQUAL(1u, fixture.Context.CountCalls("UpdateSubresource"));
+
+	delete shader;
+}
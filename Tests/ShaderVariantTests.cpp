@@ -0,0 +1,99 @@
+#include "TestHarness.h"
+#include "ShaderVariants.h"
+#include <string>
+
+namespace
+{
+	// The file a key selects from the project's table, or empty if none fits
+	std::wstring Selected(unsigned int key)
+	{
+		int index = SelectShaderVariant(PixelShaderVariants, PixelShaderVariantCount, key);
+		return index < 0 ? std::wstring() : std::wstring(PixelShaderVariants[index].File);
+	}
+}
+
+TEST(LightCountsFallInTheSmallestBucket)
+{
+	CHECK_EQUAL((unsigned int)ShaderFeatureLights2, ShaderLightBucket(0));
+	CHECK_EQUAL((unsigned int)ShaderFeatureLights2, ShaderLightBucket(2));
+	CHECK_EQUAL((unsigned int)ShaderFeatureLights4, ShaderLightBucket(3));
+	CHECK_EQUAL((unsigned int)ShaderFeatureLights4, ShaderLightBucket(4));
+	CHECK_EQUAL((unsigned int)ShaderFeatureLights6, ShaderLightBucket(6));
+	CHECK_EQUAL(0u, ShaderLightBucket(7));
+
+	CHECK_EQUAL(2u, ShaderLightLimit(ShaderFeatureLights2 | ShaderFeatureNormalMap));
+	CHECK_EQUAL(4u, ShaderLightLimit(ShaderFeatureLights4));
+	CHECK_EQUAL(6u, ShaderLightLimit(ShaderFeatureLights6 | ShaderFeaturePbr));
+	CHECK_EQUAL(0u, ShaderLightLimit(ShaderFeatureNormalMap));
+}
+
+TEST(KeysCarryEachFeature)
+{
+	CHECK_EQUAL((unsigned int)ShaderFeatureLights2, ShaderVariantKey(false, false, false, 1));
+	CHECK_EQUAL((unsigned int)(ShaderFeatureNormalMap | ShaderFeatureLights4), ShaderVariantKey(true, false, false, 3));
+	CHECK_EQUAL((unsigned int)(ShaderFeaturePbr | ShaderFeatureShadows | ShaderFeatureLights6), ShaderVariantKey(false, true, true, 5));
+	CHECK_EQUAL((unsigned int)ShaderFeatureNormalMap, ShaderVariantKey(true, false, false, 20));
+
+	// Compile time keys are built the same way
+	CHECK_EQUAL(ShaderVariantKey(true, true, false, 4), (ShaderVariant<ShaderFeaturePbr, ShaderFeatureNormalMap, ShaderFeatureLights4>::Key));
+	CHECK((ShaderVariant<ShaderFeatureNormalMap>::NormalMap));
+	CHECK(!(ShaderVariant<ShaderFeatureNormalMap>::Pbr));
+}
+
+TEST(ProjectVariantsPickTheTightestFit)
+{
+	CHECK(Selected(ShaderVariantKey(true, false, false, 1)) == L"PixelShader_N_L2.cso");
+	CHECK(Selected(ShaderVariantKey(false, false, false, 3)) == L"PixelShader_L4.cso");
+	CHECK(Selected(ShaderVariantKey(true, true, false, 5)) == L"PBRPixelShader_N_L6.cso");
+	CHECK(Selected(ShaderVariantKey(false, true, false, 2)) == L"PBRPixelShader_L2.cso");
+
+	// Too many lights for any fixed loop
+	CHECK(Selected(ShaderVariantKey(true, false, false, 9)) == L"PixelShader.cso");
+	CHECK(Selected(ShaderVariantKey(true, true, false, 9)) == L"PBRPixelShader.cso");
+
+	// Nothing without a normal map runs a runtime light count
+	CHECK(Selected(ShaderVariantKey(false, false, false, 9)).empty());
+
+	// No variant samples shadows yet, so that's left out rather than refused
+	CHECK(Selected(ShaderVariantKey(true, false, true, 4)) == L"PixelShader_N_L4.cso");
+}
+
+TEST(SelectionNeverBreaksTheRules)
+{
+	for (int normalMap = 0; normalMap < 2; normalMap++)
+	for (int pbr = 0; pbr < 2; pbr++)
+	for (int shadows = 0; shadows < 2; shadows++)
+	for (unsigned int lights = 0; lights <= 8; lights++)
+	{
+		unsigned int key = ShaderVariantKey(normalMap != 0, pbr != 0, shadows != 0, lights);
+		int index = SelectShaderVariant(PixelShaderVariants, PixelShaderVariantCount, key);
+		if (index < 0)
+			continue;
+
+		unsigned int variant = PixelShaderVariants[index].Key;
+		unsigned int variantSwitches = variant & ~ShaderFeatureLightMask;
+		unsigned int switches = key & ~ShaderFeatureLightMask;
+		CHECK_EQUAL(key & ShaderFeaturePbr, variant & ShaderFeaturePbr);
+		CHECK_EQUAL(0u, variantSwitches & ~switches);
+		CHECK(ShaderLightLimit(variant) == 0 || ShaderLightLimit(variant) >= lights);
+	}
+}
+
+TEST(MatchingSwitchesBeatLightFit)
+{
+	const ShaderVariantEntry table[] =
+	{
+		MakeShaderVariantEntry<ShaderVariant<ShaderFeatureLights2>>(L"Plain_L2"),
+		MakeShaderVariantEntry<ShaderVariant<ShaderFeatureNormalMap, ShaderFeatureLights6>>(L"Normal_L6"),
+		MakeShaderVariantEntry<ShaderVariant<ShaderFeatureNormalMap>>(L"Normal"),
+	};
+
+	// A normal mapped material takes the normal mapped loop, even the looser one
+	CHECK_EQUAL(1, SelectShaderVariant(table, 3, ShaderVariantKey(true, false, false, 2)));
+
+	// Fixed loops beat the runtime one while they're big enough
+	CHECK_EQUAL(2, SelectShaderVariant(table, 3, ShaderVariantKey(true, false, false, 7)));
+	CHECK_EQUAL(0, SelectShaderVariant(table, 3, ShaderVariantKey(false, false, false, 1)));
+	CHECK_EQUAL(-1, SelectShaderVariant(table, 3, ShaderVariantKey(false, false, false, 3)));
+	CHECK_EQUAL(-1, SelectShaderVariant(table, 0, ShaderVariantKey(true, false, false, 1)));
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+// --------------------------------------------------------
+// GENERATED by tools/generate_cbuffers.py - do not edit.
+//
+// C++ versions of each shader's constant buffers, laid
+// out by HLSL's packing rules, for SetBufferData().
+// --------------------------------------------------------
+
+#include <DirectXMath.h>
+#include <cstddef>
+
+// An HLSL array whose elements don't fill a register: each
+// element but the last is padded out to 16 bytes
+template<typename T, unsigned int N>
+struct ShaderArray
+{
+	struct Element
+	{
+		T Value;
+		unsigned char Padding[16 - sizeof(T) % 16];
+	};
+
+	Element Elements[N - 1];
+	T Last;
+
+	T& operator[](unsigned int i) { return i == N - 1 ? Last : Elements[i].Value; }
+	const T& operator[](unsigned int i) const { return i == N - 1 ? Last : Elements[i].Value; }
+};
+
+namespace ShaderConstants
+{
+	// PackingEdgeCases.hlsl
+	namespace PackingEdgeCases
+	{
+		struct Light
+		{
+			DirectX::XMFLOAT3 color;
+			float range;
+			DirectX::XMFLOAT3 direction;
+			float padding0;
+		};
+		static_assert(offsetof(Light, color) == 0, "Light.color is misplaced");
+		static_assert(offsetof(Light, range) == 12, "Light.range is misplaced");
+		static_assert(offsetof(Light, direction) == 16, "Light.direction is misplaced");
+		static_assert(sizeof(Light) == 32, "Light is the wrong size");
+
+		struct Vectors
+		{
+			static const char* BufferName() { return "vectors"; }
+			static const unsigned int Register = 0;
+
+			DirectX::XMFLOAT3 position;
+			float intensity;
+			DirectX::XMFLOAT2 uv;
+			float padding0[2];
+			DirectX::XMFLOAT3 straddle;
+			float tail;
+		};
+		static_assert(offsetof(Vectors, position) == 0, "vectors.position is misplaced");
+		static_assert(offsetof(Vectors, intensity) == 12, "vectors.intensity is misplaced");
+		static_assert(offsetof(Vectors, uv) == 16, "vectors.uv is misplaced");
+		static_assert(offsetof(Vectors, straddle) == 32, "vectors.straddle is misplaced");
+		static_assert(offsetof(Vectors, tail) == 44, "vectors.tail is misplaced");
+		static_assert(sizeof(Vectors) == 48, "vectors is the wrong size");
+
+		struct Arrays
+		{
+			static const char* BufferName() { return "arrays"; }
+			static const unsigned int Register = 1;
+
+			ShaderArray<float, 3> weights;
+			float afterWeights;
+			float padding0[2];
+			ShaderArray<DirectX::XMFLOAT2, 2> offsets;
+			DirectX::XMFLOAT2 afterOffsets;
+			DirectX::XMFLOAT4 colors[2];
+		};
+		static_assert(offsetof(Arrays, weights) == 0, "arrays.weights is misplaced");
+		static_assert(offsetof(Arrays, afterWeights) == 36, "arrays.afterWeights is misplaced");
+		static_assert(offsetof(Arrays, offsets) == 48, "arrays.offsets is misplaced");
+		static_assert(offsetof(Arrays, afterOffsets) == 72, "arrays.afterOffsets is misplaced");
+		static_assert(offsetof(Arrays, colors) == 80, "arrays.colors is misplaced");
+		static_assert(sizeof(Arrays) == 112, "arrays is the wrong size");
+
+		struct Matrices
+		{
+			static const char* BufferName() { return "matrices"; }
+			static const unsigned int Register = 2;
+
+			float single;
+			float padding0[3];
+			float rotation[11];
+			float afterRotation;
+			float rows[15];
+			float padding1;
+			DirectX::XMFLOAT4X4 world;
+		};
+		static_assert(offsetof(Matrices, single) == 0, "matrices.single is misplaced");
+		static_assert(offsetof(Matrices, rotation) == 16, "matrices.rotation is misplaced");
+		static_assert(offsetof(Matrices, afterRotation) == 60, "matrices.afterRotation is misplaced");
+		static_assert(offsetof(Matrices, rows) == 64, "matrices.rows is misplaced");
+		static_assert(offsetof(Matrices, world) == 128, "matrices.world is misplaced");
+		static_assert(sizeof(Matrices) == 192, "matrices is the wrong size");
+
+		struct Structs
+		{
+			static const char* BufferName() { return "structs"; }
+			static const unsigned int Register = 3;
+
+			float lead;
+			float padding0[3];
+			Light light;
+			float afterLight;
+			float padding1[3];
+			Light lights[2];
+		};
+		static_assert(offsetof(Structs, lead) == 0, "structs.lead is misplaced");
+		static_assert(offsetof(Structs, light) == 16, "structs.light is misplaced");
+		static_assert(offsetof(Structs, afterLight) == 48, "structs.afterLight is misplaced");
+		static_assert(offsetof(Structs, lights) == 64, "structs.lights is misplaced");
+		static_assert(sizeof(Structs) == 128, "structs is the wrong size");
+	}
+}
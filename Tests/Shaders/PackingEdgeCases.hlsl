@@ -0,0 +1,51 @@
+// --------------------------------------------------------
+// Not a real shader: constant buffers that hit the corners
+// of HLSL's packing rules, for tools/generate_cbuffers.py.
+// PackingConstants.h is generated from it, and
+// ShaderConstantsTests checks that against offsets worked
+// out by hand.
+// --------------------------------------------------------
+
+#define LIGHT_COUNT 2
+
+struct Light
+{
+	float3 color;
+	float range;
+	float3 direction;
+};
+
+cbuffer vectors : register(b0)
+{
+	float3 position;		// A float fits after a float3...
+	float intensity;
+	float2 uv;
+	float3 straddle;		// ...but a float3 after a float2 would cross a register
+	float tail;
+};
+
+cbuffer arrays : register(b1)
+{
+	float weights[3];		// Every element gets a register of its own...
+	float afterWeights;		// ...but the last one's spare room is used
+	float2 offsets[LIGHT_COUNT];
+	float2 afterOffsets;
+	float4 colors[2];		// Already whole registers, so a plain array
+};
+
+cbuffer matrices : register(b2)
+{
+	float single;
+	float3x3 rotation;		// Column major: starts a register, 3 columns of 3
+	float afterRotation;	// Fits beside the last column
+	row_major float4x3 rows;	// 4 rows of 3
+	float4x4 world;
+};
+
+cbuffer structs : register(b3)
+{
+	float lead;
+	Light light;			// Starts a register, and so does whatever follows it
+	float afterLight;
+	Light lights[LIGHT_COUNT];
+};
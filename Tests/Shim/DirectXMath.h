@@ -0,0 +1,232 @@
+#pragma once
+
+// --------------------------------------------------------
+// Test shim: the parts of DirectXMath the renderer uses.
+// Per-lane arithmetic maps straight to SSE, as it does in
+// DirectXMath; the rest is written plainly, a lane at a
+// time.  Same conventions as the real thing - row vectors,
+// left handed, matrices multiplied v * M.
+// --------------------------------------------------------
+
+#include <cmath>
+#include <cstdint>
+#include <emmintrin.h>
+#define XM_CALLCONV
+
+namespace DirectX {
+const float XM_PI = 3.141592654f; const float XM_2PI = 6.283185307f; const float XM_PIDIV2 = 1.570796327f; const float XM_PIDIV4 = 0.785398163f;
+struct XMFLOAT2 { float x, y; XMFLOAT2() = default; XMFLOAT2(float a, float b) : x(a), y(b) {} };
+struct XMFLOAT3 { float x, y, z; XMFLOAT3() = default; XMFLOAT3(float a, float b, float c) : x(a), y(b), z(c) {} };
+struct XMFLOAT4 { float x, y, z, w; XMFLOAT4() = default; XMFLOAT4(float a, float b, float c, float d) : x(a), y(b), z(c), w(d) {} };
+struct alignas(16) XMFLOAT3A : XMFLOAT3 { using XMFLOAT3::XMFLOAT3; };
+struct alignas(16) XMFLOAT4A : XMFLOAT4 { using XMFLOAT4::XMFLOAT4; };
+struct XMUINT4 { uint32_t x, y, z, w; };
+struct XMFLOAT4X4 { union { struct { float _11,_12,_13,_14,_21,_22,_23,_24,_31,_32,_33,_34,_41,_42,_43,_44; }; float m[4][4]; }; XMFLOAT4X4() = default; };
+typedef __m128 XMVECTOR;
+typedef const XMVECTOR FXMVECTOR; typedef const XMVECTOR GXMVECTOR; typedef const XMVECTOR HXMVECTOR; typedef const XMVECTOR& CXMVECTOR;
+struct XMMATRIX { XMVECTOR r[4]; };
+typedef const XMMATRIX& FXMMATRIX; typedef const XMMATRIX& CXMMATRIX;
+union XMVU { XMVECTOR v; float f[4]; uint32_t u[4]; };
+inline float F(XMVECTOR v, int i) { XMVU x; x.v = v; return x.f[i]; }
+inline uint32_t U(XMVECTOR v, int i) { XMVU x; x.v = v; return x.u[i]; }
+inline XMVECTOR XMVectorSet(float x, float y, float z, float w) { return _mm_setr_ps(x,y,z,w); }
+inline XMVECTOR XMVectorSetInt(uint32_t x, uint32_t y, uint32_t z, uint32_t w) { return _mm_castsi128_ps(_mm_setr_epi32(x,y,z,w)); }
+inline XMVECTOR XMVectorZero() { return _mm_setzero_ps(); }
+inline XMVECTOR XMVectorReplicate(float s) { return _mm_set1_ps(s); }
+inline XMVECTOR XMVectorReplicatePtr(const float* s) { return _mm_set1_ps(*s); }
+inline XMVECTOR XMVectorSplatOne() { return _mm_set1_ps(1); }
+// The per-lane operations that hot loops lean on map straight to SSE, as they do in DirectXMath
+inline XMVECTOR XMVectorAdd(FXMVECTOR a, FXMVECTOR b) { return _mm_add_ps(a, b); }
+inline XMVECTOR XMVectorSubtract(FXMVECTOR a, FXMVECTOR b) { return _mm_sub_ps(a, b); }
+inline XMVECTOR XMVectorMultiply(FXMVECTOR a, FXMVECTOR b) { return _mm_mul_ps(a, b); }
+inline XMVECTOR XMVectorDivide(FXMVECTOR a, FXMVECTOR b) { return _mm_div_ps(a, b); }
+inline XMVECTOR XMVectorMin(FXMVECTOR a, FXMVECTOR b) { return _mm_min_ps(a, b); }
+inline XMVECTOR XMVectorMax(FXMVECTOR a, FXMVECTOR b) { return _mm_max_ps(a, b); }
+inline XMVECTOR XMVectorLess(FXMVECTOR a, FXMVECTOR b) { return _mm_cmplt_ps(a, b); }
+inline XMVECTOR XMVectorLessOrEqual(FXMVECTOR a, FXMVECTOR b) { return _mm_cmple_ps(a, b); }
+inline XMVECTOR XMVectorGreater(FXMVECTOR a, FXMVECTOR b) { return _mm_cmpgt_ps(a, b); }
+inline XMVECTOR XMVectorGreaterOrEqual(FXMVECTOR a, FXMVECTOR b) { return _mm_cmpge_ps(a, b); }
+inline XMVECTOR XMVectorEqual(FXMVECTOR a, FXMVECTOR b) { return _mm_cmpeq_ps(a, b); }
+inline XMVECTOR XMVectorOrInt(FXMVECTOR a, FXMVECTOR b) { return _mm_or_ps(a, b); }
+inline XMVECTOR XMVectorAndInt(FXMVECTOR a, FXMVECTOR b) { return _mm_and_ps(a, b); }
+inline XMVECTOR XMVectorAndCInt(FXMVECTOR a, FXMVECTOR b) { return _mm_andnot_ps(b, a); }
+inline XMVECTOR XMVectorXorInt(FXMVECTOR a, FXMVECTOR b) { return _mm_xor_ps(a, b); }
+inline XMVECTOR XMVectorEqualInt(FXMVECTOR a, FXMVECTOR b) { return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_castps_si128(a), _mm_castps_si128(b))); }
+inline XMVECTOR XMVectorSelect(FXMVECTOR a, FXMVECTOR b, FXMVECTOR control) { return _mm_or_ps(_mm_andnot_ps(control, a), _mm_and_ps(b, control)); }
+inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+inline XMVECTOR XMVectorNegativeMultiplySubtract(FXMVECTOR a, FXMVECTOR b, FXMVECTOR c) { return _mm_sub_ps(c, _mm_mul_ps(a, b)); }
+inline XMVECTOR XMVectorScale(FXMVECTOR a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+inline XMVECTOR XMVectorAbs(FXMVECTOR a) { return _mm_max_ps(a, _mm_sub_ps(_mm_setzero_ps(), a)); }
+inline XMVECTOR XMVectorNegate(FXMVECTOR a) { return XMVectorSubtract(_mm_setzero_ps(), a); }
+inline XMVECTOR XMVectorSqrt(FXMVECTOR a) { return _mm_sqrt_ps(a); }
+inline XMVECTOR XMVectorReciprocal(FXMVECTOR a) { return XMVectorDivide(_mm_set1_ps(1), a); }
+inline XMVECTOR XMVectorTrueInt() { return _mm_castsi128_ps(_mm_set1_epi32(-1)); }
+inline XMVECTOR XMVectorFalseInt() { return _mm_setzero_ps(); }
+inline XMVECTOR XMVectorSplatX(FXMVECTOR a) { return _mm_set1_ps(F(a,0)); }
+inline XMVECTOR XMVectorSplatY(FXMVECTOR a) { return _mm_set1_ps(F(a,1)); }
+inline XMVECTOR XMVectorSplatZ(FXMVECTOR a) { return _mm_set1_ps(F(a,2)); }
+inline XMVECTOR XMVectorSplatW(FXMVECTOR a) { return _mm_set1_ps(F(a,3)); }
+inline float XMVectorGetX(FXMVECTOR a) { return F(a,0); } inline float XMVectorGetY(FXMVECTOR a) { return F(a,1); }
+inline float XMVectorGetZ(FXMVECTOR a) { return F(a,2); } inline float XMVectorGetW(FXMVECTOR a) { return F(a,3); }
+inline XMVECTOR XMVectorSetW(FXMVECTOR a, float w) { return _mm_setr_ps(F(a,0),F(a,1),F(a,2),w); }
+inline XMVECTOR XMVector3Dot(FXMVECTOR a, FXMVECTOR b) { return _mm_set1_ps(F(a,0)*F(b,0)+F(a,1)*F(b,1)+F(a,2)*F(b,2)); }
+inline XMVECTOR XMVector4Dot(FXMVECTOR a, FXMVECTOR b) { return _mm_set1_ps(F(a,0)*F(b,0)+F(a,1)*F(b,1)+F(a,2)*F(b,2)+F(a,3)*F(b,3)); }
+inline XMVECTOR XMVector3Length(FXMVECTOR a) { return XMVectorSqrt(XMVector3Dot(a,a)); }
+inline XMVECTOR XMVector3LengthSq(FXMVECTOR a) { return XMVector3Dot(a,a); }
+inline XMVECTOR XMVector3Normalize(FXMVECTOR a) { float l = std::sqrt(F(XMVector3Dot(a,a),0)); return XMVectorScale(a, l > 0 ? 1/l : 0); }
+inline XMVECTOR XMVector3Cross(FXMVECTOR a, FXMVECTOR b) { return XMVectorSet(F(a,1)*F(b,2)-F(a,2)*F(b,1), F(a,2)*F(b,0)-F(a,0)*F(b,2), F(a,0)*F(b,1)-F(a,1)*F(b,0), 0); }
+inline XMVECTOR XMPlaneNormalize(FXMVECTOR p) { float l = std::sqrt(F(p,0)*F(p,0)+F(p,1)*F(p,1)+F(p,2)*F(p,2)); return XMVectorScale(p, 1/l); }
+inline XMVECTOR XMPlaneDotCoord(FXMVECTOR p, FXMVECTOR v) { return _mm_set1_ps(F(p,0)*F(v,0)+F(p,1)*F(v,1)+F(p,2)*F(v,2)+F(p,3)); }
+inline uint32_t XMVectorMoveMask(FXMVECTOR a) { return (uint32_t)_mm_movemask_ps(a); }
+inline bool XMVector4EqualInt(FXMVECTOR a, FXMVECTOR b) { for (int i=0;i<4;i++) if (U(a,i)!=U(b,i)) return false; return true; }
+inline bool XMVector3Less(FXMVECTOR a, FXMVECTOR b) { for (int i=0;i<3;i++) if (!(F(a,i)<F(b,i))) return false; return true; }
+inline bool XMVector3Greater(FXMVECTOR a, FXMVECTOR b) { for (int i=0;i<3;i++) if (!(F(a,i)>F(b,i))) return false; return true; }
+inline bool XMVector3LessOrEqual(FXMVECTOR a, FXMVECTOR b) { for (int i=0;i<3;i++) if (!(F(a,i)<=F(b,i))) return false; return true; }
+inline bool XMVector3GreaterOrEqual(FXMVECTOR a, FXMVECTOR b) { for (int i=0;i<3;i++) if (!(F(a,i)>=F(b,i))) return false; return true; }
+inline bool XMVector4Less(FXMVECTOR a, FXMVECTOR b) { for (int i=0;i<4;i++) if (!(F(a,i)<F(b,i))) return false; return true; }
+inline bool XMVector4Greater(FXMVECTOR a, FXMVECTOR b) { for (int i=0;i<4;i++) if (!(F(a,i)>F(b,i))) return false; return true; }
+inline XMVECTOR XMLoadFloat(const float* p) { return XMVectorSet(*p,0,0,0); }
+inline XMVECTOR XMLoadFloat3(const XMFLOAT3* p) { return XMVectorSet(p->x,p->y,p->z,0); }
+inline XMVECTOR XMLoadFloat3A(const XMFLOAT3A* p) { return XMVectorSet(p->x,p->y,p->z,0); }
+inline XMVECTOR XMLoadFloat4(const XMFLOAT4* p) { return XMVectorSet(p->x,p->y,p->z,p->w); }
+inline XMVECTOR XMLoadFloat4A(const XMFLOAT4A* p) { return XMVectorSet(p->x,p->y,p->z,p->w); }
+inline XMVECTOR XMLoadUInt4(const XMUINT4* p) { return XMVectorSetInt(p->x,p->y,p->z,p->w); }
+inline void XMStoreUInt4(XMUINT4* p, FXMVECTOR v) { p->x=U(v,0); p->y=U(v,1); p->z=U(v,2); p->w=U(v,3); }
+inline void XMStoreFloat(float* p, FXMVECTOR v) { *p = F(v,0); }
+inline void XMStoreFloat3(XMFLOAT3* p, FXMVECTOR v) { p->x=F(v,0); p->y=F(v,1); p->z=F(v,2); }
+inline void XMStoreFloat3A(XMFLOAT3A* p, FXMVECTOR v) { p->x=F(v,0); p->y=F(v,1); p->z=F(v,2); }
+inline void XMStoreFloat4(XMFLOAT4* p, FXMVECTOR v) { p->x=F(v,0); p->y=F(v,1); p->z=F(v,2); p->w=F(v,3); }
+inline void XMStoreFloat4A(XMFLOAT4A* p, FXMVECTOR v) { p->x=F(v,0); p->y=F(v,1); p->z=F(v,2); p->w=F(v,3); }
+inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* p) { XMMATRIX m; for (int r=0;r<4;r++) m.r[r] = XMVectorSet(p->m[r][0],p->m[r][1],p->m[r][2],p->m[r][3]); return m; }
+inline void XMStoreFloat4x4(XMFLOAT4X4* p, FXMMATRIX m) { for (int r=0;r<4;r++) for (int c=0;c<4;c++) p->m[r][c] = F(m.r[r],c); }
+inline XMMATRIX XMMatrixSet(float a,float b,float c,float d,float e,float f,float g,float h,float i,float j,float k,float l,float m2,float n,float o,float q) { XMMATRIX m; m.r[0]=XMVectorSet(a,b,c,d); m.r[1]=XMVectorSet(e,f,g,h); m.r[2]=XMVectorSet(i,j,k,l); m.r[3]=XMVectorSet(m2,n,o,q); return m; }
+inline XMMATRIX XMMatrixIdentity() { return XMMatrixSet(1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1); }
+inline XMMATRIX XMMatrixMultiply(FXMMATRIX a, CXMMATRIX b) { XMMATRIX m; for (int r=0;r<4;r++) { float v[4]; for (int c=0;c<4;c++) { float s=0; for (int k=0;k<4;k++) s += F(a.r[r],k)*F(b.r[k],c); v[c]=s; } m.r[r]=XMVectorSet(v[0],v[1],v[2],v[3]); } return m; }
+inline XMMATRIX XMMatrixTranspose(FXMMATRIX a) { XMMATRIX m; for (int r=0;r<4;r++) m.r[r] = XMVectorSet(F(a.r[0],r),F(a.r[1],r),F(a.r[2],r),F(a.r[3],r)); return m; }
+inline XMMATRIX XMMatrixTranslation(float x, float y, float z) { return XMMatrixSet(1,0,0,0,0,1,0,0,0,0,1,0,x,y,z,1); }
+inline XMMATRIX XMMatrixScaling(float x, float y, float z) { return XMMatrixSet(x,0,0,0,0,y,0,0,0,0,z,0,0,0,0,1); }
+inline XMMATRIX XMMatrixRotationY(float a) { float s = std::sin(a), c = std::cos(a); return XMMatrixSet(c,0,-s,0,0,1,0,0,s,0,c,0,0,0,0,1); }
+inline XMMATRIX XMMatrixPerspectiveFovLH(float fov, float aspect, float n, float f) { float h = 1/std::tan(fov/2), w = h/aspect, r = f/(f-n); return XMMatrixSet(w,0,0,0,0,h,0,0,0,0,r,1,0,0,-r*n,0); }
+inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m) { float r[4]; for (int c=0;c<4;c++) r[c] = F(v,0)*F(m.r[0],c)+F(v,1)*F(m.r[1],c)+F(v,2)*F(m.r[2],c)+F(v,3)*F(m.r[3],c); return XMVectorSet(r[0],r[1],r[2],r[3]); }
+inline XMVECTOR XMVector3TransformCoord(FXMVECTOR v, FXMMATRIX m) { XMVECTOR r = XMVector4Transform(XMVectorSetW(v,1), m); return XMVectorScale(r, 1/F(r,3)); }
+inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m) { return XMVector4Transform(XMVectorSetW(v,1), m); }
+inline XMVECTOR XMVector3TransformNormal(FXMVECTOR v, FXMMATRIX m) { return XMVector4Transform(XMVectorSetW(v,0), m); }
+inline float XMConvertToRadians(float d) { return d * (XM_PI / 180.0f); }
+inline void XMScalarSinCos(float* s, float* c, float a) { *s = std::sin(a); *c = std::cos(a); }
+
+inline XMMATRIX XMMatrixScalingFromVector(FXMVECTOR s) { return XMMatrixScaling(F(s,0), F(s,1), F(s,2)); }
+inline XMMATRIX XMMatrixTranslationFromVector(FXMVECTOR t) { return XMMatrixTranslation(F(t,0), F(t,1), F(t,2)); }
+inline XMMATRIX XMMatrixOrthographicLH(float w, float h, float n, float f) { float r = 1 / (f - n); return XMMatrixSet(2/w,0,0,0, 0,2/h,0,0, 0,0,r,0, 0,0,-r*n,1); }
+
+// Roll about z, then pitch about x, then yaw about y
+inline XMMATRIX XMMatrixRotationRollPitchYaw(float pitch, float yaw, float roll)
+{
+	float sp = std::sin(pitch), cp = std::cos(pitch);
+	float sy = std::sin(yaw), cy = std::cos(yaw);
+	float sr = std::sin(roll), cr = std::cos(roll);
+	XMMATRIX rz = XMMatrixSet(cr,sr,0,0, -sr,cr,0,0, 0,0,1,0, 0,0,0,1);
+	XMMATRIX rx = XMMatrixSet(1,0,0,0, 0,cp,sp,0, 0,-sp,cp,0, 0,0,0,1);
+	XMMATRIX ry = XMMatrixSet(cy,0,-sy,0, 0,1,0,0, sy,0,cy,0, 0,0,0,1);
+	return XMMatrixMultiply(XMMatrixMultiply(rz, rx), ry);
+}
+inline XMMATRIX XMMatrixRotationRollPitchYawFromVector(FXMVECTOR angles) { return XMMatrixRotationRollPitchYaw(F(angles,0), F(angles,1), F(angles,2)); }
+
+inline XMVECTOR XMQuaternionRotationRollPitchYaw(float pitch, float yaw, float roll)
+{
+	float sp = std::sin(pitch * 0.5f), cp = std::cos(pitch * 0.5f);
+	float sy = std::sin(yaw * 0.5f), cy = std::cos(yaw * 0.5f);
+	float sr = std::sin(roll * 0.5f), cr = std::cos(roll * 0.5f);
+	return XMVectorSet(
+		cr * sp * cy + sr * cp * sy,
+		cr * cp * sy - sr * sp * cy,
+		sr * cp * cy - cr * sp * sy,
+		cr * cp * cy + sr * sp * sy);
+}
+inline XMVECTOR XMQuaternionRotationRollPitchYawFromVector(FXMVECTOR angles) { return XMQuaternionRotationRollPitchYaw(F(angles,0), F(angles,1), F(angles,2)); }
+
+inline XMVECTOR XMQuaternionRotationAxis(FXMVECTOR axis, float angle)
+{
+	XMVECTOR n = XMVector3Normalize(axis);
+	float s = std::sin(angle * 0.5f);
+	return XMVectorSet(F(n,0) * s, F(n,1) * s, F(n,2) * s, std::cos(angle * 0.5f));
+}
+
+// Rotation q1 followed by rotation q2
+inline XMVECTOR XMQuaternionMultiply(FXMVECTOR q1, FXMVECTOR q2)
+{
+	float ax = F(q2,0), ay = F(q2,1), az = F(q2,2), aw = F(q2,3);
+	float bx = F(q1,0), by = F(q1,1), bz = F(q1,2), bw = F(q1,3);
+	return XMVectorSet(
+		aw * bx + ax * bw + ay * bz - az * by,
+		aw * by - ax * bz + ay * bw + az * bx,
+		aw * bz + ax * by - ay * bx + az * bw,
+		aw * bw - ax * bx - ay * by - az * bz);
+}
+
+inline XMVECTOR XMVector3Rotate(FXMVECTOR v, FXMVECTOR q)
+{
+	XMVECTOR t = XMVectorScale(XMVector3Cross(q, v), 2.0f);
+	return XMVectorAdd(XMVectorAdd(v, XMVectorScale(t, F(q,3))), XMVector3Cross(q, t));
+}
+
+inline XMMATRIX XMMatrixRotationQuaternion(FXMVECTOR q)
+{
+	float x = F(q,0), y = F(q,1), z = F(q,2), w = F(q,3);
+	return XMMatrixSet(
+		1 - 2 * (y * y + z * z), 2 * (x * y + z * w), 2 * (x * z - y * w), 0,
+		2 * (x * y - z * w), 1 - 2 * (x * x + z * z), 2 * (y * z + x * w), 0,
+		2 * (x * z + y * w), 2 * (y * z - x * w), 1 - 2 * (x * x + y * y), 0,
+		0, 0, 0, 1);
+}
+
+inline XMMATRIX XMMatrixLookToLH(FXMVECTOR eye, FXMVECTOR direction, FXMVECTOR up)
+{
+	XMVECTOR z = XMVector3Normalize(direction);
+	XMVECTOR x = XMVector3Normalize(XMVector3Cross(up, z));
+	XMVECTOR y = XMVector3Cross(z, x);
+	return XMMatrixSet(
+		F(x,0), F(y,0), F(z,0), 0,
+		F(x,1), F(y,1), F(z,1), 0,
+		F(x,2), F(y,2), F(z,2), 0,
+		-F(XMVector3Dot(x, eye),0), -F(XMVector3Dot(y, eye),0), -F(XMVector3Dot(z, eye),0), 1);
+}
+
+// Cofactors over the determinant
+inline XMMATRIX XMMatrixInverse(XMVECTOR* determinant, FXMMATRIX matrix)
+{
+	float m[16], inv[16];
+	for (int r = 0; r < 4; r++)
+		for (int c = 0; c < 4; c++)
+			m[r * 4 + c] = F(matrix.r[r], c);
+
+	inv[0] = m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15] + m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+	inv[4] = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15] - m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+	inv[8] = m[4]*m[9]*m[15] - m[4]*m[11]*m[13] - m[8]*m[5]*m[15] + m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[9];
+	inv[12] = -m[4]*m[9]*m[14] + m[4]*m[10]*m[13] + m[8]*m[5]*m[14] - m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[9];
+	inv[1] = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15] - m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+	inv[5] = m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15] + m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+	inv[9] = -m[0]*m[9]*m[15] + m[0]*m[11]*m[13] + m[8]*m[1]*m[15] - m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[9];
+	inv[13] = m[0]*m[9]*m[14] - m[0]*m[10]*m[13] - m[8]*m[1]*m[14] + m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[9];
+	inv[2] = m[1]*m[6]*m[15] - m[1]*m[7]*m[14] - m[5]*m[2]*m[15] + m[5]*m[3]*m[14] + m[13]*m[2]*m[7] - m[13]*m[3]*m[6];
+	inv[6] = -m[0]*m[6]*m[15] + m[0]*m[7]*m[14] + m[4]*m[2]*m[15] - m[4]*m[3]*m[14] - m[12]*m[2]*m[7] + m[12]*m[3]*m[6];
+	inv[10] = m[0]*m[5]*m[15] - m[0]*m[7]*m[13] - m[4]*m[1]*m[15] + m[4]*m[3]*m[13] + m[12]*m[1]*m[7] - m[12]*m[3]*m[5];
+	inv[14] = -m[0]*m[5]*m[14] + m[0]*m[6]*m[13] + m[4]*m[1]*m[14] - m[4]*m[2]*m[13] - m[12]*m[1]*m[6] + m[12]*m[2]*m[5];
+	inv[3] = -m[1]*m[6]*m[11] + m[1]*m[7]*m[10] + m[5]*m[2]*m[11] - m[5]*m[3]*m[10] - m[9]*m[2]*m[7] + m[9]*m[3]*m[6];
+	inv[7] = m[0]*m[6]*m[11] - m[0]*m[7]*m[10] - m[4]*m[2]*m[11] + m[4]*m[3]*m[10] + m[8]*m[2]*m[7] - m[8]*m[3]*m[6];
+	inv[11] = -m[0]*m[5]*m[11] + m[0]*m[7]*m[9] + m[4]*m[1]*m[11] - m[4]*m[3]*m[9] - m[8]*m[1]*m[7] + m[8]*m[3]*m[5];
+	inv[15] = m[0]*m[5]*m[10] - m[0]*m[6]*m[9] - m[4]*m[1]*m[10] + m[4]*m[2]*m[9] + m[8]*m[1]*m[6] - m[8]*m[2]*m[5];
+
+	float det = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+	if (determinant)
+		*determinant = XMVectorReplicate(det);
+
+	XMMATRIX result;
+	for (int r = 0; r < 4; r++)
+		result.r[r] = XMVectorSet(inv[r * 4] / det, inv[r * 4 + 1] / det, inv[r * 4 + 2] / det, inv[r * 4 + 3] / det);
+	return result;
+}
+}
+namespace DirectX { struct XMVECTORF32 { union { float f[4]; XMVECTOR v; }; operator XMVECTOR() const { return v; } };
+struct XMVECTORU32 { union { uint32_t u[4]; XMVECTOR v; }; operator XMVECTOR() const { return v; } }; }
+namespace DirectX { inline XMVECTOR XMVectorLerp(XMVECTOR a, XMVECTOR b, float t){ return a + (b-a)*t; }
+inline XMVECTOR XMVectorLerpV(XMVECTOR a, XMVECTOR b, XMVECTOR t){ return a + (b-a)*t; } }
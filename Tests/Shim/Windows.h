@@ -0,0 +1,100 @@
+#pragma once
+
+// --------------------------------------------------------
+// Test shim: the few Win32 types, macros and functions the
+// renderer's CPU code uses, so it builds and runs off
+// Windows.  Nothing here talks to a real system.
+// --------------------------------------------------------
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef int BOOL;
+typedef unsigned int UINT;
+typedef int INT;
+typedef int HRESULT;			// 32 bits, as on Windows, so FAILED() sees the sign bit
+typedef unsigned int DWORD;
+typedef unsigned char BYTE;
+typedef int LONG;
+typedef unsigned long long UINT64;
+typedef float FLOAT;
+typedef size_t SIZE_T;
+typedef const wchar_t* LPCWSTR;
+typedef const char* LPCSTR;
+typedef char* LPSTR;
+typedef void* HANDLE;
+typedef void* HINSTANCE;
+typedef void* HWND;
+typedef uintptr_t WPARAM;
+typedef intptr_t LPARAM;
+typedef intptr_t LRESULT;
+
+struct POINT { LONG x, y; };
+struct LARGE_INTEGER { long long QuadPart; };
+
+#define TRUE 1
+#define FALSE 0
+#define S_OK ((HRESULT)0)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define WINAPI
+#define CALLBACK
+#define ZeroMemory(p, s) memset((p), 0, (s))
+#define VK_ESCAPE 0x1B
+
+#define sscanf_s sscanf
+#define strcpy_s(dest, size, source) strcpy(dest, source)
+
+// Interface ids are just distinct addresses, one per type
+struct GUID { unsigned int Data; };
+typedef GUID IID;
+typedef const GUID& REFIID;
+
+template<class T> const IID& ShimUuidOf()
+{
+	static const IID id = { 0 };
+	return id;
+}
+#define __uuidof(type) ShimUuidOf<type>()
+
+// Windows.h has min and max as macros; functions are kinder to std::
+template<class T> T max(T a, T b) { return a > b ? a : b; }
+template<class T> T min(T a, T b) { return a < b ? a : b; }
+inline unsigned int max(unsigned int a, int b) { return a > (unsigned int)b ? a : b; }
+
+// COM objects in the shim don't count references - tests own them
+struct IUnknown
+{
+	virtual ~IUnknown() {}
+	virtual unsigned long AddRef() { return 1; }
+	virtual unsigned long Release() { return 0; }
+	virtual HRESULT QueryInterface(REFIID, void** object) { *object = 0; return E_NOINTERFACE; }
+
+	template<class Q> HRESULT QueryInterface(Q** object)
+	{
+		return QueryInterface(__uuidof(Q), (void**)object);
+	}
+};
+
+inline BOOL QueryPerformanceFrequency(LARGE_INTEGER* frequency)
+{
+	frequency->QuadPart = 1000000000;
+	return 1;
+}
+
+inline BOOL QueryPerformanceCounter(LARGE_INTEGER* counter)
+{
+	counter->QuadPart = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	return 1;
+}
+
+inline short GetAsyncKeyState(int) { return 0; }
+inline int ShowCursor(BOOL) { return 0; }
+inline HWND SetCapture(HWND) { return 0; }
+inline BOOL ReleaseCapture() { return 1; }
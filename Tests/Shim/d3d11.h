@@ -0,0 +1,168 @@
+#pragma once
+
+// Test shim - see Windows.h.  Every call is a no-op that fails or does nothing;
+// tests derive from these to record or fake what they need.
+#include <Windows.h>
+#include <d3dcommon.h>
+#include <dxgi.h>
+
+#define D3D11_FLOAT32_MAX 3.402823466e+38f
+#define D3D11_SDK_VERSION 7
+#define D3D11_SO_NO_RASTERIZED_STREAM 0xffffffff
+#define D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT 14
+#define D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT 128
+#define D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT 16
+#define D3D11_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT 32
+#define D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT 8
+#define D3D11_APPEND_ALIGNED_ELEMENT 0xffffffff
+#define D3D11_REQ_CONSTANT_BUFFER_ELEMENT_COUNT 4096
+enum D3D11_USAGE { D3D11_USAGE_DEFAULT, D3D11_USAGE_IMMUTABLE, D3D11_USAGE_DYNAMIC, D3D11_USAGE_STAGING };
+enum { D3D11_BIND_VERTEX_BUFFER = 1, D3D11_BIND_INDEX_BUFFER = 2, D3D11_BIND_CONSTANT_BUFFER = 4, D3D11_BIND_SHADER_RESOURCE = 8, D3D11_BIND_RENDER_TARGET = 0x20, D3D11_BIND_DEPTH_STENCIL = 0x40, D3D11_BIND_UNORDERED_ACCESS = 0x80, D3D11_BIND_STREAM_OUTPUT = 0x10 };
+enum { D3D11_CPU_ACCESS_WRITE = 0x10000, D3D11_CPU_ACCESS_READ = 0x20000 };
+enum { D3D11_RESOURCE_MISC_BUFFER_STRUCTURED = 0x40 };
+enum D3D11_MAP { D3D11_MAP_READ = 1, D3D11_MAP_WRITE, D3D11_MAP_READ_WRITE, D3D11_MAP_WRITE_DISCARD, D3D11_MAP_WRITE_NO_OVERWRITE };
+enum { D3D11_CLEAR_DEPTH = 1, D3D11_CLEAR_STENCIL = 2 };
+enum D3D11_SRV_DIMENSION { D3D11_SRV_DIMENSION_BUFFER = 1, D3D11_SRV_DIMENSION_TEXTURE2D = 4 };
+enum D3D11_RTV_DIMENSION { D3D11_RTV_DIMENSION_TEXTURE2D = 4 };
+enum D3D11_DSV_DIMENSION { D3D11_DSV_DIMENSION_TEXTURE2D = 3 };
+enum D3D11_INPUT_CLASSIFICATION { D3D11_INPUT_PER_VERTEX_DATA, D3D11_INPUT_PER_INSTANCE_DATA };
+enum D3D11_FILL_MODE { D3D11_FILL_WIREFRAME = 2, D3D11_FILL_SOLID = 3 };
+enum D3D11_CULL_MODE { D3D11_CULL_NONE = 1, D3D11_CULL_FRONT, D3D11_CULL_BACK };
+enum D3D11_COMPARISON_FUNC { D3D11_COMPARISON_NEVER = 1, D3D11_COMPARISON_LESS, D3D11_COMPARISON_EQUAL, D3D11_COMPARISON_LESS_EQUAL, D3D11_COMPARISON_GREATER, D3D11_COMPARISON_NOT_EQUAL, D3D11_COMPARISON_GREATER_EQUAL, D3D11_COMPARISON_ALWAYS };
+enum D3D11_DEPTH_WRITE_MASK { D3D11_DEPTH_WRITE_MASK_ZERO, D3D11_DEPTH_WRITE_MASK_ALL };
+enum D3D11_BLEND { D3D11_BLEND_ZERO = 1, D3D11_BLEND_ONE, D3D11_BLEND_SRC_COLOR, D3D11_BLEND_INV_SRC_COLOR, D3D11_BLEND_SRC_ALPHA, D3D11_BLEND_INV_SRC_ALPHA };
+enum D3D11_BLEND_OP { D3D11_BLEND_OP_ADD = 1 };
+enum { D3D11_COLOR_WRITE_ENABLE_RED = 1, D3D11_COLOR_WRITE_ENABLE_ALL = 15 };
+enum D3D11_FILTER { D3D11_FILTER_MIN_MAG_MIP_LINEAR = 0x15, D3D11_FILTER_ANISOTROPIC = 0x55, D3D11_FILTER_COMPARISON_MIN_MAG_MIP_LINEAR = 0x95 };
+enum D3D11_TEXTURE_ADDRESS_MODE { D3D11_TEXTURE_ADDRESS_WRAP = 1, D3D11_TEXTURE_ADDRESS_MIRROR, D3D11_TEXTURE_ADDRESS_CLAMP, D3D11_TEXTURE_ADDRESS_BORDER };
+enum D3D11_STENCIL_OP { D3D11_STENCIL_OP_KEEP = 1 };
+enum D3D11_FEATURE { D3D11_FEATURE_THREADING = 0, D3D11_FEATURE_D3D11_OPTIONS = 4 };
+struct D3D11_FEATURE_DATA_D3D11_OPTIONS { BOOL OutputMergerLogicOp, UAVOnlyRenderingForcedSampleCount, DiscardAPIsSeenByDriver, FlagsForUpdateAndCopySeenByDriver, ClearView, CopyWithOverlap, ConstantBufferPartialUpdate, ConstantBufferOffsetting, MapNoOverwriteOnDynamicConstantBuffer, MapNoOverwriteOnDynamicBufferSRV, MultisampleRTVWithForcedSampleCountOne, SAD4ShaderInstructions, ExtendedDoublesShaderInstructions, ExtendedResourceSharing; };
+struct D3D11_BUFFER_DESC { UINT ByteWidth; D3D11_USAGE Usage; UINT BindFlags; UINT CPUAccessFlags; UINT MiscFlags; UINT StructureByteStride; };
+struct D3D11_SUBRESOURCE_DATA { const void* pSysMem; UINT SysMemPitch; UINT SysMemSlicePitch; };
+struct D3D11_MAPPED_SUBRESOURCE { void* pData; UINT RowPitch; UINT DepthPitch; };
+struct D3D11_BOX { UINT left, top, front, right, bottom, back; };
+struct D3D11_BUFFER_SRV { UINT FirstElement; UINT NumElements; };
+struct D3D11_TEX2D_SRV { UINT MostDetailedMip; UINT MipLevels; };
+struct D3D11_SHADER_RESOURCE_VIEW_DESC { DXGI_FORMAT Format; D3D11_SRV_DIMENSION ViewDimension; union { D3D11_BUFFER_SRV Buffer; D3D11_TEX2D_SRV Texture2D; }; };
+struct D3D11_TEX2D_RTV { UINT MipSlice; };
+struct D3D11_RENDER_TARGET_VIEW_DESC { DXGI_FORMAT Format; D3D11_RTV_DIMENSION ViewDimension; D3D11_TEX2D_RTV Texture2D; };
+struct D3D11_TEX2D_DSV { UINT MipSlice; };
+struct D3D11_DEPTH_STENCIL_VIEW_DESC { DXGI_FORMAT Format; D3D11_DSV_DIMENSION ViewDimension; UINT Flags; D3D11_TEX2D_DSV Texture2D; };
+struct D3D11_TEXTURE2D_DESC { UINT Width, Height, MipLevels, ArraySize; DXGI_FORMAT Format; DXGI_SAMPLE_DESC SampleDesc; D3D11_USAGE Usage; UINT BindFlags, CPUAccessFlags, MiscFlags; };
+struct D3D11_INPUT_ELEMENT_DESC { LPCSTR SemanticName; UINT SemanticIndex; DXGI_FORMAT Format; UINT InputSlot; UINT AlignedByteOffset; D3D11_INPUT_CLASSIFICATION InputSlotClass; UINT InstanceDataStepRate; };
+struct D3D11_RASTERIZER_DESC { D3D11_FILL_MODE FillMode; D3D11_CULL_MODE CullMode; BOOL FrontCounterClockwise; INT DepthBias; FLOAT DepthBiasClamp; FLOAT SlopeScaledDepthBias; BOOL DepthClipEnable; BOOL ScissorEnable; BOOL MultisampleEnable; BOOL AntialiasedLineEnable; };
+struct D3D11_DEPTH_STENCILOP_DESC { D3D11_STENCIL_OP StencilFailOp, StencilDepthFailOp, StencilPassOp; D3D11_COMPARISON_FUNC StencilFunc; };
+struct D3D11_DEPTH_STENCIL_DESC { BOOL DepthEnable; D3D11_DEPTH_WRITE_MASK DepthWriteMask; D3D11_COMPARISON_FUNC DepthFunc; BOOL StencilEnable; BYTE StencilReadMask; BYTE StencilWriteMask; D3D11_DEPTH_STENCILOP_DESC FrontFace, BackFace; };
+struct D3D11_RENDER_TARGET_BLEND_DESC { BOOL BlendEnable; D3D11_BLEND SrcBlend, DestBlend; D3D11_BLEND_OP BlendOp; D3D11_BLEND SrcBlendAlpha, DestBlendAlpha; D3D11_BLEND_OP BlendOpAlpha; BYTE RenderTargetWriteMask; };
+struct D3D11_BLEND_DESC { BOOL AlphaToCoverageEnable; BOOL IndependentBlendEnable; D3D11_RENDER_TARGET_BLEND_DESC RenderTarget[8]; };
+struct D3D11_SAMPLER_DESC { D3D11_FILTER Filter; D3D11_TEXTURE_ADDRESS_MODE AddressU, AddressV, AddressW; FLOAT MipLODBias; UINT MaxAnisotropy; D3D11_COMPARISON_FUNC ComparisonFunc; FLOAT BorderColor[4]; FLOAT MinLOD; FLOAT MaxLOD; };
+struct D3D11_VIEWPORT { FLOAT TopLeftX, TopLeftY, Width, Height, MinDepth, MaxDepth; };
+struct D3D11_SO_DECLARATION_ENTRY { UINT Stream; LPCSTR SemanticName; UINT SemanticIndex; BYTE StartComponent; BYTE ComponentCount; BYTE OutputSlot; };
+struct ID3D11Device;
+
+struct ID3D11DeviceChild : IUnknown
+{
+	virtual void GetDevice(ID3D11Device** device) { *device = 0; }
+};
+
+struct ID3D11Resource : ID3D11DeviceChild {};
+
+struct ID3D11Buffer : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_BUFFER_DESC* desc) { memset(desc, 0, sizeof(*desc)); }
+};
+
+struct ID3D11Texture2D : ID3D11Resource
+{
+	virtual void GetDesc(D3D11_TEXTURE2D_DESC* desc) { memset(desc, 0, sizeof(*desc)); }
+};
+
+struct ID3D11View : ID3D11DeviceChild
+{
+	virtual void GetResource(ID3D11Resource** resource) { *resource = 0; }
+};
+
+struct ID3D11ShaderResourceView : ID3D11View {};
+struct ID3D11RenderTargetView : ID3D11View {};
+struct ID3D11DepthStencilView : ID3D11View {};
+struct ID3D11UnorderedAccessView : ID3D11View {};
+struct ID3D11SamplerState : ID3D11DeviceChild {};
+struct ID3D11RasterizerState : ID3D11DeviceChild {};
+struct ID3D11DepthStencilState : ID3D11DeviceChild {};
+struct ID3D11BlendState : ID3D11DeviceChild {};
+struct ID3D11InputLayout : ID3D11DeviceChild {};
+struct ID3D11ClassInstance : ID3D11DeviceChild {};
+struct ID3D11ClassLinkage : ID3D11DeviceChild {};
+struct ID3D11VertexShader : ID3D11DeviceChild {};
+struct ID3D11PixelShader : ID3D11DeviceChild {};
+struct ID3D11DomainShader : ID3D11DeviceChild {};
+struct ID3D11HullShader : ID3D11DeviceChild {};
+struct ID3D11GeometryShader : ID3D11DeviceChild {};
+struct ID3D11ComputeShader : ID3D11DeviceChild {};
+
+#define D3D11_SHIM_STAGE(prefix, shaderType) \
+	virtual void prefix##SetShader(shaderType*, ID3D11ClassInstance* const*, UINT) {} \
+	virtual void prefix##SetConstantBuffers(UINT, UINT, ID3D11Buffer* const*) {} \
+	virtual void prefix##SetShaderResources(UINT, UINT, ID3D11ShaderResourceView* const*) {} \
+	virtual void prefix##SetSamplers(UINT, UINT, ID3D11SamplerState* const*) {}
+
+struct ID3D11DeviceContext : ID3D11DeviceChild
+{
+	D3D11_SHIM_STAGE(VS, ID3D11VertexShader)
+	D3D11_SHIM_STAGE(PS, ID3D11PixelShader)
+	D3D11_SHIM_STAGE(DS, ID3D11DomainShader)
+	D3D11_SHIM_STAGE(HS, ID3D11HullShader)
+	D3D11_SHIM_STAGE(GS, ID3D11GeometryShader)
+	D3D11_SHIM_STAGE(CS, ID3D11ComputeShader)
+
+	virtual void CSSetUnorderedAccessViews(UINT, UINT, ID3D11UnorderedAccessView* const*, const UINT*) {}
+	virtual void Dispatch(UINT, UINT, UINT) {}
+
+	virtual void IASetInputLayout(ID3D11InputLayout*) {}
+	virtual void IASetVertexBuffers(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) {}
+	virtual void IASetIndexBuffer(ID3D11Buffer*, DXGI_FORMAT, UINT) {}
+	virtual void IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY) {}
+
+	virtual void Draw(UINT, UINT) {}
+	virtual void DrawIndexed(UINT, UINT, INT) {}
+	virtual void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) {}
+
+	virtual HRESULT Map(ID3D11Resource*, UINT, D3D11_MAP, UINT, D3D11_MAPPED_SUBRESOURCE*) { return E_FAIL; }
+	virtual void Unmap(ID3D11Resource*, UINT) {}
+	virtual void UpdateSubresource(ID3D11Resource*, UINT, const D3D11_BOX*, const void*, UINT, UINT) {}
+
+	virtual void OMSetRenderTargets(UINT, ID3D11RenderTargetView* const*, ID3D11DepthStencilView*) {}
+	virtual void OMSetBlendState(ID3D11BlendState*, const FLOAT[4], UINT) {}
+	virtual void OMSetDepthStencilState(ID3D11DepthStencilState*, UINT) {}
+	virtual void RSSetState(ID3D11RasterizerState*) {}
+	virtual void RSSetViewports(UINT, const D3D11_VIEWPORT*) {}
+	virtual void SOSetTargets(UINT, ID3D11Buffer* const*, const UINT*) {}
+
+	virtual void ClearRenderTargetView(ID3D11RenderTargetView*, const FLOAT[4]) {}
+	virtual void ClearDepthStencilView(ID3D11DepthStencilView*, UINT, FLOAT, BYTE) {}
+};
+
+struct ID3D11Device : IUnknown
+{
+	virtual HRESULT CreateBuffer(const D3D11_BUFFER_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Buffer**) { return E_FAIL; }
+	virtual HRESULT CreateTexture2D(const D3D11_TEXTURE2D_DESC*, const D3D11_SUBRESOURCE_DATA*, ID3D11Texture2D**) { return E_FAIL; }
+	virtual HRESULT CreateShaderResourceView(ID3D11Resource*, const D3D11_SHADER_RESOURCE_VIEW_DESC*, ID3D11ShaderResourceView**) { return E_FAIL; }
+	virtual HRESULT CreateRenderTargetView(ID3D11Resource*, const D3D11_RENDER_TARGET_VIEW_DESC*, ID3D11RenderTargetView**) { return E_FAIL; }
+	virtual HRESULT CreateDepthStencilView(ID3D11Resource*, const D3D11_DEPTH_STENCIL_VIEW_DESC*, ID3D11DepthStencilView**) { return E_FAIL; }
+	virtual HRESULT CreateUnorderedAccessView(ID3D11Resource*, const void*, ID3D11UnorderedAccessView**) { return E_FAIL; }
+	virtual HRESULT CreateInputLayout(const D3D11_INPUT_ELEMENT_DESC*, UINT, const void*, SIZE_T, ID3D11InputLayout**) { return E_FAIL; }
+	virtual HRESULT CreateVertexShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11VertexShader**) { return E_FAIL; }
+	virtual HRESULT CreatePixelShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11PixelShader**) { return E_FAIL; }
+	virtual HRESULT CreateDomainShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11DomainShader**) { return E_FAIL; }
+	virtual HRESULT CreateHullShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11HullShader**) { return E_FAIL; }
+	virtual HRESULT CreateGeometryShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11GeometryShader**) { return E_FAIL; }
+	virtual HRESULT CreateGeometryShaderWithStreamOutput(const void*, SIZE_T, const D3D11_SO_DECLARATION_ENTRY*, UINT, const UINT*, UINT, UINT, ID3D11ClassLinkage*, ID3D11GeometryShader**) { return E_FAIL; }
+	virtual HRESULT CreateComputeShader(const void*, SIZE_T, ID3D11ClassLinkage*, ID3D11ComputeShader**) { return E_FAIL; }
+	virtual HRESULT CreateSamplerState(const D3D11_SAMPLER_DESC*, ID3D11SamplerState**) { return E_FAIL; }
+	virtual HRESULT CreateRasterizerState(const D3D11_RASTERIZER_DESC*, ID3D11RasterizerState**) { return E_FAIL; }
+	virtual HRESULT CreateDepthStencilState(const D3D11_DEPTH_STENCIL_DESC*, ID3D11DepthStencilState**) { return E_FAIL; }
+	virtual HRESULT CreateBlendState(const D3D11_BLEND_DESC*, ID3D11BlendState**) { return E_FAIL; }
+	virtual HRESULT CheckFeatureSupport(D3D11_FEATURE, void*, UINT) { return E_FAIL; }
+	virtual void GetImmediateContext(ID3D11DeviceContext** context) { *context = 0; }
+};
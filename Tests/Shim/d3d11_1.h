@@ -0,0 +1,17 @@
+#pragma once
+
+// Test shim - see Windows.h
+#include <d3d11.h>
+
+enum { D3D11_COPY_NO_OVERWRITE = 1, D3D11_COPY_DISCARD = 2 };
+
+struct ID3D11DeviceContext1 : ID3D11DeviceContext
+{
+	virtual void VSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) {}
+	virtual void PSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) {}
+	virtual void HSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) {}
+	virtual void DSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) {}
+	virtual void GSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) {}
+	virtual void CSSetConstantBuffers1(UINT, UINT, ID3D11Buffer* const*, const UINT*, const UINT*) {}
+	virtual void UpdateSubresource1(ID3D11Resource*, UINT, const D3D11_BOX*, const void*, UINT, UINT, UINT) {}
+};
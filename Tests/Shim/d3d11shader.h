@@ -0,0 +1,34 @@
+#pragma once
+
+// Test shim - see Windows.h.  Only the types; see d3dcompiler.h for D3DReflect.
+#include <d3dcommon.h>
+
+struct D3D11_SHADER_DESC { UINT Version; LPCSTR Creator; UINT Flags; UINT ConstantBuffers; UINT BoundResources; UINT InputParameters; UINT OutputParameters; };
+struct D3D11_SHADER_BUFFER_DESC { LPCSTR Name; D3D_CBUFFER_TYPE Type; UINT Variables; UINT Size; UINT uFlags; };
+struct D3D11_SHADER_VARIABLE_DESC { LPCSTR Name; UINT StartOffset; UINT Size; UINT uFlags; void* DefaultValue; UINT StartTexture, TextureSize, StartSampler, SamplerSize; };
+struct D3D11_SHADER_INPUT_BIND_DESC { LPCSTR Name; D3D_SHADER_INPUT_TYPE Type; UINT BindPoint; UINT BindCount; UINT uFlags; UINT ReturnType; UINT Dimension; UINT NumSamples; };
+struct D3D11_SIGNATURE_PARAMETER_DESC { LPCSTR SemanticName; UINT SemanticIndex; UINT Register; UINT SystemValueType; D3D_REGISTER_COMPONENT_TYPE ComponentType; BYTE Mask; BYTE ReadWriteMask; UINT Stream; };
+
+struct ID3D11ShaderReflectionVariable
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_VARIABLE_DESC*) { return E_FAIL; }
+};
+
+struct ID3D11ShaderReflectionConstantBuffer
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_BUFFER_DESC*) { return E_FAIL; }
+	virtual ID3D11ShaderReflectionVariable* GetVariableByIndex(UINT) { return 0; }
+};
+
+struct ID3D11ShaderReflection : IUnknown
+{
+	virtual HRESULT GetDesc(D3D11_SHADER_DESC*) { return E_FAIL; }
+	virtual ID3D11ShaderReflectionConstantBuffer* GetConstantBufferByIndex(UINT) { return 0; }
+	virtual HRESULT GetResourceBindingDesc(UINT, D3D11_SHADER_INPUT_BIND_DESC*) { return E_FAIL; }
+	virtual HRESULT GetResourceBindingDescByName(LPCSTR, D3D11_SHADER_INPUT_BIND_DESC*) { return E_FAIL; }
+	virtual HRESULT GetInputParameterDesc(UINT, D3D11_SIGNATURE_PARAMETER_DESC*) { return E_FAIL; }
+	virtual HRESULT GetOutputParameterDesc(UINT, D3D11_SIGNATURE_PARAMETER_DESC*) { return E_FAIL; }
+	virtual UINT GetThreadGroupSize(UINT*, UINT*, UINT*) { return 0; }
+};
+
+#define IID_ID3D11ShaderReflection __uuidof(ID3D11ShaderReflection)
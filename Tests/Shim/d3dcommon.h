@@ -0,0 +1,41 @@
+#pragma once
+
+// Test shim - see Windows.h
+#include <Windows.h>
+
+struct ID3D10Blob : IUnknown
+{
+	virtual void* GetBufferPointer() { return 0; }
+	virtual SIZE_T GetBufferSize() { return 0; }
+};
+typedef ID3D10Blob ID3DBlob;
+
+enum D3D_FEATURE_LEVEL { D3D_FEATURE_LEVEL_11_0 = 0xb000, D3D_FEATURE_LEVEL_11_1 = 0xb100 };
+
+enum D3D_PRIMITIVE_TOPOLOGY
+{
+	D3D11_PRIMITIVE_TOPOLOGY_UNDEFINED = 0,
+	D3D11_PRIMITIVE_TOPOLOGY_POINTLIST = 1,
+	D3D11_PRIMITIVE_TOPOLOGY_LINELIST = 2,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST = 4,
+	D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP = 5
+};
+typedef D3D_PRIMITIVE_TOPOLOGY D3D11_PRIMITIVE_TOPOLOGY;
+
+enum D3D_CBUFFER_TYPE
+{
+	D3D_CT_CBUFFER = 0, D3D_CT_TBUFFER, D3D_CT_INTERFACE_POINTERS, D3D_CT_RESOURCE_BIND_INFO,
+	D3D11_CT_CBUFFER = 0, D3D11_CT_TBUFFER, D3D11_CT_INTERFACE_POINTERS, D3D11_CT_RESOURCE_BIND_INFO
+};
+
+enum D3D_SHADER_INPUT_TYPE
+{
+	D3D_SIT_CBUFFER = 0, D3D_SIT_TBUFFER, D3D_SIT_TEXTURE, D3D_SIT_SAMPLER, D3D_SIT_UAV_RWTYPED, D3D_SIT_STRUCTURED,
+	D3D_SIT_UAV_RWSTRUCTURED, D3D_SIT_BYTEADDRESS, D3D_SIT_UAV_RWBYTEADDRESS, D3D_SIT_UAV_APPEND_STRUCTURED,
+	D3D_SIT_UAV_CONSUME_STRUCTURED, D3D_SIT_UAV_RWSTRUCTURED_WITH_COUNTER
+};
+
+enum D3D_REGISTER_COMPONENT_TYPE
+{
+	D3D_REGISTER_COMPONENT_UNKNOWN = 0, D3D_REGISTER_COMPONENT_UINT32, D3D_REGISTER_COMPONENT_SINT32, D3D_REGISTER_COMPONENT_FLOAT32
+};
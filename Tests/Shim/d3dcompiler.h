@@ -0,0 +1,77 @@
+#pragma once
+
+// Test shim - see Windows.h.  Blobs are real, so shaders can be "loaded"
+// from any file, but reflection fails unless a test installs a reflector
+// of its own: tests supply it through a ShaderReflectionCache instead, and
+// can check it was never needed.
+#include <d3d11shader.h>
+#include <string>
+#include <vector>
+
+struct ShimBlob : ID3DBlob
+{
+	std::vector<unsigned char> Bytes;
+	unsigned long References = 1;
+
+	void* GetBufferPointer() override { return Bytes.data(); }
+	SIZE_T GetBufferSize() override { return Bytes.size(); }
+	unsigned long AddRef() override { return ++References; }
+	unsigned long Release() override
+	{
+		unsigned long left = --References;
+		if (left == 0)
+			delete this;
+		return left;
+	}
+};
+
+// Calls made to D3DReflect
+inline unsigned int& ShimReflectCalls()
+{
+	static unsigned int calls = 0;
+	return calls;
+}
+
+// What D3DReflect hands back for any bytecode; null makes it fail.  Not owned.
+inline ID3D11ShaderReflection*& ShimReflector()
+{
+	static ID3D11ShaderReflection* reflector = 0;
+	return reflector;
+}
+
+inline HRESULT D3DCreateBlob(SIZE_T size, ID3DBlob** blob)
+{
+	ShimBlob* shimBlob = new ShimBlob();
+	shimBlob->Bytes.resize(size);
+	*blob = shimBlob;
+	return S_OK;
+}
+
+inline HRESULT D3DReadFileToBlob(LPCWSTR fileName, ID3DBlob** blob)
+{
+	// Test file names are plain ASCII
+	std::string path;
+	for (LPCWSTR c = fileName; *c; c++)
+		path += (char)*c;
+
+	FILE* file = fopen(path.c_str(), "rb");
+	if (!file)
+		return E_FAIL;
+
+	ShimBlob* shimBlob = new ShimBlob();
+	unsigned char chunk[4096];
+	size_t read;
+	while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		shimBlob->Bytes.insert(shimBlob->Bytes.end(), chunk, chunk + read);
+	fclose(file);
+
+	*blob = shimBlob;
+	return S_OK;
+}
+
+inline HRESULT D3DReflect(const void*, SIZE_T, REFIID, void** reflector)
+{
+	ShimReflectCalls()++;
+	*reflector = ShimReflector();
+	return ShimReflector() ? S_OK : E_FAIL;
+}
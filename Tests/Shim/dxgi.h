@@ -0,0 +1,23 @@
+#pragma once
+
+// Test shim - see Windows.h
+#include <Windows.h>
+
+enum DXGI_FORMAT
+{
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32A32_FLOAT = 2, DXGI_FORMAT_R32G32B32A32_UINT, DXGI_FORMAT_R32G32B32A32_SINT,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6, DXGI_FORMAT_R32G32B32_UINT, DXGI_FORMAT_R32G32B32_SINT,
+	DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+	DXGI_FORMAT_R32G32_FLOAT = 16, DXGI_FORMAT_R32G32_UINT, DXGI_FORMAT_R32G32_SINT,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R32_TYPELESS = 39, DXGI_FORMAT_D32_FLOAT, DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_R32_UINT, DXGI_FORMAT_R32_SINT,
+	DXGI_FORMAT_R16_UINT = 57
+};
+
+struct DXGI_SAMPLE_DESC { UINT Count; UINT Quality; };
+
+struct IDXGISwapChain : IUnknown
+{
+	virtual HRESULT Present(UINT, UINT) { return S_OK; }
+};
@@ -0,0 +1,175 @@
+#include "TestHarness.h"
+#include "SimpleShader.h"
+
+namespace
+{
+	// bufferCount buffers of variablesPerBuffer floats each, named "b<buffer>v<variable>"
+	ShaderReflectionData MakeManyVariables(unsigned int bufferCount, unsigned int variablesPerBuffer)
+	{
+		ShaderReflectionData data;
+		for (unsigned int b = 0; b < bufferCount; b++)
+		{
+			ReflectedConstantBuffer buffer = { "buffer" + std::to_string(b), 0, b, variablesPerBuffer * 4, {} };
+			for (unsigned int v = 0; v < variablesPerBuffer; v++)
+				buffer.Variables.push_back({ "b" + std::to_string(b) + "v" + std::to_string(v), v * 4, 4 });
+			data.ConstantBuffers.push_back(buffer);
+		}
+		return data;
+	}
+
+	bool InBuffer(SimpleConstantBuffer* cb, SimpleShaderVariable* var)
+	{
+		return var >= cb->Variables && var < cb->Variables + cb->VariableCount;
+	}
+}
+
+TEST(EveryVariableIsFoundByName)
+{
+	// Enough names that the table has to probe past collisions
+	ShaderReflectionData data = MakeManyVariables(4, 40);
+	data.Textures.push_back({ "diffuse", 0 });
+	data.Samplers.push_back({ "basicSampler", 0 });
+
+	SimpleShaderMetadata metadata;
+	metadata.Build(data);
+	CHECK_EQUAL(4u, metadata.GetConstantBufferCount());
+
+	for (unsigned int b = 0; b < data.ConstantBuffers.size(); b++)
+	{
+		SimpleConstantBuffer* cb = metadata.FindConstantBuffer(data.ConstantBuffers[b].Name);
+		CHECK(cb == &metadata.GetConstantBuffers()[b]);
+		CHECK(strcmp(cb->Name, data.ConstantBuffers[b].Name.c_str()) == 0);
+
+		for (const ReflectedVariable& reflected : data.ConstantBuffers[b].Variables)
+		{
+			SimpleShaderVariable* var = metadata.FindVariable(reflected.Name);
+			CHECK(var != 0);
+			if (!var)
+				continue;
+			CHECK_EQUAL(b, var->ConstantBufferIndex);
+			CHECK_EQUAL(reflected.ByteOffset, var->ByteOffset);
+			CHECK_EQUAL(reflected.Size, var->Size);
+			CHECK(InBuffer(cb, var));
+		}
+	}
+
+	CHECK(metadata.FindShaderResourceView("diffuse") == &metadata.GetShaderResourceViews()[0]);
+	CHECK(metadata.FindSampler("basicSampler") == &metadata.GetSamplers()[0]);
+	CHECK(metadata.FindVariable("b4v0") == 0);
+	CHECK(metadata.FindVariable("") == 0);
+}
+
+TEST(DuplicateVariableNamesFindTheFirstBuffer)
+{
+	ShaderReflectionData data;
+	ReflectedConstantBuffer perFrame = { "perFrame", 0, 0, 80, {} };
+	perFrame.Variables.push_back({ "view", 0, 64 });
+	perFrame.Variables.push_back({ "time", 64, 4 });
+	ReflectedConstantBuffer perObject = { "perObject", 0, 1, 80, {} };
+	perObject.Variables.push_back({ "world", 0, 64 });
+	perObject.Variables.push_back({ "time", 68, 4 });
+	data.ConstantBuffers.push_back(perFrame);
+	data.ConstantBuffers.push_back(perObject);
+
+	SimpleShaderMetadata metadata;
+	metadata.Build(data);
+
+	// As a map insert would: the first one declared wins the name...
+	SimpleShaderVariable* time = metadata.FindVariable("time");
+	CHECK(time != 0);
+	CHECK_EQUAL(0u, time->ConstantBufferIndex);
+	CHECK_EQUAL(64u, time->ByteOffset);
+
+	// ...but each buffer still holds its own
+	SimpleConstantBuffer* second = metadata.FindConstantBuffer("perObject");
+	CHECK_EQUAL(2u, second->VariableCount);
+	CHECK_EQUAL(68u, second->Variables[1].ByteOffset);
+	CHECK_EQUAL(1u, second->Variables[1].ConstantBufferIndex);
+	CHECK(metadata.FindVariable("world") == &second->Variables[0]);
+}
+
+TEST(NamesOfDifferentKindsDontCollide)
+{
+	ShaderReflectionData data;
+	ReflectedConstantBuffer buffer = { "shadow", 0, 0, 16, {} };
+	buffer.Variables.push_back({ "shadow", 0, 4 });
+	data.ConstantBuffers.push_back(buffer);
+	data.Textures.push_back({ "shadow", 2 });
+	data.Samplers.push_back({ "shadow", 3 });
+
+	SimpleShaderMetadata metadata;
+	metadata.Build(data);
+
+	CHECK(metadata.FindConstantBuffer("shadow") == &metadata.GetConstantBuffers()[0]);
+	CHECK(metadata.FindVariable("shadow") != 0);
+	CHECK_EQUAL(2u, metadata.FindShaderResourceView("shadow")->BindIndex);
+	CHECK_EQUAL(3u, metadata.FindSampler("shadow")->BindIndex);
+}
+
+TEST(VariablesAreInOffsetOrder)
+{
+	// Declared out of order, as packoffset allows, with two sharing an offset
+	ShaderReflectionData data;
+	ReflectedConstantBuffer first = { "first", 0, 0, 64, {} };
+	first.Variables.push_back({ "c", 32, 4 });
+	first.Variables.push_back({ "a", 0, 16 });
+	first.Variables.push_back({ "d", 48, 4 });
+	first.Variables.push_back({ "b", 16, 4 });
+	first.Variables.push_back({ "alias", 16, 4 });
+	ReflectedConstantBuffer second = { "second", 0, 1, 32, {} };
+	second.Variables.push_back({ "y", 16, 4 });
+	second.Variables.push_back({ "x", 0, 4 });
+	data.ConstantBuffers.push_back(first);
+	data.ConstantBuffers.push_back(second);
+
+	SimpleShaderMetadata metadata;
+	metadata.Build(data);
+
+	for (unsigned int b = 0; b < metadata.GetConstantBufferCount(); b++)
+	{
+		SimpleConstantBuffer* cb = &metadata.GetConstantBuffers()[b];
+		for (unsigned int v = 1; v < cb->VariableCount; v++)
+			CHECK(cb->Variables[v - 1].ByteOffset <= cb->Variables[v].ByteOffset);
+	}
+
+	// Ties keep their declared order, and lookups follow the moves
+	SimpleConstantBuffer* cb = metadata.FindConstantBuffer("first");
+	CHECK(metadata.FindVariable("a") == &cb->Variables[0]);
+	CHECK(metadata.FindVariable("b") == &cb->Variables[1]);
+	CHECK(metadata.FindVariable("alias") == &cb->Variables[2]);
+	CHECK(metadata.FindVariable("d") == &cb->Variables[4]);
+	CHECK(metadata.FindVariable("x") == &metadata.FindConstantBuffer("second")->Variables[0]);
+}
+
+TEST(LocalDataIsAlignedAndSeparate)
+{
+	ShaderReflectionData data = MakeManyVariables(3, 5);
+
+	SimpleShaderMetadata metadata;
+	metadata.Build(data);
+
+	SimpleConstantBuffer* buffers = metadata.GetConstantBuffers();
+	for (unsigned int b = 0; b < metadata.GetConstantBufferCount(); b++)
+	{
+		CHECK_EQUAL((size_t)0, (size_t)buffers[b].LocalDataBuffer % 16);
+		if (b > 0)
+			CHECK(buffers[b].LocalDataBuffer >= buffers[b - 1].LocalDataBuffer + buffers[b - 1].Size);
+	}
+}
+
+TEST(RebuildingReplacesEverything)
+{
+	SimpleShaderMetadata metadata;
+	metadata.Build(MakeManyVariables(2, 3));
+	size_t firstSize = metadata.GetSize();
+
+	metadata.Build(MakeManyVariables(1, 1));
+	CHECK_EQUAL(1u, metadata.GetConstantBufferCount());
+	CHECK(metadata.FindVariable("b0v0") != 0);
+	CHECK(metadata.FindVariable("b1v0") == 0);
+	CHECK(metadata.GetSize() < firstSize);
+
+	metadata.Clear();
+	CHECK_EQUAL(0u, metadata.GetConstantBufferCount());
+	CHECK(metadata.FindVariable("b0v0") == 0);
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// --------------------------------------------------------
+// Just enough of a test framework for the CPU side of the
+// renderer.  TEST(Name) { ... } defines a test, CHECK fails
+// it without stopping the rest, and TestMain.cpp runs every
+// test linked into the executable.
+// --------------------------------------------------------
+struct TestCase
+{
+	const char* Name;
+	void (*Run)();
+};
+
+inline std::vector<TestCase>& TestRegistry()
+{
+	static std::vector<TestCase> tests;
+	return tests;
+}
+
+// Failed checks in the test that's running
+inline int& TestFailures()
+{
+	static int failures = 0;
+	return failures;
+}
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* name, void (*run)())
+	{
+		TestRegistry().push_back({ name, run });
+	}
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(condition) \
+	do { \
+		if (!(condition)) { \
+			std::printf("  %s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+			TestFailures()++; \
+		} \
+	} while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { \
+		if (!((expected) == (actual))) { \
+			std::printf("  %s(%d): CHECK_EQUAL(%s, %s) failed\n", __FILE__, __LINE__, #expected, #actual); \
+			TestFailures()++; \
+		} \
+	} while (0)
@@ -0,0 +1,18 @@
+#include "TestHarness.h"
+
+int main()
+{
+	int failed = 0;
+	for (const TestCase& test : TestRegistry())
+	{
+		TestFailures() = 0;
+		test.Run();
+
+		std::printf("%s %s\n", TestFailures() == 0 ? "[ pass ]" : "[ FAIL ]", test.Name);
+		if (TestFailures() != 0)
+			failed++;
+	}
+
+	std::printf("%d of %d tests failed\n", failed, (int)TestRegistry().size());
+	return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,346 @@
+#!/usr/bin/env python3
+"""Generates GraphXpo/ShaderConstants.h from the cbuffer declarations in GraphXpo/*.hlsl.
+
+Each shader gets a namespace inside ShaderConstants, named after its file,
+holding a C++ struct per cbuffer (and per HLSL struct those cbuffers use).
+They're laid out with HLSL's constant buffer packing rules and checked with
+static_asserts, so a struct can be handed to ISimpleShader::SetBufferData()
+in one copy.
+
+Usage:
+    python3 tools/generate_cbuffers.py          # Rewrite the header
+    python3 tools/generate_cbuffers.py --check  # Fail if it is out of date
+
+Only plain text processing - runs anywhere Python 3 does.
+"""
+
+import argparse
+import os
+import re
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SHADER_DIR = os.path.join(ROOT, "GraphXpo")
+OUTPUT = os.path.join(SHADER_DIR, "ShaderConstants.h")
+
+REGISTER = 16
+
+# HLSL scalar -> (C++ scalar, C++ vector type prefix)
+SCALARS = {
+    "float": ("float", "DirectX::XMFLOAT"),
+    "int": ("int", "DirectX::XMINT"),
+    "uint": ("unsigned int", "DirectX::XMUINT"),
+    "dword": ("unsigned int", "DirectX::XMUINT"),
+    "bool": ("int", "DirectX::XMINT"),  # 4 bytes in a constant buffer
+}
+
+
+class ShaderError(Exception):
+    pass
+
+
+def align(value, alignment):
+    return (value + alignment - 1) // alignment * alignment
+
+
+def strip_comments(text):
+    text = re.sub(r"/\*.*?\*/", lambda m: "\n" * m.group(0).count("\n"), text, flags=re.S)
+    return re.sub(r"//[^\n]*", "", text)
+
+
+class Type:
+    """A member's type: a scalar, vector, matrix or struct, and its packed size."""
+
+    def __init__(self, name, size, cpp, starts_register, ends_register):
+        self.name = name
+        self.size = size                    # Bytes, without trailing padding
+        self.cpp = cpp                      # C++ type spelling, or None if it must be flattened to floats
+        self.starts_register = starts_register
+        self.ends_register = ends_register  # The next member starts a new register
+
+
+def basic_type(name, row_major):
+    m = re.fullmatch(r"(float|int|uint|dword|bool)([1-4])?(?:x([1-4]))?", name)
+    if name == "matrix":
+        m = re.fullmatch(r"(float)(4)x(4)", "float4x4")
+    if not m:
+        return None
+
+    scalar, rows, cols = m.group(1), m.group(2), m.group(3)
+    cpp_scalar, cpp_vector = SCALARS[scalar]
+    if cols is None:
+        count = int(rows or 1)
+        cpp = cpp_scalar if count == 1 else cpp_vector + str(count)
+        return Type(name, 4 * count, cpp, False, False)
+
+    rows, cols = int(rows), int(cols)
+    # Column major (HLSL's default) stores one register per column
+    registers, per_register = (rows, cols) if row_major else (cols, rows)
+    size = REGISTER * (registers - 1) + 4 * per_register
+    cpp = "DirectX::XMFLOAT4X4" if (scalar == "float" and rows == 4 and cols == 4) else None
+    return Type(name, size, cpp, True, False)
+
+
+class Member:
+    def __init__(self, type_, name, count, offset):
+        self.type = type_
+        self.name = name
+        self.count = count    # 0 if not an array
+        self.offset = offset
+
+
+class Layout:
+    """A cbuffer or struct: its members at their packed offsets."""
+
+    def __init__(self, name):
+        self.name = name
+        self.members = []
+        self.size = 0
+
+    def add(self, type_, name, count):
+        offset = self.size
+        if count:
+            # Every array element starts a register
+            offset = align(offset, REGISTER)
+            stride = align(type_.size, REGISTER)
+            end = offset + stride * (count - 1) + type_.size
+        else:
+            if type_.starts_register or (offset % REGISTER) + type_.size > REGISTER:
+                offset = align(offset, REGISTER)
+            end = offset + type_.size
+
+        self.members.append(Member(type_, name, count, offset))
+        self.size = align(end, REGISTER) if type_.ends_register else end
+
+
+def parse_members(body, structs, defines, where):
+    layout_members = []
+    for statement in body.split(";"):
+        statement = " ".join(statement.split())
+        if not statement:
+            continue
+        if "packoffset" in statement:
+            raise ShaderError("%s: packoffset is not supported: %s" % (where, statement))
+
+        m = re.fullmatch(r"((?:(?:row_major|column_major|const|static|uniform)\s+)*)(\w+)\s+(.+)", statement)
+        if not m:
+            raise ShaderError("%s: can't parse member: %s" % (where, statement))
+        modifiers, type_name, declarators = m.group(1).split(), m.group(2), m.group(3)
+        if "static" in modifiers:
+            continue
+
+        type_ = structs.get(type_name) or basic_type(type_name, "row_major" in modifiers)
+        if type_ is None:
+            raise ShaderError("%s: unsupported type %s" % (where, type_name))
+
+        for declarator in declarators.split(","):
+            declarator = declarator.split(":")[0].strip()
+            d = re.fullmatch(r"(\w+)\s*(?:\[\s*(\w+)\s*\])?", declarator)
+            if not d:
+                raise ShaderError("%s: can't parse declarator: %s" % (where, declarator))
+            count = 0
+            if d.group(2):
+                size = defines.get(d.group(2), d.group(2))
+                if not size.isdigit():
+                    raise ShaderError("%s: array size %s is not a number" % (where, d.group(2)))
+                count = int(size)
+            layout_members.append((type_, d.group(1), count))
+    return layout_members
+
+
+def parse_shader(path):
+    text = strip_comments(open(path).read())
+    name = os.path.splitext(os.path.basename(path))[0]
+
+    defines = dict(re.findall(r"^\s*#define\s+(\w+)\s+(\d+)\s*$", text, flags=re.M))
+    structs = {}
+    struct_layouts = []
+    buffers = []
+
+    for m in re.finditer(r"\b(struct|cbuffer)\s+(\w+)[^{;]*\{(.*?)\}", text, flags=re.S):
+        kind, block_name, body = m.groups()
+        where = "%s: %s %s" % (os.path.basename(path), kind, block_name)
+
+        if kind == "struct":
+            # Structs holding semantics are shader inputs and outputs, not constants
+            if ":" in body:
+                continue
+            try:
+                members = parse_members(body, structs, defines, where)
+            except ShaderError:
+                continue  # Only a problem if a cbuffer uses it
+            layout = Layout(block_name)
+            for member in members:
+                layout.add(*member)
+            structs[block_name] = Type(block_name, layout.size, block_name, True, True)
+            struct_layouts.append(layout)
+        else:
+            register = re.search(r"register\s*\(\s*b(\d+)\s*\)", m.group(0).split("{")[0])
+            layout = Layout(block_name)
+            layout.register = int(register.group(1)) if register else None
+            for member in parse_members(body, structs, defines, where):
+                layout.add(*member)
+            buffers.append(layout)
+
+    # Only the structs the cbuffers use, in declaration order
+    used = set()
+
+    def use(layout):
+        for member in layout.members:
+            if member.type.name in structs and member.type.name not in used:
+                used.add(member.type.name)
+                use(next(s for s in struct_layouts if s.name == member.type.name))
+
+    for buffer in buffers:
+        use(buffer)
+
+    return name, [s for s in struct_layouts if s.name in used], buffers
+
+
+def cpp_name(name):
+    return name[0].upper() + name[1:]
+
+
+def emit_layout(lines, layout, struct_name, is_buffer, register):
+    lines.append("\tstruct %s" % struct_name)
+    lines.append("\t{")
+    if is_buffer:
+        lines.append("\t\tstatic const char* BufferName() { return \"%s\"; }" % layout.name)
+        if register is not None:
+            lines.append("\t\tstatic const unsigned int Register = %d;" % register)
+        lines.append("")
+
+    cursor = 0
+    padding = 0
+
+    def pad(to):
+        nonlocal cursor, padding
+        if to > cursor:
+            floats = (to - cursor) // 4
+            lines.append("\t\tfloat padding%d%s;" % (padding, "" if floats == 1 else "[%d]" % floats))
+            padding += 1
+            cursor = to
+
+    for member in layout.members:
+        pad(member.offset)
+        t = member.type
+        if member.count:
+            stride = align(t.size, REGISTER)
+            if t.cpp is None:
+                decl = "float %s[%d];" % (member.name, (stride * (member.count - 1) + t.size) // 4)
+            # Structs already carry their padding to a whole register in C++
+            elif t.size % REGISTER and member.count > 1 and not t.ends_register:
+                decl = "ShaderArray<%s, %d> %s;" % (t.cpp, member.count, member.name)
+            else:
+                decl = "%s %s[%d];" % (t.cpp, member.name, member.count)
+            size = stride * (member.count - 1) + t.size
+            if t.ends_register:
+                size = stride * member.count   # C++ structs carry their trailing padding
+        else:
+            decl = "%s %s;" % (t.cpp, member.name) if t.cpp else "float %s[%d];" % (member.name, t.size // 4)
+            size = align(t.size, REGISTER) if t.ends_register else t.size
+        lines.append("\t\t" + decl)
+        cursor = member.offset + size
+
+    # Whole registers, so arrays of structs and whole buffers match HLSL
+    pad(align(layout.size, REGISTER))
+    lines.append("\t};")
+
+    for member in layout.members:
+        lines.append("\tstatic_assert(offsetof(%s, %s) == %d, \"%s.%s is misplaced\");"
+                     % (struct_name, member.name, member.offset, layout.name, member.name))
+    lines.append("\tstatic_assert(sizeof(%s) == %d, \"%s is the wrong size\");"
+                 % (struct_name, align(layout.size, REGISTER), layout.name))
+    lines.append("")
+
+
+def generate(shader_dir):
+    lines = [
+        "#pragma once",
+        "",
+        "// --------------------------------------------------------",
+        "// GENERATED by tools/generate_cbuffers.py - do not edit.",
+        "//",
+        "// C++ versions of each shader's constant buffers, laid",
+        "// out by HLSL's packing rules, for SetBufferData().",
+        "// --------------------------------------------------------",
+        "",
+        "#include <DirectXMath.h>",
+        "#include <cstddef>",
+        "",
+        "// An HLSL array whose elements don't fill a register: each",
+        "// element but the last is padded out to 16 bytes",
+        "template<typename T, unsigned int N>",
+        "struct ShaderArray",
+        "{",
+        "\tstruct Element",
+        "\t{",
+        "\t\tT Value;",
+        "\t\tunsigned char Padding[16 - sizeof(T) % 16];",
+        "\t};",
+        "",
+        "\tElement Elements[N - 1];",
+        "\tT Last;",
+        "",
+        "\tT& operator[](unsigned int i) { return i == N - 1 ? Last : Elements[i].Value; }",
+        "\tconst T& operator[](unsigned int i) const { return i == N - 1 ? Last : Elements[i].Value; }",
+        "};",
+        "",
+        "namespace ShaderConstants",
+        "{",
+    ]
+
+    for file_name in sorted(os.listdir(shader_dir), key=str.lower):
+        if not file_name.endswith(".hlsl"):
+            continue
+        name, structs, buffers = parse_shader(os.path.join(shader_dir, file_name))
+        if not buffers:
+            continue
+
+        shader = []
+        for layout in structs:
+            emit_layout(shader, layout, layout.name, False, None)
+        for layout in buffers:
+            emit_layout(shader, layout, cpp_name(layout.name), True, layout.register)
+        shader.pop()
+
+        lines.append("\t// %s" % file_name)
+        lines.append("\tnamespace %s" % name)
+        lines.append("\t{")
+        lines.extend("\t" + line if line else line for line in shader)
+        lines.append("\t}")
+        lines.append("")
+
+    lines[-1] = "}"
+    lines.append("")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--check", action="store_true", help="exit with an error if the header is out of date")
+    parser.add_argument("--shaders", default=SHADER_DIR, help="directory holding the .hlsl files")
+    parser.add_argument("--output", default=OUTPUT, help="header to write")
+    args = parser.parse_args()
+
+    try:
+        header = generate(args.shaders)
+    except ShaderError as e:
+        print("generate_cbuffers: %s" % e, file=sys.stderr)
+        return 1
+
+    existing = open(args.output).read() if os.path.exists(args.output) else None
+    if args.check:
+        if existing != header:
+            print("generate_cbuffers: %s is out of date" % args.output, file=sys.stderr)
+            return 1
+        return 0
+
+    if existing != header:
+        with open(args.output, "w", newline="\n") as f:
+            f.write(header)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())